@@ -23,6 +23,7 @@
 
 #include <QApplication>
 #include <QDebug>
+#include <QStandardPaths>
 #include <QUuid>
 #include <QtConcurrentFilter>
 #include <QtConcurrentMap>
@@ -133,6 +134,23 @@ void Align::align_with_ais(bool ais_crop_flag) {
     qDebug() << "ais started";
 }
 
+bool Align::isAisAvailable() {
+#ifdef Q_OS_MACOS
+    return QFileInfo(QCoreApplication::applicationDirPath() +
+                     "/align_image_stack")
+        .isExecutable();
+#elif defined Q_OS_WIN
+    return QFileInfo("hugin/align_image_stack.exe").isExecutable();
+#else
+    // align_with_ais() adds the application directory to the PATH
+    const QString name(QStringLiteral("align_image_stack"));
+    return !QStandardPaths::findExecutable(name).isEmpty() ||
+           !QStandardPaths::findExecutable(
+                name, QStringList(QCoreApplication::applicationDirPath()))
+                .isEmpty();
+#endif
+}
+
 void Align::ais_finished(int exitcode, QProcess::ExitStatus exitstatus) {
     if (exitstatus != QProcess::NormalExit) {
         qDebug() << "ais failed";
@@ -41,6 +41,8 @@ class Align : public QObject {
     ~Align();
 
     void align_with_ais(bool ais_crop_flag);
+    //! \return true if align_with_ais() can find align_image_stack
+    static bool isAisAvailable();
     void reset();
     void removeTempFiles();
 
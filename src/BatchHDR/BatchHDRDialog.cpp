@@ -37,13 +37,16 @@
 #include <QSqlQuery>
 #include <QSqlQueryModel>
 #include <QSqlRecord>
+#include <QSharedPointer>
 #include <QtConcurrentRun>
 
 #include <boost/bind.hpp>
 #include <memory>
 
 #include <Libpfs/frame.h>
+#include <Libpfs/io/framereaderfactory.h>
 
+#include <Core/IOService.h>
 #include <Core/IOWorker.h>
 #include <Libpfs/pfs.h>
 #include <OsIntegration/osintegration.h>
@@ -60,14 +63,18 @@ BatchHDRDialog::BatchHDRDialog(QWidget *p)
       m_errors(false),
       m_loading_error(false),
       m_abort(false),
-      m_processing(false) {
+      m_processing(false),
+      m_pendingWrites(0),
+      m_merged(false) {
     m_Ui->setupUi(this);
 
     m_Ui->closeButton->hide();
     m_Ui->progressBar->hide();
 
     m_hdrCreationManager = new HdrCreationManager;
-    m_IO_Worker = new IOWorker;
+    m_io_service.reset(new IOService(
+        static_cast<qint64>(LuminanceOptions().getBatchIOMemoryBudget())
+        << 20));
 
     connect(m_Ui->horizontalSlider, &QAbstractSlider::valueChanged, this,
             &BatchHDRDialog::num_bracketed_changed);
@@ -179,7 +186,8 @@ BatchHDRDialog::~BatchHDRDialog() {
     // DAVIDE _ HDR WIZARD
     m_hdrCreationManager->reset();
     delete m_hdrCreationManager;
-    delete m_IO_Worker;
+    // waits for the HDRs still being written
+    m_io_service.reset();
 }
 
 void BatchHDRDialog::num_bracketed_changed(int value) {
@@ -323,6 +331,39 @@ void BatchHDRDialog::on_startButton_clicked() {
     }
 
     if (doStart) {
+        // read the headers only: reject unreadable files and brackets mixing
+        // image sizes before anything is loaded
+        const int bracketSize = m_Ui->spinBox->value();
+        QStringList problems;
+        size_t width = 0;
+        size_t height = 0;
+        for (int i = 0; i < m_bracketed.count(); ++i) {
+            const QString fileName = QFileInfo(m_bracketed.at(i)).fileName();
+            try {
+                pfs::io::FrameInfo info = pfs::io::FrameReaderFactory::probe(
+                    QFile::encodeName(m_bracketed.at(i)).constData());
+                if (i % bracketSize == 0) {
+                    width = info.width;
+                    height = info.height;
+                } else if (info.width != width || info.height != height) {
+                    problems << tr("%1: size differs from the rest of its "
+                                   "bracket")
+                                    .arg(fileName);
+                }
+            } catch (std::exception &e) {
+                problems << QStringLiteral("%1: %2").arg(
+                    fileName, QString::fromLocal8Bit(e.what()));
+            }
+        }
+        if (!problems.isEmpty()) {
+            QMessageBox::warning(
+                0, tr("Warning"),
+                tr("Some input files cannot be used:\n\n%1")
+                    .arg(problems.join(QStringLiteral("\n"))),
+                QMessageBox::Ok, QMessageBox::NoButton);
+            return;
+        }
+
         m_Ui->horizontalSlider->setEnabled(false);
         m_Ui->spinBox->setEnabled(false);
         m_Ui->groupBoxOutput->setEnabled(false);
@@ -360,25 +401,34 @@ void BatchHDRDialog::batch_hdr() {
         for (int i = 0; i < m_Ui->spinBox->value(); ++i) {
             toProcess << m_bracketed.takeFirst();
         }
+        // the next bracket comes from the disk cache while this one is merged
+        m_io_service->readAhead(m_bracketed.mid(0, m_Ui->spinBox->value()));
         qDebug() << "BatchHDRDialog::batch_hdr() Files to process: "
                  << toProcess;
         // DAVIDE _ HDR CREATION
         QtConcurrent::run(boost::bind(&HdrCreationManager::loadFiles,
                                       m_hdrCreationManager, toProcess));
     } else {
-        m_Ui->closeButton->show();
-        m_Ui->cancelButton->hide();
-        m_Ui->startButton->hide();
-        m_Ui->progressBar->hide();
-        OsIntegration::getInstance().setProgress(-1);
-        QApplication::restoreOverrideCursor();
-        if (m_errors)
-            m_Ui->textEdit->append(tr("Completed with errors"));
-        else
-            m_Ui->textEdit->append(tr("Completed without errors"));
+        // the "Written" messages (and errors) of the last HDRs first:
+        // hdrWritten() completes the batch after the last write
+        m_merged = true;
+        if (m_pendingWrites == 0) batchDone();
     }
 }
 
+void BatchHDRDialog::batchDone() {
+    m_Ui->closeButton->show();
+    m_Ui->cancelButton->hide();
+    m_Ui->startButton->hide();
+    m_Ui->progressBar->hide();
+    OsIntegration::getInstance().setProgress(-1);
+    QApplication::restoreOverrideCursor();
+    if (m_errors)
+        m_Ui->textEdit->append(tr("Completed with errors"));
+    else
+        m_Ui->textEdit->append(tr("Completed without errors"));
+}
+
 void BatchHDRDialog::align() {
     QStringList filesLackingExif = m_hdrCreationManager->getFilesWithoutExif();
     if (!filesLackingExif.isEmpty()) {
@@ -476,9 +526,27 @@ void BatchHDRDialog::createHdrFinished() {
                                            QChar('0')) +
                   "." + suffix;
     }
-    m_IO_Worker->write_hdr_frame(resultHDR.get(), outName,
-                                 m_formatHelper.getParams());
-    resultHDR.reset();
+    // written on the IOService thread, while the next bracket is loaded
+    QSharedPointer<pfs::Frame> output(resultHDR.release());
+    const pfs::Params params = m_formatHelper.getParams();
+    ++m_pendingWrites;
+    m_io_service->post(
+        [this, output, outName, params]() {
+            // hdrWritten() must hear of every write
+            bool status = false;
+            try {
+                status =
+                    IOWorker().write_hdr_frame(output.data(), outName, params);
+            } catch (std::exception &e) {
+                qDebug() << "BatchHDRDialog: write failed" << e.what();
+            }
+            QMetaObject::invokeMethod(this, "hdrWritten",
+                                      Qt::QueuedConnection,
+                                      Q_ARG(QString, outName),
+                                      Q_ARG(bool, status));
+            return status;
+        },
+        IOService::frameBytes(*output));
 
     // DAVIDE _ HDR WIZARD
     m_hdrCreationManager->reset();
@@ -487,10 +555,21 @@ void BatchHDRDialog::createHdrFinished() {
     OsIntegration::getInstance().setProgress(
         progressValue,
         m_Ui->progressBar->maximum() - m_Ui->progressBar->minimum());
-    m_Ui->textEdit->append(tr("Written ") + outName);
     batch_hdr();
 }
 
+void BatchHDRDialog::hdrWritten(const QString &filename, bool status) {
+    if (status) {
+        m_Ui->textEdit->append(tr("Written ") + filename);
+    } else {
+        m_Ui->textEdit->append(tr("Error: cannot write ") + filename);
+        m_errors = true;
+    }
+
+    --m_pendingWrites;
+    if (m_merged && m_pendingWrites == 0) batchDone();
+}
+
 void BatchHDRDialog::error_while_loading(const QString &message) {
     qDebug() << message;
     m_Ui->textEdit->append(tr("Error: ") + message);
@@ -36,7 +36,7 @@
 #include "LibpfsAdditions/formathelper.h"
 
 // Forward declaration
-class IOWorker;
+class IOService;
 class HdrCreationManager;
 
 namespace Ui {
@@ -75,9 +75,14 @@ class BatchHDRDialog : public QDialog {
     void updateThresholdSpinBox(double);
     void ais_failed(QProcess::ProcessError);
     void createHdrFinished();
+    //! \brief \a filename has been written (or not), from the IOService
+    void hdrWritten(const QString &filename, bool status);
     void loadFilesAborted();
 
    protected:
+    //! \brief shows the outcome, once every HDR is merged and written
+    void batchDone();
+
     // Application-wide settings, loaded via QSettings
     QString m_batchHdrInputDir;
     QString m_batchHdrOutputDir;
@@ -85,7 +90,8 @@ class BatchHDRDialog : public QDialog {
 
     QStringList m_bracketed;
     QString m_output_file_name_base;
-    IOWorker *m_IO_Worker;
+    // writes the HDRs while the next bracket is merged
+    QScopedPointer<IOService> m_io_service;
     HdrCreationManager *m_hdrCreationManager;
     int m_numProcessed;
     int m_processed;
@@ -94,6 +100,10 @@ class BatchHDRDialog : public QDialog {
     bool m_loading_error;
     bool m_abort;
     bool m_processing;
+    //! \brief HDRs posted to the IOService and not reported by hdrWritten()
+    int m_pendingWrites;
+    //! \brief every bracket has been merged
+    bool m_merged;
     QVector<FusionOperatorConfig> m_customConfig;
     QFutureWatcher<void> m_futureWatcher;
     QFuture<pfs::Frame *> m_future;
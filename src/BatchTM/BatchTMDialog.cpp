@@ -27,14 +27,17 @@
  *
  */
 
+#include <algorithm>
 #include <cassert>
 #include <climits>
 
+#include <QFile>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QTextStream>
+#include <QThread>
 
 #include <BatchTM/BatchTMDialog.h>
 #include <BatchTM/ui_BatchTMDialog.h>
@@ -42,8 +45,10 @@
 #include <BatchTM/BatchTMJob.h>
 #include <UI/SavedParametersDialog.h>
 #include <Common/config.h>
+#include <Core/IOService.h>
 #include <Core/TonemappingOptions.h>
 #include <Exif/ExifOperations.h>
+#include <Libpfs/io/framereaderfactory.h>
 #include <OsIntegration/osintegration.h>
 
 BatchTMDialog::BatchTMDialog(QWidget *p, QSqlDatabase db)
@@ -248,11 +253,26 @@ void BatchTMDialog::out_folder_clicked() {
 
 void BatchTMDialog::add_view_model_HDRs(const QStringList &list) {
     for (int idx = 0; idx < list.size(); ++idx) {
+        // reject unreadable files up front: only their header is read
+        pfs::io::FrameInfo info;
+        try {
+            info = pfs::io::FrameReaderFactory::probe(
+                QFile::encodeName(list.at(idx)).constData());
+        } catch (std::exception &e) {
+            add_log_message(tr("Skipping %1: %2")
+                                .arg(QFileInfo(list.at(idx)).fileName(),
+                                     QString::fromLocal8Bit(e.what())));
+            continue;
+        }
+
         // fill graphical list
         QListWidgetItem *item = new QListWidgetItem();
         item->setData(Qt::DisplayRole, QFileInfo(list.at(idx)).fileName());
         item->setData(Qt::UserRole + 1,
                       QFileInfo(list.at(idx)).absoluteFilePath());
+        item->setData(Qt::ToolTipRole, QStringLiteral("%1 x %2")
+                                           .arg(info.width)
+                                           .arg(info.height));
         m_Ui->listWidget_HDRs->addItem(item);
     }
     // HDRs_list += list;
@@ -371,6 +391,12 @@ void BatchTMDialog::batch_core() {
                          ->data(Qt::UserRole + 1)
                          .toString();
     }
+    // each job takes its HDR from here: the next ones are read while the
+    // current ones are tone mapped
+    m_io_service.reset(new IOService(
+        static_cast<qint64>(LuminanceOptions().getBatchIOMemoryBudget()) << 20,
+        m_max_num_threads));
+    m_io_service->prefetch(HDRs_list, m_max_num_threads);
     start_batch_thread();  // kick off the conversion!
 }
 
@@ -397,10 +423,17 @@ void BatchTMDialog::start_batch_thread() {
             // need to store its pointer somewhere
             QString fileExtension = m_formatHelper.getFileExtension();
 
+            // the jobs and their writers run side by side, on threads the
+            // writers cannot tell from the main one: share the cores out
+            pfs::Params params = m_formatHelper.getParams();
+            params.set("threads",
+                       std::max(1, QThread::idealThreadCount() /
+                                       m_max_num_threads));
+
             BatchTMJob *job_thread = new BatchTMJob(
-                t_id, HDRs_list.at(m_next_hdr_file), &m_tm_options_list,
-                m_Ui->out_folder_widgets->text(), fileExtension,
-                m_formatHelper.getParams());
+                t_id, m_io_service.data(), m_next_hdr_file,
+                HDRs_list.at(m_next_hdr_file), &m_tm_options_list,
+                m_Ui->out_folder_widgets->text(), fileExtension, params);
 
             // Thread deletes itself when it has done with its job
             connect(job_thread, &QThread::finished, job_thread,
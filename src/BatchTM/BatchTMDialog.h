@@ -31,6 +31,7 @@
 #include <QDialog>
 #include <QFuture>
 #include <QMutex>
+#include <QScopedPointer>
 #include <QSemaphore>
 #include <QSortFilterProxyModel>
 #include <QStringListModel>
@@ -43,6 +44,7 @@
 #include "Common/LuminanceOptions.h"
 
 // Forward declaration
+class IOService;
 class TonemappingOptions;
 
 namespace Ui {
@@ -118,6 +120,8 @@ class BatchTMDialog : public QDialog {
     bool m_abort;
     QSqlDatabase m_db;
     int m_next_hdr_file;
+    // reads the HDRs ahead of the jobs, writes their outputs
+    QScopedPointer<IOService> m_io_service;
 
     pfsadditions::FormatHelper m_formatHelper;
 
@@ -27,7 +27,9 @@
 #include <QDebug>
 #include <QFileInfo>
 #include <QImage>
+#include <QPair>
 #include <QScopedPointer>
+#include <QSharedPointer>
 
 #include <BatchTM/BatchTMJob.h>
 #include <Exif/ExifOperations.h>
@@ -39,13 +41,17 @@
 #include <Libpfs/tm/TonemapOperator.h>
 
 #include <Common/LuminanceOptions.h>
+#include <Core/IOService.h>
 #include <Core/IOWorker.h>
 
-BatchTMJob::BatchTMJob(int thread_id, const QString &filename,
+BatchTMJob::BatchTMJob(int thread_id, IOService *io_service, int index,
+                       const QString &filename,
                        const QList<TonemappingOptions *> *tm_options,
                        const QString &output_folder, const QString &format,
                        pfs::Params params)
     : m_thread_id(thread_id),
+      m_io_service(io_service),
+      m_index(index),
       m_file_name(filename),
       m_tm_options(tm_options),
       m_output_folder(output_folder),
@@ -61,15 +67,13 @@ BatchTMJob::~BatchTMJob() {}
 
 void BatchTMJob::run() {
     pfs::Progress prog_helper;
-    IOWorker io_worker;
 
     emit add_log_message(tr("[T%1] Start processing %2")
                              .arg(m_thread_id)
                              .arg(QFileInfo(m_file_name).fileName()));
 
-    // reference frame
-    QScopedPointer<pfs::Frame> reference_frame(
-        io_worker.read_hdr_frame(m_file_name));
+    // reference frame (read ahead by the IOService)
+    QScopedPointer<pfs::Frame> reference_frame(m_io_service->take(m_index));
 
     if (!reference_frame.isNull()) {
         // update message box
@@ -80,6 +84,10 @@ void BatchTMJob::run() {
         // update progress bar!
         emit increment_progress_bar(1);
 
+        // outputs being written: ticket and file name
+        QList<QPair<int, QString>> writes;
+        bool failed = false;
+
         for (int idx = 0; idx < m_tm_options->size(); ++idx) {
             TonemappingOptions *opts = m_tm_options->at(idx);
 
@@ -106,38 +114,56 @@ void BatchTMJob::run() {
             try {
                 tm_operator->tonemapFrame(*temporary_frame, opts, prog_helper);
             } catch (...) {
-                emit add_log_message(
-                    tr("[T%1] ERROR: Failed to tonemap file: %2")
-                        .arg(m_thread_id)
-                        .arg(QFileInfo(m_file_name).fileName()));
-                emit increment_progress_bar(m_tm_options->size() + 1);
-                emit done(m_thread_id);
-                return;
+                failed = true;
+                break;
             }
 
             QString output_file_name = m_output_file_name_base + "_" +
                                        opts->getPostfix() + "." +
                                        m_ldr_output_format;
 
-            if (io_worker.write_ldr_frame(
-                    temporary_frame.data(), output_file_name,
-                    "FromHdrFile",  // inform we tonemapped an
-                                    // existing HDR with no exif
-                                    // data
-                    QVector<float>(), opts, m_params)) {
+            // the writer keeps its own copy of the options: the next job
+            // changes them
+            QSharedPointer<pfs::Frame> output(temporary_frame.take());
+            QSharedPointer<TonemappingOptions> output_opts(
+                new TonemappingOptions(*opts));
+            const pfs::Params params = m_params;
+            const int ticket = m_io_service->write(
+                [output, output_file_name, output_opts, params]() {
+                    return IOWorker().write_ldr_frame(
+                        output.data(), output_file_name,
+                        "FromHdrFile",  // inform we tonemapped an
+                                        // existing HDR with no exif
+                                        // data
+                        QVector<float>(), output_opts.data(), params);
+                },
+                IOService::frameBytes(*output));
+            writes.append(qMakePair(ticket, output_file_name));
+        }
+
+        // every ticket must be waited for, even after a failure
+        for (int idx = 0; idx < writes.size(); ++idx) {
+            if (m_io_service->wait(writes.at(idx).first)) {
                 emit add_log_message(
                     tr("[T%1] Successfully saved LDR file: %2")
                         .arg(m_thread_id)
-                        .arg(QFileInfo(output_file_name).fileName()));
+                        .arg(QFileInfo(writes.at(idx).second).fileName()));
             } else {
                 emit add_log_message(
                     tr("[T%1] ERROR: Cannot save to file: %2")
                         .arg(m_thread_id)
-                        .arg(QFileInfo(output_file_name).fileName()));
+                        .arg(QFileInfo(writes.at(idx).second).fileName()));
             }
 
             emit increment_progress_bar(1);
         }
+
+        if (failed) {
+            emit add_log_message(tr("[T%1] ERROR: Failed to tonemap file: %2")
+                                     .arg(m_thread_id)
+                                     .arg(QFileInfo(m_file_name).fileName()));
+            emit increment_progress_bar(m_tm_options->size() - writes.size());
+        }
     } else {
         // update message box
         // emit add_log_message(error_message);
@@ -149,5 +175,9 @@ void BatchTMJob::run() {
         emit increment_progress_bar(m_tm_options->size() + 1);
     }
 
+    // the next inputs can be read ahead in its place
+    reference_frame.reset();
+    m_io_service->release(m_index);
+
     emit done(m_thread_id);
 }
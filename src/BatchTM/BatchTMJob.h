@@ -36,12 +36,16 @@
 #include <Libpfs/params.h>
 
 // Forward declaration
+class IOService;
 class TonemappingOptions;
 
 class BatchTMJob : public QThread {
     Q_OBJECT
    public:
-    BatchTMJob(int thread_id, const QString &filename,
+    //! \brief tone maps input \a index of \a io_service (\a filename), the
+    //! outputs are written by \a io_service while the next one is computed
+    BatchTMJob(int thread_id, IOService *io_service, int index,
+               const QString &filename,
                const QList<TonemappingOptions *> *tm_options,
                const QString &output_folder, const QString &ldr_output_format,
                pfs::Params params);
@@ -57,6 +61,8 @@ class BatchTMJob : public QThread {
 
    private:
     int m_thread_id;
+    IOService *m_io_service;
+    int m_index;
     QString m_file_name;
     const QList<TonemappingOptions *> *m_tm_options;
     QString m_output_folder;
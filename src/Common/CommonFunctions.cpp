@@ -40,6 +40,7 @@
 #include <Libpfs/io/framereaderfactory.h>
 #include <Libpfs/io/framewriter.h>
 #include <Libpfs/io/framewriterfactory.h>
+#include <Libpfs/io/rawreader.h>
 #include <Libpfs/io/tiffreader.h>
 #include <Libpfs/io/tiffwriter.h>
 #include <Libpfs/manip/copy.h>
@@ -278,8 +279,20 @@ void LoadFile::operator()(HdrCreationItem &currentItem) {
         qDebug() << QStringLiteral("LoadFile: Loading data for %1")
                         .arg(filePath.constData());
 
+        pfs::Params params = getRawSettings();
+        if (m_halfFloat) {
+            params.set("half_storage", true);
+        }
+        const bool preview = !m_rawPreview.empty() && m_rawPreview != "none";
+        if (preview) {
+            params.set("raw.preview", m_rawPreview);
+        }
+
         FrameReaderPtr reader = FrameReaderFactory::open(filePath.constData());
-        reader->read(*currentItem.frame(), getRawSettings());
+        reader->read(*currentItem.frame(), params);
+        // only the raw reader knows about previews
+        currentItem.setPreview(preview &&
+                               dynamic_cast<RAWReader *>(reader.get()));
 
         // read Average Luminance
         pfs::exif::ExifData exifData(currentItem.filename().toStdString());
@@ -351,6 +364,12 @@ void LoadFile::operator()(HdrCreationItem &currentItem) {
         }
 
         currentItem.qimage().swap(tempImage);
+
+        // the thumbnail has been built: from now on the frame is only held
+        // until the HDR gets merged
+        if (m_halfFloat) {
+            currentItem.frame()->pack();
+        }
     } catch (std::runtime_error &err) {
         qDebug() << QStringLiteral("LoadFile: Cannot load %1: %2")
                         .arg(currentItem.filename(),
@@ -27,6 +27,8 @@
 #include <QImage>
 #include <QString>
 
+#include <string>
+
 #include <HdrCreation/fusionoperator.h>
 #include <HdrWizard/HdrCreationItem.h>
 #include <Libpfs/utils/minmax.h>
@@ -132,7 +134,15 @@ struct ConvertToQRgb {
 };
 
 struct LoadFile {
-    explicit LoadFile(bool fromFITS = false) : m_datamax(0.f), m_datamin(0.f) {
+    //! \param halfFloat keep the loaded frame as 16-bit floats
+    //! \param rawPreview raw.preview mode of raw files ("half",
+    //! "thumbnail"), empty (or "none") for the full decode
+    explicit LoadFile(bool fromFITS = false, bool halfFloat = false,
+                      const std::string &rawPreview = std::string())
+        : m_datamax(0.f),
+          m_datamin(0.f),
+          m_halfFloat(halfFloat),
+          m_rawPreview(rawPreview) {
         m_fromFITS = fromFITS;
     }
     void operator()(HdrCreationItem &currentItem);
@@ -140,6 +150,8 @@ struct LoadFile {
     float m_datamax;
     float m_datamin;
     bool m_fromFITS;
+    bool m_halfFloat;
+    std::string m_rawPreview;
 };
 
 struct SaveFile {
@@ -40,8 +40,11 @@
 #include <QString>
 #include <QStyleFactory>
 
+#include <algorithm>
+
 #include "Common/LuminanceOptions.h"
 #include "Common/config.h"
+#include "Libpfs/utils/bufferpool.h"
 
 #if defined(Q_OS_WIN)
 const QString LuminanceOptions::LUMINANCE_HDR_HOME_FOLDER = "LuminanceHDR";
@@ -617,6 +620,62 @@ void LuminanceOptions::setBatchTmNumThreads(int v) {
     m_settingHolder->setValue(KEY_BATCH_TM_NUM_THREADS, v);
 }
 
+int LuminanceOptions::getBatchIOMemoryBudget() {
+    return m_settingHolder->value(KEY_BATCH_IO_MEMORY_BUDGET, 2048).toInt();
+}
+
+void LuminanceOptions::setBatchIOMemoryBudget(int megabytes) {
+    m_settingHolder->setValue(KEY_BATCH_IO_MEMORY_BUDGET, megabytes);
+}
+
+int LuminanceOptions::getOutOfCoreThreshold() {
+    return m_settingHolder->value(KEY_OUT_OF_CORE_THRESHOLD, 0).toInt();
+}
+
+void LuminanceOptions::setOutOfCoreThreshold(int v) {
+    m_settingHolder->setValue(KEY_OUT_OF_CORE_THRESHOLD, v);
+}
+
+int LuminanceOptions::getBufferCacheSize() {
+    return m_settingHolder
+        ->value(KEY_BUFFER_CACHE_SIZE,
+                static_cast<int>(
+                    pfs::utils::BufferPool::DEFAULT_MAX_CACHED_BYTES >> 20))
+        .toInt();
+}
+
+void LuminanceOptions::setBufferCacheSize(int v) {
+    m_settingHolder->setValue(KEY_BUFFER_CACHE_SIZE, v);
+}
+
+bool LuminanceOptions::isExrMipmap() {
+    return m_settingHolder->value(KEY_EXR_MIPMAP, true).toBool();
+}
+
+void LuminanceOptions::setExrMipmap(const bool b) {
+    m_settingHolder->setValue(KEY_EXR_MIPMAP, b);
+}
+
+bool LuminanceOptions::isPfsMmap() {
+    return m_settingHolder->value(KEY_PFS_MMAP, false).toBool();
+}
+
+void LuminanceOptions::setPfsMmap(const bool b) {
+    m_settingHolder->setValue(KEY_PFS_MMAP, b);
+}
+
+void LuminanceOptions::applyMemorySettings() {
+    pfs::utils::BufferPool &pool = pfs::utils::BufferPool::instance();
+
+    const size_t threshold =
+        static_cast<size_t>(std::max(getOutOfCoreThreshold(), 0)) << 20;
+    pool.setMapThreshold(threshold,
+                         QFile::encodeName(getTempDir()).constData());
+    const size_t cacheSize =
+        static_cast<size_t>(std::max(getBufferCacheSize(), 0)) << 20;
+    pool.setMaxCachedBytes(cacheSize);
+}
+
 namespace {
 #ifdef QT_DEBUG
 struct PrintTempDir {
@@ -719,6 +778,31 @@ void LuminanceOptions::setShowMissingEVsWarning(const bool b) {
     m_settingHolder->setValue(KEY_WIZARD_SHOW_MISSING_EVS_WARNING, b);
 }
 
+bool LuminanceOptions::isHalfFloatInputs() {
+    return m_settingHolder->value(KEY_WIZARD_HALF_FLOAT_INPUTS, false)
+        .toBool();
+}
+
+void LuminanceOptions::setHalfFloatInputs(const bool b) {
+    m_settingHolder->setValue(KEY_WIZARD_HALF_FLOAT_INPUTS, b);
+}
+
+QString LuminanceOptions::getRawPreview() {
+    return m_settingHolder->value(KEY_WIZARD_RAW_PREVIEW, "half").toString();
+}
+
+void LuminanceOptions::setRawPreview(const QString &mode) {
+    m_settingHolder->setValue(KEY_WIZARD_RAW_PREVIEW, mode);
+}
+
+int LuminanceOptions::getLoadMemoryBudget() {
+    return m_settingHolder->value(KEY_WIZARD_LOAD_MEMORY_BUDGET, 4096).toInt();
+}
+
+void LuminanceOptions::setLoadMemoryBudget(int megabytes) {
+    m_settingHolder->setValue(KEY_WIZARD_LOAD_MEMORY_BUDGET, megabytes);
+}
+
 QString LuminanceOptions::getDefaultPathTmoSettings() {
     return m_settingHolder
         ->value(KEY_RECENT_PATH_LOAD_SAVE_TMO_SETTINGS, QDir::currentPath())
@@ -184,6 +184,11 @@ class LuminanceOptions : public QObject {
     int getNumThreads() { return getBatchTmNumThreads(); }
     void setNumThreads(int i) { setBatchTmNumThreads(i); }
 
+    // memory (in MB) the batch tools can hold in frames read ahead or
+    // waiting to be written
+    int getBatchIOMemoryBudget();
+    void setBatchIOMemoryBudget(int megabytes);
+
     // Default Paths
     // Path to save temporary cached files
     QString getTempDir();
@@ -194,6 +199,22 @@ class LuminanceOptions : public QObject {
     QString getDefaultPathTmoSettings();
 
     void setTempDir(const QString &);
+
+    // Images larger than this (in MB, per channel) are kept in scratch files
+    // of the temporary directory. 0 (the default) keeps everything in RAM.
+    int getOutOfCoreThreshold();
+    void setOutOfCoreThreshold(int);
+    // Memory (in MB) of released image buffers kept for reuse
+    int getBufferCacheSize();
+    void setBufferCacheSize(int);
+    // OpenEXR images are saved with mipmap levels for fast previews
+    bool isExrMipmap();
+    void setExrMipmap(const bool b);
+    // PFS files are mapped in memory instead of being read and written
+    bool isPfsMmap();
+    void setPfsMmap(const bool b);
+    //! \brief hand the out-of-core and buffer cache settings over to Libpfs
+    void applyMemorySettings();
     void setDefaultPathHdrIn(const QString &);
     void setDefaultPathHdrOut(const QString &);
     void setDefaultPathLdrIn(const QString &);  // HdrWizard
@@ -211,6 +232,19 @@ class LuminanceOptions : public QObject {
     bool isShowMissingEVsWarning();
     void setShowMissingEVsWarning(const bool b);
 
+    // keep the loaded brackets as 16-bit floats (Preferences > Tone Mapping)
+    bool isHalfFloatInputs();
+    void setHalfFloatInputs(const bool b);
+
+    // raw files are loaded as previews ("half", "thumbnail" or "none") and
+    // fully decoded only when the HDR gets merged
+    QString getRawPreview();
+    void setRawPreview(const QString &mode);
+
+    // memory (in MB) the decoders of a bracket can take at the same time
+    int getLoadMemoryBudget();
+    void setLoadMemoryBudget(int megabytes);
+
     // MainWindow
     int getMainWindowToolBarMode();
     void setMainWindowToolBarMode(int);
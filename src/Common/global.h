@@ -34,6 +34,10 @@
 
 enum InterpolationMethod { LanczosInterp, BilinearInterp };
 
+//! \brief width of the reduced copy of an HDR image the previews of the tone
+//! mapping operators are computed from
+const int HDR_PREVIEW_WIDTH = 1200;
+
 bool matchesLdrFilename(const QString &file);
 bool matchesHdrFilename(const QString &file);
 bool matchesValidHDRorLDRfilename(const QString &file);
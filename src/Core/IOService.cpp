@@ -0,0 +1,270 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Core/IOService.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <QDebug>
+#include <QFile>
+#include <QMutexLocker>
+#include <QRunnable>
+
+#include <Core/IOWorker.h>
+#include <Libpfs/channel.h>
+#include <Libpfs/frame.h>
+
+namespace {
+
+// QRunnable::create() is Qt 5.15 only
+class Task : public QRunnable {
+   public:
+    explicit Task(const std::function<void()> &task) : m_task(task) {}
+
+    void run() { m_task(); }
+
+   private:
+    std::function<void()> m_task;
+};
+
+pfs::Frame *readHdrFrame(const QString &filename) {
+    return IOWorker().read_hdr_frame(filename);
+}
+
+// the reads of readAhead()
+const qint64 READ_AHEAD_CHUNK = 1 << 20;
+}
+
+IOService::IOService(qint64 memoryBudget, int writers)
+    : m_budget(std::max<qint64>(memoryBudget, 0)),
+      m_held(0),
+      m_depth(0),
+      m_nextRead(0),
+      m_ahead(0),
+      m_reading(0),
+      m_wanted(-1),
+      m_estimate(0),
+      m_nextTicket(0),
+      m_writing(0) {
+    m_writers.setMaxThreadCount(std::max(writers, 1));
+}
+
+IOService::~IOService() {
+    {
+        // no new reads
+        QMutexLocker lock(&m_mutex);
+        m_nextRead = static_cast<int>(m_inputs.size());
+    }
+    m_readers.waitForDone();
+    m_writers.waitForDone();
+
+    QMutexLocker lock(&m_mutex);
+    clearInputs();
+}
+
+qint64 IOService::frameBytes(const pfs::Frame &frame) {
+    return static_cast<qint64>(frame.getChannels().size()) *
+           frame.getWidth() * frame.getHeight() * sizeof(float);
+}
+
+void IOService::prefetch(const QStringList &files, int depth,
+                         const Reader &reader) {
+    {
+        QMutexLocker lock(&m_mutex);
+        m_nextRead = static_cast<int>(m_inputs.size());
+    }
+    m_readers.waitForDone();
+
+    QMutexLocker lock(&m_mutex);
+    clearInputs();
+
+    m_files = files;
+    m_reader = reader ? reader : Reader(&readHdrFrame);
+    m_depth = std::max(depth, 1);
+    m_inputs.assign(files.size(), Input());
+    m_nextRead = 0;
+    m_ahead = 0;
+    m_wanted = -1;
+    m_estimate = 0;
+    m_readers.setMaxThreadCount(m_depth);
+
+    schedule();
+}
+
+void IOService::schedule() {
+    while (m_nextRead < static_cast<int>(m_inputs.size())) {
+        const bool wanted = m_nextRead <= m_wanted;
+        // without an estimate, a read at a time
+        const bool fits =
+            m_ahead < m_depth &&
+            (m_estimate > 0 ? m_held == 0 || m_held + m_estimate <= m_budget
+                            : m_reading == 0);
+        if (!wanted && !fits) break;
+
+        const int index = m_nextRead++;
+        Input &input = m_inputs[index];
+        input.state = INPUT_READING;
+        input.bytes = m_estimate;
+        m_held += input.bytes;
+        ++m_ahead;
+        ++m_reading;
+
+        m_readers.start(new Task([this, index]() { read(index); }));
+    }
+}
+
+void IOService::read(int index) {
+    pfs::Frame *frame = NULL;
+    try {
+        frame = m_reader(m_files.at(index));
+    } catch (std::exception &e) {
+        qDebug() << "IOService: cannot read" << m_files.at(index) << e.what();
+    }
+
+    QMutexLocker lock(&m_mutex);
+    Input &input = m_inputs[index];
+    m_held -= input.bytes;
+    input.state = INPUT_READY;
+    --m_reading;
+    input.frame = frame;
+    input.bytes = frame ? frameBytes(*frame) : 0;
+    m_held += input.bytes;
+    if (frame) m_estimate = input.bytes;
+
+    schedule();
+    m_changed.wakeAll();
+}
+
+pfs::Frame *IOService::take(int index) {
+    QMutexLocker lock(&m_mutex);
+    if (index < 0 || index >= static_cast<int>(m_inputs.size()) ||
+        m_inputs[index].state == INPUT_TAKEN ||
+        m_inputs[index].state == INPUT_RELEASED) {
+        return NULL;
+    }
+
+    m_wanted = std::max(m_wanted, index);
+    schedule();
+    while (m_inputs[index].state != INPUT_READY) {
+        m_changed.wait(&m_mutex);
+    }
+
+    Input &input = m_inputs[index];
+    pfs::Frame *frame = input.frame;
+    input.state = INPUT_TAKEN;
+    input.frame = NULL;
+    --m_ahead;
+
+    schedule();
+    m_changed.wakeAll();
+    return frame;
+}
+
+void IOService::release(int index) {
+    QMutexLocker lock(&m_mutex);
+    if (index < 0 || index >= static_cast<int>(m_inputs.size()) ||
+        m_inputs[index].state != INPUT_TAKEN) {
+        return;
+    }
+
+    Input &input = m_inputs[index];
+    input.state = INPUT_RELEASED;
+    m_held -= input.bytes;
+    input.bytes = 0;
+
+    schedule();
+    m_changed.wakeAll();
+}
+
+void IOService::clearInputs() {
+    for (size_t idx = 0; idx < m_inputs.size(); ++idx) {
+        m_held -= m_inputs[idx].bytes;
+        delete m_inputs[idx].frame;
+    }
+    m_inputs.clear();
+    m_files.clear();
+}
+
+void IOService::readAhead(const QStringList &files) {
+    m_readers.start(new Task([files]() {
+        foreach (const QString &filename, files) {
+            QFile file(filename);
+            if (!file.open(QIODevice::ReadOnly)) continue;
+            while (!file.read(READ_AHEAD_CHUNK).isEmpty()) {
+            }
+        }
+    }));
+}
+
+int IOService::write(const Writer &writer, qint64 bytes) {
+    return startWrite(writer, bytes, true);
+}
+
+void IOService::post(const Writer &writer, qint64 bytes) {
+    startWrite(writer, bytes, false);
+}
+
+int IOService::startWrite(const Writer &writer, qint64 bytes, bool keep) {
+    QMutexLocker lock(&m_mutex);
+    // only writes in flight free memory here: waiting for the inputs read
+    // ahead would dead-lock a caller that also takes them
+    while (m_writing > 0 && m_held + bytes > m_budget) {
+        m_changed.wait(&m_mutex);
+    }
+
+    const int ticket = m_nextTicket++;
+    m_held += bytes;
+    ++m_writing;
+
+    m_writers.start(new Task([this, writer, bytes, keep, ticket]() {
+        bool status = false;
+        try {
+            status = writer();
+        } catch (std::exception &e) {
+            qDebug() << "IOService: write failed" << e.what();
+        }
+
+        QMutexLocker lock(&m_mutex);
+        m_held -= bytes;
+        --m_writing;
+        if (keep) m_results.insert(ticket, status);
+
+        schedule();
+        m_changed.wakeAll();
+    }));
+    return ticket;
+}
+
+bool IOService::wait(int ticket) {
+    QMutexLocker lock(&m_mutex);
+    while (!m_results.contains(ticket)) {
+        m_changed.wait(&m_mutex);
+    }
+    return m_results.take(ticket);
+}
+
+void IOService::waitForWrites() {
+    QMutexLocker lock(&m_mutex);
+    while (m_writing > 0) {
+        m_changed.wait(&m_mutex);
+    }
+}
@@ -0,0 +1,150 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Asynchronous I/O for the batch tools (Batch TM, Batch HDR and the
+//! command line)
+
+#ifndef IOSERVICE_H
+#define IOSERVICE_H
+
+#include <functional>
+#include <vector>
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+namespace pfs {
+class Frame;
+}
+
+//! \brief Reads the next inputs of a list while the caller works on the
+//! current one, and writes outputs on writer threads.
+//!
+//! Frames read ahead, frames taken and not yet released and frames waiting to
+//! be written share one memory budget: no new input is read ahead, and
+//! write() blocks, while the budget is exhausted. An input somebody is
+//! waiting for in take() is always read. The size of the inputs is not known
+//! before the first of them is read: until then they are read one at a time.
+class IOService {
+   public:
+    //! \brief decodes a file, returns NULL on failure
+    typedef std::function<pfs::Frame *(const QString &)> Reader;
+    //! \brief writes an output, returns false on failure
+    typedef std::function<bool()> Writer;
+
+    //! \param memoryBudget bytes of frames the service holds at once
+    //! \param writers number of writer threads
+    explicit IOService(qint64 memoryBudget, int writers = 1);
+    //! \brief waits for every read and write
+    ~IOService();
+
+    //! \brief starts reading \a files in order, up to \a depth of them ahead
+    //! of take(). The default \a reader is IOWorker::read_hdr_frame.
+    void prefetch(const QStringList &files, int depth,
+                  const Reader &reader = Reader());
+
+    //! \brief waits for input \a index of prefetch() and hands it over.
+    //! The frame is charged to the budget until release(\a index).
+    //! \return NULL if it cannot be read. Each input can be taken once.
+    pfs::Frame *take(int index);
+    //! \brief the frame of take(\a index) has been deleted
+    void release(int index);
+
+    //! \brief reads \a files on a reader thread and drops their content, so
+    //! that decoding them later hits the cache of the operating system
+    void readAhead(const QStringList &files);
+
+    //! \brief runs \a writer on a writer thread: \a bytes is the memory it
+    //! holds until it is done
+    //! \return a ticket for wait(): every ticket must be waited for
+    int write(const Writer &writer, qint64 bytes);
+    //! \brief same as write(), for writers that report on their own
+    void post(const Writer &writer, qint64 bytes);
+
+    //! \return the result of the write of \a ticket, once it is done
+    bool wait(int ticket);
+    //! \brief waits for every write
+    void waitForWrites();
+
+    //! \return memory held by \a frame
+    static qint64 frameBytes(const pfs::Frame &frame);
+
+   private:
+    Q_DISABLE_COPY(IOService)
+
+    enum InputState {
+        INPUT_QUEUED,
+        INPUT_READING,
+        INPUT_READY,
+        INPUT_TAKEN,
+        INPUT_RELEASED
+    };
+
+    struct Input {
+        Input() : state(INPUT_QUEUED), frame(NULL), bytes(0) {}
+
+        InputState state;
+        pfs::Frame *frame;
+        qint64 bytes;
+    };
+
+    //! \brief starts the reads allowed by depth and budget (locked)
+    void schedule();
+    void read(int index);
+    //! \brief drops the inputs nobody took (locked)
+    void clearInputs();
+    int startWrite(const Writer &writer, qint64 bytes, bool keep);
+
+    QMutex m_mutex;
+    QWaitCondition m_changed;
+    QThreadPool m_readers;
+    QThreadPool m_writers;
+
+    const qint64 m_budget;
+    //! \brief bytes of inputs read ahead or taken and of outputs not yet
+    //! written
+    qint64 m_held;
+
+    QStringList m_files;
+    Reader m_reader;
+    int m_depth;
+    std::vector<Input> m_inputs;
+    int m_nextRead;
+    //! \brief inputs read (or being read) and not taken yet
+    int m_ahead;
+    //! \brief inputs being read
+    int m_reading;
+    //! \brief highest index waited for in take()
+    int m_wanted;
+    //! \brief size of the last frame read, used as estimate of the next one
+    //! (0 before the first one)
+    qint64 m_estimate;
+
+    int m_nextTicket;
+    int m_writing;
+    QMap<int, bool> m_results;
+};
+
+#endif  // IOSERVICE_H
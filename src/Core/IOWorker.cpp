@@ -33,12 +33,14 @@
 #include <QByteArray>
 #include <QDebug>
 #include <QFileInfo>
+#include <QMetaMethod>
 #include <QScopedPointer>
 #include <QString>
 
 #include <Core/IOWorker.h>
 #include <Libpfs/frame.h>
 #include <Common/LuminanceOptions.h>
+#include <Common/global.h>
 #include <Core/TonemappingOptions.h>
 #include <Exif/ExifOperations.h>
 #include <Fileformat/pfsoutldrimage.h>
@@ -93,6 +95,13 @@ bool IOWorker::write_hdr_frame(pfs::Frame *hdr_frame, const QString &filename,
     if (!writerParams.count("tiff_mode")) {
         writerParams.set("tiff_mode", 2);
     }
+    // mipmap levels let read_hdr_frame() show the image at once
+    if (!writerParams.count("exr_mipmap")) {
+        writerParams.set("exr_mipmap", LuminanceOptions().isExrMipmap());
+    }
+    if (!writerParams.count("pfs_mmap")) {
+        writerParams.set("pfs_mmap", LuminanceOptions().isPfsMmap());
+    }
 
     try {
         FrameWriterPtr writer =
@@ -228,7 +237,8 @@ bool IOWorker::write_ldr_frame(pfs::Frame *ldr_input, const QString &filename,
     return status;
 }
 
-pfs::Frame *IOWorker::read_hdr_frame(const QString &filename) {
+pfs::Frame *IOWorker::read_hdr_frame(const QString &filename,
+                                     const pfs::Params &readerParams) {
     emit IO_init();
 
     if (filename.isEmpty()) {
@@ -248,8 +258,23 @@ pfs::Frame *IOWorker::read_hdr_frame(const QString &filename) {
         QByteArray encodedFileName = QFile::encodeName(qfi.absoluteFilePath());
 
         pfs::Params params = getRawSettings();
+        params.set("pfs_mmap", LuminanceOptions().isPfsMmap());
+        for (pfs::Params::const_iterator it = readerParams.begin(),
+                                         itEnd = readerParams.end();
+             it != itEnd; ++it) {
+            params.set(it->first, it->second);
+        }
         FrameReaderPtr reader =
             FrameReaderFactory::open(encodedFileName.constData());
+        // files storing reduced levels give the previews a head start
+        if (reader->hasScaledLevels() &&
+            reader->width() >= 2 * static_cast<size_t>(HDR_PREVIEW_WIDTH) &&
+            isSignalConnected(
+                QMetaMethod::fromSignal(&IOWorker::read_hdr_preview))) {
+            QScopedPointer<pfs::Frame> preview(new pfs::Frame());
+            reader->readScaled(*preview, HDR_PREVIEW_WIDTH, params);
+            emit read_hdr_preview(preview.take(), filename);
+        }
         reader->read(*hdrpfsframe, params);
         reader->close();
     } catch (pfs::io::UnsupportedFormat &exUnsupported) {
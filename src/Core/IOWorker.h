@@ -72,7 +72,9 @@ class IOWorker : public QObject {
     ~IOWorker();
 
    public Q_SLOTS:
-    pfs::Frame *read_hdr_frame(const QString &filename);
+    //! \brief \a params are handed to the reader on top of the settings
+    pfs::Frame *read_hdr_frame(const QString &filename,
+                               const pfs::Params &params = pfs::Params());
 
     bool write_hdr_frame(pfs::Frame *frame, const QString &filename,
                          const pfs::Params &params = pfs::Params());
@@ -93,6 +95,9 @@ class IOWorker : public QObject {
 
    signals:
     void read_hdr_failed(const QString &);
+    //! \brief reduced copy of a multi-resolution file, sent before
+    //! read_hdr_success(): the receiver owns it
+    void read_hdr_preview(pfs::Frame *, const QString &);
     void read_hdr_success(pfs::Frame *, const QString &);
 
     void write_hdr_failed(const QString &);
@@ -33,8 +33,8 @@
 
 #include <Core/IOWorker.h>
 #include <Libpfs/frame.h>
+#include <Libpfs/frameview.h>
 #include <Libpfs/manip/copy.h>
-#include <Libpfs/manip/cut.h>
 #include <Libpfs/manip/gamma.h>
 #include <Libpfs/manip/resize.h>
 #include <Libpfs/manip/saturation.h>
@@ -179,19 +179,19 @@ pfs::Frame *TMWorker::preprocessFrame(pfs::Frame *input_frame,
                                       InterpolationMethod m) {
     pfs::Frame *working_frame = NULL;
 
+    // the input frame is never modified: the working frame is the only copy
+    // made before tonemapping, and it only holds the pixels that are needed
     if (tm_options->tonemapSelection) {
         // workingframe = "crop"
-        // std::cout << "crop:[" << opts.selection_x_up_left <<", " <<
-        // opts.selection_y_up_left <<"],";
-        // std::cout << "[" << opts.selection_x_bottom_right <<", " <<
-        // opts.selection_y_bottom_right <<"]" << std::endl;
-        working_frame = pfs::cut(input_frame, tm_options->selection_x_up_left,
-                                 tm_options->selection_y_up_left,
-                                 tm_options->selection_x_bottom_right,
-                                 tm_options->selection_y_bottom_right);
+        working_frame = pfs::copy(pfs::FrameView(
+            *input_frame, tm_options->selection_x_up_left,
+            tm_options->selection_y_up_left,
+            tm_options->selection_x_bottom_right,
+            tm_options->selection_y_bottom_right));
     } else if (tm_options->xsize != tm_options->origxsize) {
         // workingframe = "resize"
-        working_frame = pfs::resize(input_frame, tm_options->xsize, m);
+        working_frame =
+            pfs::resize(pfs::FrameView(*input_frame), tm_options->xsize, m);
     } else {
         // workingframe = "full res"
         working_frame = pfs::copy(input_frame);
@@ -27,6 +27,7 @@
 //! \author Davide Anastasia <davideanastasia@users.sourceforge.net>
 
 #include "HdrCreation/debevec.h"
+#include "HdrCreation/fusionblocks.h"
 #include <Libpfs/colorspace/normalizer.h>
 #include <Libpfs/utils/msec_timer.h>
 #include <Libpfs/utils/numeric.h>
@@ -74,184 +75,141 @@ void DebevecOperator::computeFusion(ResponseCurve &response,
 #endif
     assert(images.size() != 0);
 
-    vector<float> times;
+    const int channels = 3;
+    const int length = images.size();
 
     const int W = images[0].frame()->getWidth();
     const int H = images[0].frame()->getHeight();
-
-    for (size_t idx = 0; idx < images.size(); ++idx) {
-        times.push_back(images[idx].averageLuminance());
-    }
-
-    const int channels = 3;
     const size_t size = W * H;
 
-    vector<float> exp_values(times);
-
-    transform(exp_values.begin(), exp_values.end(), exp_values.begin(), logf);
-
-    frame.resize(W, H);
-    Channel *Ch[3];
-    frame.createXYZChannels(Ch[0], Ch[1], Ch[2]);
-    Array2Df *resultCh[channels] = {Ch[0], Ch[1], Ch[2]};
-
-#ifdef _OPENMP
-    #pragma omp parallel for
-#endif
-    for (int c = 0; c < channels; c++) {
-        resultCh[c]->fill(0.f);
-    }
-    Array2Df weight_sum(W, H);
-    weight_sum.fill(0.f);
-
-    int length = images.size();
+    // gather the input channels and the normalization of every exposure.
+    // Input frames are normalized on the fly, inside each block, so that they
+    // are left untouched and no full-frame copy is needed
+    vector<const float *> inputCh(length * channels);
+    vector<Normalizer> normalizers;
+    vector<float> cadd(length);
 
-#ifdef _OPENMP
-    int numthreads = omp_get_max_threads();
-    int nestedthreads = std::max(numthreads / length, 1);
-    bool oldNested = omp_get_nested();
-    if(nestedthreads > 1) {
-        omp_set_nested(true);
-    }
-    #pragma omp parallel for
-#endif
     for (int i = 0; i < length; i++) {
-        Channel *Ch[channels];
-        images[i].frame()->getXYZChannels(Ch[0], Ch[1], Ch[2]);
-        Array2Df *imagesCh[channels] = {Ch[0], Ch[1], Ch[2]};
+        const Channel *Ch[channels];
+        static_cast<const pfs::Frame &>(*images[i].frame())
+            .getXYZChannels(Ch[0], Ch[1], Ch[2]);
 
-        float cmax[3];
-        float cmin[3];
+        float minval = numeric_limits<float>::max();
+        float maxval = numeric_limits<float>::min();
+        for (int c = 0; c < channels; c++) {
+            const float *data = Ch[c]->data();
+            inputCh[i * channels + c] = data;
 #ifdef _OPENMP
-        #pragma omp parallel for num_threads(nestedthreads) if (nestedthreads>1)
+            #pragma omp parallel for reduction(min:minval) reduction(max:maxval)
 #endif
-        for (int c = 0; c < channels; c++) {
-            float minval = numeric_limits<float>::max();
-            float maxval = numeric_limits<float>::min();
             for (size_t k = 0; k < size; k++) {
-                minval = std::min(minval, (*imagesCh[c])(k));
-                maxval = std::max(maxval, (*imagesCh[c])(k));
+                minval = std::min(minval, data[k]);
+                maxval = std::max(maxval, data[k]);
             }
-            cmax[c] = maxval;
-            cmin[c] = minval;
         }
+        normalizers.push_back(Normalizer(minval, maxval));
+        cadd[i] = -logf(images[i].averageLuminance());
+    }
 
-        float Max = max(cmax[0], max(cmax[1], cmax[2]));
-        float Min = min(cmin[0], min(cmin[1], cmin[2]));
+    frame.resize(W, H);
+    Channel *Ch[channels];
+    frame.createXYZChannels(Ch[0], Ch[1], Ch[2]);
+    float *resultCh[channels] = {Ch[0]->data(), Ch[1]->data(), Ch[2]->data()};
 
-#ifdef _OPENMP
-        #pragma omp parallel for num_threads(nestedthreads) if (nestedthreads>1)
-#endif
+    const size_t numBlocks = numFusionBlocks(size);
+    vector<float> blockMax(numBlocks, numeric_limits<float>::min());
+    vector<char> blockInvalid(numBlocks, 0);
+
+    const float cmul = 1.f / channels;
+
+    forEachFusionBlock(size, [&](size_t b, size_t begin, size_t end) {
+        const size_t n = end - begin;
+
+        float acc[channels][FUSION_BLOCK_SIZE] ALIGNED16;
+        float wsum[FUSION_BLOCK_SIZE] ALIGNED16;
+        float w[FUSION_BLOCK_SIZE] ALIGNED16;
+        float r[FUSION_BLOCK_SIZE] ALIGNED16;
+
+        std::fill(wsum, wsum + n, 0.f);
         for (int c = 0; c < channels; c++) {
-            transform(Ch[c]->begin(), Ch[c]->end(), Ch[c]->begin(),
-                      Normalizer(Min, Max));
+            std::fill(acc[c], acc[c] + n, 0.f);
         }
 
-        Array2Df response_img(W, H);
-        Array2Df w(W, H);
+        for (int i = 0; i < length; i++) {
+            const Normalizer &norm = normalizers[i];
+            const float *in[channels] = {inputCh[i * channels] + begin,
+                                         inputCh[i * channels + 1] + begin,
+                                         inputCh[i * channels + 2] + begin};
 
-        float cmul = 1.f / channels;
-#ifdef _OPENMP
-        #pragma omp parallel for num_threads(nestedthreads) if (nestedthreads>1)
-#endif
-        for (size_t k = 0; k < size; k++) {
-            w(k) = cmul * (weight((*imagesCh[0])(k)) + weight((*imagesCh[1])(k)) + weight((*imagesCh[2])(k)));
-        }
-        float cadd = -logf(times.at((int)i));
-        for (int c = 0; c < channels; c++) {
-            #pragma omp parallel for num_threads(nestedthreads) if (nestedthreads>1)
-            for (size_t k = 0; k < size; k++) {
-                (response_img)(k) = response((*imagesCh[c])(k));
+            for (size_t k = 0; k < n; k++) {
+                w[k] = cmul * (weight(norm(in[0][k])) + weight(norm(in[1][k])) +
+                               weight(norm(in[2][k])));
+                wsum[k] += w[k];
             }
+
+            for (int c = 0; c < channels; c++) {
+                for (size_t k = 0; k < n; k++) {
+                    r[k] = response(norm(in[c][k]));
+                }
+
+                size_t k = 0;
 #ifdef __SSE2__
-            vfloat caddv = F2V(cadd);
-#ifdef _OPENMP
-            #pragma omp parallel for num_threads(nestedthreads) if (nestedthreads>1)
-#endif
-            for (size_t k = 0; k < size - 3; k+=4) {
-                STVFU((response_img)(k), (xlogf(LVFU((response_img)(k))) + caddv) * LVFU(w(k)));
-            }
-            for (size_t k = size - (size % 4); k < size; k++) {
-                (response_img)(k) = (xlogf((response_img)(k)) + cadd) * w(k);
+                const vfloat caddv = F2V(cadd[i]);
+                for (; k + 3 < n; k += 4) {
+                    STVF(acc[c][k], LVF(acc[c][k]) +
+                                        (xlogf(LVF(r[k])) + caddv) * LVF(w[k]));
+                }
+#endif
+                for (; k < n; k++) {
+                    acc[c][k] += (xlogf(r[k]) + cadd[i]) * w[k];
+                }
             }
-#else
-#ifdef _OPENMP
-            #pragma omp parallel for num_threads(nestedthreads) if (nestedthreads>1)
-#endif
-            for (size_t k = 0; k < size; k++) {
-                (response_img)(k) = (xlogf((response_img)(k)) + cadd) * w(k);
-            }
-#endif
-
-#ifdef _OPENMP
-            #pragma omp critical
-#endif
-            vadd(resultCh[c], &response_img, resultCh[c], size);
         }
 
-#ifdef _OPENMP
-        #pragma omp critical
-#endif
-        vadd(&weight_sum, &w, &weight_sum, size);
-    }
-#ifdef _OPENMP
-    omp_set_nested(oldNested);
-#endif
-
-    for (int c = 0; c < channels; c++) {
-#ifdef _OPENMP
-        #pragma omp parallel for
-#endif
-        for(int y = 0; y < H; ++y) {
-            int x = 0;
+        // TODO: Investigate why scaling hdr yields better result
+        float maxval = numeric_limits<float>::min();
+        bool invalid = false;
+        for (int c = 0; c < channels; c++) {
+            float *out = resultCh[c] + begin;
+            size_t k = 0;
 #ifdef __SSE2__
-            for(; x < W - 3; x += 4) {
-                STVFU((*resultCh[c])(x, y), xexpf(LVFU((*resultCh[c])(x,y)) / LVFU(weight_sum(x,y))));
+            const vfloat scalev = F2V(0.1f);
+            for (; k + 3 < n; k += 4) {
+                STVFU(out[k], xexpf(LVF(acc[c][k]) / LVF(wsum[k])) * scalev);
             }
 #endif
-            for(; x < W; ++x) {
-                (*resultCh[c])(x, y) = xexpf((*resultCh[c])(x,y) / weight_sum(x,y));
+            for (; k < n; k++) {
+                out[k] = xexpf(acc[c][k] / wsum[k]) * 0.1f;
             }
-        }
-    }
-    float cmax[3];
-    for (int c = 0; c < channels; c++) {
-        float max = numeric_limits<float>::min();
-#ifdef _OPENMP
-    #pragma omp parallel for reduction(max:max)
-#endif
-        for (size_t k = 0; k < size; k++) {
-            float val = (*resultCh[c])(k);
-            if(std::isnormal(val)) {
-                max = std::max(max, val);
+
+            for (k = 0; k < n; k++) {
+                if (std::isnormal(out[k])) {
+                    maxval = std::max(maxval, out[k]);
+                } else {
+                    invalid = true;
+                }
             }
         }
-        cmax[c] = max;
-    }
+        blockMax[b] = maxval;
+        blockInvalid[b] = invalid;
+    });
 
-    float Max = max(cmax[0], max(cmax[1], cmax[2]));
+    const float Max = *std::max_element(blockMax.begin(), blockMax.end());
 
-    for (int c = 0; c < channels; c++) {
-#ifdef _OPENMP
-    #pragma omp parallel for
-#endif
-        for (size_t k = 0; k < size; k++) {
-            float val = (*resultCh[c])(k);
-            if(!std::isnormal(val)) {
-                (*resultCh[c])(k) = Max;
-            }
+    // replace not-normal values (no valid exposure) with the brightest one,
+    // visiting only the blocks where such values have been found
+    forEachFusionBlock(size, [&](size_t b, size_t begin, size_t end) {
+        if (!blockInvalid[b]) {
+            return;
         }
-    }
-
-    // TODO: Investigate why scaling hdr yields better result
-    for (int c = 0; c < channels; c++) {
-#ifdef _OPENMP
-    #pragma omp parallel for
-#endif
-        for (size_t k = 0; k < size; k++) {
-            (*resultCh[c])(k) *= 0.1f;
+        for (int c = 0; c < channels; c++) {
+            for (size_t k = begin; k < end; k++) {
+                if (!std::isnormal(resultCh[c][k])) {
+                    resultCh[c][k] = Max;
+                }
+            }
         }
-    }
+    });
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
@@ -0,0 +1,660 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *  Copyright (C) 2026 The Luminance HDR developers
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ *
+ */
+
+#include "feature_alignment.h"
+#include "mtb_bitmap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/colorspace/xyz.h>
+#include <Libpfs/frame.h>
+#include <Libpfs/tag.h>
+
+using namespace std;
+using namespace pfs;
+
+#ifndef NDEBUG
+#define PRINT_DEBUG(str) std::cerr << "FeatureAlign: " << str << std::endl
+#else
+#define PRINT_DEBUG(str)
+#endif
+
+namespace {
+
+//! longest side of the image used for the detection
+const size_t MAX_WORKING_SIZE = 1600;
+//! radius of the patch sampled by the descriptor
+const int PATCH_RADIUS = 15;
+//! one keypoint at most is taken from every cell
+const int CELL_SIZE = 24;
+//! 256 bits BRIEF descriptor
+const int DESCRIPTOR_WORDS = 4;
+const int DESCRIPTOR_BITS = DESCRIPTOR_WORDS * 64;
+//! matches farther than this are discarded
+const int MAX_HAMMING_DISTANCE = 64;
+//! Lowe's ratio between best and second best match
+const float MATCH_RATIO = 0.8f;
+
+const int RANSAC_MAX_ITERATIONS = 2000;
+//! inlier threshold, in pixels of the working image
+const double RANSAC_THRESHOLD = 2.0;
+const size_t MIN_INLIERS = 12;
+
+typedef Eigen::Matrix3d Homography;
+
+struct KeyPoint {
+    float x;
+    float y;
+    uint64_t desc[DESCRIPTOR_WORDS];
+};
+
+struct Match {
+    size_t a;
+    size_t b;
+};
+
+struct BriefPair {
+    int x1, y1;
+    int x2, y2;
+};
+
+// sampling pattern of the descriptor: isotropic gaussian around the keypoint,
+// as in the original BRIEF paper. It is only required to be the same for all
+// the frames of a run.
+const vector<BriefPair> &briefPattern() {
+    static const vector<BriefPair> pattern = [] {
+        vector<BriefPair> p(DESCRIPTOR_BITS);
+        std::mt19937 rng(0x1ee7);
+        std::normal_distribution<float> dist(0.f, (2 * PATCH_RADIUS + 1) / 5.f);
+        auto sample = [&]() {
+            int v = static_cast<int>(std::floor(dist(rng) + 0.5f));
+            return std::max(-PATCH_RADIUS, std::min(PATCH_RADIUS, v));
+        };
+        for (auto &pair : p) {
+            pair.x1 = sample();
+            pair.y1 = sample();
+            pair.x2 = sample();
+            pair.y2 = sample();
+        }
+        return p;
+    }();
+    return pattern;
+}
+
+//! \brief separable [1 4 6 4 1] / 16 blur, borders clamped
+void blur(const Array2Df &in, Array2Df &out) {
+    const int W = in.getCols();
+    const int H = in.getRows();
+    Array2Df tmp(W, H);
+    out.resize(W, H);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            const int x0 = std::max(x - 2, 0);
+            const int x1 = std::max(x - 1, 0);
+            const int x3 = std::min(x + 1, W - 1);
+            const int x4 = std::min(x + 2, W - 1);
+            tmp(x, y) = (in(x0, y) + 4.f * in(x1, y) + 6.f * in(x, y) +
+                         4.f * in(x3, y) + in(x4, y)) *
+                        (1.f / 16.f);
+        }
+    }
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (int y = 0; y < H; ++y) {
+        const int y0 = std::max(y - 2, 0);
+        const int y1 = std::max(y - 1, 0);
+        const int y3 = std::min(y + 1, H - 1);
+        const int y4 = std::min(y + 2, H - 1);
+        for (int x = 0; x < W; ++x) {
+            out(x, y) = (tmp(x, y0) + 4.f * tmp(x, y1) + 6.f * tmp(x, y) +
+                         4.f * tmp(x, y3) + tmp(x, y4)) *
+                        (1.f / 16.f);
+        }
+    }
+}
+
+//! \brief box-downsampled luminance of \a frame, histogram equalized so that
+//! differently exposed frames look alike to the detector
+void buildWorkingImage(const Frame &frame, size_t scale, Array2Df &out) {
+    const Channel *R;
+    const Channel *G;
+    const Channel *B;
+    frame.getXYZChannels(R, G, B);
+
+    const int W = frame.getWidth() / scale;
+    const int H = frame.getHeight() / scale;
+    out.resize(W, H);
+
+    const float norm = 1.f / (scale * scale);
+    const float *cr = pfs::colorspace::rgb2xyzD65Mat[1];
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            float sum = 0.f;
+            for (size_t j = y * scale; j < (y + 1) * scale; ++j) {
+                for (size_t i = x * scale; i < (x + 1) * scale; ++i) {
+                    sum += cr[0] * (*R)(i, j) + cr[1] * (*G)(i, j) +
+                           cr[2] * (*B)(i, j);
+                }
+            }
+            out(x, y) = sum * norm;
+        }
+    }
+
+    // histogram equalization
+    const size_t BINS = 4096;
+    const float minVal = *std::min_element(out.begin(), out.end());
+    const float maxVal = *std::max_element(out.begin(), out.end());
+    if (maxVal <= minVal) {
+        out.fill(0.f);
+        return;
+    }
+    const float binScale = (BINS - 1) / (maxVal - minVal);
+
+    vector<size_t> hist(BINS, 0);
+    for (Array2Df::const_iterator it = out.begin(); it != out.end(); ++it) {
+        ++hist[static_cast<size_t>((*it - minVal) * binScale)];
+    }
+    vector<float> cdf(BINS);
+    size_t acc = 0;
+    for (size_t b = 0; b < BINS; ++b) {
+        acc += hist[b];
+        cdf[b] = static_cast<float>(acc) / out.size();
+    }
+    for (Array2Df::iterator it = out.begin(); it != out.end(); ++it) {
+        *it = cdf[static_cast<size_t>((*it - minVal) * binScale)];
+    }
+}
+
+//! \brief Harris corner response of \a img
+void harrisResponse(const Array2Df &img, Array2Df &response) {
+    const int W = img.getCols();
+    const int H = img.getRows();
+
+    Array2Df ixx(W, H);
+    Array2Df iyy(W, H);
+    Array2Df ixy(W, H);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            const float dx = 0.5f * (img(std::min(x + 1, W - 1), y) -
+                                     img(std::max(x - 1, 0), y));
+            const float dy = 0.5f * (img(x, std::min(y + 1, H - 1)) -
+                                     img(x, std::max(y - 1, 0)));
+            ixx(x, y) = dx * dx;
+            iyy(x, y) = dy * dy;
+            ixy(x, y) = dx * dy;
+        }
+    }
+
+    Array2Df sxx;
+    Array2Df syy;
+    Array2Df sxy;
+    blur(ixx, sxx);
+    blur(iyy, syy);
+    blur(ixy, sxy);
+
+    response.resize(W, H);
+    for (size_t k = 0; k < response.size(); ++k) {
+        const float det = sxx(k) * syy(k) - sxy(k) * sxy(k);
+        const float tr = sxx(k) + syy(k);
+        response(k) = det - 0.04f * tr * tr;
+    }
+}
+
+//! \brief strongest corner of every cell of the grid, with its descriptor
+void detectKeyPoints(const Array2Df &img, vector<KeyPoint> &keypoints) {
+    const int W = img.getCols();
+    const int H = img.getRows();
+    const int margin = PATCH_RADIUS + 1;
+
+    keypoints.clear();
+    if (W <= 2 * margin || H <= 2 * margin) {
+        return;
+    }
+
+    Array2Df smooth;
+    blur(img, smooth);
+
+    Array2Df response;
+    harrisResponse(smooth, response);
+
+    const float threshold =
+        1e-3f * *std::max_element(response.begin(), response.end());
+    if (threshold <= 0.f) {
+        return;
+    }
+
+    // descriptors are taken on a more blurred version, for noise robustness
+    Array2Df descImg;
+    blur(smooth, descImg);
+
+    const vector<BriefPair> &pattern = briefPattern();
+    for (int cy = margin; cy < H - margin; cy += CELL_SIZE) {
+        for (int cx = margin; cx < W - margin; cx += CELL_SIZE) {
+            float best = threshold;
+            int bx = -1;
+            int by = -1;
+            for (int y = cy; y < std::min(cy + CELL_SIZE, H - margin); ++y) {
+                for (int x = cx; x < std::min(cx + CELL_SIZE, W - margin);
+                     ++x) {
+                    if (response(x, y) > best) {
+                        best = response(x, y);
+                        bx = x;
+                        by = y;
+                    }
+                }
+            }
+            if (bx < 0) {
+                continue;
+            }
+
+            KeyPoint kp;
+            kp.x = bx;
+            kp.y = by;
+            std::fill(kp.desc, kp.desc + DESCRIPTOR_WORDS, 0);
+            for (int b = 0; b < DESCRIPTOR_BITS; ++b) {
+                const BriefPair &p = pattern[b];
+                if (descImg(bx + p.x1, by + p.y1) <
+                    descImg(bx + p.x2, by + p.y2)) {
+                    kp.desc[b / 64] |= uint64_t(1) << (b % 64);
+                }
+            }
+            keypoints.push_back(kp);
+        }
+    }
+}
+
+inline int hammingDistance(const KeyPoint &a, const KeyPoint &b) {
+    int d = 0;
+    for (int w = 0; w < DESCRIPTOR_WORDS; ++w) {
+        d += libhdr::popcount(a.desc[w] ^ b.desc[w]);
+    }
+    return d;
+}
+
+//! \brief index of the best match of \a kp in \a candidates, or -1 if the
+//! match is not distinctive enough
+long bestMatch(const KeyPoint &kp, const vector<KeyPoint> &candidates) {
+    int best = std::numeric_limits<int>::max();
+    int second = std::numeric_limits<int>::max();
+    long bestIdx = -1;
+    for (size_t j = 0; j < candidates.size(); ++j) {
+        const int d = hammingDistance(kp, candidates[j]);
+        if (d < best) {
+            second = best;
+            best = d;
+            bestIdx = j;
+        } else if (d < second) {
+            second = d;
+        }
+    }
+    if (best > MAX_HAMMING_DISTANCE || best >= MATCH_RATIO * second) {
+        return -1;
+    }
+    return bestIdx;
+}
+
+//! \brief mutual best matches between \a a and \a b
+void matchKeyPoints(const vector<KeyPoint> &a, const vector<KeyPoint> &b,
+                    vector<Match> &matches) {
+    matches.clear();
+
+    vector<long> ab(a.size());
+    vector<long> ba(b.size());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (long i = 0; i < (long)a.size(); ++i) {
+        ab[i] = bestMatch(a[i], b);
+    }
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (long j = 0; j < (long)b.size(); ++j) {
+        ba[j] = bestMatch(b[j], a);
+    }
+
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (ab[i] >= 0 && ba[ab[i]] == (long)i) {
+            Match m = {i, static_cast<size_t>(ab[i])};
+            matches.push_back(m);
+        }
+    }
+}
+
+//! \brief similarity that moves the centroid of the points in the origin and
+//! sets their average distance from it to sqrt(2) (Hartley normalization)
+Homography normalizingTransform(const vector<Eigen::Vector2d> &pts,
+                                const vector<size_t> &idx) {
+    Eigen::Vector2d c(0., 0.);
+    for (size_t i : idx) c += pts[i];
+    c /= static_cast<double>(idx.size());
+
+    double d = 0.;
+    for (size_t i : idx) d += (pts[i] - c).norm();
+    d /= static_cast<double>(idx.size());
+
+    const double s = (d > 0.) ? std::sqrt(2.) / d : 1.;
+    Homography T;
+    T << s, 0., -s * c.x(), 0., s, -s * c.y(), 0., 0., 1.;
+    return T;
+}
+
+//! \brief normalized DLT on the correspondences \a idx (at least 4)
+bool fitHomography(const vector<Eigen::Vector2d> &src,
+                   const vector<Eigen::Vector2d> &dst,
+                   const vector<size_t> &idx, Homography &H) {
+    assert(idx.size() >= 4);
+
+    const Homography Ts = normalizingTransform(src, idx);
+    const Homography Td = normalizingTransform(dst, idx);
+
+    Eigen::MatrixXd A(2 * idx.size(), 9);
+    for (size_t r = 0; r < idx.size(); ++r) {
+        const Eigen::Vector3d s = Ts * src[idx[r]].homogeneous();
+        const Eigen::Vector3d d = Td * dst[idx[r]].homogeneous();
+
+        A.row(2 * r) << -s.x(), -s.y(), -1., 0., 0., 0., d.x() * s.x(),
+            d.x() * s.y(), d.x();
+        A.row(2 * r + 1) << 0., 0., 0., -s.x(), -s.y(), -1., d.y() * s.x(),
+            d.y() * s.y(), d.y();
+    }
+
+    Eigen::JacobiSVD<Eigen::MatrixXd> svd(A, Eigen::ComputeFullV);
+    const Eigen::VectorXd h = svd.matrixV().col(8);
+
+    Homography Hn;
+    Hn << h(0), h(1), h(2), h(3), h(4), h(5), h(6), h(7), h(8);
+
+    H = Td.inverse() * Hn * Ts;
+    if (std::abs(H(2, 2)) < 1e-12 || !H.allFinite()) {
+        return false;
+    }
+    H /= H(2, 2);
+    return true;
+}
+
+inline double transferError(const Homography &H, const Eigen::Vector2d &s,
+                            const Eigen::Vector2d &d) {
+    const Eigen::Vector3d p = H * s.homogeneous();
+    if (std::abs(p.z()) < 1e-12) {
+        return std::numeric_limits<double>::max();
+    }
+    return (p.hnormalized() - d).squaredNorm();
+}
+
+size_t findInliers(const Homography &H, const vector<Eigen::Vector2d> &src,
+                   const vector<Eigen::Vector2d> &dst, vector<size_t> &inliers) {
+    const double th2 = RANSAC_THRESHOLD * RANSAC_THRESHOLD;
+    inliers.clear();
+    for (size_t i = 0; i < src.size(); ++i) {
+        if (transferError(H, src[i], dst[i]) < th2) {
+            inliers.push_back(i);
+        }
+    }
+    return inliers.size();
+}
+
+//! \brief robust estimation of the homography mapping \a src on \a dst
+bool ransacHomography(const vector<Eigen::Vector2d> &src,
+                      const vector<Eigen::Vector2d> &dst, Homography &H) {
+    const size_t n = src.size();
+    if (n < MIN_INLIERS) {
+        return false;
+    }
+
+    // fixed seed: the same input always gives the same alignment
+    std::mt19937 rng(0x5eed);
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+
+    vector<size_t> bestInliers;
+    vector<size_t> inliers;
+    vector<size_t> sample(4);
+
+    int iterations = RANSAC_MAX_ITERATIONS;
+    for (int it = 0; it < iterations; ++it) {
+        for (size_t s = 0; s < 4; ++s) {
+            size_t candidate;
+            do {
+                candidate = pick(rng);
+            } while (std::find(sample.begin(), sample.begin() + s,
+                               candidate) != sample.begin() + s);
+            sample[s] = candidate;
+        }
+
+        Homography model;
+        if (!fitHomography(src, dst, sample, model)) {
+            continue;
+        }
+        if (findInliers(model, src, dst, inliers) > bestInliers.size()) {
+            bestInliers.swap(inliers);
+
+            // adaptive number of iterations, 99.5% confidence
+            const double w = static_cast<double>(bestInliers.size()) / n;
+            const double p = 1. - std::pow(w, 4.);
+            if (p <= 0.) break;
+            const double needed = std::log(1. - 0.995) / std::log(p);
+            iterations = std::min(RANSAC_MAX_ITERATIONS,
+                                  static_cast<int>(std::ceil(needed)));
+        }
+    }
+
+    if (bestInliers.size() < MIN_INLIERS) {
+        return false;
+    }
+
+    // least squares refinement on the consensus set
+    for (int refine = 0; refine < 2; ++refine) {
+        if (!fitHomography(src, dst, bestInliers, H)) {
+            return false;
+        }
+        if (findInliers(H, src, dst, inliers) < MIN_INLIERS) {
+            return false;
+        }
+        bestInliers.swap(inliers);
+    }
+
+    PRINT_DEBUG("RANSAC: " << bestInliers.size() << "/" << n << " inliers");
+    return static_cast<double>(bestInliers.size()) >= 0.25 * n;
+}
+
+//! \brief homography that maps points of the frame described by \a a onto the
+//! frame described by \a b
+bool registerPair(const vector<KeyPoint> &a, const vector<KeyPoint> &b,
+                  Homography &H) {
+    vector<Match> matches;
+    matchKeyPoints(a, b, matches);
+
+    PRINT_DEBUG(a.size() << "/" << b.size() << " keypoints, "
+                         << matches.size() << " matches");
+
+    vector<Eigen::Vector2d> src;
+    vector<Eigen::Vector2d> dst;
+    for (const Match &m : matches) {
+        src.push_back(Eigen::Vector2d(a[m.a].x, a[m.a].y));
+        dst.push_back(Eigen::Vector2d(b[m.b].x, b[m.b].y));
+    }
+    return ransacHomography(src, dst, H);
+}
+
+//! \brief resample \a frame so that its pixel (x, y) is taken from the point
+//! \a H (x, y) of the original. Samples falling outside are set to zero, as
+//! \c pfs::shift does.
+void warpFrame(Frame &frame, const Homography &H) {
+    const int W = frame.getWidth();
+    const int Ht = frame.getHeight();
+
+    Frame warped(W, Ht);
+    const ChannelContainer &channels =
+        static_cast<const Frame &>(frame).getChannels();
+
+    vector<const Channel *> in;
+    vector<Channel *> out;
+    for (ChannelContainer::const_iterator it = channels.begin();
+         it != channels.end(); ++it) {
+        in.push_back(*it);
+        out.push_back(warped.createChannel((*it)->getName()));
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (int y = 0; y < Ht; ++y) {
+        for (int x = 0; x < W; ++x) {
+            const Eigen::Vector3d p = H * Eigen::Vector3d(x, y, 1.);
+            const double sx = p.x() / p.z();
+            const double sy = p.y() / p.z();
+
+            const bool inside = std::isfinite(sx) && std::isfinite(sy) &&
+                                sx >= 0. && sy >= 0. && sx <= W - 1 &&
+                                sy <= Ht - 1;
+            if (!inside) {
+                for (size_t c = 0; c < in.size(); ++c) {
+                    (*out[c])(x, y) = 0.f;
+                }
+                continue;
+            }
+
+            const int x0 = std::min(static_cast<int>(sx), std::max(W - 2, 0));
+            const int y0 = std::min(static_cast<int>(sy), std::max(Ht - 2, 0));
+            const int x1 = std::min(x0 + 1, W - 1);
+            const int y1 = std::min(y0 + 1, Ht - 1);
+            const float fx = static_cast<float>(sx - x0);
+            const float fy = static_cast<float>(sy - y0);
+
+            for (size_t c = 0; c < in.size(); ++c) {
+                const Channel &ch = *in[c];
+                const float top = ch(x0, y0) + fx * (ch(x1, y0) - ch(x0, y0));
+                const float bottom =
+                    ch(x0, y1) + fx * (ch(x1, y1) - ch(x0, y1));
+                (*out[c])(x, y) = top + fy * (bottom - top);
+            }
+        }
+    }
+
+    pfs::copyTags(&frame, &warped);
+    frame.swap(warped);
+}
+
+}  // anonymous
+
+namespace libhdr {
+
+size_t feature_alignment(std::vector<pfs::FramePtr> &framePtrList) {
+    const int numFrames = framePtrList.size();
+    if (numFrames <= 1) return 0;
+
+    const size_t width = framePtrList[0]->getWidth();
+    const size_t height = framePtrList[0]->getHeight();
+    const size_t scale = std::max<size_t>(
+        1, (std::max(width, height) + MAX_WORKING_SIZE - 1) / MAX_WORKING_SIZE);
+
+    PRINT_DEBUG("width=" << width << ", height=" << height
+                         << ", detection scale=1/" << scale);
+
+    // keypoints of every frame, computed once and in parallel
+    vector<vector<KeyPoint>> keypoints(numFrames);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < numFrames; ++i) {
+        Array2Df working;
+        buildWorkingImage(*framePtrList[i], scale, working);
+        detectKeyPoints(working, keypoints[i]);
+    }
+
+    // pairwise registration of adjacent exposures: pairH[i] maps points of
+    // frame i onto frame i + 1
+    vector<Homography> pairH(numFrames - 1, Homography::Identity());
+    vector<char> pairOk(numFrames - 1, 0);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < numFrames - 1; ++i) {
+        pairOk[i] = registerPair(keypoints[i], keypoints[i + 1], pairH[i]);
+    }
+    vector<vector<KeyPoint>>().swap(keypoints);
+
+    // bring the transforms to full resolution (pixel centers included)
+    Homography S;
+    S << double(scale), 0., 0.5 * (scale - 1), 0., double(scale),
+        0.5 * (scale - 1), 0., 0., 1.;
+    const Homography Sinv = S.inverse();
+    for (int i = 0; i < numFrames - 1; ++i) {
+        pairH[i] = S * pairH[i] * Sinv;
+    }
+
+    // chain the transforms towards the reference (middle) frame: toFrame[j]
+    // maps points of the reference onto frame j
+    const int ref = numFrames / 2;
+    vector<Homography> toFrame(numFrames, Homography::Identity());
+    vector<char> frameOk(numFrames, 1);
+    for (int j = ref + 1; j < numFrames; ++j) {
+        toFrame[j] = pairH[j - 1] * toFrame[j - 1];
+        frameOk[j] = frameOk[j - 1] && pairOk[j - 1];
+    }
+    for (int j = ref - 1; j >= 0; --j) {
+        toFrame[j] = pairH[j].inverse() * toFrame[j + 1];
+        frameOk[j] = frameOk[j + 1] && pairOk[j];
+    }
+
+    size_t failed = 0;
+    for (int j = 0; j < numFrames; ++j) {
+        if (!frameOk[j]) {
+            PRINT_DEBUG("frame " << j << " could not be registered");
+            ++failed;
+        }
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int j = 0; j < numFrames; ++j) {
+        if (j != ref && frameOk[j]) {
+            warpFrame(*framePtrList[j], toFrame[j] / toFrame[j](2, 2));
+        }
+    }
+
+    return failed;
+}
+
+}  // libhdr
@@ -0,0 +1,46 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *  Copyright (C) 2026 The Luminance HDR developers
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ *
+ */
+
+#ifndef LIBHDR_FEATURE_ALIGNMENT_H
+#define LIBHDR_FEATURE_ALIGNMENT_H
+
+//! \brief In-memory feature based alignment of a bracketed set of frames.
+//! Corners are detected on an exposure-equalized luminance, described with
+//! binary (BRIEF) descriptors and matched between adjacent exposures; a
+//! homography is fitted with RANSAC and every frame is warped onto the
+//! reference (middle) exposure.
+
+#include <cstddef>
+#include <vector>
+
+#include <Libpfs/frame.h>
+
+namespace libhdr {
+
+//! \brief align \a framePtrList in place on the frame in the middle of the list
+//! \return number of frames that could not be registered: those frames are
+//! left untouched
+size_t feature_alignment(std::vector<pfs::FramePtr> &framePtrList);
+
+}  // libhdr
+
+#endif  // LIBHDR_FEATURE_ALIGNMENT_H
@@ -0,0 +1,65 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef LIBHDR_FUSION_FUSIONBLOCKS_H
+#define LIBHDR_FUSION_FUSIONBLOCKS_H
+
+//! \brief Streaming block engine shared by the fusion operators.
+//! The frame is split in contiguous blocks of pixels: every exposure is
+//! streamed through one block at a time, so that the accumulators of the
+//! block stay in cache and no full-frame temporary is ever allocated.
+
+#include <algorithm>
+#include <cstddef>
+
+namespace libhdr {
+namespace fusion {
+
+//! \brief number of pixels processed together by the fusion kernels. The
+//! accumulators of a block (3 channels plus the weight sum) take 32KB
+static const size_t FUSION_BLOCK_SIZE = 2048;
+
+//! \return number of blocks needed to cover \a size pixels
+inline size_t numFusionBlocks(size_t size) {
+    return (size + FUSION_BLOCK_SIZE - 1) / FUSION_BLOCK_SIZE;
+}
+
+//! \brief call \a func(blockIdx, begin, end) for every block of pixels in
+//! [0, size). Blocks are independent and are processed in parallel.
+template <typename BlockFunc>
+void forEachFusionBlock(size_t size, BlockFunc func) {
+    const long numBlocks = static_cast<long>(numFusionBlocks(size));
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 8)
+#endif
+    for (long b = 0; b < numBlocks; ++b) {
+        const size_t begin = static_cast<size_t>(b) * FUSION_BLOCK_SIZE;
+        const size_t end = std::min(size, begin + FUSION_BLOCK_SIZE);
+
+        func(static_cast<size_t>(b), begin, end);
+    }
+}
+
+}  // fusion
+}  // libhdr
+
+#endif  // LIBHDR_FUSION_FUSIONBLOCKS_H
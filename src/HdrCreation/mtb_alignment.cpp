@@ -22,6 +22,7 @@
  */
 
 #include "mtb_alignment.h"
+#include "mtb_bitmap.h"
 
 #include <iso646.h>
 #include <boost/lexical_cast.hpp>
@@ -52,53 +53,9 @@ using namespace pfs;
 #endif
 
 typedef Array2D<uint8_t> Array2D8u;
-typedef Array2D<bool> Array2Db;
 
 namespace libhdr {
 
-long XORimages(const Array2Db &img1, const Array2Db &mask1,
-               const Array2Db &img2, const Array2Db &mask2) {
-    long err = 0;
-    for (size_t i = 0; i < img1.getRows(); i++) {
-        Array2Db::const_iterator p1 = img1.row_begin(i);
-        Array2Db::const_iterator p2 = img2.row_begin(i);
-        Array2Db::const_iterator m1 = mask1.row_begin(i);
-        Array2Db::const_iterator m2 = mask2.row_begin(i);
-
-        for (size_t j = 0; j < img1.getCols(); j++) {
-            err += (long)((*p1++ xor *p2++) and *m1++ and *m2++);
-        }
-    }
-    return err;
-}
-
-// setThreshold gets the data from the input image and creates the threshold
-// and mask images.
-// Those are bitmap (0,1 valued) with depth()=1
-void setThreshold(const Array2D8u &in, const int threshold, const int noise,
-                  Array2Db &threshold_out, Array2Db &mask_out) {
-    assert(in.getCols() == threshold_out.getCols());
-    assert(in.getRows() == threshold_out.getRows());
-    assert(in.getCols() == mask_out.getCols());
-    assert(in.getRows() == mask_out.getRows());
-
-    for (size_t i = 0; i < in.getRows(); i++) {
-        Array2D8u::const_iterator inp = in.row_begin(i);
-
-        Array2Db::iterator outp = threshold_out.row_begin(i);
-        Array2Db::iterator maskp = mask_out.row_begin(i);
-
-        for (size_t j = 0; j < in.getCols(); j++) {
-            *outp++ = *inp < threshold ? 0 : 1;
-            *maskp++ =
-                (*inp > (threshold - noise)) && (*inp < (threshold + noise))
-                    ? 0
-                    : 1;
-            ++inp;
-        }
-    }
-}
-
 void getExpShift(const Array2D8u &img1, const int median1,
                  const Array2D8u &img2, const int median2, const int noise,
                  const int shift_bits, int &shift_x, int &shift_y) {
@@ -121,28 +78,23 @@ void getExpShift(const Array2D8u &img1, const int median1,
         curr_y *= 2;
     }
 
-    Array2Db img1threshold(img1.getCols(), img1.getRows());
-    Array2Db img1mask(img1.getCols(), img1.getRows());
-    Array2Db img2threshold(img2.getCols(), img2.getRows());
-    Array2Db img2mask(img2.getCols(), img2.getRows());
+    Bitmap img1threshold(img1.getCols(), img1.getRows());
+    Bitmap img1mask(img1.getCols(), img1.getRows());
+    Bitmap img2threshold(img2.getCols(), img2.getRows());
+    Bitmap img2mask(img2.getCols(), img2.getRows());
 
     setThreshold(img1, median1, noise, img1threshold, img1mask);
     setThreshold(img2, median2, noise, img2threshold, img2mask);
 
-    Array2Db img2_shifted(img2.getCols(), img2.getRows());
-    Array2Db img2mask_shifted(img2.getCols(), img2.getRows());
-
-    int minerr = img1.size();
+    // img2 is read shifted in place by XORimages, no shifted copy is needed
+    long minerr = img1.size();
     for (int i = -1; i <= 1; i++) {
         for (int j = -1; j <= 1; j++) {
             int dx = curr_x + i;
             int dy = curr_y + j;
 
-            pfs::shift(img2threshold, dx, dy, img2_shifted);
-            pfs::shift(img2mask, dx, dy, img2mask_shifted);
-
-            long err = XORimages(img1threshold, img1mask, img2_shifted,
-                                 img2mask_shifted);
+            long err = XORimages(img1threshold, img1mask, img2threshold,
+                                 img2mask, dx, dy);
 
             if (err < minerr) {
                 minerr = err;
@@ -194,15 +146,9 @@ int getLum(const Frame &in, Array2D8u &out, double quantile) {
     return idx;
 }
 
-void mtbalign(const pfs::Frame &image1, const pfs::Frame &image2,
-              const double quantile, const int noise, const int shift_bits,
+void mtbalign(const Array2D8u &img1lum, int median1, const Array2D8u &img2lum,
+              int median2, const int noise, const int shift_bits,
               int &shift_x, int &shift_y) {
-    Array2D8u img1lum;
-    Array2D8u img2lum;
-
-    int median1 = getLum(image1, img1lum, quantile);
-    int median2 = getLum(image2, img2lum, quantile);
-
     PRINT_DEBUG("align::medians, image 1: " << median1
                                             << ", image 2: " << median2);
     getExpShift(img1lum, median1, img2lum, median2, noise, shift_bits, shift_x,
@@ -226,35 +172,54 @@ void mtb_alignment(std::vector<pfs::FramePtr> &framePtrList) {
     PRINT_DEBUG("width=" << width << ", height=" << height
                          << ", shift_bits=" << shift_bits);
 
+    const int numFrames = framePtrList.size();
+
+    // luminance and median of every frame, computed once and in parallel
+    vector<Array2D8u> lums(numFrames);
+    vector<int> medians(numFrames);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (int i = 0; i < numFrames; i++) {
+        medians[i] = getLum(*framePtrList[i], lums[i], quantile);
+    }
+
     // these arrays contain the shifts of each image (except the 0-th) wrt the
     // previous one
-    vector<int> shiftsX(framePtrList.size() - 1);
-    vector<int> shiftsY(framePtrList.size() - 1);
+    vector<int> shiftsX(numFrames - 1);
+    vector<int> shiftsY(numFrames - 1);
 
-    // find the shitfs
-    for (size_t i = 0; i < framePtrList.size() - 1; i++) {
-        mtbalign(*framePtrList[i], *framePtrList[i + 1], quantile, noise,
+    // find the shifts: every pair is independent, so search them in parallel
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < numFrames - 1; i++) {
+        mtbalign(lums[i], medians[i], lums[i + 1], medians[i + 1], noise,
                  shift_bits, shiftsX[i], shiftsY[i]);
     }
+    vector<Array2D8u>().swap(lums);  // release memory
 
     PRINT_DEBUG("shifting the images");
-    int originalsize = framePtrList.size();
+    vector<int> cumulativeX(numFrames, 0);
+    vector<int> cumulativeY(numFrames, 0);
+    for (int i = 1; i < numFrames; i++) {
+        cumulativeX[i] = cumulativeX[i - 1] + shiftsX[i - 1];
+        cumulativeY[i] = cumulativeY[i - 1] + shiftsY[i - 1];
+    }
 
-    int cumulativeX = 0;
-    int cumulativeY = 0;
     // shift the images (apply the shifts starting from the second (index=1))
-    for (int i = 1; i < originalsize; i++) {
-        cumulativeX += shiftsX[i - 1];
-        cumulativeY += shiftsY[i - 1];
-
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 1; i < numFrames; i++) {
         // avoid shifting if cumulativeX and cumulativeY are zero
-        if (cumulativeX || cumulativeY) {
+        if (cumulativeX[i] || cumulativeY[i]) {
             PRINT_DEBUG("Cumulative shift for image "
-                        << i << " = (" << cumulativeX << "," << cumulativeY
-                        << ")");
+                        << i << " = (" << cumulativeX[i] << ","
+                        << cumulativeY[i] << ")");
 
             FramePtr shiftedFrame(
-                pfs::shift(*framePtrList[i], cumulativeX, cumulativeY));
+                pfs::shift(*framePtrList[i], cumulativeX[i], cumulativeY[i]));
 
             framePtrList[i]->swap(*shiftedFrame);
         }
@@ -0,0 +1,142 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *  Copyright (C) 2026 The Luminance HDR developers
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ *
+ */
+
+#include "mtb_bitmap.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace libhdr {
+
+Bitmap::Bitmap(size_t width, size_t height)
+    : m_width(width),
+      m_height(height),
+      m_wordsPerRow((width + WORD_BITS - 1) / WORD_BITS),
+      m_data(m_wordsPerRow * height, 0) {}
+
+void Bitmap::set(size_t x, size_t y, bool value) {
+    assert(x < m_width);
+    assert(y < m_height);
+
+    Word &w = row(y)[x / WORD_BITS];
+    const Word bit = Word(1) << (x % WORD_BITS);
+    if (value) {
+        w |= bit;
+    } else {
+        w &= ~bit;
+    }
+}
+
+size_t Bitmap::count() const {
+    size_t c = 0;
+    for (size_t idx = 0; idx < m_data.size(); ++idx) {
+        c += popcount(m_data[idx]);
+    }
+    return c;
+}
+
+Bitmap::Word Bitmap::shiftedWord(size_t r, size_t word, int dx) const {
+    const Word *src = row(r);
+    const long words = static_cast<long>(m_wordsPerRow);
+
+    // first source bit of the requested word
+    const long s = static_cast<long>(word * WORD_BITS) + dx;
+    const long q = (s >= 0) ? s / long(WORD_BITS)
+                            : -((-s + long(WORD_BITS) - 1) / long(WORD_BITS));
+    const int b = static_cast<int>(s - q * long(WORD_BITS));
+
+    const Word lo = (q >= 0 && q < words) ? src[q] : 0;
+    if (b == 0) {
+        return lo;
+    }
+    const Word hi = (q + 1 >= 0 && q + 1 < words) ? src[q + 1] : 0;
+    return (lo >> b) | (hi << (WORD_BITS - b));
+}
+
+void setThreshold(const pfs::Array2D<uint8_t> &in, int threshold, int noise,
+                  Bitmap &threshold_out, Bitmap &mask_out) {
+    assert(in.getCols() == threshold_out.getWidth());
+    assert(in.getRows() == threshold_out.getHeight());
+    assert(in.getCols() == mask_out.getWidth());
+    assert(in.getRows() == mask_out.getHeight());
+
+    const size_t width = in.getCols();
+    const size_t words = threshold_out.getWordsPerRow();
+
+    for (size_t i = 0; i < in.getRows(); i++) {
+        const uint8_t *inp = in.data() + i * width;
+        Bitmap::Word *outp = threshold_out.row(i);
+        Bitmap::Word *maskp = mask_out.row(i);
+
+        for (size_t w = 0; w < words; w++) {
+            const size_t begin = w * Bitmap::WORD_BITS;
+            const size_t end = std::min(width, begin + Bitmap::WORD_BITS);
+
+            Bitmap::Word t = 0;
+            Bitmap::Word m = 0;
+            for (size_t j = begin; j < end; j++) {
+                const int v = inp[j];
+                const Bitmap::Word bit = Bitmap::Word(1) << (j - begin);
+                if (v >= threshold) t |= bit;
+                if (v <= threshold - noise || v >= threshold + noise) m |= bit;
+            }
+            outp[w] = t;
+            maskp[w] = m;
+        }
+    }
+}
+
+long XORimages(const Bitmap &img1, const Bitmap &mask1, const Bitmap &img2,
+               const Bitmap &mask2, int dx, int dy) {
+    assert(img1.getWidth() == img2.getWidth());
+    assert(img1.getHeight() == img2.getHeight());
+
+    const long rows = static_cast<long>(img1.getHeight());
+    const size_t words = img1.getWordsPerRow();
+
+    // rows of img2 shifted in from outside are all masked out
+    const long rowBegin = std::max(0L, -static_cast<long>(dy));
+    const long rowEnd = std::min(rows, rows - dy);
+
+    long err = 0;
+    for (long r = rowBegin; r < rowEnd; ++r) {
+        const Bitmap::Word *p1 = img1.row(r);
+        const Bitmap::Word *m1 = mask1.row(r);
+        const size_t r2 = static_cast<size_t>(r + dy);
+
+        if (dx == 0) {
+            const Bitmap::Word *p2 = img2.row(r2);
+            const Bitmap::Word *m2 = mask2.row(r2);
+            for (size_t w = 0; w < words; ++w) {
+                err += popcount((p1[w] ^ p2[w]) & m1[w] & m2[w]);
+            }
+        } else {
+            for (size_t w = 0; w < words; ++w) {
+                err += popcount((p1[w] ^ img2.shiftedWord(r2, w, dx)) & m1[w] &
+                                mask2.shiftedWord(r2, w, dx));
+            }
+        }
+    }
+    return err;
+}
+
+}  // libhdr
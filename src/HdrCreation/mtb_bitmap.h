@@ -0,0 +1,108 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *  Copyright (C) 2026 The Luminance HDR developers
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ *
+ */
+
+#ifndef LIBHDR_MTB_BITMAP_H
+#define LIBHDR_MTB_BITMAP_H
+
+//! \brief Bit-packed bitmaps used by the MTB alignment
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <Libpfs/array2d.h>
+
+namespace libhdr {
+
+//! \brief 1-bit image: 64 pixels are packed in every word, least significant
+//! bit first. Rows are padded to a whole number of words and the padding bits
+//! are always zero, so that whole words can be combined without masking.
+class Bitmap {
+   public:
+    typedef uint64_t Word;
+    static const size_t WORD_BITS = 64;
+
+    Bitmap(size_t width = 0, size_t height = 0);
+
+    size_t getWidth() const { return m_width; }
+    size_t getHeight() const { return m_height; }
+    size_t getWordsPerRow() const { return m_wordsPerRow; }
+
+    Word *row(size_t r) { return m_data.data() + r * m_wordsPerRow; }
+    const Word *row(size_t r) const {
+        return m_data.data() + r * m_wordsPerRow;
+    }
+
+    bool get(size_t x, size_t y) const {
+        return (row(y)[x / WORD_BITS] >> (x % WORD_BITS)) & 1u;
+    }
+    void set(size_t x, size_t y, bool value);
+
+    //! \brief number of bits set
+    size_t count() const;
+
+    //! \brief word \a word of row \a r, as it would be if the bitmap was
+    //! shifted horizontally by \a dx (pixel x reads pixel x + dx, as in
+    //! \c pfs::shift). Pixels shifted in from outside the bitmap are zero.
+    Word shiftedWord(size_t r, size_t word, int dx) const;
+
+   private:
+    size_t m_width;
+    size_t m_height;
+    size_t m_wordsPerRow;
+    std::vector<Word> m_data;
+};
+
+//! \brief number of bits set in \a w
+inline int popcount(Bitmap::Word w) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(w);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<int>(__popcnt64(w));
+#else
+    w = w - ((w >> 1) & 0x5555555555555555ULL);
+    w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+    w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+//! \brief build the threshold and the exclusion bitmaps of \a in
+//! \param threshold pixels >= threshold are set in \a threshold_out
+//! \param noise pixels within +/- \a noise from \a threshold are cleared
+//! in \a mask_out
+void setThreshold(const pfs::Array2D<uint8_t> &in, int threshold, int noise,
+                  Bitmap &threshold_out, Bitmap &mask_out);
+
+//! \brief count the pixels that differ between \a img1 and \a img2 shifted by
+//! (\a dx, \a dy), considering only pixels valid in both \a mask1 and the
+//! shifted \a mask2. No shifted copy of \a img2 is built.
+long XORimages(const Bitmap &img1, const Bitmap &mask1, const Bitmap &img2,
+               const Bitmap &mask2, int dx, int dy);
+
+}  // libhdr
+
+#endif  // LIBHDR_MTB_BITMAP_H
@@ -26,6 +26,7 @@
 //! to Giuseppe Rota)
 
 #include "robertson02.h"
+#include "fusionblocks.h"
 #include "arch/math.h"
 
 #include <algorithm>
@@ -53,16 +54,15 @@ using namespace std;
 namespace libhdr {
 namespace fusion {
 
-void RobertsonOperator::applyResponse(
+size_t RobertsonOperator::applyResponseBlock(
     ResponseCurve &response, WeightFunction &weight, ResponseChannel channel,
-    const DataList &inputData, float *outputData, size_t width, size_t height,
+    const DataList &inputData, float *outputData, size_t begin, size_t end,
     float minAllowedValue, float maxAllowedValue, const float *arrayofexptime) {
     assert(inputData.size());
 
     size_t saturatedPixels = 0;
 
-    int numPixels = (int)width * height;
-    for (int j = 0; j < numPixels; ++j) {
+    for (size_t j = begin; j < end; ++j) {
         // all exposures for each pixel
         float sum = 0.0f;
         float div = 0.0f;
@@ -123,6 +123,25 @@ void RobertsonOperator::applyResponse(
         }
     }
 
+    return saturatedPixels;
+}
+
+void RobertsonOperator::applyResponse(
+    ResponseCurve &response, WeightFunction &weight, ResponseChannel channel,
+    const DataList &inputData, float *outputData, size_t width, size_t height,
+    float minAllowedValue, float maxAllowedValue, const float *arrayofexptime) {
+    size_t saturatedPixels = 0;
+
+    forEachFusionBlock(width * height, [&](size_t, size_t begin, size_t end) {
+        size_t saturated = applyResponseBlock(
+            response, weight, channel, inputData, outputData, begin, end,
+            minAllowedValue, maxAllowedValue, arrayofexptime);
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        saturatedPixels += saturated;
+    });
+
     PRINT_DEBUG("Saturated pixels: " << saturatedPixels);
 }
 
@@ -155,18 +174,32 @@ void RobertsonOperator::computeFusion(ResponseCurve &response,
                    std::back_inserter(averageLuminances),
                    boost::bind(&FrameEnhanced::averageLuminance, _1));
 
-    applyResponse(response, weight, RESPONSE_CHANNEL_RED, redChannels,
-                  outputRed->data(), tempFrame.getWidth(),
-                  tempFrame.getHeight(), minAllowedValue, maxAllowedValue,
-                  averageLuminances.data());  // red
-    applyResponse(response, weight, RESPONSE_CHANNEL_BLUE, blueChannels,
-                  outputBlue->data(), tempFrame.getWidth(),
-                  tempFrame.getHeight(), minAllowedValue, maxAllowedValue,
-                  averageLuminances.data());  // blue
-    applyResponse(response, weight, RESPONSE_CHANNEL_GREEN, greenChannels,
-                  outputGreen->data(), tempFrame.getWidth(),
-                  tempFrame.getHeight(), minAllowedValue, maxAllowedValue,
-                  averageLuminances.data());  // green
+    // stream all the exposures through one block at a time, so that the
+    // three channels of a block are merged while they are still in cache
+    const float *exptimes = averageLuminances.data();
+    size_t saturatedPixels = 0;
+    forEachFusionBlock(
+        tempFrame.size(), [&](size_t, size_t begin, size_t end) {
+            size_t saturated = 0;
+            saturated += applyResponseBlock(
+                response, weight, RESPONSE_CHANNEL_RED, redChannels,
+                outputRed->data(), begin, end, minAllowedValue,
+                maxAllowedValue, exptimes);
+            saturated += applyResponseBlock(
+                response, weight, RESPONSE_CHANNEL_GREEN, greenChannels,
+                outputGreen->data(), begin, end, minAllowedValue,
+                maxAllowedValue, exptimes);
+            saturated += applyResponseBlock(
+                response, weight, RESPONSE_CHANNEL_BLUE, blueChannels,
+                outputBlue->data(), begin, end, minAllowedValue,
+                maxAllowedValue, exptimes);
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+            saturatedPixels += saturated;
+        });
+
+    PRINT_DEBUG("Saturated pixels: " << saturatedPixels);
 
     float cmax[3];
     cmax[0] = *max_element(outputRed->begin(), outputRed->end());
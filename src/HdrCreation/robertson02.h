@@ -45,6 +45,15 @@ class RobertsonOperator : public IFusionOperator {
                        pfs::Frame &frame);
 
    protected:
+    //! \brief merge the pixels in [begin, end) of \a inputData
+    //! \return number of saturated pixels in the block
+    size_t applyResponseBlock(ResponseCurve &response, WeightFunction &weight,
+                              ResponseChannel channel,
+                              const DataList &inputData, float *outputData,
+                              size_t begin, size_t end, float minAllowedValue,
+                              float maxAllowedValue,
+                              const float *arrayofexptime);
+
     void applyResponse(ResponseCurve &response, WeightFunction &weight,
                        ResponseChannel channel, const DataList &inputData,
                        float *outputData, size_t width, size_t height,
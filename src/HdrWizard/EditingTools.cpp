@@ -32,6 +32,8 @@
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QWhatsThis>
+#include <QtConcurrentRun>
+#include <boost/bind.hpp>
 #include <cassert>
 
 #include "HdrWizard/ui_EditingTools.h"
@@ -676,13 +678,17 @@ void EditingTools::saveImagesButtonClicked() {
     if (test.isWritable() && test.exists() && test.isDir()) {
         QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
         m_hcm->applyShiftsToItems(m_HV_offsets);
-        m_hcm->saveImages(
-            QFile::encodeName((qfi.path() + "/" + qfi.fileName())));
+        // raw files are saved from their full decode: off the GUI thread,
+        // with the dialog disabled until imagesSaved()
+        setEnabled(false);
+        QtConcurrent::run(boost::bind(&HdrCreationManager::saveImages, m_hcm,
+                                      qfi.path() + "/" + qfi.fileName()));
     }
 }
 
 void EditingTools::restoreSaveImagesButtonState() {
     m_imagesSaved = true;
+    setEnabled(true);
     m_Ui->saveImagesButton->setEnabled(true);
     m_Ui->Next_Finishbutton->setEnabled(true);
     QApplication::restoreOverrideCursor();
@@ -62,6 +62,10 @@ class HdrCreationItem {
     void setEV(float ev) { m_averageLuminance = std::pow(2.f, ev); }
     float getEV() const { return log2(m_averageLuminance); }
 
+    //! \brief the frame is a preview of a raw file (see raw.preview)
+    bool isPreview() const { return m_isPreview; }
+    void setPreview(bool preview) { m_isPreview = preview; }
+
     void setMin(float m) { m_datamin = m; }
     void setMax(float M) { m_datamax = M; }
     float getMin() const { return m_datamin; }
@@ -78,6 +82,7 @@ class HdrCreationItem {
     float m_exposureTime;
     float m_datamin;
     float m_datamax;
+    bool m_isPreview;
     pfs::FramePtr m_frame;
     QSharedPointer<QImage> m_thumbnail;
 };
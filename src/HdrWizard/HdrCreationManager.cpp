@@ -34,6 +34,7 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QScopedPointer>
+#include <QSemaphore>
 #include <QtConcurrentFilter>
 #include <QtConcurrentMap>
 
@@ -42,10 +43,12 @@
 #include <boost/limits.hpp>
 #include <boost/numeric/conversion/bounds.hpp>
 #include <cmath>
+#include <functional>
 #include <iostream>
 #include <vector>
 
 #include <Common/CommonFunctions.h>
+#include <Common/LuminanceOptions.h>
 #include <Libpfs/colorspace/colorspace.h>
 #include <Libpfs/colorspace/convert.h>
 #include <Libpfs/colorspace/normalizer.h>
@@ -63,6 +66,7 @@
 #include <Libpfs/utils/transform.h>
 
 #include <Exif/ExifOperations.h>
+#include <HdrCreation/feature_alignment.h>
 #include <HdrCreation/mtb_alignment.h>
 #include <HdrWizard/WhiteBalance.h>
 #include <TonemappingOperators/fattal02/pde.h>
@@ -114,6 +118,100 @@ void shiftItem(HdrCreationItem &item, int dx, int dy) {
     item.qimage().swap(*img);
     img.reset();  // release memory
 }
+
+void cropItem(HdrCreationItem &item, const QRect &ca) {
+    std::unique_ptr<QImage> newimage(new QImage(item.qimage().copy(ca)));
+    if (newimage == NULL) {
+        exit(1);  // TODO: exit gracefully
+    }
+    item.qimage().swap(*newimage);
+    newimage.reset();
+
+    int x_ul, y_ur, x_bl, y_br;
+    ca.getCoords(&x_ul, &y_ur, &x_bl, &y_br);
+
+    FramePtr cropped(cut(item.frame().get(), static_cast<size_t>(x_ul),
+                         static_cast<size_t>(y_ur), static_cast<size_t>(x_bl),
+                         static_cast<size_t>(y_br)));
+    item.frame().swap(cropped);
+    cropped.reset();
+}
+}
+
+namespace {
+//! \brief full decode of an item loaded as a preview: the EV (which the
+//! user might have changed in the meantime) is kept, and \a edit replays
+//! the edits of the preview
+struct LoadFullFrame {
+    typedef std::function<void(HdrCreationItem &)> Edit;
+
+    LoadFullFrame(bool halfFloat, const Edit &edit)
+        : m_halfFloat(halfFloat), m_edit(edit) {}
+
+    void operator()(HdrCreationItem &item) const {
+        if (!item.isPreview()) {
+            return;
+        }
+        const float averageLuminance = item.getAverageLuminance();
+        const float exposureTime = item.getExposureTime();
+
+        LoadFile(false, m_halfFloat)(item);
+        m_edit(item);
+
+        item.setAverageLuminance(averageLuminance);
+        item.setExposureTime(exposureTime);
+    }
+
+    bool m_halfFloat;
+    Edit m_edit;
+};
+
+//! \brief LoadFile on a memory budget: each file takes an estimate of the
+//! memory its decoder needs (twice its float frame, from the header of the
+//! file) out of \a budget MB until it is loaded, so the threads of
+//! QtConcurrent never decode more than the budget at once. Items are loaded
+//! in place, so their order (and their EXIF) does not depend on timing.
+struct LoadFileOnBudget {
+    LoadFileOnBudget(const LoadFile &load, int budget,
+                     HdrCreationManager *manager,
+                     const HdrCreationItem *first)
+        : m_load(load),
+          m_budget(new QSemaphore(budget)),
+          m_total(budget),
+          m_manager(manager),
+          m_first(first) {}
+
+    void operator()(HdrCreationItem &item) const {
+        int megabytes = 1;
+        try {
+            const FrameInfo info = FrameReaderFactory::probe(
+                QFile::encodeName(item.alignedFilename()).constData());
+            megabytes =
+                static_cast<int>((2 * info.frameBytes()) >> 20) + 1;
+        } catch (const std::runtime_error &) {
+            // LoadFile will report it
+        }
+        megabytes = std::min(megabytes, m_total);
+
+        m_budget->acquire(megabytes);
+        try {
+            LoadFile(m_load)(item);
+        } catch (...) {
+            m_budget->release(megabytes);
+            throw;
+        }
+        m_budget->release(megabytes);
+
+        emit m_manager->fileLoaded(static_cast<int>(&item - m_first),
+                                   item.filename(), item.getExposureTime());
+    }
+
+    LoadFile m_load;
+    QSharedPointer<QSemaphore> m_budget;
+    int m_total;
+    HdrCreationManager *m_manager;
+    const HdrCreationItem *m_first;
+};
 }
 
 static bool checkFileName(const HdrCreationItem &item, const QString &str) {
@@ -147,9 +245,99 @@ void HdrCreationManager::loadFiles(const QStringList &filenames) {
     connect(&m_futureWatcher, &QFutureWatcherBase::finished, this,
             &HdrCreationManager::loadFilesDone, Qt::DirectConnection);
 
-    // Start the computation.
-    m_futureWatcher.setFuture(
-        QtConcurrent::map(m_tmpdata.begin(), m_tmpdata.end(), LoadFile()));
+    // Start the computation: the files of the bracket are decoded at the
+    // same time, as many as the threads of QtConcurrent and the memory
+    // budget allow
+    LuminanceOptions options;
+    const bool halfFloat = options.isHalfFloatInputs();
+    const int budget = std::max(1, options.getLoadMemoryBudget());
+    m_futureWatcher.setFuture(QtConcurrent::map(
+        m_tmpdata.begin(), m_tmpdata.end(),
+        LoadFileOnBudget(
+            LoadFile(false, halfFloat, m_rawPreview.toStdString()), budget,
+            this, m_tmpdata.data())));
+}
+
+bool HdrCreationManager::hasPreviews() const {
+    for (const auto &hdrCreationItem : m_data) {
+        if (hdrCreationItem.isPreview()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HdrCreationManager::loadFullFrames() {
+    const bool halfFloat = LuminanceOptions().isHalfFloatInputs();
+    m_fullFramesWatcher.setFuture(QtConcurrent::map(
+        m_data.begin(), m_data.end(),
+        LoadFullFrame(halfFloat, [this](HdrCreationItem &item) {
+            applyPreviewEdits(item, static_cast<int>(&item - m_data.data()));
+        })));
+}
+
+void HdrCreationManager::loadFullFramesDone() {
+    if (m_fullFramesWatcher.isCanceled())  // LoadFile() threw an exception
+    {
+        disconnect(this, &HdrCreationManager::fullFramesLoaded, this,
+                   &HdrCreationManager::finishLoadingFiles);
+        m_previewEdits.clear();
+        emit errorWhileLoading(tr(
+            "HdrCreationManager::loadFullFramesDone(): Error loading a file."));
+        return;
+    }
+    m_previewEdits.clear();
+
+    // the mask has been drawn on the previews
+    if (m_agMask != NULL && !m_data.empty()) {
+        const QSize size(m_data[0].frame()->getWidth(),
+                         m_data[0].frame()->getHeight());
+        if (m_agMask->size() != size) {
+            *m_agMask = m_agMask->scaled(size, Qt::IgnoreAspectRatio,
+                                         Qt::FastTransformation);
+        }
+    }
+    emit fullFramesLoaded();
+}
+
+void HdrCreationManager::addPreviewEdit(const PreviewEdit &edit) {
+    if (!hasPreviews()) {
+        return;
+    }
+    if (m_previewEdits.empty()) {
+        m_previewSize = QSize(m_data[0].frame()->getWidth(),
+                              m_data[0].frame()->getHeight());
+    }
+    m_previewEdits.push_back(edit);
+}
+
+void HdrCreationManager::applyPreviewEdits(HdrCreationItem &item,
+                                           int index) const {
+    if (m_previewEdits.empty()) {
+        return;
+    }
+    const float sx = static_cast<float>(item.frame()->getWidth()) /
+                     m_previewSize.width();
+    const float sy = static_cast<float>(item.frame()->getHeight()) /
+                     m_previewSize.height();
+
+    for (const auto &edit : m_previewEdits) {
+        if (edit.shifts.isEmpty()) {
+            const QRect crop(qRound(edit.crop.x() * sx),
+                             qRound(edit.crop.y() * sy),
+                             qRound(edit.crop.width() * sx),
+                             qRound(edit.crop.height() * sy));
+            cropItem(item, crop.intersected(
+                               QRect(0, 0, item.frame()->getWidth(),
+                                     item.frame()->getHeight())));
+        } else if (index < edit.shifts.size()) {
+            const QPair<int, int> &shift = edit.shifts[index];
+            if (shift.first != 0 || shift.second != 0) {
+                shiftItem(item, qRound(shift.first * sx),
+                          qRound(shift.second * sy));
+            }
+        }
+    }
 }
 
 void HdrCreationManager::loadFilesDone() {
@@ -189,6 +377,19 @@ void HdrCreationManager::loadFilesDone() {
 
     refreshEVOffset();
 
+    // previews of raw files are smaller than the frames of other formats
+    if (!framesHaveSameSize() && hasPreviews()) {
+        connect(this, &HdrCreationManager::fullFramesLoaded, this,
+                &HdrCreationManager::finishLoadingFiles);
+        loadFullFrames();
+        return;
+    }
+    finishLoadingFiles();
+}
+
+void HdrCreationManager::finishLoadingFiles() {
+    disconnect(this, &HdrCreationManager::fullFramesLoaded, this,
+               &HdrCreationManager::finishLoadingFiles);
     if (!framesHaveSameSize()) {
         m_data.clear();
         emit errorWhileLoading(
@@ -294,6 +495,15 @@ HdrCreationManager::HdrCreationManager(bool fromCommandLine)
             &HdrCreationManager::progressRangeChanged, Qt::DirectConnection);
     connect(&m_futureWatcher, &QFutureWatcherBase::progressValueChanged, this,
             &HdrCreationManager::progressValueChanged, Qt::DirectConnection);
+
+    connect(&m_fullFramesWatcher, &QFutureWatcherBase::finished, this,
+            &HdrCreationManager::loadFullFramesDone);
+    connect(&m_fullFramesWatcher, &QFutureWatcherBase::progressRangeChanged,
+            this, &HdrCreationManager::progressRangeChanged,
+            Qt::DirectConnection);
+    connect(&m_fullFramesWatcher, &QFutureWatcherBase::progressValueChanged,
+            this, &HdrCreationManager::progressValueChanged,
+            Qt::DirectConnection);
 }
 
 void HdrCreationManager::setConfig(const FusionOperatorConfig &c) {
@@ -350,6 +560,32 @@ void HdrCreationManager::align_with_mtb() {
     emit finishedAligning(0);
 }
 
+void HdrCreationManager::align_with_features() {
+    // build temporary container...
+    vector<FramePtr> frames;
+    for (size_t i = 0; i < m_data.size(); ++i) {
+        frames.push_back(m_data[i].frame());
+    }
+
+    // run the in-memory feature based alignment
+    size_t failed = libhdr::feature_alignment(frames);
+    if (failed) {
+        qDebug() << QStringLiteral(
+                        "HdrCreationManager::align_with_features(): %1 "
+                        "frame(s) could not be registered")
+                        .arg(failed);
+    }
+
+    // rebuild previews
+    QFutureWatcher<void> futureWatcher;
+    futureWatcher.setFuture(
+        QtConcurrent::map(m_data.begin(), m_data.end(), RefreshPreview()));
+    futureWatcher.waitForFinished();
+
+    // emit finished
+    emit finishedAligning(0);
+}
+
 void HdrCreationManager::set_ais_crop_flag(bool flag) {
     m_ais_crop_flag = flag;
 }
@@ -406,30 +642,22 @@ void HdrCreationManager::applyShiftsToItems(
         }
         shiftItem(m_data[i], hvOffsets[i].first, hvOffsets[i].second);
     }
+
+    PreviewEdit edit;
+    edit.shifts = hvOffsets;
+    addPreviewEdit(edit);
 }
 
 void HdrCreationManager::cropItems(const QRect &ca) {
     // crop all frames and images
     int size = m_data.size();
     for (int idx = 0; idx < size; idx++) {
-        std::unique_ptr<QImage> newimage(
-            new QImage(m_data[idx].qimage().copy(ca)));
-        if (newimage == NULL) {
-            exit(1);  // TODO: exit gracefully
-        }
-        m_data[idx].qimage().swap(*newimage);
-        newimage.reset();
-
-        int x_ul, y_ur, x_bl, y_br;
-        ca.getCoords(&x_ul, &y_ur, &x_bl, &y_br);
-
-        FramePtr cropped(
-            cut(m_data[idx].frame().get(), static_cast<size_t>(x_ul),
-                static_cast<size_t>(y_ur), static_cast<size_t>(x_bl),
-                static_cast<size_t>(y_br)));
-        m_data[idx].frame().swap(cropped);
-        cropped.reset();
+        cropItem(m_data[idx], ca);
     }
+
+    PreviewEdit edit;
+    edit.crop = ca;
+    addPreviewEdit(edit);
 }
 
 HdrCreationManager::~HdrCreationManager() {
@@ -442,9 +670,18 @@ void HdrCreationManager::saveImages(const QString &prefix) {
     for (HdrCreationItemContainer::const_iterator it = m_data.begin(),
                                                   itEnd = m_data.end();
          it != itEnd; ++it) {
+        // the files get the full frames of the previews, edited the same way
+        FramePtr frame = it->frame();
+        if (it->isPreview()) {
+            HdrCreationItem full(it->filename());
+            LoadFile()(full);
+            applyPreviewEdits(full, idx);
+            frame = full.frame();
+        }
+
         QString filename = prefix + QStringLiteral("_%1").arg(idx) + ".tiff";
         pfs::io::TiffWriter writer(QFile::encodeName(filename).constData());
-        writer.write(*it->frame(), pfs::Params("tiff_mode", 1));
+        writer.write(*frame, pfs::Params("tiff_mode", 1));
 
         QFileInfo qfi(filename);
         QString absoluteFileName = qfi.absoluteFilePath();
@@ -838,6 +1075,10 @@ void HdrCreationManager::reset() {
 
     disconnect(&m_futureWatcher, &QFutureWatcherBase::finished, this,
                &HdrCreationManager::loadFilesDone);
+    m_fullFramesWatcher.waitForFinished();
+    disconnect(this, &HdrCreationManager::fullFramesLoaded, this,
+               &HdrCreationManager::finishLoadingFiles);
     m_data.clear();
     m_tmpdata.clear();
+    m_previewEdits.clear();
 }
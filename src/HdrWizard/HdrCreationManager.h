@@ -32,9 +32,12 @@
 #include <vector>
 
 #include <QFutureWatcher>
+#include <QList>
 #include <QPair>
 #include <QProcess>
+#include <QRect>
 #include <QSharedPointer>
+#include <QSize>
 
 #include <HdrCreation/createhdr.h>
 #include <HdrCreation/fusionoperator.h>
@@ -66,10 +69,24 @@ class HdrCreationManager : public QObject {
     const HdrCreationItem &getFile(size_t idx) const { return m_data[idx]; }
 
     void loadFiles(const QStringList &filenames);
+    //! \brief raw.preview mode of the raw files loaded from now on: their
+    //! full decode is deferred until the frames are actually needed
+    void setRawPreview(const QString &mode) { m_rawPreview = mode; }
+    //! \return some of the frames are previews of raw files
+    bool hasPreviews() const;
+    //! \brief replace the previews with the full decode of their files, on
+    //! the threads of QtConcurrent: progress goes through
+    //! progressRangeChanged() and progressValueChanged(), then
+    //! fullFramesLoaded() (or errorWhileLoading()) is emitted. The shifts
+    //! and crops applied to the previews, and the anti-ghosting mask drawn
+    //! on them, are scaled to the full frames. Alignment and merge need the
+    //! full frames, the editing tools work on the previews.
+    void loadFullFrames();
     void removeFile(int idx);
     void clearFiles() {
         m_data.clear();
         m_tmpdata.clear();
+        m_previewEdits.clear();
     }
     size_t availableInputFiles() const { return m_data.size(); }
 
@@ -125,6 +142,7 @@ class HdrCreationManager : public QObject {
     void set_ais_crop_flag(bool flag);
     void align_with_ais();
     void align_with_mtb();
+    void align_with_features();
 
     const HdrCreationItemContainer &getData() const { return m_data; }
     // const QList<QImage*>& getAntiGhostingMasksList() const  { return
@@ -159,11 +177,15 @@ class HdrCreationManager : public QObject {
     void progressRangeChanged(int, int);
     void progressValueChanged(int);
     void finishedLoadingFiles();
+    //! \brief the full decode of loadFullFrames() is done
+    void fullFramesLoaded();
 
     // legacy code
     void finishedLoadingInputFiles(const QStringList &filesLackingExif);
     void errorWhileLoading(const QString &message);  // also for !valid size
 
+    //! \brief emitted (from the loading threads) as soon as each file of
+    //! loadFiles() is decoded, \a index is its position in the list
     void fileLoaded(int index, const QString &fname, float expotime);
 
     void finishedAligning(int);
@@ -178,6 +200,20 @@ class HdrCreationManager : public QObject {
     bool framesHaveSameSize();
     void refreshEVOffset();
 
+    //! \brief shift (one offset per item) or crop applied to the previews,
+    //! in their pixels
+    struct PreviewEdit {
+        QList<QPair<int, int>> shifts;
+        QRect crop;
+    };
+    void addPreviewEdit(const PreviewEdit &edit);
+    //! \brief applies m_previewEdits to the full frame of item \a index
+    void applyPreviewEdits(HdrCreationItem &item, int index) const;
+
+    std::vector<PreviewEdit> m_previewEdits;
+    //! \brief size of the previews before m_previewEdits
+    QSize m_previewSize;
+
     float m_evOffset;
 
     std::unique_ptr<libhdr::fusion::ResponseCurve> m_response;
@@ -185,8 +221,10 @@ class HdrCreationManager : public QObject {
     libhdr::fusion::FusionOperator m_fusionOperator;
     QString m_responseCurveInputFilename;
     QString m_responseCurveOutputFilename;
+    QString m_rawPreview;
 
     QFutureWatcher<void> m_futureWatcher;
+    QFutureWatcher<void> m_fullFramesWatcher;
     // QList<QImage*> m_antiGhostingMasksList;  //QImages used for manual
     // anti-ghosting
     QImage *m_agMask;
@@ -204,5 +242,8 @@ class HdrCreationManager : public QObject {
    private slots:
     void ais_failed_slot(QProcess::ProcessError);
     void loadFilesDone();
+    //! \brief size check at the end of loadFiles()
+    void finishLoadingFiles();
+    void loadFullFramesDone();
 };
 #endif
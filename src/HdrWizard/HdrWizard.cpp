@@ -124,6 +124,11 @@ HdrWizard::HdrWizard(QWidget *p, const QStringList &files,
     m_Ui->textEdit->hide();
     m_Ui->HideLogButton->hide();
 
+    // the in-process engine needs no external tool
+    if (!Align::isAisAvailable()) {
+        m_Ui->features_radioButton->setChecked(true);
+    }
+
     if (files.size()) {
         m_Ui->pagestack->setCurrentIndex(0);
 
@@ -143,6 +148,13 @@ void HdrWizard::setupConnections() {
     connect(m_hdrCreationManager.data(),
             &HdrCreationManager::finishedLoadingFiles, this,
             &HdrWizard::loadInputFilesDone);
+    connect(m_hdrCreationManager.data(), &HdrCreationManager::fileLoaded,
+            this, [this](int, const QString &fname, float) {
+                m_Ui->confirmloadlabel->setText(
+                    "<center><h3><b>" +
+                    tr("Loaded %1").arg(QFileInfo(fname).fileName()) +
+                    "</b></h3></center>");
+            });
     connect(m_hdrCreationManager.data(),
             &HdrCreationManager::progressRangeChanged, this,
             &HdrWizard::setRange, Qt::DirectConnection);
@@ -161,6 +173,10 @@ void HdrWizard::setupConnections() {
 
     connect(m_Ui->NextFinishButton, &QAbstractButton::clicked, this,
             &HdrWizard::NextFinishButtonClicked);
+    connect(m_Ui->alignCheckBox, &QAbstractButton::toggled, this,
+            &HdrWizard::alignSelectionClicked);
+    connect(m_Ui->ais_radioButton, &QAbstractButton::toggled, this,
+            &HdrWizard::alignSelectionClicked);
     connect(m_Ui->cancelButton, SIGNAL(clicked()), this, SLOT(reject()));
     connect(m_Ui->pagestack, &QStackedWidget::currentChanged, this,
             &HdrWizard::currentPageChangedInto);
@@ -457,6 +473,8 @@ void HdrWizard::loadInputFiles(const QStringList &files) {
 
         m_inputFilesName = files;
 
+        // thumbnails and EVs only need a preview of the raw files
+        m_hdrCreationManager->setRawPreview(luminance_options.getRawPreview());
         m_futureWatcher.setFuture(
             QtConcurrent::run(boost::bind(&HdrCreationManager::loadFiles,
                                           m_hdrCreationManager.data(), files)));
@@ -564,6 +582,21 @@ void HdrWizard::errorWhileLoading(const QString &error) {
     // DAVIDE _ HDR CREATION
     m_hdrCreationManager->clearFiles();
 
+    // the full decode of a raw file can fail later on, before the alignment
+    // or the merge
+    disconnect(m_hdrCreationManager.data(),
+               &HdrCreationManager::fullFramesLoaded, this,
+               &HdrWizard::alignFrames);
+    disconnect(m_hdrCreationManager.data(),
+               &HdrCreationManager::fullFramesLoaded, this,
+               &HdrWizard::mergeFrames);
+    m_processing = false;
+    m_Ui->cancelButton->setEnabled(true);
+    m_Ui->previewLabel->setEnabled(true);
+    m_Ui->alignGroupBox->setEnabled(true);
+    m_Ui->agGroupBox->setEnabled(true);
+    m_Ui->pagestack->setCurrentIndex(0);
+
     QApplication::restoreOverrideCursor();
 
     m_Ui->confirmloadlabel->setText(
@@ -678,19 +711,21 @@ void HdrWizard::NextFinishButtonClicked() {
                 m_Ui->EVgroupBox->setDisabled(true);
                 m_Ui->tableWidget->setDisabled(true);
                 repaint();
-                m_Ui->progressBar->setMaximum(0);
-                m_Ui->progressBar->setMinimum(0);
                 m_Ui->progressBar->show();
-                if (m_Ui->ais_radioButton->isChecked()) {
-                    m_Ui->textEdit->show();
-                    m_hdrCreationManager->set_ais_crop_flag(
-                        m_Ui->autoCropCheckBox->isChecked());
-                    m_hdrCreationManager->align_with_ais();
+                // the previews of raw files are not aligned: their full
+                // decode goes first, with its own progress
+                if (m_hdrCreationManager->hasPreviews()) {
+                    connect(m_hdrCreationManager.data(),
+                            &HdrCreationManager::fullFramesLoaded, this,
+                            &HdrWizard::alignFrames);
+                    m_hdrCreationManager->loadFullFrames();
                 } else {
-                    m_hdrCreationManager->align_with_mtb();
+                    alignFrames();
                 }
                 return;
             }
+            // the editing tools work on the previews of raw files, the full
+            // decode waits for the merge
             m_Ui->pagestack->setCurrentIndex(1);
         } break;
         case 1: {
@@ -707,6 +742,27 @@ void HdrWizard::NextFinishButtonClicked() {
     }
 }
 
+void HdrWizard::alignFrames() {
+    disconnect(m_hdrCreationManager.data(),
+               &HdrCreationManager::fullFramesLoaded, this,
+               &HdrWizard::alignFrames);
+
+    m_Ui->progressBar->setMaximum(0);
+    m_Ui->progressBar->setMinimum(0);
+    if (m_Ui->ais_radioButton->isChecked()) {
+        m_Ui->textEdit->show();
+        m_hdrCreationManager->set_ais_crop_flag(
+            m_Ui->autoCropCheckBox->isChecked());
+        m_hdrCreationManager->align_with_ais();
+    } else if (m_Ui->features_radioButton->isChecked()) {
+        // finishedAligning() comes back queued
+        QtConcurrent::run(boost::bind(&HdrCreationManager::align_with_features,
+                                      m_hdrCreationManager.data()));
+    } else {
+        m_hdrCreationManager->align_with_mtb();
+    }
+}
+
 void HdrWizard::startComputation() {
     m_processing = true;
     repaint();
@@ -714,6 +770,23 @@ void HdrWizard::startComputation() {
     m_Ui->NextFinishButton->setEnabled(false);
     m_Ui->cancelButton->setEnabled(false);
 
+    // the merge needs the full frames of the raw files
+    if (m_hdrCreationManager->hasPreviews()) {
+        connect(m_hdrCreationManager.data(),
+                &HdrCreationManager::fullFramesLoaded, this,
+                &HdrWizard::mergeFrames);
+        m_Ui->progressBar->show();
+        m_hdrCreationManager->loadFullFrames();
+        return;
+    }
+    mergeFrames();
+}
+
+void HdrWizard::mergeFrames() {
+    disconnect(m_hdrCreationManager.data(),
+               &HdrCreationManager::fullFramesLoaded, this,
+               &HdrWizard::mergeFrames);
+
     if (m_Ui->autoAG_checkBox->isChecked() &&
         !m_Ui->checkBoxEditingTools->isChecked()) {
         int num_images = m_hdrCreationManager->getData().size();
@@ -1062,7 +1135,9 @@ void HdrWizard::resizeEvent(QResizeEvent *) {
 }
 
 void HdrWizard::alignSelectionClicked() {
-    m_Ui->autoCropCheckBox->setEnabled(m_Ui->ais_radioButton->isChecked());
+    // only align_image_stack crops
+    m_Ui->autoCropCheckBox->setEnabled(m_Ui->alignCheckBox->isChecked() &&
+                                       m_Ui->ais_radioButton->isChecked());
 }
 
 void HdrWizard::reject() {
@@ -117,6 +117,8 @@ class HdrWizard : public QDialog {
 
     // void updateGraphicalEVvalue(float expotime, int index_in_table);
 
+    //! \brief runs the alignment chosen on the first page
+    void alignFrames();
     void finishedAligning(int);
     void alignSelectionClicked();
 
@@ -145,6 +147,8 @@ class HdrWizard : public QDialog {
     void updateThresholdSpinBox(double);
 
     void startComputation();
+    //! \brief anti-ghosting and merge, once the frames are the full ones
+    void mergeFrames();
     void createHdr();
     void createHdrFinished();
     void autoAntighostingFinished();
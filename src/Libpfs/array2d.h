@@ -25,9 +25,10 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
-#include <vector>
+#include <string>
 
 #include <Libpfs/strideiterator.h>
+#include <Libpfs/utils/alignedbuffer.h>
 
 //! \file array2d.h
 //! \brief general 2d array interface
@@ -37,6 +38,15 @@
 //! most likely, not compatible
 
 namespace pfs {
+
+//! \brief tag type selecting the constructor of \c Array2D that does not
+//! initialize its content
+struct Uninitialized {};
+
+//! \brief pass it to the constructor of \c Array2D when every element is
+//! going to be written before being read
+static const Uninitialized uninitialized = Uninitialized();
+
 //!
 //! \brief Two dimensional array of data
 //!
@@ -44,11 +54,13 @@ namespace pfs {
 //! order. Allows easy indexing and retrieving array dimensions.
 //! It offers an undirect access to the data (using (x)(y) or (elem) ) or a
 //! direct access to the data (using getRawData() or data()).
+//! Data are 64-byte aligned (16-byte when mapped on a file) and the memory
+//! is recycled through \c pfs::utils::BufferPool.
 //!
 template <typename Type>
 class Array2D {
    public:
-    typedef std::vector<Type> DataBuffer;
+    typedef utils::AlignedBuffer<Type> DataBuffer;
     typedef typename DataBuffer::value_type value_type;
     typedef Array2D<Type> self;
 
@@ -58,6 +70,10 @@ class Array2D {
     //! \brief init \c Array2D with a matrix of \a cols times \a rows
     Array2D(size_t cols, size_t rows);  // (width, height)
 
+    //! \brief init \c Array2D with a matrix of \a cols times \a rows, without
+    //! initializing its content
+    Array2D(size_t cols, size_t rows, Uninitialized);
+
     //! \brief copy ctor
     //! \note If you want to build an empty \c Array2D with the same size of the
     //! source, use the ctor that takes dimension and you will spare the copy
@@ -111,6 +127,15 @@ class Array2D {
     //! \brief Swap the content of the current instance with \a other
     void swap(self &other);
 
+    //! \brief replace the content with a \a cols x \a rows array read from
+    //! \a filename at byte \a offset. The file is mapped: pixels are paged
+    //! in on first access and copied on first write, the file is never
+    //! modified (see \c utils::BufferPool::mapFile()).
+    //! \return false, leaving the array untouched, if the file cannot be
+    //! mapped
+    bool mapFile(const std::string &filename, size_t offset, size_t cols,
+                 size_t rows);
+
    public:
     // element/row iterator
     typedef typename DataBuffer::iterator iterator;
@@ -138,7 +163,8 @@ class Array2D {
 
     // column iterator
     typedef StrideIterator<typename DataBuffer::iterator> col_iterator;
-    typedef StrideIterator<typename DataBuffer::iterator> const_col_iterator;
+    typedef StrideIterator<typename DataBuffer::const_iterator>
+        const_col_iterator;
 
     col_iterator col_begin(size_t n) {
         return col_iterator(begin() + n, getCols());
@@ -152,6 +178,17 @@ class Array2D {
         return col_begin(n) + getCols();
     }
 
+   protected:
+    //! \brief element storage, for derived classes that keep the data in a
+    //! different format for a while (see \c Channel::pack())
+    DataBuffer &storage() { return m_data; }
+
+    //! \brief change the size of the array without touching the storage
+    void setSize(size_t cols, size_t rows) {
+        m_cols = cols;
+        m_rows = rows;
+    }
+
    private:
     DataBuffer m_data;
 
@@ -46,6 +46,12 @@ Array2D<Type>::Array2D(size_t cols, size_t rows)
     assert(m_data.size() >= m_cols * m_rows);
 }
 
+template <typename Type>
+Array2D<Type>::Array2D(size_t cols, size_t rows, Uninitialized)
+    : m_data(cols * rows, false), m_cols(cols), m_rows(rows) {
+    assert(m_data.size() >= m_cols * m_rows);
+}
+
 template <typename Type>
 Array2D<Type>::Array2D(const self &rhs)
     : m_data(rhs.m_data), m_cols(rhs.m_cols), m_rows(rhs.m_rows) {
@@ -71,47 +77,48 @@ void Array2D<Type>::resize(size_t width, size_t height) {
     assert(m_data.size() >= m_cols * m_rows);
 }
 
+template <typename Type>
+bool Array2D<Type>::mapFile(const std::string &filename, size_t offset,
+                            size_t cols, size_t rows) {
+    if (!m_data.mapFile(filename, offset, cols * rows)) {
+        return false;
+    }
+    m_cols = cols;
+    m_rows = rows;
+    return true;
+}
+
 template <typename Type>
 void Array2D<Type>::swap(self &other) {
     std::swap(m_cols, other.m_cols);
     std::swap(m_rows, other.m_rows);
-    std::swap(m_data, other.m_data);
+    m_data.swap(other.m_data);
 }
 
 template <typename Type>
 inline Type &Array2D<Type>::operator()(size_t cols, size_t rows) {
-#ifndef NDEBUG
-    return m_data.at(rows * m_cols + cols);
-#else
+    assert(cols < m_cols);
+    assert(rows < m_rows);
     return m_data[rows * m_cols + cols];
-#endif
 }
 
 template <typename Type>
 inline const Type &Array2D<Type>::operator()(size_t cols, size_t rows) const {
-#ifndef NDEBUG
-    return m_data.at(rows * m_cols + cols);
-#else
+    assert(cols < m_cols);
+    assert(rows < m_rows);
     return m_data[rows * m_cols + cols];
-#endif
 }
 
 template <typename Type>
 inline Type &Array2D<Type>::operator()(size_t index) {
-#ifndef NDEBUG
-    return m_data.at(index);
-#else
+    assert(index < size());
     return m_data[index];
-#endif
 }
 
 template <typename Type>
 inline const Type &Array2D<Type>::operator()(size_t index) const {
-#ifndef NDEBUG
-    return m_data.at(index);
-#else
+    assert(index < size());
     return m_data[index];
-#endif
 }
 
 template <typename Type>
@@ -30,6 +30,12 @@ class Array2D;
 
 //! \brief typedef provided for backward compatibility with the old API
 typedef Array2D<float> Array2Df;
+
+template <typename Type>
+class Array2DView;
+
+typedef Array2DView<float> Array2DViewf;
+typedef Array2DView<const float> Array2DConstViewf;
 }  // namespace pfs
 
 #endif /* PFS_ARRAY2D_FWD_H */
@@ -0,0 +1,142 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_ARRAY2DVIEW_H
+#define PFS_ARRAY2DVIEW_H
+
+//! \file array2dview.h
+//! \brief non-owning, strided view on a rectangular region of an Array2D
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/array2d_fwd.h>
+
+namespace pfs {
+
+//! \brief Rectangular window (origin, width, height, row stride) on the data
+//! of an \c Array2D. The view does not own the data: building it costs
+//! nothing and it must not outlive the array it refers to.
+//! Use \c Array2DView<const T> for read-only access.
+template <typename Type>
+class Array2DView {
+   public:
+    typedef Type value_type;
+    typedef typename std::remove_const<Type>::type NonConstType;
+    typedef Type *iterator;
+
+    //! \brief empty view
+    Array2DView() : m_data(NULL), m_cols(0), m_rows(0), m_stride(0) {}
+
+    //! \brief view on raw memory: \a stride is the distance (in elements)
+    //! between the beginning of two consecutive rows
+    Array2DView(Type *data, size_t cols, size_t rows, size_t stride)
+        : m_data(data), m_cols(cols), m_rows(rows), m_stride(stride) {
+        assert(m_stride >= m_cols);
+    }
+
+    //! \brief view on the whole \a array
+    Array2DView(Array2D<NonConstType> &array)
+        : m_data(array.data()),
+          m_cols(array.getCols()),
+          m_rows(array.getRows()),
+          m_stride(array.getCols()) {}
+
+    //! \brief read-only view on the whole \a array
+    Array2DView(const Array2D<NonConstType> &array)
+        : m_data(array.data()),
+          m_cols(array.getCols()),
+          m_rows(array.getRows()),
+          m_stride(array.getCols()) {}
+
+    //! \brief view on the rectangle [\a x, \a x + \a cols) x
+    //! [\a y, \a y + \a rows) of \a array
+    Array2DView(Array2D<NonConstType> &array, size_t x, size_t y, size_t cols,
+                size_t rows)
+        : m_data(array.data() + y * array.getCols() + x),
+          m_cols(cols),
+          m_rows(rows),
+          m_stride(array.getCols()) {
+        assert(x + cols <= array.getCols());
+        assert(y + rows <= array.getRows());
+    }
+
+    //! \brief read-only view on a rectangle of \a array
+    Array2DView(const Array2D<NonConstType> &array, size_t x, size_t y,
+                size_t cols, size_t rows)
+        : m_data(array.data() + y * array.getCols() + x),
+          m_cols(cols),
+          m_rows(rows),
+          m_stride(array.getCols()) {
+        assert(x + cols <= array.getCols());
+        assert(y + rows <= array.getRows());
+    }
+
+    //! \brief read-only view on a writable one
+    template <typename OtherType>
+    Array2DView(const Array2DView<OtherType> &other)
+        : m_data(other.data()),
+          m_cols(other.getCols()),
+          m_rows(other.getRows()),
+          m_stride(other.getStride()) {}
+
+    size_t getCols() const { return m_cols; }
+    size_t getRows() const { return m_rows; }
+    size_t getStride() const { return m_stride; }
+    size_t size() const { return m_cols * m_rows; }
+
+    //! \return true if there is no gap between the rows of the view
+    bool isContiguous() const { return m_stride == m_cols || m_rows <= 1; }
+
+    //! \brief first element of the view
+    Type *data() const { return m_data; }
+
+    Type &operator()(size_t col, size_t row) const {
+        assert(col < m_cols);
+        assert(row < m_rows);
+        return m_data[row * m_stride + col];
+    }
+
+    iterator row_begin(size_t r) const { return m_data + r * m_stride; }
+    iterator row_end(size_t r) const { return row_begin(r) + m_cols; }
+
+    //! \brief subscript operators, returns the row \a n
+    iterator operator[](size_t n) const { return row_begin(n); }
+
+    //! \brief view on a rectangle of this view
+    Array2DView subView(size_t x, size_t y, size_t cols, size_t rows) const {
+        assert(x + cols <= m_cols);
+        assert(y + rows <= m_rows);
+        return Array2DView(m_data + y * m_stride + x, cols, rows, m_stride);
+    }
+
+   private:
+    Type *m_data;
+    size_t m_cols;
+    size_t m_rows;
+    size_t m_stride;
+};
+
+}  // namespace pfs
+
+#endif  // PFS_ARRAY2DVIEW_H
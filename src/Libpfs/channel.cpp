@@ -33,6 +33,64 @@ namespace pfs {
 Channel::Channel(size_t width, size_t height, const std::string &channelName)
     : ChannelData(width, height), m_name(channelName), m_tags() {}
 
+Channel::Channel(const Channel &other)
+    : ChannelData(),
+      m_name(other.m_name),
+      m_tags(other.m_tags),
+      m_packed(other.m_packed) {
+    if (isPacked()) {
+        setSize(other.getCols(), other.getRows());
+    } else {
+        ChannelData::operator=(other);
+    }
+}
+
+Channel &Channel::operator=(const Channel &other) {
+    Channel tmp(other);
+    ChannelData::swap(tmp);
+    m_name.swap(tmp.m_name);
+    m_tags.swap(tmp.m_tags);
+    m_packed.swap(tmp.m_packed);
+    return *this;
+}
+
 Channel::~Channel() {}
 
+void Channel::pack() {
+    if (isPacked() || size() == 0) return;
+
+    utils::AlignedBuffer<utils::half_t> packed(size(), false);
+    utils::floatToHalf(data(), packed.data(), size());
+
+    m_packed.swap(packed);
+    DataBuffer().swap(storage());
+}
+
+void Channel::unpack() {
+    if (!isPacked()) return;
+
+    DataBuffer unpacked(size(), false);
+    utils::halfToFloat(m_packed.data(), unpacked.data(), size());
+
+    storage().swap(unpacked);
+    utils::AlignedBuffer<utils::half_t>().swap(m_packed);
+}
+
+void Channel::resizePacked(size_t width, size_t height) {
+    DataBuffer().swap(storage());
+    utils::AlignedBuffer<utils::half_t>(width * height, false).swap(m_packed);
+    setSize(width, height);
+}
+
+void Channel::assignPacked(const Channel &other) {
+    if (other.isPacked()) {
+        DataBuffer().swap(storage());
+        m_packed = other.m_packed;
+        setSize(other.getWidth(), other.getHeight());
+    } else {
+        resizePacked(other.getWidth(), other.getHeight());
+        utils::floatToHalf(other.data(), m_packed.data(), size());
+    }
+}
+
 }  // pfs
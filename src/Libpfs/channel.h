@@ -33,6 +33,8 @@
 
 #include <Libpfs/array2d.h>
 #include <Libpfs/tag.h>
+#include <Libpfs/utils/alignedbuffer.h>
+#include <Libpfs/utils/half.h>
 
 namespace pfs {
 
@@ -44,6 +46,9 @@ class Channel : public Array2D<float> {
 
     Channel(size_t width, size_t height, const std::string &channelName);
 
+    Channel(const Channel &other);
+    Channel &operator=(const Channel &other);
+
     virtual ~Channel();
 
     using ChannelData::data;
@@ -74,9 +79,33 @@ class Channel : public Array2D<float> {
     //    inline ChannelData* getChannelData();
     //    inline const ChannelData* getChannelData() const;
 
+    //! \brief A packed channel holds its pixels as 16-bit floats, at half
+    //! the memory. Its size is unchanged, but the float data (data(),
+    //! iterators, subscripts) is not available until \c unpack().
+    //! \c Frame unpacks its channels transparently on access.
+    bool isPacked() const { return m_packed.size() != 0; }
+
+    //! \brief convert the pixels to 16-bit floats and release the float data
+    void pack();
+
+    //! \brief convert the pixels back to 32-bit floats
+    void unpack();
+
+    //! \brief discard the pixels and resize the channel to \a width x
+    //! \a height packed pixels, left uninitialized
+    void resizePacked(size_t width, size_t height);
+
+    //! \brief replace the pixels with a packed copy of the pixels of \a other
+    void assignPacked(const Channel &other);
+
+    //! \brief packed pixels, NULL if the channel is not packed
+    utils::half_t *packedData() { return m_packed.data(); }
+    const utils::half_t *packedData() const { return m_packed.data(); }
+
    private:
     std::string m_name;
     TagContainer m_tags;
+    utils::AlignedBuffer<utils::half_t> m_packed;
 };
 
 }  // namespace pfs
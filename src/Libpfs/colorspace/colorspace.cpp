@@ -31,15 +31,18 @@
 
 #include "colorspace.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <iostream>
 #include <map>
 
 #include "Libpfs/array2d.h"
+#include "Libpfs/array2dview.h"
 #include "Libpfs/pfs.h"
 #include "Libpfs/utils/msec_timer.h"
 
+#include "Libpfs/colorspace/kernels.h"
 #include "Libpfs/colorspace/rgb.h"
 #include "Libpfs/colorspace/xyz.h"
 #include "Libpfs/colorspace/yuv.h"
@@ -52,6 +55,142 @@ using namespace boost::assign;
 
 namespace pfs {
 
+namespace {
+
+struct ConvertXYZ2Yuv {
+    void operator()(float X, float Y, float Z, float &outY, float &u,
+                    float &v) const {
+        float x = X / (X + Y + Z);
+        float y = Y / (X + Y + Z);
+
+        // assert((4.f*nx / (-2.f*nx + 12.f*ny + 3.f)) <= 0.62 );
+        // assert( (9.f*ny / (-2.f*nx + 12.f*ny + 3.f)) <= 0.62 );
+
+        u = 4.f * x / (-2.f * x + 12.f * y + 3.f);
+        v = 9.f * y / (-2.f * x + 12.f * y + 3.f);
+        outY = Y;
+    }
+};
+
+struct ConvertYuv2XYZ {
+    void operator()(float Y, float u, float v, float &X, float &outY,
+                    float &Z) const {
+        float x = 9.f * u / (6.f * u - 16.f * v + 12.f);
+        float y = 4.f * v / (6.f * u - 16.f * v + 12.f);
+
+        X = x / y * Y;
+        Z = (1.f - x - y) / y * Y;
+        outY = Y;
+    }
+};
+
+struct ConvertYxy2XYZ {
+    void operator()(float Y, float x, float y, float &X, float &outY,
+                    float &Z) const {
+        X = x / y * Y;
+        Z = (1.f - x - y) / y * Y;
+        outY = Y;
+    }
+};
+
+struct ConvertXYZ2Yxy {
+    void operator()(float X, float Y, float Z, float &outY, float &x,
+                    float &y) const {
+        x = X / (X + Y + Z);
+        y = Y / (X + Y + Z);
+
+        outY = Y;
+    }
+};
+
+//! \brief apply \a convOp to every pixel of a (possibly strided) region
+template <typename ConversionOperator>
+void transformView(const Array2DConstViewf &inC1, const Array2DConstViewf &inC2,
+                   const Array2DConstViewf &inC3, Array2Df *outC1,
+                   Array2Df *outC2, Array2Df *outC3) {
+    const ConversionOperator convOp = ConversionOperator();
+    const int rows = static_cast<int>(inC1.getRows());
+    const int cols = static_cast<int>(inC1.getCols());
+
+#pragma omp parallel for
+    for (int r = 0; r < rows; ++r) {
+        const float *in1 = inC1.row_begin(r);
+        const float *in2 = inC2.row_begin(r);
+        const float *in3 = inC3.row_begin(r);
+        float *out1 = outC1->row_begin(r);
+        float *out2 = outC2->row_begin(r);
+        float *out3 = outC3->row_begin(r);
+
+        for (int c = 0; c < cols; ++c) {
+            convOp(in1[c], in2[c], in3[c], out1[c], out2[c], out3[c]);
+        }
+    }
+}
+
+using colorspace::TRANSFER_LINEAR;
+using colorspace::TRANSFER_SRGB;
+
+// samples converted by each task of the parallel loops
+const size_t BLOCK_SIZE = 16 * 1024;
+
+//! \brief o = OUT(MAT * IN(i)) on whole arrays, through the vectorized
+//! kernels
+template <const float (&MAT)[3][3], colorspace::TransferFunction IN,
+          colorspace::TransferFunction OUT>
+void transformMatrix(const Array2Df *inC1, const Array2Df *inC2,
+                     const Array2Df *inC3, Array2Df *outC1, Array2Df *outC2,
+                     Array2Df *outC3) {
+    const size_t size = inC1->size();
+    const long blocks = static_cast<long>((size + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+#pragma omp parallel for if (blocks > 1)
+    for (long b = 0; b < blocks; ++b) {
+        const size_t first = b * BLOCK_SIZE;
+        colorspace::transformMatrix(
+            inC1->data() + first, inC2->data() + first, inC3->data() + first,
+            outC1->data() + first, outC2->data() + first,
+            outC3->data() + first, std::min(BLOCK_SIZE, size - first), MAT, IN,
+            OUT);
+    }
+}
+
+//! \brief o = MAT[1] . IN(i) on whole arrays (luminance only)
+template <const float (&MAT)[3][3], colorspace::TransferFunction IN>
+void transformMatrixY(const Array2Df *inC1, const Array2Df *inC2,
+                      const Array2Df *inC3, Array2Df *outC1) {
+    const size_t size = inC1->size();
+    const long blocks = static_cast<long>((size + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+#pragma omp parallel for if (blocks > 1)
+    for (long b = 0; b < blocks; ++b) {
+        const size_t first = b * BLOCK_SIZE;
+        colorspace::transformMatrix(inC1->data() + first, inC2->data() + first,
+                                    inC3->data() + first, outC1->data() + first,
+                                    std::min(BLOCK_SIZE, size - first), MAT[1],
+                                    IN);
+    }
+}
+
+//! \brief same as \c transformMatrix, one row of the views at a time
+template <const float (&MAT)[3][3], colorspace::TransferFunction IN,
+          colorspace::TransferFunction OUT>
+void transformMatrixView(const Array2DConstViewf &inC1,
+                         const Array2DConstViewf &inC2,
+                         const Array2DConstViewf &inC3, Array2Df *outC1,
+                         Array2Df *outC2, Array2Df *outC3) {
+    const int rows = static_cast<int>(inC1.getRows());
+
+#pragma omp parallel for
+    for (int r = 0; r < rows; ++r) {
+        colorspace::transformMatrix(inC1.row_begin(r), inC2.row_begin(r),
+                                    inC3.row_begin(r), outC1->row_begin(r),
+                                    outC2->row_begin(r), outC3->row_begin(r),
+                                    inC1.getCols(), MAT, IN, OUT);
+    }
+}
+}
+
+
 //-----------------------------------------------------------
 // sRGB conversion functions
 //-----------------------------------------------------------
@@ -63,9 +202,8 @@ void transformSRGB2XYZ(const Array2Df *inC1, const Array2Df *inC2,
     f_timer.start();
 #endif
 
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertSRGB2XYZ());
+    transformMatrix<colorspace::rgb2xyzD65Mat, TRANSFER_SRGB,
+                    TRANSFER_LINEAR>(inC1, inC2, inC3, outC1, outC2, outC3);
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
@@ -75,8 +213,8 @@ void transformSRGB2XYZ(const Array2Df *inC1, const Array2Df *inC2,
 }
 void transformSRGB2Y(const Array2Df *inC1, const Array2Df *inC2,
                      const Array2Df *inC3, Array2Df *outC1) {
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), colorspace::ConvertSRGB2Y());
+    transformMatrixY<colorspace::rgb2xyzD65Mat, TRANSFER_SRGB>(inC1, inC2, inC3,
+                                                               outC1);
 }
 
 //-----------------------------------------------------------
@@ -90,9 +228,8 @@ void transformRGB2XYZ(const Array2Df *inC1, const Array2Df *inC2,
     f_timer.start();
 #endif
 
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertRGB2XYZ());
+    transformMatrix<colorspace::rgb2xyzD65Mat, TRANSFER_LINEAR,
+                    TRANSFER_LINEAR>(inC1, inC2, inC3, outC1, outC2, outC3);
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
@@ -103,8 +240,8 @@ void transformRGB2XYZ(const Array2Df *inC1, const Array2Df *inC2,
 
 void transformRGB2Y(const Array2Df *inC1, const Array2Df *inC2,
                     const Array2Df *inC3, Array2Df *outC1) {
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), colorspace::ConvertRGB2Y());
+    transformMatrixY<colorspace::rgb2xyzD65Mat, TRANSFER_LINEAR>(inC1, inC2,
+                                                                 inC3, outC1);
 }
 
 void transformRGB2Yuv(const Array2Df *inC1, const Array2Df *inC2,
@@ -115,9 +252,8 @@ void transformRGB2Yuv(const Array2Df *inC1, const Array2Df *inC2,
     f_timer.start();
 #endif
 
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertRGB2YUV());
+    transformMatrix<colorspace::rgb2yuvMat, TRANSFER_LINEAR,
+                    TRANSFER_LINEAR>(inC1, inC2, inC3, outC1, outC2, outC3);
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
@@ -134,9 +270,8 @@ void transformXYZ2SRGB(const Array2Df *inC1, const Array2Df *inC2,
     f_timer.start();
 #endif
 
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertXYZ2SRGB());
+    transformMatrix<colorspace::xyz2rgbD65Mat, TRANSFER_LINEAR,
+                    TRANSFER_SRGB>(inC1, inC2, inC3, outC1, outC2, outC3);
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
@@ -153,9 +288,8 @@ void transformXYZ2RGB(const Array2Df *inC1, const Array2Df *inC2,
     f_timer.start();
 #endif
 
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertXYZ2RGB());
+    transformMatrix<colorspace::xyz2rgbD65Mat, TRANSFER_LINEAR,
+                    TRANSFER_LINEAR>(inC1, inC2, inC3, outC1, outC2, outC3);
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
@@ -167,38 +301,17 @@ void transformXYZ2RGB(const Array2Df *inC1, const Array2Df *inC2,
 void transformXYZ2Yuv(const Array2Df *inC1, const Array2Df *inC2,
                       const Array2Df *inC3, Array2Df *outC1, Array2Df *outC2,
                       Array2Df *outC3) {
-    const int elems = inC1->getRows() * inC1->getCols();
-    for (int idx = 0; idx < elems; idx++) {
-        const float &X = (*inC1)(idx), Y = (*inC2)(idx), &Z = (*inC3)(idx);
-        float &outY = (*outC1)(idx), &u = (*outC2)(idx), &v = (*outC3)(idx);
-
-        float x = X / (X + Y + Z);
-        float y = Y / (X + Y + Z);
-
-        // assert((4.f*nx / (-2.f*nx + 12.f*ny + 3.f)) <= 0.62 );
-        // assert( (9.f*ny / (-2.f*nx + 12.f*ny + 3.f)) <= 0.62 );
-
-        u = 4.f * x / (-2.f * x + 12.f * y + 3.f);
-        v = 9.f * y / (-2.f * x + 12.f * y + 3.f);
-        outY = Y;
-    }
+    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
+                     outC1->begin(), outC2->begin(), outC3->begin(),
+                     ConvertXYZ2Yuv());
 }
 
 void transformYuv2XYZ(const Array2Df *inC1, const Array2Df *inC2,
                       const Array2Df *inC3, Array2Df *outC1, Array2Df *outC2,
                       Array2Df *outC3) {
-    const int elems = inC1->getRows() * inC1->getCols();
-    for (int idx = 0; idx < elems; idx++) {
-        const float Y = (*inC1)(idx), &u = (*inC2)(idx), &v = (*inC3)(idx);
-        float &X = (*outC1)(idx), &outY = (*outC2)(idx), &Z = (*outC3)(idx);
-
-        float x = 9.f * u / (6.f * u - 16.f * v + 12.f);
-        float y = 4.f * v / (6.f * u - 16.f * v + 12.f);
-
-        X = x / y * Y;
-        Z = (1.f - x - y) / y * Y;
-        outY = Y;
-    }
+    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
+                     outC1->begin(), outC2->begin(), outC3->begin(),
+                     ConvertYuv2XYZ());
 }
 
 void transformYuv2RGB(const Array2Df *inC1, const Array2Df *inC2,
@@ -209,9 +322,8 @@ void transformYuv2RGB(const Array2Df *inC1, const Array2Df *inC2,
     f_timer.start();
 #endif
 
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertYUV2RGB());
+    transformMatrix<colorspace::yuv2rgbMat, TRANSFER_LINEAR,
+                    TRANSFER_LINEAR>(inC1, inC2, inC3, outC1, outC2, outC3);
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
@@ -223,30 +335,17 @@ void transformYuv2RGB(const Array2Df *inC1, const Array2Df *inC2,
 void transformYxy2XYZ(const Array2Df *inC1, const Array2Df *inC2,
                       const Array2Df *inC3, Array2Df *outC1, Array2Df *outC2,
                       Array2Df *outC3) {
-    const int elems = inC1->getRows() * inC1->getCols();
-    for (int idx = 0; idx < elems; idx++) {
-        const float Y = (*inC1)(idx), x = (*inC2)(idx), y = (*inC3)(idx);
-        float &X = (*outC1)(idx), &outY = (*outC2)(idx), &Z = (*outC3)(idx);
-
-        X = x / y * Y;
-        Z = (1.f - x - y) / y * Y;
-        outY = Y;
-    }
+    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
+                     outC1->begin(), outC2->begin(), outC3->begin(),
+                     ConvertYxy2XYZ());
 }
 
 void transformXYZ2Yxy(const Array2Df *inC1, const Array2Df *inC2,
                       const Array2Df *inC3, Array2Df *outC1, Array2Df *outC2,
                       Array2Df *outC3) {
-    const int elems = inC1->getRows() * inC1->getCols();
-    for (int idx = 0; idx < elems; idx++) {
-        const float X = (*inC1)(idx), Y = (*inC2)(idx), Z = (*inC3)(idx);
-        float &outY = (*outC1)(idx), &x = (*outC2)(idx), &y = (*outC3)(idx);
-
-        x = X / (X + Y + Z);
-        y = Y / (X + Y + Z);
-
-        outY = Y;
-    }
+    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
+                     outC1->begin(), outC2->begin(), outC3->begin(),
+                     ConvertXYZ2Yxy());
 }
 
 typedef void (*CSTransformFunc)(const Array2Df *inC1, const Array2Df *inC2,
@@ -304,4 +403,65 @@ void transformColorSpace(ColorSpace inCS, const Array2Df *inC1,
     // CSTransformFunc func =
     (itTransform->second)(inC1, inC2, inC3, outC1, outC2, outC3);
 }
+
+typedef void (*CSViewTransformFunc)(const Array2DConstViewf &inC1,
+                                    const Array2DConstViewf &inC2,
+                                    const Array2DConstViewf &inC3,
+                                    Array2Df *outC1, Array2Df *outC2,
+                                    Array2Df *outC3);
+typedef std::map<CSTransformProfile, CSViewTransformFunc> CSViewTransformMap;
+
+void transformColorSpace(ColorSpace inCS, const Array2DConstViewf &inC1,
+                         const Array2DConstViewf &inC2,
+                         const Array2DConstViewf &inC3, ColorSpace outCS,
+                         Array2Df *outC1, Array2Df *outC2, Array2Df *outC3) {
+    assert(inC1.getCols() == inC2.getCols() &&
+           inC2.getCols() == inC3.getCols() &&
+           inC3.getCols() == outC1->getCols() &&
+           outC1->getCols() == outC2->getCols() &&
+           outC2->getCols() == outC3->getCols());
+
+    assert(inC1.getRows() == inC2.getRows() &&
+           inC2.getRows() == inC3.getRows() &&
+           inC3.getRows() == outC1->getRows() &&
+           outC1->getRows() == outC2->getRows() &&
+           outC2->getRows() == outC3->getRows());
+
+    static CSViewTransformMap s_csViewTransformMap = map_list_of
+        // XYZ -> *
+        (CSTransformProfile(CS_XYZ, CS_SRGB),
+         transformMatrixView<colorspace::xyz2rgbD65Mat, TRANSFER_LINEAR,
+                             TRANSFER_SRGB>)(
+            CSTransformProfile(CS_XYZ, CS_RGB),
+            transformMatrixView<colorspace::xyz2rgbD65Mat, TRANSFER_LINEAR,
+                                TRANSFER_LINEAR>)(
+            CSTransformProfile(CS_XYZ, CS_YUV), transformView<ConvertXYZ2Yuv>)(
+            CSTransformProfile(CS_XYZ, CS_Yxy), transformView<ConvertXYZ2Yxy>)
+        // sRGB -> *
+        (CSTransformProfile(CS_SRGB, CS_XYZ),
+         transformMatrixView<colorspace::rgb2xyzD65Mat, TRANSFER_SRGB,
+                             TRANSFER_LINEAR>)
+        // RGB -> *
+        (CSTransformProfile(CS_RGB, CS_XYZ),
+         transformMatrixView<colorspace::rgb2xyzD65Mat, TRANSFER_LINEAR,
+                             TRANSFER_LINEAR>)(
+            CSTransformProfile(CS_RGB, CS_YUV),
+            transformMatrixView<colorspace::rgb2yuvMat, TRANSFER_LINEAR,
+                                TRANSFER_LINEAR>)
+        // Yuv -> *
+        (CSTransformProfile(CS_YUV, CS_XYZ), transformView<ConvertYuv2XYZ>)(
+            CSTransformProfile(CS_YUV, CS_RGB),
+            transformMatrixView<colorspace::yuv2rgbMat, TRANSFER_LINEAR,
+                                TRANSFER_LINEAR>)
+        // Yxy -> *
+        (CSTransformProfile(CS_Yxy, CS_XYZ), transformView<ConvertYxy2XYZ>);
+
+    CSViewTransformMap::const_iterator itTransform =
+        s_csViewTransformMap.find(CSTransformProfile(inCS, outCS));
+
+    if (itTransform == s_csViewTransformMap.end()) {
+        throw Exception("Unsupported color tranform");
+    }
+    (itTransform->second)(inC1, inC2, inC3, outC1, outC2, outC3);
+}
 }  // namespace pfs
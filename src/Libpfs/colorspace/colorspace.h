@@ -116,6 +116,15 @@ void transformColorSpace(ColorSpace inCS, const Array2Df *inC1,
                          const Array2Df *inC2, const Array2Df *inC3,
                          ColorSpace outCS, Array2Df *outC1, Array2Df *outC2,
                          Array2Df *outC3);
+
+//! \brief Same as above, but the input is read through (possibly strided)
+//! views, so that a region of interest can be converted without cropping it
+//! first. Output channels must have the size of the views and must not
+//! overlap the input.
+void transformColorSpace(ColorSpace inCS, const Array2DConstViewf &inC1,
+                         const Array2DConstViewf &inC2,
+                         const Array2DConstViewf &inC3, ColorSpace outCS,
+                         Array2Df *outC1, Array2Df *outC2, Array2Df *outC3);
 }
 
 #endif  // COLORSPACE_H
@@ -0,0 +1,291 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Vectorized 3x3 matrix + transfer function kernels, with runtime
+//! dispatch on the instruction set of the CPU
+//!
+//! The kernels are written once, branch-free, and compiled for each
+//! instruction set through the \c target attribute: every loop is a
+//! \c omp \c simd loop, so each copy is vectorized at the width of its
+//! instruction set. The sRGB curve uses a polynomial pow() (log2/exp2
+//! decomposition) accurate to a few ulps instead of calling \c powf.
+
+#include <Libpfs/colorspace/kernels.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define LUMINANCE_KERNELS_DISPATCH
+#define KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#define KERNEL_INLINE inline
+#endif
+
+namespace pfs {
+namespace colorspace {
+
+namespace {
+
+KERNEL_INLINE float asFloat(uint32_t i) {
+    float f;
+    std::memcpy(&f, &i, sizeof(f));
+    return f;
+}
+
+KERNEL_INLINE uint32_t asInt(float f) {
+    uint32_t i;
+    std::memcpy(&i, &f, sizeof(i));
+    return i;
+}
+
+//! \brief log2(x) for x > 0 and normal
+KERNEL_INLINE float fastLog2(float x) {
+    const uint32_t bits = asInt(x);
+    float e = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+    // mantissa in [1, 2), moved into [sqrt(0.5), sqrt(2))
+    float m = asFloat((bits & 0x007fffff) | 0x3f800000);
+    const bool big = m > 1.41421356f;
+    m *= big ? 0.5f : 1.f;
+    e += big ? 1.f : 0.f;
+
+    // ln(m) = 2 atanh(s), |s| < 0.172
+    const float s = (m - 1.f) / (m + 1.f);
+    const float s2 = s * s;
+    const float p =
+        1.f +
+        s2 * (1.f / 3.f +
+              s2 * (1.f / 5.f + s2 * (1.f / 7.f + s2 * (1.f / 9.f))));
+    return e + (2.f * 1.44269504f) * s * p;
+}
+
+//! \brief 2^x, x is clamped to the range of normal floats
+KERNEL_INLINE float fastExp2(float x) {
+    x = std::min(std::max(x, -126.f), 127.f);
+
+    // x = n + f, f in [-0.5, 0.5)
+    const int n = static_cast<int>(x + 127.5f) - 127;
+    const float f = (x - static_cast<float>(n)) * 0.69314718f;
+
+    const float p =
+        1.f +
+        f * (1.f +
+             f * (1.f / 2.f +
+                  f * (1.f / 6.f +
+                       f * (1.f / 24.f +
+                            f * (1.f / 120.f +
+                                 f * (1.f / 720.f + f * (1.f / 5040.f)))))));
+    return p * asFloat(static_cast<uint32_t>(n + 127) << 23);
+}
+
+KERNEL_INLINE float fastPow(float x, float y) {
+    x = std::max(x, 1e-30f);
+    return fastExp2(y * fastLog2(x));
+}
+
+//! \brief same as \c ConvertSRGB2RGB
+KERNEL_INLINE float srgbToLinear(float x) {
+    const float a = std::fabs(x);
+    const float p = fastPow((a + 0.055f) * (1.f / 1.055f), 2.4f);
+    const float l = a * (1.f / 12.92f);
+    const float r = a > 0.04045f ? p : l;
+    return std::copysign(r, x);
+}
+
+//! \brief same as \c ConvertRGB2SRGB
+KERNEL_INLINE float linearToSrgb(float x) {
+    const float p = fastPow(std::fabs(x), 1.f / 2.4f);
+    const float l = x * 12.92f;
+    const float pos = 1.055f * p - 0.055f;
+    const float neg = (0.055f - 1.f) * p - 0.055f;
+    const float r = x > 0.0031308f ? pos : l;
+    return x < -0.0031308f ? neg : r;
+}
+
+template <TransferFunction TF>
+KERNEL_INLINE float expand(float x) {
+    return TF == TRANSFER_SRGB ? srgbToLinear(x) : x;
+}
+
+template <TransferFunction TF>
+KERNEL_INLINE float compand(float x) {
+    return TF == TRANSFER_SRGB ? linearToSrgb(x) : x;
+}
+
+template <TransferFunction IN, TransferFunction OUT>
+KERNEL_INLINE void matrixKernel(const float *in1, const float *in2,
+                                const float *in3, float *out1, float *out2,
+                                float *out3, size_t size,
+                                const float mat[3][3]) {
+    const float m00 = mat[0][0], m01 = mat[0][1], m02 = mat[0][2];
+    const float m10 = mat[1][0], m11 = mat[1][1], m12 = mat[1][2];
+    const float m20 = mat[2][0], m21 = mat[2][1], m22 = mat[2][2];
+
+    const long n = static_cast<long>(size);
+#pragma omp simd
+    for (long idx = 0; idx < n; ++idx) {
+        const float i1 = expand<IN>(in1[idx]);
+        const float i2 = expand<IN>(in2[idx]);
+        const float i3 = expand<IN>(in3[idx]);
+
+        out1[idx] = compand<OUT>(m00 * i1 + m01 * i2 + m02 * i3);
+        out2[idx] = compand<OUT>(m10 * i1 + m11 * i2 + m12 * i3);
+        out3[idx] = compand<OUT>(m20 * i1 + m21 * i2 + m22 * i3);
+    }
+}
+
+template <TransferFunction IN>
+KERNEL_INLINE void rowKernel(const float *in1, const float *in2,
+                             const float *in3, float *out, size_t size,
+                             const float row[3]) {
+    const float r0 = row[0], r1 = row[1], r2 = row[2];
+
+    const long n = static_cast<long>(size);
+#pragma omp simd
+    for (long idx = 0; idx < n; ++idx) {
+        out[idx] = r0 * expand<IN>(in1[idx]) + r1 * expand<IN>(in2[idx]) +
+                   r2 * expand<IN>(in3[idx]);
+    }
+}
+
+typedef void (*MatrixFunc)(const float *, const float *, const float *,
+                           float *, float *, float *, size_t,
+                           const float[3][3], TransferFunction,
+                           TransferFunction);
+typedef void (*RowFunc)(const float *, const float *, const float *, float *,
+                        size_t, const float[3], TransferFunction);
+
+// one copy of the dispatchers for each instruction set
+#define LUMINANCE_KERNELS(SUFFIX, TARGET)                                      \
+    TARGET void matrix##SUFFIX(const float *in1, const float *in2,            \
+                               const float *in3, float *out1, float *out2,    \
+                               float *out3, size_t size,                      \
+                               const float mat[3][3], TransferFunction inTf,  \
+                               TransferFunction outTf) {                      \
+        if (inTf == TRANSFER_SRGB && outTf == TRANSFER_SRGB) {                 \
+            matrixKernel<TRANSFER_SRGB, TRANSFER_SRGB>(                        \
+                in1, in2, in3, out1, out2, out3, size, mat);                   \
+        } else if (inTf == TRANSFER_SRGB) {                                    \
+            matrixKernel<TRANSFER_SRGB, TRANSFER_LINEAR>(                      \
+                in1, in2, in3, out1, out2, out3, size, mat);                   \
+        } else if (outTf == TRANSFER_SRGB) {                                   \
+            matrixKernel<TRANSFER_LINEAR, TRANSFER_SRGB>(                      \
+                in1, in2, in3, out1, out2, out3, size, mat);                   \
+        } else {                                                               \
+            matrixKernel<TRANSFER_LINEAR, TRANSFER_LINEAR>(                    \
+                in1, in2, in3, out1, out2, out3, size, mat);                   \
+        }                                                                      \
+    }                                                                          \
+    TARGET void row##SUFFIX(const float *in1, const float *in2,               \
+                            const float *in3, float *out, size_t size,        \
+                            const float row[3], TransferFunction inTf) {      \
+        if (inTf == TRANSFER_SRGB) {                                           \
+            rowKernel<TRANSFER_SRGB>(in1, in2, in3, out, size, row);           \
+        } else {                                                               \
+            rowKernel<TRANSFER_LINEAR>(in1, in2, in3, out, size, row);         \
+        }                                                                      \
+    }
+
+LUMINANCE_KERNELS(Generic, )
+#ifdef LUMINANCE_KERNELS_DISPATCH
+LUMINANCE_KERNELS(AVX2, __attribute__((target("avx2,fma"))))
+LUMINANCE_KERNELS(AVX512, __attribute__((target("avx512f"))))
+#endif
+
+#undef LUMINANCE_KERNELS
+
+SimdLevel detectSimdLevel() {
+#ifdef LUMINANCE_KERNELS_DISPATCH
+    // runs during static initialization
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SIMD_AVX2;
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return SIMD_SSE2;
+#else
+    return SIMD_NONE;
+#endif
+}
+
+// the generic kernels are built for the baseline of the build: SSE2 on
+// x86-64, plain C elsewhere
+SimdLevel s_simdLevel = maxSimdLevel();
+}
+
+SimdLevel maxSimdLevel() {
+    static const SimdLevel s_maxLevel = detectSimdLevel();
+    return s_maxLevel;
+}
+
+SimdLevel simdLevel() { return s_simdLevel; }
+
+void setSimdLevel(SimdLevel level) {
+    s_simdLevel = level < maxSimdLevel() ? level : maxSimdLevel();
+}
+
+void transformMatrix(const float *in1, const float *in2, const float *in3,
+                     float *out1, float *out2, float *out3, size_t size,
+                     const float mat[3][3], TransferFunction inTransfer,
+                     TransferFunction outTransfer) {
+    MatrixFunc func = &matrixGeneric;
+#ifdef LUMINANCE_KERNELS_DISPATCH
+    switch (s_simdLevel) {
+        case SIMD_AVX512:
+            func = &matrixAVX512;
+            break;
+        case SIMD_AVX2:
+            func = &matrixAVX2;
+            break;
+        default:
+            break;
+    }
+#endif
+    func(in1, in2, in3, out1, out2, out3, size, mat, inTransfer, outTransfer);
+}
+
+void transformMatrix(const float *in1, const float *in2, const float *in3,
+                     float *out, size_t size, const float row[3],
+                     TransferFunction inTransfer) {
+    RowFunc func = &rowGeneric;
+#ifdef LUMINANCE_KERNELS_DISPATCH
+    switch (s_simdLevel) {
+        case SIMD_AVX512:
+            func = &rowAVX512;
+            break;
+        case SIMD_AVX2:
+            func = &rowAVX2;
+            break;
+        default:
+            break;
+    }
+#endif
+    func(in1, in2, in3, out, size, row, inTransfer);
+}
+
+}  // colorspace
+}  // pfs
@@ -0,0 +1,75 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Vectorized 3x3 matrix + transfer function kernels, with runtime
+//! dispatch on the instruction set of the CPU
+
+#ifndef PFS_COLORSPACE_KERNELS_H
+#define PFS_COLORSPACE_KERNELS_H
+
+#include <cstddef>
+
+namespace pfs {
+namespace colorspace {
+
+//! \brief transfer function applied by the kernels to their input (expansion)
+//! or to their output (companding)
+enum TransferFunction {
+    TRANSFER_LINEAR = 0,
+    TRANSFER_SRGB = 1  //!< same curve of \c ConvertSRGB2RGB/ConvertRGB2SRGB
+};
+
+//! \brief instruction sets the kernels are compiled for. \c SIMD_NONE and
+//! \c SIMD_SSE2 both run the kernels built for the baseline of the build
+//! (SSE2 on x86-64).
+enum SimdLevel {
+    SIMD_NONE = 0,
+    SIMD_SSE2 = 1,
+    SIMD_AVX2 = 2,
+    SIMD_AVX512 = 3
+};
+
+//! \return the instruction set used by the kernels
+SimdLevel simdLevel();
+
+//! \brief use at most \a level (the best level supported by the CPU if
+//! \a level is higher). Mostly meant for testing and benchmarking.
+void setSimdLevel(SimdLevel level);
+
+//! \return the best instruction set supported by this CPU and this build
+SimdLevel maxSimdLevel();
+
+//! \brief o = outTransfer(mat * inTransfer(i)) for \a size samples.
+//! The output may point to the same memory of the input.
+void transformMatrix(const float *in1, const float *in2, const float *in3,
+                     float *out1, float *out2, float *out3, size_t size,
+                     const float mat[3][3], TransferFunction inTransfer,
+                     TransferFunction outTransfer);
+
+//! \brief o = row . inTransfer(i) for \a size samples (e.g. RGB -> Y)
+void transformMatrix(const float *in1, const float *in2, const float *in3,
+                     float *out, size_t size, const float row[3],
+                     TransferFunction inTransfer);
+
+}  // colorspace
+}  // pfs
+
+#endif  // PFS_COLORSPACE_KERNELS_H
@@ -75,3 +75,31 @@ Remapper<uint8_t>::Remapper(RGBMappingType mappingMethod)
         m_lut[idx] = 255.f * callback(float(idx) / 255.f);
     }
 }
+
+namespace {
+// same as Normalizer, Clamp<float>(0.f, 1.f) and convertSample<uint8_t>
+inline uint8_t quantize(float sample, float min, float range) {
+    float v = (sample - min) / range;
+    v = v > 0.f ? v : 0.f;  // NaN as well
+    v = v < 1.f ? v : 1.f;
+    return static_cast<uint8_t>(v * 255.f + 0.5f);
+}
+}
+
+void Remapper<uint8_t>::interleave(const float *r, const float *g,
+                                   const float *b, size_t size, float min,
+                                   float max, uint8_t *rgb) const {
+    const float range = max - min;
+    assert(range != 0.f);
+
+    const long n = static_cast<long>(size);
+#pragma omp simd
+    for (long idx = 0; idx < n; ++idx) {
+        rgb[3 * idx] = quantize(r[idx], min, range);
+        rgb[3 * idx + 1] = quantize(g[idx], min, range);
+        rgb[3 * idx + 2] = quantize(b[idx], min, range);
+    }
+    for (long idx = 0; idx < 3 * n; ++idx) {
+        rgb[idx] = m_lut[rgb[idx]];
+    }
+}
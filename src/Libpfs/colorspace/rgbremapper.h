@@ -30,6 +30,7 @@
 
 #include <stdint.h>
 #include <array>
+#include <cstddef>
 
 #include <Libpfs/colorspace/convert.h>
 #include <Libpfs/colorspace/rgbremapper_fwd.h>
@@ -107,6 +108,12 @@ class Remapper<uint8_t> : public RemapperBase {
         o3 = (*this)(i3);
     }
 
+    //! \brief Normalizer(\a min, \a max), clamp to [0, 1] and this remapper
+    //! in a single vectorized pass: \a size samples of \a r, \a g and \a b
+    //! are stored interleaved in \a rgb (NaN are stored as 0)
+    void interleave(const float *r, const float *g, const float *b,
+                    size_t size, float min, float max, uint8_t *rgb) const;
+
    private:
     RGBMappingType m_mappingMethod;
     std::array<uint8_t, 256> m_lut;  // LUT of 256 bins...
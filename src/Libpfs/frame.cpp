@@ -39,21 +39,140 @@ namespace pfs {
 Frame::Frame(size_t width, size_t height)
     : m_width(width), m_height(height), m_X(NULL), m_Y(NULL), m_Z(NULL) {}
 
-namespace {
-struct ChannelDeleter {
-    template <typename T>
-    inline void operator()(T *p) {
-        delete p;
+Frame::~Frame() {}
+
+Frame::Frame(const Frame &other)
+    : m_width(other.m_width),
+      m_height(other.m_height),
+      m_tags(other.m_tags),
+      m_writable(other.m_channels.size(), 0) {
+    {
+        // const accessors of the other frame may be unpacking its channels
+        boost::mutex::scoped_lock lock(other.m_mutex);
+        m_owners = other.m_owners;
+        m_channels = other.m_channels;
+        m_X = other.m_X;
+        m_Y = other.m_Y;
+        m_Z = other.m_Z;
     }
-};
+
+    // the other frame may still be written through a pointer it handed out
+    for (size_t idx = 0; idx < m_channels.size(); ++idx) {
+        if (other.m_writable[idx]) {
+            makePrivate(idx);
+        }
+    }
+}
+
+Frame &Frame::operator=(const Frame &other) {
+    Frame tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+void Frame::makePrivate(size_t idx) const {
+    Channel *oldCh = m_channels[idx];
+    ChannelPtr newCh(new Channel(*oldCh));
+
+    m_owners[idx] = newCh;
+    m_channels[idx] = newCh.get();
+    updateXYZCache(oldCh, newCh.get());
+}
+
+Channel *Frame::detach(size_t idx) {
+    if (m_owners[idx].use_count() > 1) {
+        makePrivate(idx);
+    }
+    m_channels[idx]->unpack();
+    m_writable[idx] = 1;
+    return m_channels[idx];
+}
+
+const Channel *Frame::unpacked(size_t idx) const {
+    if (m_channels[idx]->isPacked()) {
+        // the packed copy is small: duplicate it rather than unpacking the
+        // pixels under the feet of the other owners
+        if (m_owners[idx].use_count() > 1) {
+            makePrivate(idx);
+        }
+        m_channels[idx]->unpack();
+    }
+    return m_channels[idx];
+}
+
+size_t Frame::indexOf(const Channel *ch) const {
+    return find(m_channels.begin(), m_channels.end(), ch) - m_channels.begin();
+}
+
+void Frame::detachAll() {
+    for (size_t idx = 0; idx < m_channels.size(); ++idx) {
+        detach(idx);
+    }
+}
+
+void Frame::updateXYZCache(const Channel *oldCh, Channel *newCh) const {
+    if (m_X == oldCh) {
+        m_X = newCh;
+    } else if (m_Y == oldCh) {
+        m_Y = newCh;
+    } else if (m_Z == oldCh) {
+        m_Z = newCh;
+    }
+}
+
+void Frame::setXYZCache(const string &name, Channel *ch) {
+    if (name == "X") {
+        m_X = ch;
+    } else if (name == "Y") {
+        m_Y = ch;
+    } else if (name == "Z") {
+        m_Z = ch;
+    }
+}
+
+void Frame::pack() {
+    for (size_t idx = 0; idx < m_channels.size(); ++idx) {
+        Channel *ch = m_channels[idx];
+        if (ch->isPacked()) continue;
+
+        if (m_owners[idx].use_count() > 1) {
+            // never touch the float data of the other owners
+            ChannelPtr packedCh(new Channel(0, 0, ch->getName()));
+            packedCh->getTags() = ch->getTags();
+            packedCh->assignPacked(*ch);
+
+            m_owners[idx] = packedCh;
+            m_channels[idx] = packedCh.get();
+            updateXYZCache(ch, packedCh.get());
+        } else {
+            ch->pack();
+        }
+    }
+    // the pixels the old pointers addressed are gone
+    std::fill(m_writable.begin(), m_writable.end(), 0);
 }
 
-Frame::~Frame() {
-    for_each(m_channels.begin(), m_channels.end(), ChannelDeleter());
+bool Frame::isPacked() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    for (size_t idx = 0; idx < m_channels.size(); ++idx) {
+        if (m_channels[idx]->isPacked()) return true;
+    }
+    return false;
+}
+
+bool Frame::isChannelShared(const string &name) const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    for (size_t idx = 0; idx < m_channels.size(); ++idx) {
+        if (m_channels[idx]->getName() == name) {
+            return m_owners[idx].use_count() > 1;
+        }
+    }
+    return false;
 }
 
 //! \brief Changes the size of the frame
 void Frame::resize(size_t width, size_t height) {
+    detachAll();
     for_each(m_channels.begin(), m_channels.end(),
              boost::bind(&Channel::ChannelData::resize, _1, width, height));
 
@@ -77,6 +196,7 @@ struct FindChannel {
 
 void Frame::getXYZChannels(const Channel *&X, const Channel *&Y,
                            const Channel *&Z) const {
+    boost::mutex::scoped_lock lock(m_mutex);
     // find X
     if (m_X == NULL || m_Y == NULL || m_Z == NULL) {
         X = NULL;
@@ -85,9 +205,9 @@ void Frame::getXYZChannels(const Channel *&X, const Channel *&Y,
         return;
     }
 
-    X = m_X;
-    Y = m_Y;
-    Z = m_Z;
+    X = unpacked(indexOf(m_X));
+    Y = unpacked(indexOf(m_Y));
+    Z = unpacked(indexOf(m_Z));
 
     //    ChannelContainer::const_iterator it(
     //                find_if(m_channels.begin(),
@@ -125,15 +245,16 @@ void Frame::getXYZChannels(const Channel *&X, const Channel *&Y,
 }
 
 void Frame::getXYZChannels(Channel *&X, Channel *&Y, Channel *&Z) {
-    const Channel *X_;
-    const Channel *Y_;
-    const Channel *Z_;
-
-    static_cast<const Frame &>(*this).getXYZChannels(X_, Y_, Z_);
+    if (m_X == NULL || m_Y == NULL || m_Z == NULL) {
+        X = NULL;
+        Y = NULL;
+        Z = NULL;
+        return;
+    }
 
-    X = const_cast<Channel *>(X_);
-    Y = const_cast<Channel *>(Y_);
-    Z = const_cast<Channel *>(Z_);
+    X = getChannel("X");
+    Y = getChannel("Y");
+    Z = getChannel("Z");
 }
 
 void Frame::createXYZChannels(Channel *&X, Channel *&Y, Channel *&Z) {
@@ -143,17 +264,22 @@ void Frame::createXYZChannels(Channel *&X, Channel *&Y, Channel *&Z) {
 }
 
 const Channel *Frame::getChannel(const string &name) const {
+    boost::mutex::scoped_lock lock(m_mutex);
     ChannelContainer::const_iterator it =
         find_if(m_channels.begin(), m_channels.end(), FindChannel(name));
     if (it == m_channels.end())
         return NULL;
     else
-        return *it;
+        return unpacked(it - m_channels.begin());
 }
 
 Channel *Frame::getChannel(const string &name) {
-    return const_cast<Channel *>(
-        static_cast<const Frame &>(*this).getChannel(name));
+    ChannelContainer::iterator it =
+        find_if(m_channels.begin(), m_channels.end(), FindChannel(name));
+    if (it == m_channels.end())
+        return NULL;
+    else
+        return detach(it - m_channels.begin());
 }
 
 Channel *Frame::createChannel(const string &name) {
@@ -161,20 +287,46 @@ Channel *Frame::createChannel(const string &name) {
     ChannelContainer::iterator it =
         find_if(m_channels.begin(), m_channels.end(), FindChannel(name));
     if (it != m_channels.end()) {
-        ch = *it;
+        ch = detach(it - m_channels.begin());
     } else {
         ch = new Channel(m_width, m_height, name);
+        m_owners.push_back(ChannelPtr(ch));
         m_channels.push_back(ch);
+        m_writable.push_back(1);
     }
 
     // update the cache, if necessary
-    if (name == "X") {
-        m_X = ch;
-    } else if (name == "Y") {
-        m_Y = ch;
-    } else if (name == "Z") {
-        m_Z = ch;
+    setXYZCache(name, ch);
+
+    return ch;
+}
+
+Channel *Frame::createPackedChannel(const string &name) {
+    Channel *ch = NULL;
+    ChannelContainer::iterator it =
+        find_if(m_channels.begin(), m_channels.end(), FindChannel(name));
+    if (it != m_channels.end()) {
+        const size_t idx = it - m_channels.begin();
+        if (m_owners[idx].use_count() > 1) {
+            // the pixels are discarded: only keep the tags
+            Channel *oldCh = m_channels[idx];
+            ChannelPtr newCh(new Channel(0, 0, name));
+            newCh->getTags() = oldCh->getTags();
+
+            m_owners[idx] = newCh;
+            m_channels[idx] = newCh.get();
+        }
+        ch = m_channels[idx];
+        m_writable[idx] = 1;
+    } else {
+        ch = new Channel(0, 0, name);
+        m_owners.push_back(ChannelPtr(ch));
+        m_channels.push_back(ch);
+        m_writable.push_back(1);
     }
+    ch->resizePacked(m_width, m_height);
+
+    setXYZCache(name, ch);
 
     return ch;
 }
@@ -183,9 +335,10 @@ void Frame::removeChannel(const string &channel) {
     ChannelContainer::iterator it =
         find_if(m_channels.begin(), m_channels.end(), FindChannel(channel));
     if (it != m_channels.end()) {
-        Channel *ch = *it;
+        const size_t idx = it - m_channels.begin();
+        m_owners.erase(m_owners.begin() + idx);
+        m_writable.erase(m_writable.begin() + idx);
         m_channels.erase(it);
-        delete ch;
 
         if (channel == "X") {
             m_X = NULL;
@@ -197,9 +350,18 @@ void Frame::removeChannel(const string &channel) {
     }
 }
 
-ChannelContainer &Frame::getChannels() { return this->m_channels; }
+ChannelContainer &Frame::getChannels() {
+    detachAll();
+    return this->m_channels;
+}
 
-const ChannelContainer &Frame::getChannels() const { return this->m_channels; }
+const ChannelContainer &Frame::getChannels() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    for (size_t idx = 0; idx < m_channels.size(); ++idx) {
+        unpacked(idx);
+    }
+    return this->m_channels;
+}
 
 TagContainer &Frame::getTags() { return m_tags; }
 
@@ -210,7 +372,9 @@ void Frame::swap(Frame &other) {
 
     swap(m_width, other.m_width);
     swap(m_height, other.m_height);
+    m_owners.swap(other.m_owners);
     m_channels.swap(other.m_channels);
+    m_writable.swap(other.m_writable);
     m_tags.swap(other.m_tags);
 
     swap(m_X, other.m_X);
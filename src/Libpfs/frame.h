@@ -34,6 +34,8 @@
 #include <string>
 #include <vector>
 
+#include <boost/thread/mutex.hpp>
+
 #include <Libpfs/channel.h>
 #include <Libpfs/tag.h>
 
@@ -45,11 +47,34 @@ typedef std::vector<Channel *> ChannelContainer;
 //! or more channels (e.g. color XYZ, depth channel, alpha
 //! channnel). All the channels are of the same size. Frame can
 //! also contain additional information in tags (see getTags).
+//!
+//! Channels are reference counted. A channel handed out through a
+//! non-const accessor may still be written through that pointer, so copying
+//! a \c Frame duplicates it; the other channels are shared copy-on-write,
+//! and duplicated the first time either frame hands them out through a
+//! non-const accessor. Const accessors never copy.
+//! In practice, copies of a frame that has just been filled in are deep;
+//! copies of a copy, or of a packed frame, share the pixels until they are
+//! written.
+//!
+//! A frame that is only being held can be \c pack()ed to 16-bit floats.
+//! Every accessor, const ones included, unpacks the channels it hands out.
+//! The const accessors do so under a lock, so a frame can be read by
+//! several threads at once whether it is packed or not; as usual, non-const
+//! calls must not run concurrently with any other call on the same frame.
+//! Packing is only done on request: see \c EXRReader's "half_storage"
+//! parameter and the half float inputs option of the HDR wizard.
 class Frame {
    public:
     Frame(size_t width = 0, size_t height = 0);
     ~Frame();
 
+    //! \brief copy: the channels \a other handed out for writing are
+    //! duplicated, the others are shared until one of the two frames asks
+    //! for write access
+    Frame(const Frame &other);
+    Frame &operator=(const Frame &other);
+
     bool isValid() const { return (getWidth() > 0 && getHeight() > 0); }
 
     //! \return width of the frame (in pixels).
@@ -70,6 +95,7 @@ class Frame {
     //! \param X [out] a pointer to store X channel in
     //! \param Y [out] a pointer to store Y channel in
     //! \param Z [out] a pointer to store Z channel in
+    //! \note the three channels are made private to this frame
     void getXYZChannels(Channel *&X, Channel *&Y, Channel *&Z);
 
     void getXYZChannels(const Channel *&X, const Channel *&Y,
@@ -89,7 +115,8 @@ class Frame {
     //!
     //! \param name [in] name of the channel. Name must be 8 or less
     //! character long.
-    //! \return channel or NULL if the channel does not exist
+    //! \return channel or NULL if the channel does not exist. The channel
+    //! is made private to this frame
     Channel *getChannel(const std::string &name);
     const Channel *getChannel(const std::string &name) const;
 
@@ -112,7 +139,7 @@ class Frame {
     void removeChannel(const std::string &channel);
 
     //! \return \c ChannelContainer associated to the internal list of \c
-    //! Channel
+    //! Channel. All the channels are made private to this frame
     ChannelContainer &getChannels();
 
     const ChannelContainer &getChannels() const;
@@ -127,17 +154,55 @@ class Frame {
 
     void swap(Frame &other);
 
+    //! \return true if the channel \a name is shared with another frame
+    bool isChannelShared(const std::string &name) const;
+
+    //! \brief store all the channels as 16-bit floats, halving the memory
+    //! used by the frame. Shared channels are packed into private copies.
+    //! The \c Channel pointers obtained before cannot be used any more, so
+    //! copies of the packed frame share its channels.
+    void pack();
+
+    //! \return true if at least one channel is stored as 16-bit floats
+    bool isPacked() const;
+
+    //! \brief as \c createChannel(), but the channel is left packed and
+    //! uninitialized: fill it through \c Channel::packedData()
+    Channel *createPackedChannel(const std::string &name);
+
    private:
+    typedef std::shared_ptr<Channel> ChannelPtr;
+
+    //! \brief make the channel at \a idx private to this frame and unpack it
+    Channel *detach(size_t idx);
+    void detachAll();
+    //! \brief unpack the channel at \a idx, copying it first if it is shared
+    //! (call with \c m_mutex locked)
+    const Channel *unpacked(size_t idx) const;
+    //! \brief replace the channel at \a idx with a private copy
+    void makePrivate(size_t idx) const;
+    void updateXYZCache(const Channel *oldCh, Channel *newCh) const;
+    void setXYZCache(const std::string &name, Channel *ch);
+    size_t indexOf(const Channel *ch) const;
+
     size_t m_width;
     size_t m_height;
 
     TagContainer m_tags;
-    ChannelContainer m_channels;
+    // channels are replaced by unpacked copies even through const accessors:
+    // m_mutex guards them there
+    mutable boost::mutex m_mutex;
+    //! \brief owners of the channels, in the same order of \c m_channels
+    mutable std::vector<ChannelPtr> m_owners;
+    mutable ChannelContainer m_channels;
+    //! \brief non-zero for the channels handed out for writing since the
+    //! last \c pack(): copies do not share them
+    std::vector<char> m_writable;
 
     // cache for X Y Z
-    Channel *m_X;
-    Channel *m_Y;
-    Channel *m_Z;
+    mutable Channel *m_X;
+    mutable Channel *m_Y;
+    mutable Channel *m_Z;
 };
 
 typedef std::shared_ptr<pfs::Frame> FramePtr;
@@ -0,0 +1,87 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief PFS library - read-only region of interest of a Frame
+
+#ifndef PFS_FRAMEVIEW_H
+#define PFS_FRAMEVIEW_H
+
+#include <cstddef>
+#include <string>
+
+#include <Libpfs/array2dview.h>
+
+namespace pfs {
+
+class Frame;
+class Channel;
+class TagContainer;
+
+//! \brief Read-only window on a rectangle of a \c Frame. Channels are
+//! exposed as \c Array2DConstViewf sharing the storage of the parent frame,
+//! so that building a \c FrameView never copies pixels. The parent frame
+//! must outlive the view and must not be resized while the view is in use.
+class FrameView {
+   public:
+    //! \brief view on the whole \a frame
+    explicit FrameView(const Frame &frame);
+
+    //! \brief view on the rectangle [\a x_ul, \a x_br) x [\a y_ul, \a y_br)
+    //! of \a frame. The bottom-right corner is clamped to the frame size.
+    FrameView(const Frame &frame, size_t x_ul, size_t y_ul, size_t x_br,
+              size_t y_br);
+
+    const Frame &getFrame() const { return *m_frame; }
+
+    size_t getX() const { return m_x; }
+    size_t getY() const { return m_y; }
+    size_t getWidth() const { return m_width; }
+    size_t getHeight() const { return m_height; }
+    size_t size() const { return m_width * m_height; }
+
+    //! \return true if the view covers the whole parent frame
+    bool isWhole() const;
+
+    //! \brief view on \a channel, which must belong to the parent frame
+    Array2DConstViewf getChannel(const Channel &channel) const;
+
+    //! \brief view on the channel named \a name: the view is empty if the
+    //! channel does not exist
+    Array2DConstViewf getChannel(const std::string &name) const;
+
+    //! \brief views on the X, Y and Z channels. Returns false (and leaves
+    //! the output untouched) if the parent frame has no XYZ channels
+    bool getXYZChannels(Array2DConstViewf &X, Array2DConstViewf &Y,
+                        Array2DConstViewf &Z) const;
+
+    const TagContainer &getTags() const;
+
+   private:
+    const Frame *m_frame;
+    size_t m_x;
+    size_t m_y;
+    size_t m_width;
+    size_t m_height;
+};
+
+}  // namespace pfs
+
+#endif  // PFS_FRAMEVIEW_H
@@ -0,0 +1,46 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/io/exrcommon.h>
+
+#include <ImfThreading.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace pfs {
+namespace io {
+
+int exrThreadCount(const pfs::Params &params) {
+    int threads = 0;
+    if (!params.get("threads", threads) || threads < 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // the global pool is shared by all the files: it is never shrunk
+    if (Imf::globalThreadCount() < threads) {
+        Imf::setGlobalThreadCount(threads);
+    }
+    return threads;
+}
+
+}  // io
+}  // pfs
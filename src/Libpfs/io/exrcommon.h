@@ -0,0 +1,40 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Helpers shared by the OpenEXR reader and writer
+
+#ifndef PFS_IO_EXRCOMMON_H
+#define PFS_IO_EXRCOMMON_H
+
+#include <Libpfs/params.h>
+
+namespace pfs {
+namespace io {
+
+//! \brief number of threads OpenEXR should use to (de)compress a file: the
+//! "threads" parameter if present (0 disables threading), the number of
+//! cores otherwise. The OpenEXR global pool is grown to that size if needed.
+int exrThreadCount(const pfs::Params &params);
+
+}  // io
+}  // pfs
+
+#endif  // PFS_IO_EXRCOMMON_H
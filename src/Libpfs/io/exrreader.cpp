@@ -31,13 +31,20 @@
 #include <ImfRgbaFile.h>
 #include <ImfStandardAttributes.h>
 #include <ImfStringAttribute.h>
+#include <ImfTiledInputFile.h>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <Libpfs/frame.h>
+#include <Libpfs/io/exrcommon.h>
 #include <Libpfs/io/exrreader.h>
 #include <Libpfs/io/ioexception.h>
 
@@ -64,15 +71,15 @@ namespace io {
 
 class EXRReader::EXRReaderData {
    public:
-    explicit EXRReaderData(const string &filename)
-        : file_(filename.c_str())
-          // , dw_(file_.header().displayWindow())
-          ,
-          dtw_(file_.header().dataWindow()) {}
+    EXRReaderData(const string &filename, int threads)
+        : file_(filename.c_str(), threads),
+          dtw_(file_.header().dataWindow()),
+          threads_(threads) {}
 
     Imf::InputFile file_;
-    // Box2i dtw_;
     Box2i dtw_;
+    //! \brief threads used by \c file_, fixed when the file is opened
+    int threads_;
 };
 
 EXRReader::EXRReader(const string &filename) : FrameReader(filename) {
@@ -83,7 +90,7 @@ EXRReader::~EXRReader() { close(); }
 
 void EXRReader::open() {
     // open file and read dimensions
-    m_data.reset(new EXRReaderData(filename().c_str()));
+    m_data.reset(new EXRReaderData(filename(), exrThreadCount(Params())));
 
     int width = m_data->dtw_.max.x - m_data->dtw_.min.x + 1;
     int height = m_data->dtw_.max.y - m_data->dtw_.min.y + 1;
@@ -128,6 +135,40 @@ void EXRReader::open() {
     setHeight(height);
 }
 
+void EXRReader::probe(FrameInfo &info) const {
+    FrameReader::probe(info);
+
+    const Header &header = m_data->file_.header();
+    info.channels = 0;
+    const ChannelList &channels = header.channels();
+    for (ChannelList::ConstIterator i = channels.begin(), iEnd = channels.end();
+         i != iEnd; ++i) {
+        ++info.channels;
+    }
+    switch (channels.findChannel("R")->type) {
+        case HALF:
+            info.sampleType = SAMPLE_HALF;
+            break;
+        case FLOAT:
+            info.sampleType = SAMPLE_FLOAT;
+            break;
+        default:
+            info.sampleType = SAMPLE_UINT32;
+            break;
+    }
+
+    // standard attributes, for files that do not carry EXIF data
+    if (!info.exif.hasExposureTime() && hasExpTime(header)) {
+        info.exif.setExposureTime(expTime(header));
+    }
+    if (!info.exif.hasFNumber() && hasAperture(header)) {
+        info.exif.setFNumber(aperture(header));
+    }
+    if (!info.exif.hasIsoSpeed() && hasIsoSpeed(header)) {
+        info.exif.setIsoSpeed(isoSpeed(header));
+    }
+}
+
 void EXRReader::close() {
     m_data.reset();
 
@@ -135,72 +176,292 @@ void EXRReader::close() {
     setHeight(0);
 }
 
-void EXRReader::read(Frame &frame, const Params & /*params*/) {
+namespace {
+//! \return true if the R, G and B channels of \a header are all stored as
+//! half floats
+bool isHalfRGB(const Header &header) {
+    const ChannelList &channels = header.channels();
+    const char *names[] = {"R", "G", "B"};
+    for (int c = 0; c < 3; ++c) {
+        const Imf::Channel *ch = channels.findChannel(names[c]);
+        if (ch == NULL || ch->type != HALF) return false;
+    }
+    return true;
+}
+
+//! \brief rows read at once when only some columns are needed: a multiple of
+//! the scanlines stored in a block by every compression
+const size_t STRIP_ROWS = 256;
+
+//! \brief offset (in bytes) of the base pointer of a slice whose first
+//! element is the first sample of \a row (counted from the top of the data
+//! window)
+ptrdiff_t sliceOrigin(const Box2i &dtw, size_t row, ptrdiff_t elemSize) {
+    const ptrdiff_t width = dtw.max.x - dtw.min.x + 1;
+    return (dtw.min.x + (dtw.min.y + static_cast<ptrdiff_t>(row)) * width) *
+           elemSize;
+}
+
+//! \brief read the rectangle (\a x, \a y, \a cols, \a rows) of the R, G and
+//! B channels of \a file into \a dest, as \a cols x \a rows arrays of
+//! \a type. Only the scanline blocks the rectangle touches are decoded:
+//! full-width rectangles are read in place, narrower ones go through a
+//! strip of full scanlines.
+void readRegion(InputFile &file, PixelType type, char *dest[3], size_t x,
+                size_t y, size_t cols, size_t rows) {
+    const Box2i &dtw = file.header().dataWindow();
+    const ptrdiff_t width = dtw.max.x - dtw.min.x + 1;
+    const ptrdiff_t elemSize =
+        (type == HALF) ? sizeof(utils::half_t) : sizeof(float);
+    const char *names[] = {"R", "G", "B"};
+
+    if (static_cast<ptrdiff_t>(cols) == width) {
+        FrameBuffer frameBuffer;
+        for (int c = 0; c < 3; ++c) {
+            frameBuffer.insert(
+                names[c], Slice(type, dest[c] - sliceOrigin(dtw, y, elemSize),
+                                elemSize, elemSize * width, 1, 1, 0.0));
+        }
+        file.setFrameBuffer(frameBuffer);
+        file.readPixels(dtw.min.y + static_cast<int>(y),
+                        dtw.min.y + static_cast<int>(y + rows) - 1);
+        return;
+    }
+
+    std::vector<char> strip[3];
+    for (int c = 0; c < 3; ++c) {
+        strip[c].resize(width * STRIP_ROWS * elemSize);
+    }
+
+    for (size_t r0 = y; r0 < y + rows;) {
+        const size_t r1 =
+            std::min(y + rows, (r0 / STRIP_ROWS + 1) * STRIP_ROWS);
+
+        FrameBuffer frameBuffer;
+        for (int c = 0; c < 3; ++c) {
+            frameBuffer.insert(
+                names[c],
+                Slice(type, &strip[c][0] - sliceOrigin(dtw, r0, elemSize),
+                      elemSize, elemSize * width, 1, 1, 0.0));
+        }
+        file.setFrameBuffer(frameBuffer);
+        file.readPixels(dtw.min.y + static_cast<int>(r0),
+                        dtw.min.y + static_cast<int>(r1) - 1);
+
+        for (int c = 0; c < 3; ++c) {
+            for (size_t r = r0; r < r1; ++r) {
+                std::memcpy(dest[c] + (r - y) * cols * elemSize,
+                            &strip[c][((r - r0) * width + x) * elemSize],
+                            cols * elemSize);
+            }
+        }
+        r0 = r1;
+    }
+}
+
+//! \brief as \c readRegion(), but every block of \a factor x \a factor
+//! pixels is averaged while decoding: \a dest receives FLOAT arrays of
+//! max(1, cols / factor) x max(1, rows / factor). Only one strip of full
+//! scanlines is held in memory at a time.
+void readRegionDecimated(InputFile &file, float *dest[3], size_t x, size_t y,
+                         size_t cols, size_t rows, size_t factor) {
+    const Box2i &dtw = file.header().dataWindow();
+    const ptrdiff_t width = dtw.max.x - dtw.min.x + 1;
+    const ptrdiff_t elemSize = sizeof(float);
+    const char *names[] = {"R", "G", "B"};
+
+    const size_t outCols = std::max<size_t>(1, cols / factor);
+    const size_t outRows = std::max<size_t>(1, rows / factor);
+    const size_t blockCols = std::min(factor, cols);
+    // trailing rows that do not fill a block are not decoded at all
+    const size_t lastRow = y + (rows >= factor ? outRows * factor : rows);
+
+    std::vector<float> strip[3];
+    std::vector<float> acc[3];
+    for (int c = 0; c < 3; ++c) {
+        strip[c].resize(width * STRIP_ROWS);
+        acc[c].assign(outCols, 0.f);
+    }
+
+    size_t outRow = 0;
+    size_t accRows = 0;
+    for (size_t r0 = y; r0 < lastRow;) {
+        const size_t r1 =
+            std::min(lastRow, (r0 / STRIP_ROWS + 1) * STRIP_ROWS);
+
+        FrameBuffer frameBuffer;
+        for (int c = 0; c < 3; ++c) {
+            char *base = reinterpret_cast<char *>(&strip[c][0]);
+            frameBuffer.insert(
+                names[c], Slice(FLOAT, base - sliceOrigin(dtw, r0, elemSize),
+                                elemSize, elemSize * width, 1, 1, 0.0));
+        }
+        file.setFrameBuffer(frameBuffer);
+        file.readPixels(dtw.min.y + static_cast<int>(r0),
+                        dtw.min.y + static_cast<int>(r1) - 1);
+
+        for (size_t r = r0; r < r1; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                const float *row = &strip[c][(r - r0) * width + x];
+                for (size_t i = 0; i < outCols; ++i) {
+                    float sum = 0.f;
+                    for (size_t k = 0; k < blockCols; ++k) {
+                        sum += row[i * factor + k];
+                    }
+                    acc[c][i] += sum;
+                }
+            }
+
+            if (++accRows == factor || r + 1 == lastRow) {
+                const float norm =
+                    1.f / static_cast<float>(accRows * blockCols);
+                for (int c = 0; c < 3; ++c) {
+                    float *out = dest[c] + outRow * outCols;
+                    for (size_t i = 0; i < outCols; ++i) {
+                        out[i] = acc[c][i] * norm;
+                    }
+                    std::fill(acc[c].begin(), acc[c].end(), 0.f);
+                }
+                ++outRow;
+                accRows = 0;
+            }
+        }
+        r0 = r1;
+    }
+}
+
+//! \return true if \a header describes a tiled file with mipmap levels
+bool isMipmapped(const Header &header) {
+    return header.hasTileDescription() &&
+           header.tileDescription().mode == MIPMAP_LEVELS;
+}
+
+//! \brief read the rectangle (\a x, \a y, \a cols, \a rows) of \a level
+//! of a tiled file into \a dest. Only the tiles covering the rectangle are
+//! decoded, straight into \a dest when they match it exactly.
+void readLevelRegion(TiledInputFile &file, int level, PixelType type,
+                     char *dest[3], size_t x, size_t y, size_t cols,
+                     size_t rows) {
+    const Box2i dw = file.dataWindowForLevel(level);
+    const size_t levelWidth = file.levelWidth(level);
+    const size_t levelHeight = file.levelHeight(level);
+    const size_t tileW = file.tileXSize();
+    const size_t tileH = file.tileYSize();
+    const ptrdiff_t elemSize =
+        (type == HALF) ? sizeof(utils::half_t) : sizeof(float);
+    const char *names[] = {"R", "G", "B"};
+
+    const int tx0 = static_cast<int>(x / tileW);
+    const int tx1 = static_cast<int>((x + cols - 1) / tileW);
+    const int ty0 = static_cast<int>(y / tileH);
+    const int ty1 = static_cast<int>((y + rows - 1) / tileH);
+
+    // rectangle covered by the tiles
+    const size_t bx = tx0 * tileW;
+    const size_t by = ty0 * tileH;
+    const size_t bw = std::min(levelWidth, (tx1 + 1) * tileW) - bx;
+    const size_t bh = std::min(levelHeight, (ty1 + 1) * tileH) - by;
+    const bool direct = (bx == x && by == y && bw == cols && bh == rows);
+
+    std::vector<char> buffer[3];
+    FrameBuffer frameBuffer;
+    for (int c = 0; c < 3; ++c) {
+        char *base = dest[c];
+        if (!direct) {
+            buffer[c].resize(bw * bh * elemSize);
+            base = &buffer[c][0];
+        }
+        const ptrdiff_t origin =
+            (dw.min.x + static_cast<ptrdiff_t>(bx) +
+             (dw.min.y + static_cast<ptrdiff_t>(by)) *
+                 static_cast<ptrdiff_t>(bw)) *
+            elemSize;
+        frameBuffer.insert(names[c], Slice(type, base - origin, elemSize,
+                                           elemSize * bw, 1, 1, 0.0));
+    }
+    file.setFrameBuffer(frameBuffer);
+    file.readTiles(tx0, tx1, ty0, ty1, level);
+
+    if (direct) return;
+
+    for (int c = 0; c < 3; ++c) {
+        for (size_t r = 0; r < rows; ++r) {
+            std::memcpy(dest[c] + r * cols * elemSize,
+                        &buffer[c][((y - by + r) * bw + x - bx) * elemSize],
+                        cols * elemSize);
+        }
+    }
+}
+}
+
+bool EXRReader::hasScaledLevels() const {
+    return isOpen() && isMipmapped(m_data->file_.header());
+}
+
+void EXRReader::read(Frame &frame, const Params &params) {
     if (!isOpen()) open();
 
+    const int threads = exrThreadCount(params);
+    if (threads != m_data->threads_) {
+        m_data.reset(new EXRReaderData(filename(), threads));
+    }
+
     // helpers...
     InputFile &file = m_data->file_;
-    Box2i &dtw = m_data->dtw_;
 
-    pfs::Frame tempFrame(width(), height());
-    pfs::Channel *X, *Y, *Z;
-    tempFrame.createXYZChannels(X, Y, Z);
+    // frames that are only being held can be kept as 16-bit floats: half
+    // files are then read as they are, without going through floats
+    bool halfStorage = false;
+    params.get("half_storage", halfStorage);
+
+    size_t roiX, roiY, roiWidth, roiHeight;
+    getROI(params, roiX, roiY, roiWidth, roiHeight);
+
+    // previews ("target_width"): load the nearest mipmap level, or decimate
+    // while decoding. Whatever is left is done by readScaled()
+    size_t factor = decimationFactor(params, roiWidth);
+    std::unique_ptr<TiledInputFile> tiledFile;
+    int level = 0;
+    if (factor > 1 && isMipmapped(file.header())) {
+        tiledFile.reset(new TiledInputFile(filename().c_str(), threads));
+        while (level + 1 < tiledFile->numLevels() &&
+               (static_cast<size_t>(2) << level) <= factor) {
+            ++level;
+        }
+        const size_t levelWidth = tiledFile->levelWidth(level);
+        const size_t levelHeight = tiledFile->levelHeight(level);
+        roiX = std::min(roiX >> level, levelWidth - 1);
+        roiY = std::min(roiY >> level, levelHeight - 1);
+        roiWidth = std::min(std::max<size_t>(1, roiWidth >> level),
+                            levelWidth - roiX);
+        roiHeight = std::min(std::max<size_t>(1, roiHeight >> level),
+                             levelHeight - roiY);
+        factor = 1;
+    }
 
-    FrameBuffer frameBuffer;
-    frameBuffer.insert(
-        "R",          // name
-        Slice(FLOAT,  // type
-              (char *)(X->data() - dtw.min.x - dtw.min.y * width()),
-              sizeof(float),            // xStride
-              sizeof(float) * width(),  // yStride
-              1, 1,                     // x/y sampling
-              0.0));                    // fillValue
-
-    frameBuffer.insert(
-        "G",          // name
-        Slice(FLOAT,  // type
-              (char *)(Y->data() - dtw.min.x - dtw.min.y * width()),
-              sizeof(float),            // xStride
-              sizeof(float) * width(),  // yStride
-              1, 1,                     // x/y sampling
-              0.0));                    // fillValue
-
-    frameBuffer.insert(
-        "B",          // name
-        Slice(FLOAT,  // type
-              (char *)(Z->data() - dtw.min.x - dtw.min.y * width()),
-              sizeof(float),            // xStride
-              sizeof(float) * width(),  // yStride
-              1, 1,                     // x/y sampling
-              0.0));                    // fillValue
-
-    // I know I have the channels I need because I have checked that I have the
-    // RGB channels. Hence, I don't load any further that that...
-    /*
-    const ChannelList &channels = file.header().channels();
-    for ( ChannelList::ConstIterator i = channels.begin(); i != channels.end();
-    ++i )
-    {
-        if ( !strcmp( i.name(), "R" ) ||
-             !strcmp( i.name(), "G" ) || !strcmp( i.name(), "B" ) ) continue;
+    pfs::Frame tempFrame(std::max<size_t>(1, roiWidth / factor),
+                         std::max<size_t>(1, roiHeight / factor));
+    pfs::Channel *X, *Y, *Z;
 
-        std::string channelName( i.name() );
-        if ( channelName == "Z" ) {
-            channelName = "DEPTH";
-        }
-        pfs::Channel *pfsCh = tempFrame.createChannel( channelName );
-        frameBuffer.insert( i.name(),                               // name
-                            Slice( FLOAT,                           // type
-                                   (char *)(pfsCh->data() - dtw.min.x -
-    dtw.min.y
-    * width()),
-                                   sizeof(float),                   // xStride
-                                   sizeof(float) * width(),         // yStride
-                                   1, 1,                            // x/y
-    sampling
-                                   0.0));                           // fillValue
+    const bool readHalf = halfStorage && factor == 1 &&
+                          !hasWhiteLuminance(file.header()) &&
+                          isHalfRGB(file.header());
+    char *dest[3];
+    if (readHalf) {
+        X = tempFrame.createPackedChannel("X");
+        Y = tempFrame.createPackedChannel("Y");
+        Z = tempFrame.createPackedChannel("Z");
+
+        dest[0] = reinterpret_cast<char *>(X->packedData());
+        dest[1] = reinterpret_cast<char *>(Y->packedData());
+        dest[2] = reinterpret_cast<char *>(Z->packedData());
+    } else {
+        tempFrame.createXYZChannels(X, Y, Z);
+
+        dest[0] = reinterpret_cast<char *>(X->data());
+        dest[1] = reinterpret_cast<char *>(Y->data());
+        dest[2] = reinterpret_cast<char *>(Z->data());
     }
-    */
 
     // Copy attributes to tags
     for (Header::ConstIterator it = file.header().begin(),
@@ -223,7 +484,15 @@ void EXRReader::read(Frame &frame, const Params & /*params*/) {
         } else  // channel tag
         {
             std::string channelName = string(attribName, colon - attribName);
-            pfs::Channel *ch = tempFrame.getChannel(channelName);
+            // do not go through getChannel(): it would unpack the channels
+            pfs::Channel *ch = NULL;
+            if (channelName == "X") {
+                ch = X;
+            } else if (channelName == "Y") {
+                ch = Y;
+            } else if (channelName == "Z") {
+                ch = Z;
+            }
             if (ch == NULL) {
                 std::cerr << " Warning! Can not set tag for " << channelName
                           << " channel because it does not exist\n";
@@ -233,8 +502,17 @@ void EXRReader::read(Frame &frame, const Params & /*params*/) {
         }
     }
 
-    file.setFrameBuffer(frameBuffer);
-    file.readPixels(dtw.min.y, dtw.max.y);
+    const PixelType type = readHalf ? HALF : FLOAT;
+    if (tiledFile) {
+        readLevelRegion(*tiledFile, level, type, dest, roiX, roiY, roiWidth,
+                        roiHeight);
+    } else if (factor > 1) {
+        float *destFloat[] = {X->data(), Y->data(), Z->data()};
+        readRegionDecimated(file, destFloat, roiX, roiY, roiWidth, roiHeight,
+                            factor);
+    } else {
+        readRegion(file, type, dest, roiX, roiY, roiWidth, roiHeight);
+    }
 
     // Rescale values if WhiteLuminance is present
     if (hasWhiteLuminance(file.header())) {
@@ -258,6 +536,10 @@ void EXRReader::read(Frame &frame, const Params & /*params*/) {
 
     tempFrame.getTags().setTag("FILE_NAME", filename());
 
+    if (halfStorage) {
+        tempFrame.pack();
+    }
+
     frame.swap(tempFrame);
 }
 
@@ -37,6 +37,8 @@ class EXRReader : public FrameReader {
     void close();
     void open();
     void read(Frame &frame, const Params &params);
+    void probe(FrameInfo &info) const;
+    bool hasScaledLevels() const;
 
    protected:
     class EXRReaderData;
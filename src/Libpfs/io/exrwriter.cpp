@@ -26,12 +26,26 @@
 #include <ImfRgbaFile.h>
 #include <ImfStandardAttributes.h>
 #include <ImfStringAttribute.h>
+#include <ImfTiledOutputFile.h>
+#include <OpenEXRConfig.h>
 
+#include <algorithm>
+#include <cassert>
+#include <cctype>
 #include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <sstream>
 #include <string>
 
+#include <Libpfs/array2dview.h>
 #include <Libpfs/frame.h>
+#include <Libpfs/io/exrcommon.h>
 #include <Libpfs/io/exrwriter.h>
+#include <Libpfs/io/ioexception.h>
+#include <Libpfs/manip/resize.h>
+#include <Libpfs/utils/alignedbuffer.h>
+#include <Libpfs/utils/half.h>
 
 // #define min(x,y) ( (x)<(y) ? (x) : (y) )
 
@@ -42,9 +56,160 @@ using namespace std;
 namespace pfs {
 namespace io {
 
+#if OPENEXR_VERSION_MAJOR > 2 || \
+    (OPENEXR_VERSION_MAJOR == 2 && OPENEXR_VERSION_MINOR >= 2)
+#define HAS_DWA_COMPRESSION
+#endif
+
+namespace {
+
+struct CompressionName {
+    const char *name;
+    Compression compression;
+};
+
+const CompressionName COMPRESSIONS[] = {
+    {"none", NO_COMPRESSION},   {"rle", RLE_COMPRESSION},
+    {"zips", ZIPS_COMPRESSION}, {"zip", ZIP_COMPRESSION},
+    {"piz", PIZ_COMPRESSION},   {"pxr24", PXR24_COMPRESSION},
+    {"b44", B44_COMPRESSION},   {"b44a", B44A_COMPRESSION},
+#ifdef HAS_DWA_COMPRESSION
+    {"dwaa", DWAA_COMPRESSION}, {"dwab", DWAB_COMPRESSION},
+#endif
+};
+
+// rows converted to 16-bit floats and handed to OpenEXR at a time
+const size_t HALF_STRIP_ROWS = 512;
+
+// size of the tiles of mipmapped files
+const size_t TILE_SIZE = 64;
+
+const char *const CHANNEL_NAMES[] = {"R", "G", "B"};
+
+//! \brief frame buffer for the R, G and B channels, whose rows [y, ...)
+//! start at \a data. \a width is the width of the image (or of the level)
+//! and \a origin the top left corner of its data window.
+FrameBuffer makeFrameBuffer(PixelType type, const float *const data[3],
+                            const V2i &origin, size_t y, size_t width) {
+    const ptrdiff_t elemSize =
+        (type == HALF) ? sizeof(utils::half_t) : sizeof(float);
+    // slices are addressed with absolute pixel coordinates
+    const ptrdiff_t offset =
+        (origin.x + (origin.y + static_cast<ptrdiff_t>(y)) *
+                        static_cast<ptrdiff_t>(width)) *
+        elemSize;
+
+    FrameBuffer frameBuffer;
+    for (int c = 0; c < 3; ++c) {
+        // OpenEXR takes a non-const base even for writing
+        char *base =
+            const_cast<char *>(reinterpret_cast<const char *>(data[c]));
+        frameBuffer.insert(CHANNEL_NAMES[c], Slice(type, base - offset,
+                                                   elemSize, elemSize * width));
+    }
+    return frameBuffer;
+}
+
+//! \brief hand the \a width x \a height channels \a src to \a write in
+//! strips of \a stripRows rows. Half strips are converted into a scratch
+//! buffer first: the whole image is never duplicated.
+template <typename Write>
+void writeStrips(const float *const src[3], size_t width, size_t height,
+                 size_t stripRows, bool half, Write write) {
+    if (!half) {
+        for (size_t y = 0; y < height; y += stripRows) {
+            const float *strip[] = {src[0] + y * width, src[1] + y * width,
+                                    src[2] + y * width};
+            write(strip, y, std::min(stripRows, height - y));
+        }
+        return;
+    }
+
+    utils::AlignedBuffer<utils::half_t> buffer[3];
+    for (int c = 0; c < 3; ++c) {
+        buffer[c].resize(std::min(stripRows, height) * width);
+    }
+    // the frame buffer only looks at the bytes behind these pointers
+    const float *strip[] = {reinterpret_cast<const float *>(buffer[0].data()),
+                            reinterpret_cast<const float *>(buffer[1].data()),
+                            reinterpret_cast<const float *>(buffer[2].data())};
+    for (size_t y = 0; y < height; y += stripRows) {
+        const size_t rows = std::min(stripRows, height - y);
+        for (int c = 0; c < 3; ++c) {
+            utils::floatToHalf(src[c] + y * width, buffer[c].data(),
+                               rows * width);
+        }
+        write(strip, y, rows);
+    }
+}
+
+struct EXRWriterParams {
+    EXRWriterParams()
+        : compression_(PIZ_COMPRESSION),
+          half_(false),
+          mipmap_(false),
+          threads_(0) {}
+
+    void parse(const Params &params) {
+        for (Params::const_iterator it = params.begin(), itEnd = params.end();
+             it != itEnd; ++it) {
+            if (it->first == "exr_compression") {
+                setCompression(it->second.as<std::string>(std::string()));
+                continue;
+            }
+            if (it->first == "exr_half") {
+                half_ = it->second.as<bool>(half_);
+                continue;
+            }
+            if (it->first == "exr_mipmap") {
+                mipmap_ = it->second.as<bool>(mipmap_);
+                continue;
+            }
+        }
+        threads_ = exrThreadCount(params);
+    }
+
+    void setCompression(const std::string &name) {
+        std::string lower(name);
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+        for (size_t i = 0; i < sizeof(COMPRESSIONS) / sizeof(COMPRESSIONS[0]);
+             ++i) {
+            if (lower == COMPRESSIONS[i].name) {
+                compression_ = COMPRESSIONS[i].compression;
+                return;
+            }
+        }
+        throw pfs::io::WriteException("EXR: unsupported compression " + name);
+    }
+
+    Compression compression_;
+    bool half_;
+    bool mipmap_;
+    int threads_;
+};
+
+ostream &operator<<(ostream &out, const EXRWriterParams &params) {
+    stringstream ss;
+    ss << "EXRWriterParams: [";
+    ss << "compression: " << params.compression_ << ", ";
+    ss << "half: " << params.half_ << ", ";
+    ss << "mipmap: " << params.mipmap_ << ", ";
+    ss << "threads: " << params.threads_ << "]";
+
+    return (out << ss.str());
+}
+}
+
 EXRWriter::EXRWriter(const string &filename) : FrameWriter(filename) {}
 
-bool EXRWriter::write(const Frame &frame, const Params & /*params*/) {
+bool EXRWriter::write(const Frame &frame, const Params &params) {
+    EXRWriterParams p;
+    p.parse(params);
+#ifndef NDEBUG
+    std::clog << p << std::endl;
+#endif
+
     // Channels are named (X Y Z) but contain (R G B) data
     const pfs::Channel *R, *G, *B;
     frame.getXYZChannels(R, G, B);
@@ -54,7 +219,7 @@ bool EXRWriter::write(const Frame &frame, const Params & /*params*/) {
                   Imath::V2f(0, 0),  // screenWindowCenter
                   1,                 // screenWindowWidth
                   INCREASING_Y,      // lineOrder
-                  PIZ_COMPRESSION);
+                  p.compression_);
 
     // Copy tags to attributes
     pfs::TagContainer::const_iterator it = frame.getTags().begin();
@@ -79,35 +244,60 @@ bool EXRWriter::write(const Frame &frame, const Params & /*params*/) {
         }
     }
 
-    FrameBuffer frameBuffer;
+    const float *src[] = {R->data(), G->data(), B->data()};
+    const PixelType type = p.half_ ? HALF : FLOAT;
+    for (int c = 0; c < 3; ++c) {
+        header.channels().insert(CHANNEL_NAMES[c], Imf::Channel(type));
+    }
+
+    size_t width = frame.getWidth();
+    size_t height = frame.getHeight();
+    if (!p.mipmap_) {
+        OutputFile file(filename().c_str(), header, p.threads_);
+        const V2i origin = header.dataWindow().min;
+        writeStrips(src, width, height, HALF_STRIP_ROWS, p.half_,
+                    [&](const float *const strip[3], size_t y, size_t rows) {
+                        file.setFrameBuffer(
+                            makeFrameBuffer(type, strip, origin, y, width));
+                        file.writePixels(static_cast<int>(rows));
+                    });
+        return true;
+    }
+
+    // tiled file, with each level half the size of the previous one (rounding
+    // down) built by averaging blocks of 2x2 pixels
+    header.setTileDescription(
+        TileDescription(TILE_SIZE, TILE_SIZE, MIPMAP_LEVELS, ROUND_DOWN));
+    TiledOutputFile file(filename().c_str(), header, p.threads_);
 
-    // Define channels in Header
-    // and
-    // Create channels in FrameBuffer
-    header.channels().insert("R", Imf::Channel(FLOAT));
-    frameBuffer.insert("R",                                       // name
-                       Slice(FLOAT,                               // type
-                             (char *)R->data(),                   // base
-                             sizeof(float) * 1,                   // xStride
-                             sizeof(float) * frame.getWidth()));  // yStride
-
-    header.channels().insert("G", Imf::Channel(FLOAT));
-    frameBuffer.insert("G",                                       // name
-                       Slice(FLOAT,                               // type
-                             (char *)G->data(),                   // base
-                             sizeof(float) * 1,                   // xStride
-                             sizeof(float) * frame.getWidth()));  // yStride
-
-    header.channels().insert("B", Imf::Channel(FLOAT));
-    frameBuffer.insert("B",                                       // name
-                       Slice(FLOAT,                               // type
-                             (char *)B->data(),                   // base
-                             sizeof(float) * 1,                   // xStride
-                             sizeof(float) * frame.getWidth()));  // yStride
-
-    OutputFile file(filename().c_str(), header);
-    file.setFrameBuffer(frameBuffer);
-    file.writePixels(frame.getHeight());
+    Array2Df levels[2][3];
+    for (int level = 0; level < file.numLevels(); ++level) {
+        const size_t levelWidth = file.levelWidth(level);
+        const size_t levelHeight = file.levelHeight(level);
+        if (level > 0) {
+            Array2Df *next = levels[level % 2];
+            for (int c = 0; c < 3; ++c) {
+                decimate(Array2DView<const float>(src[c], width, height, width),
+                         &next[c], 2);
+                src[c] = next[c].data();
+            }
+            assert(next[0].getCols() == levelWidth);
+            assert(next[0].getRows() == levelHeight);
+        }
+        width = levelWidth;
+        height = levelHeight;
+
+        // one row of tiles at a time
+        const V2i origin = file.dataWindowForLevel(level).min;
+        const int tilesX = file.numXTiles(level);
+        writeStrips(src, width, height, TILE_SIZE, p.half_,
+                    [&](const float *const strip[3], size_t y, size_t) {
+                        const int ty = static_cast<int>(y / TILE_SIZE);
+                        file.setFrameBuffer(
+                            makeFrameBuffer(type, strip, origin, y, width));
+                        file.writeTiles(0, tilesX - 1, ty, ty, level);
+                    });
+    }
 
     return true;
 }
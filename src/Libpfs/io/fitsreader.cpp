@@ -152,6 +152,27 @@ void FitsReader::close() {
     m_data.reset();
 }
 
+void FitsReader::probe(FrameInfo &info) const {
+    FrameReader::probe(info);
+
+    info.channels = 1;
+    switch (m_data->m_format) {
+        case BYTE_IMG:
+            info.sampleType = SAMPLE_UINT8;
+            break;
+        case SHORT_IMG:
+            info.sampleType = SAMPLE_UINT16;
+            break;
+        case LONG_IMG:
+            info.sampleType = SAMPLE_UINT32;
+            break;
+        case FLOAT_IMG:
+        case DOUBLE_IMG:
+            info.sampleType = SAMPLE_FLOAT;
+            break;
+    }
+}
+
 void FitsReader::read(Frame &frame, const Params &) {
     if (!isOpen()) open();
 
@@ -50,6 +50,7 @@ class FitsReader : public FrameReader {
     void open();
     void close();
     void read(Frame &frame, const Params &);
+    void probe(FrameInfo &info) const;
 
    private:
     std::unique_ptr<FitsReaderData> m_data;
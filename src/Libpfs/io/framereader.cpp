@@ -21,7 +21,10 @@
 
 #include <Libpfs/io/framereader.h>
 
+#include <algorithm>
+
 #include <Libpfs/frame.h>
+#include <Libpfs/manip/resize.h>
 #include <Libpfs/manip/rotate.h>
 #include <Libpfs/exif/exifdata.hpp>
 
@@ -33,6 +36,74 @@ FrameReader::FrameReader(const std::string &filename)
 
 FrameReader::~FrameReader() {}
 
+namespace {
+bool getSize(const pfs::Params &params, const std::string &key, size_t &value) {
+    if (params.get(key, value)) return true;
+
+    int temp;
+    if (params.get(key, temp) && temp >= 0) {
+        value = temp;
+        return true;
+    }
+    return false;
+}
+}
+
+bool FrameReader::getROI(const pfs::Params &params, size_t &x, size_t &y,
+                         size_t &width, size_t &height) const {
+    x = 0;
+    y = 0;
+    getSize(params, "roi_x", x);
+    getSize(params, "roi_y", y);
+    x = std::min(x, m_width);
+    y = std::min(y, m_height);
+
+    width = m_width - x;
+    height = m_height - y;
+    size_t temp;
+    if (getSize(params, "roi_width", temp)) width = std::min(width, temp);
+    if (getSize(params, "roi_height", temp)) height = std::min(height, temp);
+
+    if (width == 0 || height == 0) {
+        x = y = 0;
+        width = m_width;
+        height = m_height;
+        return false;
+    }
+    return width != m_width || height != m_height;
+}
+
+size_t FrameReader::decimationFactor(const pfs::Params &params,
+                                     size_t width) {
+    size_t targetWidth = 0;
+    if (!getSize(params, "target_width", targetWidth) || targetWidth == 0) {
+        return 1;
+    }
+    return std::max<size_t>(1, width / targetWidth);
+}
+
+void FrameReader::readScaled(pfs::Frame &frame, size_t targetWidth,
+                             const pfs::Params &params) {
+    pfs::Params p(params);
+    p.set("target_width", targetWidth);
+    read(frame, p);
+
+    const size_t factor = decimationFactor(p, frame.getWidth());
+    if (factor > 1) {
+        const bool packed = frame.isPacked();
+        Frame *decimated = pfs::decimate(frame, factor);
+        if (packed) decimated->pack();
+        frame.swap(*decimated);
+        delete decimated;
+    }
+}
+
+void FrameReader::probe(FrameInfo &info) const {
+    info.width = m_width;
+    info.height = m_height;
+    info.exif.fromFile(m_filename);
+}
+
 void FrameReader::read(pfs::Frame &frame, const pfs::Params &params) {
     pfs::exif::ExifData exifData(m_filename);
     int rotation = exifData.getOrientationDegree();
@@ -28,6 +28,7 @@
 #include <memory>
 #include <string>
 
+#include <Libpfs/exif/exifdata.hpp>
 #include <Libpfs/params.h>
 
 namespace pfs {
@@ -35,6 +36,36 @@ class Frame;
 
 namespace io {
 
+//! \brief type of the samples stored in a file
+enum SampleType {
+    SAMPLE_UNKNOWN = 0,
+    SAMPLE_UINT8,
+    SAMPLE_UINT16,
+    SAMPLE_UINT32,
+    SAMPLE_HALF,
+    SAMPLE_FLOAT  //!< also used by RGBE and LogLuv files
+};
+
+//! \brief what can be learnt about a file from its header alone
+struct FrameInfo {
+    FrameInfo()
+        : width(0), height(0), channels(0), sampleType(SAMPLE_UNKNOWN) {}
+
+    //! \brief memory taken by the XYZ float channels of the decoded frame
+    size_t frameBytes() const { return width * height * 3 * sizeof(float); }
+
+    //! \brief format of the file, as detected from its content (or its
+    //! extension when the content is not recognized)
+    std::string format;
+    size_t width;
+    size_t height;
+    //! \brief samples per pixel stored in the file
+    size_t channels;
+    SampleType sampleType;
+    //! \brief exposure time, aperture, ISO... when the file has them
+    pfs::exif::ExifData exif;
+};
+
 class FrameReader {
    public:
     FrameReader(const std::string &filename);
@@ -53,10 +84,39 @@ class FrameReader {
     virtual void close() = 0;
     virtual void read(pfs::Frame &frame, const pfs::Params &params);
 
+    //! \brief fill \a info from the header already parsed by \c open() and
+    //! from the EXIF data of the file: no pixel is decoded. Readers add
+    //! their channel count and sample type to the size set here.
+    virtual void probe(FrameInfo &info) const;
+
+    //! \brief read the image (or the region asked through \a params) at a
+    //! reduced resolution, at least \a targetWidth pixels wide when the image
+    //! is that large. Readers that can do it cheaply load the nearest level
+    //! of a multi-resolution file or decimate while decoding; any result
+    //! still twice as wide as needed is then decimated by an integer factor.
+    //! \note the reader sees the request as the "target_width" parameter
+    void readScaled(pfs::Frame &frame, size_t targetWidth,
+                    const pfs::Params &params);
+    //! \brief whether readScaled() costs much less than read(): true when
+    //! the file stores reduced levels of the image (e.g. mipmapped EXR)
+    virtual bool hasScaledLevels() const { return false; }
+
    protected:
     void setWidth(size_t width) { m_width = width; }
     void setHeight(size_t height) { m_height = height; }
 
+    //! \brief region of interest asked through the "roi_x", "roi_y",
+    //! "roi_width" and "roi_height" parameters, clamped to the size of the
+    //! file. Missing parameters default to the whole image.
+    //! \return false if the region is the whole image (or empty)
+    bool getROI(const pfs::Params &params, size_t &x, size_t &y,
+                size_t &width, size_t &height) const;
+
+    //! \return the integer factor an image \a width pixels wide can be
+    //! shrunk by while staying at least as wide as the "target_width"
+    //! parameter (1 if there is no such parameter)
+    static size_t decimationFactor(const pfs::Params &params, size_t width);
+
    private:
     std::string m_filename;
     size_t m_width;
@@ -20,7 +20,10 @@
  */
 
 #include <Libpfs/io/framereaderfactory.h>
+#include <Libpfs/utils/resourcehandlerstdio.h>
 #include <boost/assign.hpp>
+#include <cstdio>
+#include <cstring>
 
 using namespace boost::assign;
 using namespace std;
@@ -30,10 +33,77 @@ namespace io {
 
 using pfs::utils::getFormat;
 
+namespace {
+
+struct Signature {
+    const char *format;
+    const char *bytes;
+    size_t size;
+};
+
+// camera raw formats that are not TIFF containers are listed as "raw"
+const Signature SIGNATURES[] = {
+    {"exr", "\x76\x2f\x31\x01", 4},
+    {"jpeg", "\xff\xd8\xff", 3},
+    {"pfs", "PFS1\x0a", 5},
+    {"hdr", "#?RADIANCE", 10},
+    {"hdr", "#?RGBE", 6},
+    {"fits", "SIMPLE  =", 9},
+    {"raw", "II\x1a\0\0\0HEAPCCDR", 14},  // crw
+    {"raw", "FUJIFILM", 8},                // raf
+    {"raw", "FOVb", 4},                    // x3f
+    {"raw", "IIRO", 4},                    // orf
+    {"raw", "IIRS", 4},                    // orf
+    {"raw", "MMOR", 4},                    // orf
+    {"raw", "IIU\0", 4},                   // rw2
+    {"raw", "\0MRM", 4},                   // mrw
+    {"tiff", "II*\0", 4},
+    {"tiff", "MM\0*", 4},
+    {"tiff", "II+\0", 4},  // BigTIFF
+    {"tiff", "MM\0+", 4},
+};
+
+const size_t SIGNATURE_BYTES = 16;
+}
+
+std::string FrameReaderFactory::sniffFormat(const std::string &filename) {
+    utils::ScopedStdIoFile file(fopen(filename.c_str(), "rb"));
+    if (!file) return std::string();
+
+    char buffer[SIGNATURE_BYTES];
+    const size_t size = fread(buffer, 1, SIGNATURE_BYTES, file.data());
+
+    for (size_t i = 0; i < sizeof(SIGNATURES) / sizeof(SIGNATURES[0]); ++i) {
+        const Signature &sig = SIGNATURES[i];
+        if (size >= sig.size && memcmp(buffer, sig.bytes, sig.size) == 0) {
+            return sig.format;
+        }
+    }
+    return std::string();
+}
+
+namespace {
+//! \brief key of \a registry used for \a filename: the sniffed format, unless
+//! the file is a TIFF container with a camera raw extension
+std::string chooseFormat(
+    const FrameReaderFactory::FrameReaderCreatorMap &registry,
+    const std::string &filename) {
+    const std::string ext = getFormat(filename);
+    const std::string sniffed = FrameReaderFactory::sniffFormat(filename);
+
+    if (sniffed.empty() || !registry.count(sniffed)) return ext;
+    if (sniffed == "tiff" && registry.count(ext) && registry.count("raw") &&
+        registry.find(ext)->second == registry.find("raw")->second) {
+        return ext;
+    }
+    return sniffed;
+}
+}
+
 FrameReaderPtr FrameReaderFactory::open(const std::string &filename) {
-    string ext = getFormat(filename);
-    if (!ext.empty()) {
-        FrameReaderCreatorMap::const_iterator it = sm_registry.find(ext);
+    string format = chooseFormat(sm_registry, filename);
+    if (!format.empty()) {
+        FrameReaderCreatorMap::const_iterator it = sm_registry.find(format);
         if (it != sm_registry.end()) {
             return (it->second)(filename);
         }
@@ -41,6 +111,19 @@ FrameReaderPtr FrameReaderFactory::open(const std::string &filename) {
     throw UnsupportedFormat("Cannot find the correct handler for " + filename);
 }
 
+FrameInfo FrameReaderFactory::probe(const std::string &filename) {
+    FrameInfo info;
+    info.format = chooseFormat(sm_registry, filename);
+
+    FrameReaderCreatorMap::const_iterator it = sm_registry.find(info.format);
+    if (it == sm_registry.end()) {
+        throw UnsupportedFormat("Cannot find the correct handler for " +
+                                filename);
+    }
+    (it->second)(filename)->probe(info);
+    return info;
+}
+
 void FrameReaderFactory::registerFormat(
     const std::string &format, FrameReaderFactory::FrameReaderCreator creator) {
     sm_registry.insert(FrameReaderCreatorMap::value_type(format, creator));
@@ -42,8 +42,21 @@ class FrameReaderFactory {
                      utils::StringUnsensitiveComp>
         FrameReaderCreatorMap;
 
+    //! \brief reader for \a filename, chosen from the content of the file
+    //! when it is recognized (so misnamed files still open), from its
+    //! extension otherwise
     static FrameReaderPtr open(const std::string &filename);
 
+    //! \brief size, channels, sample type and exposure of \a filename, read
+    //! from its header only
+    //! \throws pfs::io::Exception if the file cannot be opened
+    static FrameInfo probe(const std::string &filename);
+
+    //! \brief format of \a filename from its first bytes (the same names
+    //! used by \c registerFormat(), "raw" for camera raw files), or an empty
+    //! string if the content is not recognized
+    static std::string sniffFormat(const std::string &filename);
+
     static void registerFormat(const std::string &format,
                                FrameReaderCreator creator);
     static size_t numRegisteredFormats();
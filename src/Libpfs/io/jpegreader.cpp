@@ -373,6 +373,13 @@ static void read4Components(j_decompress_ptr cinfo, Frame &frame,
     }
 }
 
+void JpegReader::probe(FrameInfo &info) const {
+    FrameReader::probe(info);
+
+    info.channels = m_data->cinfo_.num_components;
+    info.sampleType = SAMPLE_UINT8;
+}
+
 void JpegReader::read(Frame &frame, const Params &params) {
     try {
         Frame tempFrame(width(), height());
@@ -44,6 +44,7 @@ class JpegReader : public FrameReader {
     bool isOpen() const;
     void close();
     void read(Frame &frame, const Params &params);
+    void probe(FrameInfo &info) const;
 
    private:
     struct JpegReaderData;
@@ -31,6 +31,7 @@
 #include <Libpfs/io/jpegwriter.h>
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
@@ -38,6 +39,7 @@
 
 #include <jpeglib.h>
 #include <lcms2.h>
+#include <omp.h>
 #include <stdio.h>
 
 #include <Libpfs/colorspace/normalizer.h>
@@ -155,7 +157,9 @@ struct JpegWriterParams {
         : quality_(100),
           minLuminance_(0.f),
           maxLuminance_(1.f),
-          luminanceMapping_(MAP_LINEAR) {}
+          luminanceMapping_(MAP_LINEAR),
+          threads_(1),
+          exactSize_(false) {}
 
     void parse(const Params &params) {
         for (Params::const_iterator it = params.begin(), itEnd = params.end();
@@ -177,6 +181,14 @@ struct JpegWriterParams {
                     it->second.as<RGBMappingType>(luminanceMapping_);
                 continue;
             }
+            if (it->first == "exact_size") {
+                exactSize_ = it->second.as<bool>(exactSize_);
+                continue;
+            }
+        }
+        // same meaning of the EXR writer: 0 disables the threads
+        if (!params.get("threads", threads_) || threads_ < 0) {
+            threads_ = omp_get_max_threads();
         }
     }
 
@@ -184,6 +196,8 @@ struct JpegWriterParams {
     float minLuminance_;
     float maxLuminance_;
     RGBMappingType luminanceMapping_;
+    int threads_;
+    bool exactSize_;
 };
 
 ostream &operator<<(ostream &out, const JpegWriterParams &params) {
@@ -192,196 +206,482 @@ ostream &operator<<(ostream &out, const JpegWriterParams &params) {
     ss << "quality: " << params.quality_ << ", ";
     ss << "min_luminance: " << params.minLuminance_ << ", ";
     ss << "max_luminance: " << params.maxLuminance_ << ", ";
-    ss << "mapping_method: " << params.luminanceMapping_ << "]";
+    ss << "mapping_method: " << params.luminanceMapping_ << ", ";
+    ss << "threads: " << params.threads_ << ", ";
+    ss << "exact_size: " << params.exactSize_ << "]";
 
     return (out << ss.str());
 }
 
-class JpegWriterImpl {
-   public:
-    JpegWriterImpl() {}
-    virtual ~JpegWriterImpl() {}
+//! \ref
+//! http://www.andrewewhite.net/wordpress/2010/04/07/simple-cc-jpeg-writer-part-2-write-to-buffer-in-memory/
+typedef std::vector<JOCTET> JpegBuffer;
 
-    virtual void setupJpegDest(j_compress_ptr cinfo,
-                               const std::string &filename) = 0;
-    virtual void close() = 0;
-    virtual size_t getFileSize() const = 0;
+//! \brief destination manager filling a \c JpegBuffer
+struct JpegMemoryDestination {
+    struct jpeg_destination_mgr mgr;  // first: libjpeg only sees this one
+    JpegBuffer *buffer;
+};
 
-    bool write(const pfs::Frame &frame, const JpegWriterParams &params,
-               const std::string &filename) {
-        cmsUInt32Number cmsProfileSize = 0;
-        utils::ScopedCmsProfile hsRGB(cmsCreate_sRGBProfile());
+#define BLOCK_SIZE 16384
 
-        cmsSaveProfileToMem(hsRGB.data(), NULL,
-                            &cmsProfileSize);  // get the size
+static JpegBuffer &getBuffer(j_compress_ptr cinfo) {
+    return *reinterpret_cast<JpegMemoryDestination *>(cinfo->dest)->buffer;
+}
 
-        std::vector<JOCTET> cmsOutputProfile(cmsProfileSize);
+static void my_init_destination(j_compress_ptr cinfo) {
+    JpegBuffer &myBuffer = getBuffer(cinfo);
 
-        cmsSaveProfileToMem(hsRGB.data(), cmsOutputProfile.data(),
-                            &cmsProfileSize);
+    myBuffer.resize(BLOCK_SIZE);
+    cinfo->dest->next_output_byte = &myBuffer[0];
+    cinfo->dest->free_in_buffer = myBuffer.size();
+}
 
-        struct jpeg_compress_struct cinfo;
-        struct jpeg_error_mgr errorHandler;
+static boolean my_empty_output_buffer(j_compress_ptr cinfo) {
+    JpegBuffer &myBuffer = getBuffer(cinfo);
 
-        jpeg_create_compress(&cinfo);
+    size_t oldsize = myBuffer.size();
+    myBuffer.resize(oldsize + BLOCK_SIZE);
+    cinfo->dest->next_output_byte = &myBuffer[oldsize];
+    cinfo->dest->free_in_buffer = myBuffer.size() - oldsize;
+    return true;
+}
+
+static void my_term_destination(j_compress_ptr cinfo) {
+    JpegBuffer &myBuffer = getBuffer(cinfo);
+
+    myBuffer.resize(myBuffer.size() - cinfo->dest->free_in_buffer);
+}
+#undef BLOCK_SIZE
+
+static void setupMemoryDest(j_compress_ptr cinfo, JpegMemoryDestination &dest,
+                            JpegBuffer &buffer) {
+    dest.mgr.init_destination = my_init_destination;
+    dest.mgr.empty_output_buffer = my_empty_output_buffer;
+    dest.mgr.term_destination = my_term_destination;
+    dest.buffer = &buffer;
+
+    cinfo->dest = &dest.mgr;
+}
 
+namespace {
+
+//! \brief below this size, the image is encoded as a single band
+const size_t PARALLEL_MIN_PIXELS = 1 << 20;
+
+//! \brief below this size, the in-memory writer encodes the whole image
+const size_t ESTIMATE_MIN_PIXELS = 4 << 20;
+//! \brief least number of pixels encoded to estimate the size of an image
+const size_t ESTIMATE_PIXELS = 2 << 20;
+
+//! \brief libjpeg compressor, destroyed on the way out (errors included)
+struct JpegCompressor {
+    JpegCompressor() {
         cinfo.err = jpeg_std_error(&errorHandler);
         errorHandler.error_exit = my_writer_error_handler;
         errorHandler.output_message = my_writer_output_message;
 
-        cinfo.image_width =
-            frame.getWidth();  // image width and height, in pixels
-        cinfo.image_height = frame.getHeight();
-        cinfo.input_components = cinfo.num_components =
-            3;                           // # of color components per pixel
-        cinfo.in_color_space = JCS_RGB;  // colorspace of input image
-        cinfo.jpeg_color_space = JCS_YCbCr;
-        cinfo.density_unit = 1;  // dots/inch
-        cinfo.X_density = cinfo.Y_density = 72;
-
-        jpeg_set_defaults(&cinfo);
-        jpeg_set_colorspace(&cinfo, JCS_YCbCr);
-
-        // avoid subsampling on high quality factor
-        jpeg_set_quality(&cinfo, params.quality_, 1);
-        if (params.quality_ >= 70) {
-            for (int i = 0; i < cinfo.num_components; i++) {
-                cinfo.comp_info[i].h_samp_factor = 1;
-                cinfo.comp_info[i].v_samp_factor = 1;
-            }
-        }
+        jpeg_create_compress(&cinfo);
+    }
 
-        try {
-            setupJpegDest(&cinfo, filename);
-
-            jpeg_start_compress(&cinfo, true);
-
-            const Channel *rChannel;
-            const Channel *gChannel;
-            const Channel *bChannel;
-            frame.getXYZChannels(rChannel, gChannel, bChannel);
-
-            write_icc_profile(&cinfo, cmsOutputProfile.data(), cmsProfileSize);
-
-            // If an exception is raised, this buffer gets automatically
-            // destructed!
-            std::vector<JSAMPLE> scanLineOut(cinfo.image_width *
-                                             cinfo.num_components);
-            JSAMPROW scanLineOutArray[1] = {scanLineOut.data()};
-
-            while (cinfo.next_scanline < cinfo.image_height) {
-                // copy line from Frame into scanLineOut
-                utils::transform(
-                    rChannel->row_begin(cinfo.next_scanline),
-                    rChannel->row_end(cinfo.next_scanline),
-                    gChannel->row_begin(cinfo.next_scanline),
-                    bChannel->row_begin(cinfo.next_scanline),
-                    FixedStrideIterator<JSAMPLE *, 3>(scanLineOut.data()),
-                    FixedStrideIterator<JSAMPLE *, 3>(scanLineOut.data() + 1),
-                    FixedStrideIterator<JSAMPLE *, 3>(scanLineOut.data() + 2),
-                    utils::chain(colorspace::Normalizer(params.minLuminance_,
-                                                        params.maxLuminance_),
-                                 utils::CLAMP_F32,
-                                 Remapper<JSAMPLE>(params.luminanceMapping_)));
-                jpeg_write_scanlines(&cinfo, scanLineOutArray, 1);
-            }
-        } catch (const std::runtime_error &err) {
-            std::clog << err.what() << std::endl;
+    ~JpegCompressor() { jpeg_destroy_compress(&cinfo); }
 
-            jpeg_destroy_compress(&cinfo);
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr errorHandler;
+};
 
-            return false;
+void setupCompress(j_compress_ptr cinfo, size_t width, size_t height,
+                   const JpegWriterParams &params) {
+    cinfo->image_width = width;  // image width and height, in pixels
+    cinfo->image_height = height;
+    cinfo->input_components = cinfo->num_components =
+        3;                            // # of color components per pixel
+    cinfo->in_color_space = JCS_RGB;  // colorspace of input image
+    cinfo->jpeg_color_space = JCS_YCbCr;
+    cinfo->density_unit = 1;  // dots/inch
+    cinfo->X_density = cinfo->Y_density = 72;
+
+    jpeg_set_defaults(cinfo);
+    jpeg_set_colorspace(cinfo, JCS_YCbCr);
+
+    // avoid subsampling on high quality factor
+    jpeg_set_quality(cinfo, params.quality_, 1);
+    if (params.quality_ >= 70) {
+        for (int i = 0; i < cinfo->num_components; i++) {
+            cinfo->comp_info[i].h_samp_factor = 1;
+            cinfo->comp_info[i].v_samp_factor = 1;
         }
+    }
+}
 
-        jpeg_finish_compress(&cinfo);
-        jpeg_destroy_compress(&cinfo);
+//! \brief compress the packed RGB \a pixels, as many rows as the height of
+//! \a cinfo, embedding \a profile
+void writePixels(j_compress_ptr cinfo, const JSAMPLE *pixels,
+                 const JpegBuffer &profile) {
+    jpeg_start_compress(cinfo, true);
 
-        close();
+    write_icc_profile(cinfo, profile.data(), profile.size());
 
-        return true;
+    const size_t stride = cinfo->image_width * cinfo->num_components;
+    std::vector<JSAMPROW> rows(cinfo->image_height);
+    for (size_t y = 0; y < rows.size(); ++y) {
+        rows[y] = const_cast<JSAMPLE *>(pixels) + y * stride;
+    }
+    while (cinfo->next_scanline < cinfo->image_height) {
+        jpeg_write_scanlines(cinfo, rows.data() + cinfo->next_scanline,
+                             cinfo->image_height - cinfo->next_scanline);
     }
-};
 
-//! \ref
-//! http://www.andrewewhite.net/wordpress/2010/04/07/simple-cc-jpeg-writer-part-2-write-to-buffer-in-memory/
-typedef std::vector<JOCTET> JpegBuffer;
+    jpeg_finish_compress(cinfo);
+}
 
-struct JpegWriterImplMemory : public JpegWriterImpl {
-    typedef std::map<j_compress_ptr, JpegBuffer *> JpegRegistry;
+//! \return the offset of the entropy coded data of the JPEG \a stream (right
+//! after its SOS segment); \a sof and \a sos are the offsets of the frame
+//! header and of the SOS marker
+size_t findScan(const JpegBuffer &stream, size_t &sof, size_t &sos) {
+    size_t pos = 2;  // after SOI
+    sof = 0;
+    while (pos + 4 <= stream.size() && stream[pos] == 0xFF) {
+        const int marker = stream[pos + 1];
+        const size_t length = (stream[pos + 2] << 8) | stream[pos + 3];
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+            marker != 0xC8 && marker != 0xCC) {
+            sof = pos;
+        }
+        if (marker == 0xDA) {
+            sos = pos;
+            return pos + 2 + length;
+        }
+        pos += 2 + length;
+    }
+    throw std::runtime_error("JpegWriter: invalid band");
+}
 
-    JpegWriterImplMemory() : JpegWriterImpl(), m_cinfo(NULL), m_buffer(0) {}
+//! \brief size of the MCUs of a \a width x \a height image with \a params
+void mcuSize(size_t width, size_t height, const JpegWriterParams &params,
+             size_t &mcuWidth, size_t &mcuHeight) {
+    JpegCompressor compressor;
+    setupCompress(&compressor.cinfo, width, height, params);
+
+    mcuWidth = DCTSIZE;
+    mcuHeight = DCTSIZE;
+    for (int i = 0; i < compressor.cinfo.num_components; i++) {
+        const jpeg_component_info &comp = compressor.cinfo.comp_info[i];
+        mcuWidth = std::max<size_t>(mcuWidth, DCTSIZE * comp.h_samp_factor);
+        mcuHeight = std::max<size_t>(mcuHeight, DCTSIZE * comp.v_samp_factor);
+    }
+}
 
-    ~JpegWriterImplMemory() { close(); }
+//! \brief encode \a rows rows of packed RGB \a pixels as an image of its own
+void writeRows(const JSAMPLE *pixels, size_t width, size_t rows,
+               const JpegWriterParams &params, const JpegBuffer &profile,
+               JpegBuffer &out) {
+    JpegCompressor compressor;
+    setupCompress(&compressor.cinfo, width, rows, params);
+    // the same (standard) tables for every part of the image
+    compressor.cinfo.optimize_coding = FALSE;
+
+    JpegMemoryDestination dest;
+    setupMemoryDest(&compressor.cinfo, dest, out);
+    writePixels(&compressor.cinfo, pixels, profile);
+}
 
-    // implementation below!
-    void setupJpegDest(j_compress_ptr cinfo, const std::string &filename);
+//! \brief store \a rows rows of \a frame, starting from \a y, as packed
+//! 8 bit RGB
+void remapRows(const Frame &frame, const Remapper<JSAMPLE> &remapper,
+               const JpegWriterParams &params, size_t y, size_t rows,
+               JSAMPLE *pixels) {
+    const size_t width = frame.getWidth();
+
+    const Channel *rChannel;
+    const Channel *gChannel;
+    const Channel *bChannel;
+    frame.getXYZChannels(rChannel, gChannel, bChannel);
+
+    for (size_t row = y; row < y + rows; ++row) {
+        remapper.interleave(rChannel->row_begin(row), gChannel->row_begin(row),
+                            bChannel->row_begin(row), width,
+                            params.minLuminance_, params.maxLuminance_,
+                            pixels + (row - y) * width * 3);
+    }
+}
 
-    void close() {
-        sm_registry.erase(m_cinfo);
-        m_cinfo->dest = NULL;
+//! \brief estimate the size of the JPEG stream of \a frame: the image is
+//! split in strata of MCU rows, the MCU row in the middle of each stratum
+//! is encoded and its size is scaled by the rows of its stratum. Strata
+//! are small enough to follow the changes of content down the image, so
+//! the estimate is usually within a few percent of the real size.
+//! \return false if the image is small enough to be encoded as a whole
+bool estimateSize(const Frame &frame, const JpegWriterParams &params,
+                  const JpegBuffer &profile, size_t &estimate) {
+    const size_t width = frame.getWidth();
+    const size_t height = frame.getHeight();
+    if (width * height < ESTIMATE_MIN_PIXELS || width > JPEG_MAX_DIMENSION ||
+        height > JPEG_MAX_DIMENSION) {
+        return false;
     }
-    size_t getFileSize() const { return (m_buffer.size() * sizeof(JOCTET)); }
 
-    static JpegBuffer &getBuffer(j_compress_ptr cinfo) {
-        JpegRegistry::iterator it = sm_registry.find(cinfo);
-        if (it != sm_registry.end()) {
-            return *it->second;
+    size_t mcuWidth;
+    size_t mcuHeight;
+    mcuSize(width, height, params, mcuWidth, mcuHeight);
+    const size_t mcuRows = (height + mcuHeight - 1) / mcuHeight;
+
+    const size_t samplePixels =
+        std::max(ESTIMATE_PIXELS, width * height / 16);
+    const int strata = static_cast<int>(
+        std::max<size_t>(1, samplePixels / (width * mcuHeight)));
+    if (2 * static_cast<size_t>(strata) > mcuRows) return false;
+
+    const Remapper<JSAMPLE> remapper(params.luminanceMapping_);
+    std::vector<double> bytes(strata);
+    size_t header = 0;
+    std::atomic<bool> failed(false);
+    std::string error;
+#pragma omp parallel num_threads(std::max(1, std::min(params.threads_, strata)))
+    {
+        std::vector<JSAMPLE> pixels(width * mcuHeight * 3);
+        JpegBuffer encoded;
+#pragma omp for schedule(dynamic)
+        for (int stratum = 0; stratum < strata; ++stratum) {
+            if (failed) continue;
+            try {
+                const size_t first = stratum * mcuRows / strata;
+                const size_t last = (stratum + 1) * mcuRows / strata;
+                const size_t y = (first + last) / 2 * mcuHeight;
+                const size_t rows = std::min(mcuHeight, height - y);
+
+                remapRows(frame, remapper, params, y, rows, pixels.data());
+                writeRows(pixels.data(), width, rows, params,
+                          stratum == 0 ? profile : JpegBuffer(), encoded);
+
+                size_t sof;
+                size_t sos;
+                const size_t data = findScan(encoded, sof, sos);
+                if (stratum == 0) header = data;
+                bytes[stratum] =
+                    static_cast<double>(encoded.size() - data - 2) *
+                    (last - first);
+            } catch (const std::runtime_error &err) {
+#pragma omp critical
+                error = err.what();
+                failed = true;
+            }
         }
-        throw pfs::io::WriteException(
-            "Cannot find a valid buffer for the current writer");
+    }
+    if (failed) {
+        throw std::runtime_error(error);
     }
 
-   private:
-    struct jpeg_destination_mgr m_dmgr;
-    j_compress_ptr m_cinfo;
-    JpegBuffer m_buffer;
-
-    static JpegRegistry sm_registry;
-};
+    double total = 0.;
+    for (int stratum = 0; stratum < strata; ++stratum) {
+        total += bytes[stratum];
+    }
+    estimate = header + static_cast<size_t>(total + 0.5) + 2;  // EOI
+    return true;
+}
 
-JpegWriterImplMemory::JpegRegistry JpegWriterImplMemory::sm_registry;
+//! \brief encode bands of MCU rows as separate images, on all the threads,
+//! and chain their entropy coded data as the restart intervals of a single
+//! stream. Every restart resets the DC predictors, so each band starts
+//! exactly as a new image would, and the bands share the same tables.
+//! \return false if the image is not worth (or cannot be) split
+bool writeBands(const std::vector<JSAMPLE> &pixels, size_t width,
+                size_t height, const JpegWriterParams &params,
+                const JpegBuffer &profile, JpegBuffer &out) {
+    if (params.threads_ <= 1 || width * height < PARALLEL_MIN_PIXELS ||
+        width > JPEG_MAX_DIMENSION || height > JPEG_MAX_DIMENSION) {
+        return false;
+    }
 
-#define BLOCK_SIZE 16384
+    size_t mcuWidth;
+    size_t mcuHeight;
+    mcuSize(width, height, params, mcuWidth, mcuHeight);
+    const size_t mcusPerRow = (width + mcuWidth - 1) / mcuWidth;
+    const size_t mcuRows = (height + mcuHeight - 1) / mcuHeight;
+
+    // a few bands per thread, within the 16 bits of the restart interval
+    const size_t wanted = 4 * params.threads_;
+    const size_t bandMcuRows = std::min((mcuRows + wanted - 1) / wanted,
+                                        size_t(0xFFFF) / mcusPerRow);
+    if (bandMcuRows == 0) return false;
+    const size_t bandRows = bandMcuRows * mcuHeight;
+    const int bands = static_cast<int>((height + bandRows - 1) / bandRows);
+    if (bands < 2) return false;
+
+    std::vector<JpegBuffer> encoded(bands);
+    std::atomic<bool> failed(false);
+    std::string error;
+#pragma omp parallel for schedule(dynamic) \
+    num_threads(std::min(params.threads_, bands))
+    for (int band = 0; band < bands; ++band) {
+        if (failed) continue;
+        try {
+            const size_t y = band * bandRows;
+            writeRows(pixels.data() + y * width * 3, width,
+                      std::min(bandRows, height - y), params,
+                      band == 0 ? profile : JpegBuffer(), encoded[band]);
+        } catch (const std::runtime_error &err) {
+#pragma omp critical
+            error = err.what();
+            failed = true;
+        }
+    }
+    if (failed) {
+        throw std::runtime_error(error);
+    }
 
-static void my_init_destination(j_compress_ptr cinfo) {
-    JpegBuffer &myBuffer = JpegWriterImplMemory::getBuffer(cinfo);
+    // headers of the first band, with the whole height and the interval
+    size_t sof;
+    size_t sos;
+    size_t data = findScan(encoded[0], sof, sos);
+    if (sof == 0) {
+        throw std::runtime_error("JpegWriter: invalid band");
+    }
+    out.assign(encoded[0].begin(), encoded[0].begin() + sos);
+    out[sof + 5] = static_cast<JOCTET>(height >> 8);
+    out[sof + 6] = static_cast<JOCTET>(height & 0xFF);
+
+    const size_t interval = bandMcuRows * mcusPerRow;
+    const JOCTET dri[] = {0xFF,
+                          0xDD,
+                          0x00,
+                          0x04,
+                          static_cast<JOCTET>(interval >> 8),
+                          static_cast<JOCTET>(interval & 0xFF)};
+    out.insert(out.end(), dri, dri + sizeof(dri));
+    out.insert(out.end(), encoded[0].begin() + sos,
+               encoded[0].begin() + data);
+
+    for (int band = 0; band < bands; ++band) {
+        const JpegBuffer &stream = encoded[band];
+        if (band > 0) {
+            data = findScan(stream, sof, sos);
+        }
+        // everything up to EOI
+        if (stream.size() < data + 2 || stream[stream.size() - 2] != 0xFF ||
+            stream[stream.size() - 1] != JPEG_EOI) {
+            throw std::runtime_error("JpegWriter: invalid band");
+        }
+        out.insert(out.end(), stream.begin() + data, stream.end() - 2);
 
-    myBuffer.resize(BLOCK_SIZE);
-    cinfo->dest->next_output_byte = &myBuffer[0];
-    cinfo->dest->free_in_buffer = myBuffer.size();
+        out.push_back(0xFF);
+        out.push_back(band + 1 < bands ? JPEG_RST0 + band % 8 : JPEG_EOI);
+    }
+    return true;
+}
 }
 
-static boolean my_empty_output_buffer(j_compress_ptr cinfo) {
-    JpegBuffer &myBuffer = JpegWriterImplMemory::getBuffer(cinfo);
+//! \brief the sRGB profile embedded in every image
+static JpegBuffer sRGBProfile() {
+    cmsUInt32Number cmsProfileSize = 0;
+    utils::ScopedCmsProfile hsRGB(cmsCreate_sRGBProfile());
 
-    size_t oldsize = myBuffer.size();
-    myBuffer.resize(oldsize + BLOCK_SIZE);
-    cinfo->dest->next_output_byte = &myBuffer[oldsize];
-    cinfo->dest->free_in_buffer = myBuffer.size() - oldsize;
-    return true;
-}
+    cmsSaveProfileToMem(hsRGB.data(), NULL,
+                        &cmsProfileSize);  // get the size
 
-static void my_term_destination(j_compress_ptr cinfo) {
-    JpegBuffer &myBuffer = JpegWriterImplMemory::getBuffer(cinfo);
+    JpegBuffer cmsOutputProfile(cmsProfileSize);
 
-    myBuffer.resize(myBuffer.size() - cinfo->dest->free_in_buffer);
+    cmsSaveProfileToMem(hsRGB.data(), cmsOutputProfile.data(),
+                        &cmsProfileSize);
+    return cmsOutputProfile;
 }
-#undef BLOCK_SIZE
 
-void JpegWriterImplMemory::setupJpegDest(j_compress_ptr cinfo,
-                                         const string & /*filename*/) {
-    // remember the j_compress_struct ... it will be necessary in the dtor!
-    m_cinfo = cinfo;
-    // add entry into registry!
-    sm_registry.insert(JpegRegistry::value_type(cinfo, &m_buffer));
+class JpegWriterImpl {
+   public:
+    JpegWriterImpl() {}
+    virtual ~JpegWriterImpl() {}
 
-    // update destinations...
-    m_dmgr.init_destination = my_init_destination;
-    m_dmgr.empty_output_buffer = my_empty_output_buffer;
-    m_dmgr.term_destination = my_term_destination;
+    virtual void setupJpegDest(j_compress_ptr cinfo,
+                               const std::string &filename) = 0;
+    //! \brief store the encoded stream \a data, as a whole
+    virtual void writeData(const JpegBuffer &data,
+                           const std::string &filename) = 0;
+    virtual void close() = 0;
+    virtual size_t getFileSize() const = 0;
 
-    cinfo->dest = &m_dmgr;
-}
+    virtual bool write(const pfs::Frame &frame, const JpegWriterParams &params,
+                       const std::string &filename) {
+        const JpegBuffer cmsOutputProfile = sRGBProfile();
+
+        const size_t width = frame.getWidth();
+        const size_t height = frame.getHeight();
+
+        // remap the whole image up front, on all the threads, so that the
+        // encoder only sees packed 8 bit samples
+        std::vector<JSAMPLE> pixels(width * height * 3);
+        const Remapper<JSAMPLE> remapper(params.luminanceMapping_);
+#pragma omp parallel for num_threads(std::max(1, params.threads_))
+        for (int y = 0; y < static_cast<int>(height); ++y) {
+            remapRows(frame, remapper, params, y, 1,
+                      pixels.data() + y * width * 3);
+        }
+
+        try {
+            JpegBuffer data;
+            if (writeBands(pixels, width, height, params, cmsOutputProfile,
+                           data)) {
+                writeData(data, filename);
+            } else {
+                JpegCompressor compressor;
+                setupCompress(&compressor.cinfo, width, height, params);
+                setupJpegDest(&compressor.cinfo, filename);
+                writePixels(&compressor.cinfo, pixels.data(),
+                            cmsOutputProfile);
+            }
+        } catch (const std::runtime_error &err) {
+            std::clog << err.what() << std::endl;
+
+            close();
+
+            return false;
+        }
+
+        close();
+
+        return true;
+    }
+};
+
+//! \brief Writer to memory: its only product is the size of the image,
+//! estimated on large images unless "exact_size" is set
+struct JpegWriterImplMemory : public JpegWriterImpl {
+    JpegWriterImplMemory() : JpegWriterImpl(), m_buffer(0), m_estimate(0) {}
+
+    void setupJpegDest(j_compress_ptr cinfo, const std::string & /*filename*/) {
+        setupMemoryDest(cinfo, m_dest, m_buffer);
+    }
+
+    void writeData(const JpegBuffer &data, const std::string & /*filename*/) {
+        m_buffer = data;
+    }
+
+    bool write(const pfs::Frame &frame, const JpegWriterParams &params,
+               const std::string &filename) {
+        m_buffer.clear();
+        m_estimate = 0;
+        try {
+            if (!params.exactSize_ &&
+                estimateSize(frame, params, sRGBProfile(), m_estimate)) {
+                return true;
+            }
+        } catch (const std::runtime_error &err) {
+            std::clog << err.what() << std::endl;
+
+            return false;
+        }
+        return JpegWriterImpl::write(frame, params, filename);
+    }
+
+    void close() {}
+    size_t getFileSize() const {
+        return m_estimate ? m_estimate : (m_buffer.size() * sizeof(JOCTET));
+    }
+
+   private:
+    JpegMemoryDestination m_dest;
+    JpegBuffer m_buffer;
+    size_t m_estimate;
+};
 
 //! \brief Writer to file basic implementation
 struct JpegWriterImplFile : public JpegWriterImpl {
@@ -392,6 +692,14 @@ struct JpegWriterImplFile : public JpegWriterImpl {
         jpeg_stdio_dest(cinfo, handle());
     }
 
+    void writeData(const JpegBuffer &data, const std::string &filename) {
+        open(filename);
+        if (fwrite(data.data(), 1, data.size(), handle()) != data.size()) {
+            throw pfs::io::WriteException("Cannot write the output file " +
+                                          filename);
+        }
+    }
+
     void close() { m_handle.reset(); }
     size_t getFileSize() const { return 0; }
 
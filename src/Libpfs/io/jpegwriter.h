@@ -51,9 +51,16 @@ class JpegWriter : public FrameWriter {
     ~JpegWriter();
 
     //! \brief write a pfs::Frame into file or memory
+    //!  \c params can take quality (size_t), min_luminance (float),
+    //!  max_luminance (float), mapping_method (RGBMappingType) and threads
+    //!  (int): 0 disables the threads, the default uses all the cores.
+    //!  With more than one thread, large images are encoded in bands, one
+    //!  restart interval each.
     bool write(const pfs::Frame &frame, const pfs::Params &params);
 
-    //! \brief return size in bytes of the file written
+    //! \brief return size in bytes of the file written. The in-memory writer
+    //! estimates it from a sample of the rows on images over 4 megapixels,
+    //! unless \c params of write() set exact_size (bool)
     size_t getFileSize() const;
 
    private:
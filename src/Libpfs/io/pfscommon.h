@@ -33,4 +33,15 @@
 #define MAX_TAG_STRING 1024
 #define MAX_CHANNEL_COUNT 1024
 
+//! \brief \c PfsWriter pads the header with blank space after the channel
+//! count (which the PFS parsers skip), so that the channel data starts at a
+//! multiple of \c PFS_DATA_ALIGNMENT and can be mapped in memory by
+//! \c PfsReader
+#define PFS_DATA_ALIGNMENT 64
+
+//! \brief file name standing for the standard input (\c PfsReader) or the
+//! standard output (\c PfsWriter), where frames follow one another as a
+//! stream
+#define PFS_STDIO_NAME "-"
+
 #endif  // PFS_IO_PFSCOMMON_H
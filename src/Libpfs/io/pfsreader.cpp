@@ -22,9 +22,16 @@
 #include <Libpfs/frame.h>
 #include <Libpfs/io/pfscommon.h>
 #include <Libpfs/io/pfsreader.h>
+#include <Libpfs/utils/alignedbuffer.h>
 
+#include <cstring>
 #include <list>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
 namespace pfs {
 namespace io {
 
@@ -44,6 +51,9 @@ void readTags(TagContainer &tags, FILE *in) {
             throw Exception("Corrupted PFS tag section: missing tag");
         }
         std::string data(buf);
+        if (!data.empty() && data[data.size() - 1] == PFSEOLCH) {
+            data.erase(data.size() - 1);
+        }
         size_t found = data.find_first_of("=");
         if (found != std::string::npos) {
 #ifndef NDEBUG
@@ -61,26 +71,35 @@ void readTags(TagContainer &tags, FILE *in) {
 }
 
 PfsReader::PfsReader(const std::string &filename)
-    : FrameReader(filename), m_channelCount(0) {
+    : FrameReader(filename), m_channelCount(0), m_pending(false) {
     PfsReader::open();
 }
 
 void PfsReader::open() {
-    m_file.reset(fopen(filename().c_str(), "rb"));
+    if (isStdin()) {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        m_file.reset(stdin);
+    } else {
+        m_file.reset(fopen(filename().c_str(), "rb"));
+    }
     if (!m_file) {
         throw InvalidFile("Cannot open file " + filename());
     }
 
-#ifdef HAVE_SETMODE
-    // Needed under MS windows (text translation IO for stdin/out)
-    int old_mode = setmode(fileno(inputStream), _O_BINARY);
-#endif
+    if (!readHeader()) {
+        throw InvalidHeader("empty file!");
+    }
+}
+
+bool PfsReader::readHeader() {
     char buf[5];
     size_t read = fread(buf, 1, 5, m_file.data());
     if (read == 0) {
-        throw InvalidHeader("empty file!");
+        return false;
     }
-    if (memcmp(buf, PFSFILEID, 5)) {
+    if (read != 5 || memcmp(buf, PFSFILEID, 5)) {
         throw InvalidHeader("Incorrect PFS file header");
     }
 
@@ -101,6 +120,8 @@ void PfsReader::open() {
             "Corrupted PFS file: missing or wrong 'channelCount' tag");
     }
     m_channelCount = channelCount;
+    m_pending = true;
+    return true;
 }
 
 void PfsReader::close() {
@@ -108,12 +129,35 @@ void PfsReader::close() {
     setHeight(0);
     m_file.reset();
     m_channelCount = 0;
+    m_pending = false;
+}
+
+void PfsReader::probe(FrameInfo &info) const {
+    FrameReader::probe(info);
+
+    info.channels = m_channelCount;
+    info.sampleType = SAMPLE_FLOAT;
+}
+
+bool PfsReader::readNext(Frame &frame, const Params &params) {
+    if (isOpen() && !m_pending && !readHeader()) {
+        return false;
+    }
+    read(frame, params);
+    return true;
 }
 
-void PfsReader::read(Frame &frame, const Params & /*params*/) {
-    if (!isOpen()) open();
+void PfsReader::read(Frame &frame, const Params &params) {
+    if (!isOpen()) {
+        open();
+    } else if (!m_pending && !readHeader()) {
+        throw ReadException("Corrupted PFS file: no more frames");
+    }
+    m_pending = false;
 
-    Frame tempFrame(width(), height());
+    // channels get their size with their data, so that a mapped channel is
+    // never allocated first
+    Frame tempFrame;
 
     readTags(tempFrame.getTags(), m_file.data());
 
@@ -145,19 +189,70 @@ void PfsReader::read(Frame &frame, const Params & /*params*/) {
             "Corrupted PFS file: missing end of header (ENDH) token");
     }
 
-    // Read channels
+    // Map the channels on the file when asked to: reading then costs page
+    // faults instead of a copy (the mapping is copy-on-write). Channels stay
+    // aligned: the ones that do not start on an aligned offset (pfstools
+    // does not pad its headers) are copied out of a mapping of the whole
+    // data section. The standard input is mapped when it is a file.
+    bool mapped = false;
+    params.get("pfs_mmap", mapped);
+#ifdef _WIN32
+    const bool canMap = mapped && !isStdin();
+    const std::string mapName = filename();
+#else
+    const bool canMap = mapped;
+    const std::string mapName = isStdin() ? "/dev/stdin" : filename();
+#endif
+    const long dataOffset = canMap ? ftell(m_file.data()) : -1;
+
+    const size_t size = width() * height();
+    const size_t channelBytes = size * sizeof(float);
+    utils::AlignedBuffer<char> section;
+    size_t sectionStart = 0;
+    bool sectionTried = false;
     std::list<Channel *>::iterator it;
-    for (it = orderedChannel.begin(); it != orderedChannel.end(); ++it) {
+    size_t idx = 0;
+    for (it = orderedChannel.begin(); it != orderedChannel.end(); ++it, ++idx) {
         Channel *ch = *it;
-        unsigned int size = tempFrame.getWidth() * tempFrame.getHeight();
+        if (dataOffset >= 0) {
+            const size_t offset = dataOffset + idx * channelBytes;
+            if (offset % utils::BUFFER_ALIGNMENT == 0) {
+                if (ch->mapFile(mapName, offset, width(), height())) {
+                    continue;
+                }
+            } else {
+                if (!sectionTried) {
+                    sectionTried = true;
+                    sectionStart =
+                        dataOffset - dataOffset % utils::BUFFER_ALIGNMENT;
+                    section.mapFile(mapName, sectionStart,
+                                    dataOffset - sectionStart +
+                                        m_channelCount * channelBytes);
+                }
+                if (section.size() != 0) {
+                    ch->resize(width(), height());
+                    memcpy(ch->data(), section.data() + (offset - sectionStart),
+                           channelBytes);
+                    continue;
+                }
+            }
+            // mapped channels do not move the file position
+            fseek(m_file.data(), static_cast<long>(offset), SEEK_SET);
+        }
+
+        ch->resize(width(), height());
         read = fread(ch->data(), sizeof(float), size, m_file.data());
         if (read != size) {
             throw ReadException("Corrupted PFS file: missing channel data");
         }
     }
-#ifdef HAVE_SETMODE
-    setmode(fileno(inputStream), old_mode);
-#endif
+    if (dataOffset >= 0) {
+        // on to the next frame
+        fseek(m_file.data(),
+              static_cast<long>(dataOffset + m_channelCount * channelBytes),
+              SEEK_SET);
+    }
+    tempFrame.resize(width(), height());
 
     frame.swap(tempFrame);
 }
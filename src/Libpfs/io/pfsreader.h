@@ -28,6 +28,7 @@
 
 #include <Libpfs/io/framereader.h>
 #include <Libpfs/io/ioexception.h>
+#include <Libpfs/io/pfscommon.h>
 #include <Libpfs/params.h>
 #include <Libpfs/utils/resourcehandlerstdio.h>
 #include <string>
@@ -37,6 +38,16 @@ class Frame;
 
 namespace io {
 
+//! \brief A PFS file (or stream) holds one or more frames, one after another.
+//! \c read() returns the next one: call \c readNext() to walk through all of
+//! them. \c PFS_STDIO_NAME as file name reads from the standard input.
+//!
+//! With the "pfs_mmap" parameter set to true, channels are mapped
+//! copy-on-write on the file (or on the standard input, when it is
+//! redirected from a file) instead of being read. Channels that do not start
+//! on an aligned offset are copied out of the mapping. Off by default: the
+//! file must then stay as it is while the frame is alive, since touching a
+//! page of a file truncated meanwhile raises SIGBUS.
 class PfsReader : public FrameReader {
    public:
     PfsReader(const std::string &filename);
@@ -46,10 +57,23 @@ class PfsReader : public FrameReader {
     void open();
     void close();
     void read(pfs::Frame &frame, const pfs::Params &);
+    void probe(FrameInfo &info) const;
+
+    //! \brief read the next frame of the file
+    //! \return false at the end of the file
+    bool readNext(pfs::Frame &frame, const pfs::Params &params);
 
    private:
-    utils::ScopedStdIoFile m_file;
+    //! \brief read the first lines of the header of the next frame
+    //! \return false at the end of the file
+    bool readHeader();
+
+    bool isStdin() const { return filename() == PFS_STDIO_NAME; }
+
+    utils::ScopedStdIoStream m_file;
     size_t m_channelCount;
+    //! \brief true when the header of the next frame has been read
+    bool m_pending;
 };
 
 }  // io
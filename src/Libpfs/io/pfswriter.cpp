@@ -19,74 +19,185 @@
  * ----------------------------------------------------------------------
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
 
 #include <Libpfs/frame.h>
 #include <Libpfs/io/pfscommon.h>
 #include <Libpfs/io/pfswriter.h>
 #include <Libpfs/tag.h>
+#include <Libpfs/utils/alignedbuffer.h>
 #include <Libpfs/utils/resourcehandlerstdio.h>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace pfs {
 namespace io {
 
 static const char *PFSFILEID = "PFS1\x0a";
 
-void writeTags(const TagContainer &tags, FILE *out) {
-    fprintf(out, "%d" PFSEOL, (int)tags.size());
+void writeTags(const TagContainer &tags, std::ostream &out) {
+    out << tags.size() << PFSEOL;
     for (TagContainer::const_iterator it = tags.begin(); it != tags.end();
          ++it) {
-        fprintf(out, "%s", std::string(it->first + "=" + it->second).c_str());
-        fprintf(out, PFSEOL);
+        out << it->first << "=" << it->second << PFSEOL;
     }
 }
 
-PfsWriter::PfsWriter(const std::string &filename) : FrameWriter(filename) {}
+namespace {
 
-bool PfsWriter::write(const Frame &frame, const Params & /*params*/) {
-    utils::ScopedStdIoFile outputStream(fopen(filename().c_str(), "wb"));
-    if (!outputStream) {
-        throw pfs::io::InvalidFile("PfsWriter: cannot open " + filename());
+std::string header(const Frame &frame, size_t padding) {
+    const ChannelContainer &channels = frame.getChannels();
+
+    std::ostringstream out;
+    out << PFSFILEID << frame.getWidth() << " " << frame.getHeight() << PFSEOL
+        << channels.size() << PFSEOL << std::string(padding, ' ');
+    writeTags(frame.getTags(), out);
+
+    for (ChannelContainer::const_iterator it = channels.begin();
+         it != channels.end(); ++it) {
+        out << (*it)->getName() << PFSEOL;
+        writeTags((*it)->getTags(), out);
     }
+    out << "ENDH";
+    return out.str();
+}
 
-#ifdef HAVE_SETMODE
-    // Needed under MS windows (text translation IO for stdin/out)
-    int old_mode = setmode(fileno(outputStream.data()), _O_BINARY);
+//! \brief header of \a frame, padded so that the channel data that follows
+//! it is aligned to \c PFS_DATA_ALIGNMENT. The "%d" PFSEOL the parsers read
+//! the channel count with skips any blank space after it
+std::string paddedHeader(const Frame &frame) {
+    const size_t size = header(frame, 0).size();
+    return header(frame, (PFS_DATA_ALIGNMENT - size % PFS_DATA_ALIGNMENT) %
+                             PFS_DATA_ALIGNMENT);
+}
+
+#ifndef _WIN32
+//! \brief write \a frame through a mapping of the output file, sized upfront
+//! \return false if the file cannot be mapped (e.g. it is a pipe)
+bool writeMapped(const std::string &filename, const std::string &header,
+                 const std::vector<const float *> &channels,
+                 size_t channelBytes) {
+    // an existing file is rewritten in place, as fopen() would do, so that
+    // its links, owner and permissions are kept
+    const int fd = open(filename.c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    const size_t bytes = header.size() + channels.size() * channelBytes;
+    bool sized = (ftruncate(fd, bytes) == 0);
+#ifdef __linux__
+    // reserve the blocks now: running out of disk later would be a SIGBUS
+    sized = sized && (posix_fallocate(fd, 0, bytes) == 0);
 #endif
+    void *p = MAP_FAILED;
+    if (sized) {
+        p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
 
-    // Write header ID
-    fwrite(PFSFILEID, 1, 5, outputStream.data());
+    char *dest = static_cast<char *>(p);
+    std::memcpy(dest, header.data(), header.size());
+    dest += header.size();
+    for (size_t idx = 0; idx < channels.size(); ++idx, dest += channelBytes) {
+        std::memcpy(dest, channels[idx], channelBytes);
+    }
+    munmap(p, bytes);
+    return true;
+}
+#endif
+}
 
-    const ChannelContainer &channels = frame.getChannels();
+PfsWriter::PfsWriter(const std::string &filename)
+    : FrameWriter(filename), m_stream(NULL) {}
 
-    fprintf(outputStream.data(), "%d %d" PFSEOL, (int)frame.getWidth(),
-            (int)frame.getHeight());
-    fprintf(outputStream.data(), "%d" PFSEOL, (int)channels.size());
+PfsWriter::PfsWriter(FILE *stream)
+    : FrameWriter(PFS_STDIO_NAME), m_stream(stream) {}
 
-    writeTags(frame.getTags(), outputStream.data());
+bool PfsWriter::write(const Frame &frame, const Params &params) {
+    const ChannelContainer &channels = frame.getChannels();
+    const std::string head = paddedHeader(frame);
+    const size_t size = frame.getWidth() * frame.getHeight();
+    const bool toStream = (m_stream != NULL);
+    const bool toStdout = !toStream && (filename() == PFS_STDIO_NAME);
+
+    // channels mapped on a file are copied first: it may be the file about
+    // to be truncated and rewritten
+    std::vector<const float *> data(channels.size());
+    std::vector<utils::AlignedBuffer<float> > copies(channels.size());
+    const utils::BufferPool &pool = utils::BufferPool::instance();
+    for (size_t idx = 0; idx < channels.size(); ++idx) {
+        data[idx] = channels[idx]->data();
+        if (pool.isFileMapped(data[idx])) {
+            utils::AlignedBuffer<float> copy(size, false);
+            std::copy(data[idx], data[idx] + size, copy.data());
+            copies[idx].swap(copy);
+            data[idx] = copies[idx].data();
+        }
+    }
 
-    // Write channel IDs and tags
-    for (ChannelContainer::const_iterator it = channels.begin();
-         it != channels.end(); ++it) {
-        fprintf(outputStream.data(), "%s" PFSEOL, (*it)->getName().c_str());
-        writeTags((*it)->getTags(), outputStream.data());
+#ifndef _WIN32
+    bool mapped = false;
+    params.get("pfs_mmap", mapped);
+    if (mapped && !toStream && !toStdout &&
+        writeMapped(filename(), head, data, size * sizeof(float))) {
+        return true;
+    }
+#else
+    (void)params;
+#endif
+
+    // every frame written on a stream is appended to it, and the stream is
+    // left open
+    utils::ScopedStdIoFile file(
+        toStream || toStdout ? NULL : fopen(filename().c_str(), "wb"));
+    FILE *outputStream =
+        toStream ? m_stream : toStdout ? stdout : file.data();
+    if (!outputStream) {
+        throw pfs::io::InvalidFile("PfsWriter: cannot open " + filename());
     }
 
-    fprintf(outputStream.data(), "ENDH");
+#ifdef _WIN32
+    // no text translation of the binary data
+    int old_mode = _setmode(_fileno(outputStream), _O_BINARY);
+#endif
+
+    fwrite(head.data(), 1, head.size(), outputStream);
 
     // Write channels
-    for (ChannelContainer::const_iterator it = channels.begin();
-         it != channels.end(); ++it) {
-        int size = frame.getWidth() * frame.getHeight();
-        fwrite((*it)->data(), sizeof(float), size, outputStream.data());
+    for (size_t idx = 0; idx < data.size(); ++idx) {
+        fwrite(data[idx], sizeof(float), size, outputStream);
     }
 
     // Very important for pfsoutavi !!!
-    fflush(outputStream.data());
-#ifdef HAVE_SETMODE
-    setmode(fileno(outputStream.data()), old_mode);
+    fflush(outputStream);
+#ifdef _WIN32
+    _setmode(_fileno(outputStream), old_mode);
 #endif
+    if (ferror(outputStream)) {
+        throw WriteException("PfsWriter: cannot write " + filename());
+    }
     return true;
 }
 
@@ -29,6 +29,7 @@
 #include <Libpfs/io/framewriter.h>
 #include <Libpfs/io/ioexception.h>
 #include <Libpfs/params.h>
+#include <cstdio>
 #include <string>
 
 namespace pfs {
@@ -36,11 +37,25 @@ class Frame;
 
 namespace io {
 
+//! \brief \c PFS_STDIO_NAME as file name writes to the standard output:
+//! every call to \c write() then appends a frame to the stream.
+//!
+//! With the "pfs_mmap" parameter set to true, regular files are written
+//! through a shared mapping (off by default). The file is rewritten in
+//! place, as with stdio. The channels of the frame written that are mapped
+//! on a file are copied first, but other frames read mapped on the file
+//! must be gone by then.
 class PfsWriter : public FrameWriter {
    public:
     PfsWriter(const std::string &filename);
+    //! \brief every frame is appended to \a stream, which stays open (e.g. a
+    //! duplicate of the standard output taken before it was redirected)
+    PfsWriter(FILE *stream);
 
     bool write(const pfs::Frame &frame, const pfs::Params &params);
+
+   private:
+    FILE *m_stream;
 };
 
 }  // io
@@ -23,23 +23,23 @@
 #include "pngwriter.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
 #include <vector>
 
 #include <lcms2.h>
+#include <omp.h>
 #include <png.h>
 #include <stdio.h>
+#include <zlib.h>
 
 #include <Libpfs/colorspace/normalizer.h>
 #include <Libpfs/colorspace/rgbremapper.h>
-#include <Libpfs/fixedstrideiterator.h>
 #include <Libpfs/frame.h>
-#include <Libpfs/utils/chain.h>
-#include <Libpfs/utils/clamp.h>
 #include <Libpfs/utils/resourcehandlerlcms.h>
 #include <Libpfs/utils/resourcehandlerstdio.h>
-#include <Libpfs/utils/transform.h>
 
 using namespace std;
 using namespace pfs;
@@ -47,12 +47,59 @@ using namespace pfs;
 namespace pfs {
 namespace io {
 
+namespace {
+
+struct NamedValue {
+    const char *name;
+    int value;
+};
+
+const NamedValue STRATEGIES[] = {{"default", Z_DEFAULT_STRATEGY},
+                                 {"filtered", Z_FILTERED},
+                                 {"huffman", Z_HUFFMAN_ONLY},
+                                 {"rle", Z_RLE},
+                                 {"fixed", Z_FIXED}};
+
+const NamedValue FILTERS[] = {{"none", PNG_FILTER_NONE},
+                              {"sub", PNG_FILTER_SUB},
+                              {"up", PNG_FILTER_UP},
+                              {"avg", PNG_FILTER_AVG},
+                              {"paeth", PNG_FILTER_PAETH},
+                              {"all", PNG_ALL_FILTERS}};
+
+int lookup(const NamedValue *table, size_t size, const std::string &name,
+           const std::string &what) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    for (size_t i = 0; i < size; ++i) {
+        if (lower == table[i].name) {
+            return table[i].value;
+        }
+    }
+    throw pfs::io::WriteException("PNG: unsupported " + what + " " + name);
+}
+
+//! \brief uncompressed (filtered) bytes deflated by each thread: the same
+//! block size of pigz, large enough to make the dictionary priming cheap
+const size_t CHUNK_BYTES = 128 * 1024;
+
+//! \brief window of deflate, the dictionary of each chunk
+const size_t WINDOW_BYTES = 32 * 1024;
+
+//! \brief maximum size of each IDAT chunk written by the parallel path
+const size_t IDAT_BYTES = 1024 * 1024;
+}
+
 struct PngWriterParams {
     PngWriterParams()
         : quality_(100),
           minLuminance_(0.f),
           maxLuminance_(1.f),
-          luminanceMapping_(MAP_LINEAR) {}
+          luminanceMapping_(MAP_LINEAR),
+          compressionLevel_(-1),
+          strategy_(Z_DEFAULT_STRATEGY),
+          filters_(PNG_ALL_FILTERS),
+          threads_(1) {}
 
     void parse(const Params &params) {
         for (Params::const_iterator it = params.begin(), itEnd = params.end();
@@ -74,10 +121,37 @@ struct PngWriterParams {
                     it->second.as<RGBMappingType>(luminanceMapping_);
                 continue;
             }
+            if (it->first == "png_compression_level") {
+                compressionLevel_ = it->second.as<int>(compressionLevel_);
+                continue;
+            }
+            if (it->first == "png_strategy") {
+                strategy_ = lookup(
+                    STRATEGIES, sizeof(STRATEGIES) / sizeof(STRATEGIES[0]),
+                    it->second.as<std::string>(std::string()), "strategy");
+                continue;
+            }
+            if (it->first == "png_filter") {
+                filters_ =
+                    lookup(FILTERS, sizeof(FILTERS) / sizeof(FILTERS[0]),
+                           it->second.as<std::string>(std::string()),
+                           "filter");
+                continue;
+            }
+        }
+        // same meaning of the EXR writer: 0 disables the threads
+        if (!params.get("threads", threads_) || threads_ < 0) {
+            threads_ = omp_get_max_threads();
         }
     }
 
+    //! \brief "png_compression_level" wins over the level derived from
+    //! "quality"
     int compressionLevel() const {
+        if (compressionLevel_ >= 0) {
+            return std::min(compressionLevel_, 9);
+        }
+
         int compLevel = (9 - (int)((float)quality_ / 11.11111f + 0.5f));
 
         assert(compLevel >= 0);
@@ -90,12 +164,19 @@ struct PngWriterParams {
     float minLuminance_;
     float maxLuminance_;
     RGBMappingType luminanceMapping_;
+    int compressionLevel_;
+    int strategy_;
+    int filters_;
+    int threads_;
 };
 
 ostream &operator<<(ostream &out, const PngWriterParams &params) {
     stringstream ss;
     ss << "PngWriterParams: [";
     ss << "compression_level: " << params.compressionLevel() << ", ";
+    ss << "strategy: " << params.strategy_ << ", ";
+    ss << "filters: " << params.filters_ << ", ";
+    ss << "threads: " << params.threads_ << ", ";
     ss << "min_luminance: " << params.minLuminance_ << ", ";
     ss << "max_luminance: " << params.maxLuminance_ << ", ";
     ss << "mapping_method: " << params.luminanceMapping_ << "]";
@@ -124,6 +205,204 @@ static void png_write_icc_profile(png_structp png_ptr, png_infop info_ptr) {
                  profileBuffer.data(), (png_uint_32)profileSize);
 }
 
+//! 8 bit RGB
+void remapPixels(const Frame &frame, const PngWriterParams &params,
+                 png_byte *pixels) {
+    const size_t width = frame.getWidth();
+    const int height = static_cast<int>(frame.getHeight());
+
+    const Channel *rChannel;
+    const Channel *gChannel;
+    const Channel *bChannel;
+    frame.getXYZChannels(rChannel, gChannel, bChannel);
+
+    const Remapper<png_byte> remapper(params.luminanceMapping_);
+#pragma omp parallel for num_threads(std::max(1, params.threads_))
+    for (int row = 0; row < height; ++row) {
+        remapper.interleave(rChannel->row_begin(row), gChannel->row_begin(row),
+                            bChannel->row_begin(row), width,
+                            params.minLuminance_, params.maxLuminance_,
+                            pixels + row * width * 3);
+    }
+}
+
+inline int paethPredictor(int a, int b, int c) {
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+}
+
+//! \brief filter \a bytes of \a row with the PNG filter \a type (0..4),
+//! \a prev is NULL on the first row. RGB, 3 bytes per pixel.
+void filterRow(int type, const png_byte *row, const png_byte *prev,
+               size_t bytes, png_byte *out) {
+    const int bpp = 3;
+    for (size_t i = 0; i < bytes; ++i) {
+        const int a = i >= bpp ? row[i - bpp] : 0;
+        const int b = prev ? prev[i] : 0;
+        const int c = (prev && i >= bpp) ? prev[i - bpp] : 0;
+        int predictor = 0;
+        switch (type) {
+            case PNG_FILTER_VALUE_SUB:
+                predictor = a;
+                break;
+            case PNG_FILTER_VALUE_UP:
+                predictor = b;
+                break;
+            case PNG_FILTER_VALUE_AVG:
+                predictor = (a + b) / 2;
+                break;
+            case PNG_FILTER_VALUE_PAETH:
+                predictor = paethPredictor(a, b, c);
+                break;
+        }
+        out[i] = static_cast<png_byte>(row[i] - predictor);
+    }
+}
+
+//! \brief filter \a row in \a out (type byte first): with more than one
+//! filter in \a filters, the one with the minimum sum of absolute
+//! differences wins, the same heuristic of libpng
+void filterRow(int filters, const png_byte *row, const png_byte *prev,
+               size_t bytes, png_byte *out, std::vector<png_byte> &scratch) {
+    static const int FLAGS[] = {PNG_FILTER_NONE, PNG_FILTER_SUB,
+                                PNG_FILTER_UP, PNG_FILTER_AVG,
+                                PNG_FILTER_PAETH};
+
+    scratch.resize(bytes);
+    size_t bestSum = size_t(-1);
+    for (int type = 0; type < 5; ++type) {
+        if (!(filters & FLAGS[type])) continue;
+        filterRow(type, row, prev, bytes, scratch.data());
+
+        size_t sum = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            sum += scratch[i] < 128 ? scratch[i] : 256 - scratch[i];
+        }
+        if (sum < bestSum) {
+            bestSum = sum;
+            out[0] = static_cast<png_byte>(type);
+            std::copy(scratch.begin(), scratch.end(), out + 1);
+        }
+    }
+    if (bestSum == size_t(-1)) {  // no filter allowed: same as libpng
+        out[0] = PNG_FILTER_VALUE_NONE;
+        std::copy(row, row + bytes, out + 1);
+    }
+}
+
+//! \brief filter the rows of \a pixels and deflate them in chunks on all
+//! the threads, in the style of pigz: each chunk is a raw deflate stream
+//! primed with the last 32 KiB of the data before it and closed by a sync
+//! flush, so the chunks chain into a single zlib stream. The checksums of
+//! the chunks are combined with \c adler32_combine.
+//! \return false if the image is not worth (or cannot be) split
+bool deflateChunks(const std::vector<png_byte> &pixels, size_t width,
+                   size_t height, const PngWriterParams &params,
+                   std::vector<png_byte> &out) {
+    const size_t rowBytes = width * 3;
+    const size_t filteredBytes = rowBytes + 1;
+    const size_t total = filteredBytes * height;
+    if (params.threads_ <= 1 || total < 2 * CHUNK_BYTES) {
+        return false;
+    }
+
+    std::vector<png_byte> filtered(total);
+#pragma omp parallel num_threads(params.threads_)
+    {
+        std::vector<png_byte> scratch;
+#pragma omp for
+        for (int row = 0; row < static_cast<int>(height); ++row) {
+            const png_byte *current = pixels.data() + row * rowBytes;
+            filterRow(params.filters_, current,
+                      row ? current - rowBytes : NULL, rowBytes,
+                      filtered.data() + row * filteredBytes, scratch);
+        }
+    }
+
+    const int level = params.compressionLevel();
+    const int chunks =
+        static_cast<int>((total + CHUNK_BYTES - 1) / CHUNK_BYTES);
+    std::vector<std::vector<png_byte> > compressed(chunks);
+    std::vector<uLong> checksums(chunks);
+    std::atomic<bool> failed(false);
+#pragma omp parallel for schedule(dynamic) \
+    num_threads(std::min(params.threads_, chunks))
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        if (failed) continue;
+
+        const size_t begin = chunk * CHUNK_BYTES;
+        const size_t size = std::min(CHUNK_BYTES, total - begin);
+        const bool last = chunk + 1 == chunks;
+
+        z_stream stream;
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8,
+                         params.strategy_) != Z_OK) {
+            failed = true;
+            continue;
+        }
+        if (begin > 0) {
+            const size_t window = std::min(WINDOW_BYTES, begin);
+            deflateSetDictionary(&stream, filtered.data() + begin - window,
+                                 static_cast<uInt>(window));
+        }
+
+        // room for the empty stored block of the sync flush
+        std::vector<png_byte> &dst = compressed[chunk];
+        dst.resize(deflateBound(&stream, size) + 16);
+        stream.next_in = filtered.data() + begin;
+        stream.avail_in = static_cast<uInt>(size);
+        stream.next_out = dst.data();
+        stream.avail_out = static_cast<uInt>(dst.size());
+
+        const int result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+        if ((last && result != Z_STREAM_END) ||
+            (!last && (result != Z_OK || stream.avail_in != 0))) {
+            failed = true;
+        }
+        dst.resize(stream.total_out);
+        deflateEnd(&stream);
+
+        checksums[chunk] = adler32(adler32(0L, Z_NULL, 0),
+                                   filtered.data() + begin,
+                                   static_cast<uInt>(size));
+    }
+    if (failed) {
+        throw io::WriteException("PNG: Failed to deflate the image");
+    }
+
+    // zlib header, with the same level hint of deflate()
+    const unsigned int flevel =
+        level < 2 ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3));
+    unsigned int header = (Z_DEFLATED + ((MAX_WBITS - 8) << 4)) << 8;
+    header |= flevel << 6;
+    header += 31 - (header % 31);
+
+    out.clear();
+    out.push_back(static_cast<png_byte>(header >> 8));
+    out.push_back(static_cast<png_byte>(header & 0xFF));
+
+    uLong checksum = checksums[0];
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        out.insert(out.end(), compressed[chunk].begin(),
+                   compressed[chunk].end());
+        if (chunk > 0) {
+            checksum = adler32_combine(
+                checksum, checksums[chunk],
+                std::min(CHUNK_BYTES, total - chunk * CHUNK_BYTES));
+        }
+    }
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<png_byte>((checksum >> shift) & 0xFF));
+    }
+    return true;
+}
+
 class PngWriterImpl {
    public:
     PngWriterImpl() : m_filesize(0) {}
@@ -143,6 +422,13 @@ class PngWriterImpl {
         png_uint_32 width = frame.getWidth();
         png_uint_32 height = frame.getHeight();
 
+        // remapped and compressed before libpng (and its longjmp) sees them
+        std::vector<png_byte> pixels(static_cast<size_t>(width) * height * 3);
+        remapPixels(frame, params, pixels.data());
+        std::vector<png_byte> idat;
+        const bool chunked =
+            deflateChunks(pixels, width, height, params, idat);
+
         png_structp png_ptr =
             png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
         if (!png_ptr) {
@@ -177,32 +463,29 @@ class PngWriterImpl {
                      PNG_FILTER_TYPE_DEFAULT);
 
         png_set_compression_level(png_ptr, params.compressionLevel());
-        png_set_bgr(png_ptr);
+        png_set_compression_strategy(png_ptr, params.strategy_);
+        png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, params.filters_);
         png_write_icc_profile(png_ptr,
                               info_ptr);  // user defined function, see above
         png_write_info(png_ptr, info_ptr);
 
-        const Channel *rChannel;
-        const Channel *gChannel;
-        const Channel *bChannel;
-        frame.getXYZChannels(rChannel, gChannel, bChannel);
-
-        std::vector<png_byte> scanLineOut(width * 3);
-        for (png_uint_32 row = 0; row < height; ++row) {
-            utils::transform(
-                rChannel->row_begin(row), rChannel->row_end(row),
-                gChannel->row_begin(row), bChannel->row_begin(row),
-                FixedStrideIterator<png_byte *, 3>(scanLineOut.data() + 2),
-                FixedStrideIterator<png_byte *, 3>(scanLineOut.data() + 1),
-                FixedStrideIterator<png_byte *, 3>(scanLineOut.data()),
-                utils::chain(colorspace::Normalizer(params.minLuminance_,
-                                                    params.maxLuminance_),
-                             utils::CLAMP_F32,
-                             Remapper<png_byte>(params.luminanceMapping_)));
-            png_write_row(png_ptr, scanLineOut.data());
+        if (chunked) {
+            // already compressed: bypass the zlib stream of libpng
+            png_byte idatName[] = {'I', 'D', 'A', 'T', '\0'};
+            png_byte iendName[] = {'I', 'E', 'N', 'D', '\0'};
+            for (size_t offset = 0; offset < idat.size();
+                 offset += IDAT_BYTES) {
+                png_write_chunk(
+                    png_ptr, idatName, idat.data() + offset,
+                    std::min(IDAT_BYTES, idat.size() - offset));
+            }
+            png_write_chunk(png_ptr, iendName, NULL, 0);
+        } else {
+            for (png_uint_32 row = 0; row < height; ++row) {
+                png_write_row(png_ptr, pixels.data() + row * width * 3);
+            }
+            png_write_end(png_ptr, info_ptr);
         }
-
-        png_write_end(png_ptr, info_ptr);
         png_destroy_write_struct(&png_ptr, &info_ptr);
 
         computeSize();
@@ -48,6 +48,14 @@ class PngWriter : public FrameWriter {
     PngWriter();
     ~PngWriter();
 
+    //! \brief write a pfs::Frame into file or memory
+    //!  \c params can take quality (size_t), min_luminance (float),
+    //!  max_luminance (float), mapping_method (RGBMappingType),
+    //!  png_compression_level (int, 0-9, overrides quality), png_strategy
+    //!  (default, filtered, huffman, rle, fixed), png_filter (none, sub, up,
+    //!  avg, paeth, all) and threads (int): 0 disables the threads, the
+    //!  default uses all the cores. With more than one thread, large images
+    //!  are deflated in chunks, chained into a single IDAT stream.
     bool write(const pfs::Frame &frame, const pfs::Params &params);
 
     size_t getFileSize() const;
@@ -23,12 +23,18 @@
  */
 
 #include <cmath>
+#include <cstddef>
+#include <cstdio>
 #include <limits>
 #include <sstream>
+#include <utility>
 #include <vector>
 
+#include <jpeglib.h>
+
 #include <Libpfs/colorspace/copy.h>
 #include <Libpfs/colorspace/gamma.h>
+#include <Libpfs/colorspace/rgb.h>
 #include <Libpfs/fixedstrideiterator.h>
 #include <Libpfs/frame.h>
 #include <Libpfs/io/rawreader.h>
@@ -106,9 +112,17 @@ static void temperatureToRGB(double T, double RGB[3]) {
 #define USER_QUALITY 3  // using AHD
 #endif
 
+//! \brief what RAWReader::read decodes
+enum RAWPreview {
+    RAW_PREVIEW_NONE = 0,  //!< full size, full quality demosaic
+    RAW_PREVIEW_HALF,      //!< half size image, no demosaic at all
+    RAW_PREVIEW_THUMBNAIL  //!< embedded thumbnail, half size if missing
+};
+
 struct RAWReaderParams {
     RAWReaderParams()
-        : gamma0_(1.f / 2.4),
+        : preview_(RAW_PREVIEW_NONE),
+          gamma0_(1.f / 2.4),
           gamma1_(12.92),
           fourColorRGB_(0),
           useFujiRotate_(-1),
@@ -138,6 +152,20 @@ struct RAWReaderParams {
         float tempFloat;
         bool tempBool;
         double tempDouble;
+        std::string tempString;
+        // preview
+        if (params.get("raw.preview", tempString)) {
+            if (tempString.empty() || tempString == "none") {
+                preview_ = RAW_PREVIEW_NONE;
+            } else if (tempString == "half") {
+                preview_ = RAW_PREVIEW_HALF;
+            } else if (tempString == "thumbnail") {
+                preview_ = RAW_PREVIEW_THUMBNAIL;
+            } else {
+                throw pfs::io::ReadException("RAWReader: unknown preview " +
+                                             tempString);
+            }
+        }
         // general settings
         if (params.get("raw.four_color", tempInt)) {
             fourColorRGB_ = tempInt;
@@ -206,7 +234,6 @@ struct RAWReaderParams {
             }
         }
 
-        std::string tempString;
         if (params.get("raw.camera_profile", tempString)) {
             if (!tempString.empty()) {
                 cameraProfile_.swap(tempString);
@@ -228,6 +255,8 @@ struct RAWReaderParams {
     }
 
    public:
+    RAWPreview preview_;
+
     float gamma0_;
     float gamma1_;
 
@@ -264,7 +293,8 @@ struct RAWReaderParams {
 
 ostream &operator<<(ostream &out, const RAWReaderParams &p) {
     stringstream ss;
-    ss << "[gamma0: " << p.gamma0_ << ", gamma1: " << p.gamma1_;
+    ss << "[preview: " << p.preview_;
+    ss << ", gamma0: " << p.gamma0_ << ", gamma1: " << p.gamma1_;
     ss << ", 4-Color RGB: " << p.fourColorRGB_;
     ss << ", Fuji Rotate: " << p.useFujiRotate_;
     ss << ", User Quality (Demosaicing method): " << p.userQuality_;
@@ -321,6 +351,12 @@ static void setParams(LibRaw &processor, const RAWReaderParams &params) {
     outParams.user_qual = params.userQuality_;
     outParams.med_passes = params.medPasses_;
     outParams.user_flip = 0;  // exif orientation is done afterwards
+    // previews: one pixel per Bayer quad, no interpolation at all
+    outParams.half_size = (params.preview_ != RAW_PREVIEW_NONE);
+    if (outParams.half_size) {
+        outParams.user_qual = 0;
+        outParams.med_passes = 0;
+    }
 
     switch (params.wbMethod_) {
         case 1:  // camera
@@ -395,6 +431,87 @@ static void setParams(LibRaw &processor, const RAWReaderParams &params) {
     }
 }
 
+static void thumbnailErrorHandler(j_common_ptr cinfo) {
+    char buffer[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, buffer);
+    throw std::runtime_error(std::string(buffer));
+}
+
+//! \brief libjpeg decompressor, destroyed on the way out (errors included)
+struct JpegDecompressor {
+    JpegDecompressor() {
+        cinfo.err = jpeg_std_error(&jerr);
+        jerr.error_exit = thumbnailErrorHandler;
+        jpeg_create_decompress(&cinfo);
+    }
+    ~JpegDecompressor() { jpeg_destroy_decompress(&cinfo); }
+
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+};
+
+//! \brief decode the JPEG stream in \a data into packed 8 bit RGB
+static void decodeJpeg(unsigned char *data, size_t size,
+                       std::vector<uint8_t> &rgb, size_t &width,
+                       size_t &height) {
+    JpegDecompressor decompressor;
+    j_decompress_ptr cinfo = &decompressor.cinfo;
+
+    jpeg_mem_src(cinfo, data, static_cast<unsigned long>(size));
+    jpeg_read_header(cinfo, TRUE);
+    cinfo->out_color_space = JCS_RGB;
+    jpeg_start_decompress(cinfo);
+
+    width = cinfo->output_width;
+    height = cinfo->output_height;
+    rgb.resize(width * height * 3);
+    while (cinfo->output_scanline < cinfo->output_height) {
+        JSAMPROW row = &rgb[cinfo->output_scanline * width * 3];
+        jpeg_read_scanlines(cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(cinfo);
+}
+
+//! \brief LUT from the samples of \c imgdata.image to the samples of the
+//! frame: the output curve of LibRaw (\c gamma_curve(), mode 2, as applied
+//! by \c dcraw_make_mem_image() to 16 bit output) followed by the curve the
+//! mem image goes through, so both paths give the same frame
+static void buildOutputLut(double pwr, double ts, int imax,
+                           std::vector<float> &lut) {
+    double g[6] = {pwr, ts, 0., 0., 0., 0.};
+    double bnd[2] = {0., 0.};
+    bnd[g[1] >= 1] = 1;
+    if (g[1] && (g[1] - 1) * (g[0] - 1) <= 0) {
+        for (int i = 0; i < 48; i++) {
+            g[2] = (bnd[0] + bnd[1]) / 2;
+            if (g[0]) {
+                bnd[(std::pow(g[2] / g[1], -g[0]) - 1) / g[0] - 1 / g[2] >
+                    -1] = g[2];
+            } else {
+                bnd[g[2] / std::exp(1 - 1 / g[2]) < g[1]] = g[2];
+            }
+        }
+        g[3] = g[2] / g[1];
+        if (g[0]) g[4] = g[2] * (1 / g[0] - 1);
+    }
+
+    lut.resize(0x10000);
+#pragma omp parallel for
+    for (int i = 0; i < 0x10000; i++) {
+        uint16_t curve = 0xffff;
+        const double r = static_cast<double>(i) / imax;
+        if (r < 1) {
+            curve = static_cast<uint16_t>(
+                0x10000 *
+                (r < g[3] ? r * g[1]
+                          : (g[0] ? std::pow(r, g[0]) * (1 + g[4]) - g[4]
+                                  : std::log(r) * g[2] + 1)));
+        }
+        lut[i] = std::pow(static_cast<float>(curve) / 65535.f,
+                          colorspace::Gamma1_8::gamma());
+    }
+}
+
 #define P1 m_processor.imgdata.idata
 #define S m_processor.imgdata.sizes
 #define C m_processor.imgdata.color
@@ -419,6 +536,25 @@ void RAWReader::open() {
 
 bool RAWReader::isOpen() const { return true; }
 
+void RAWReader::probe(FrameInfo &info) const {
+    FrameReader::probe(info);
+
+    const libraw_data_t &data = m_processor.imgdata;
+    info.channels = data.idata.colors;
+    info.sampleType = SAMPLE_UINT16;
+
+    // LibRaw parses the makernotes exiv2 might not understand
+    if (!info.exif.hasExposureTime() && data.other.shutter > 0.f) {
+        info.exif.setExposureTime(data.other.shutter);
+    }
+    if (!info.exif.hasFNumber() && data.other.aperture > 0.f) {
+        info.exif.setFNumber(data.other.aperture);
+    }
+    if (!info.exif.hasIsoSpeed() && data.other.iso_speed > 0.f) {
+        info.exif.setIsoSpeed(data.other.iso_speed);
+    }
+}
+
 void RAWReader::close() { m_processor.recycle(); }
 
 void RAWReader::read(Frame &frame, const Params &params) {
@@ -429,6 +565,18 @@ void RAWReader::read(Frame &frame, const Params &params) {
 
     open();
 
+    pfs::Frame tempFrame;
+    if (p.preview_ != RAW_PREVIEW_THUMBNAIL || !readThumbnail(tempFrame)) {
+        // half size previews are set up by setParams()
+        readImage(tempFrame);
+    }
+    m_processor.recycle();
+
+    FrameReader::read(tempFrame, params);
+    frame.swap(tempFrame);
+}
+
+void RAWReader::readImage(Frame &frame) {
     if (m_processor.unpack() != LIBRAW_SUCCESS) {
         m_processor.recycle();
         throw pfs::io::ReadException("Error Unpacking RAW File");
@@ -450,6 +598,10 @@ void RAWReader::read(Frame &frame, const Params &params) {
         throw pfs::io::ReadException("Error Processing RAW File");
     }
 
+    if (copyImage(frame)) {
+        return;
+    }
+
     libraw_processed_image_t *image = m_processor.dcraw_make_mem_image();
 
     if (!image)  // ret != LIBRAW_SUCCESS ||
@@ -483,12 +635,135 @@ void RAWReader::read(Frame &frame, const Params &params) {
     PRINT_DEBUG("W: " << W << " H: " << H);
 
     LibRaw::dcraw_clear_mem(image);
-    m_processor.recycle();
 
-    FrameReader::read(tempFrame, params);
     frame.swap(tempFrame);
 }
 
+bool RAWReader::copyImage(Frame &frame) {
+    // the curve depends on the histogram with auto brightness, and only
+    // dcraw_make_mem_image() knows how to stretch the image
+    if (!OUT.no_auto_bright || OUT.output_bps != 16 || P1.colors != 3 ||
+        S.width != S.iwidth || S.height != S.iheight ||
+        !m_processor.imgdata.image) {
+        return false;
+    }
+
+    std::vector<float> lut;
+    buildOutputLut(OUT.gamm[0], OUT.gamm[1],
+                   static_cast<int>((0x2000 << 3) / OUT.bright), lut);
+
+    // the flip is applied while copying, as LibRaw's copy_mem_image() does:
+    // bit 2 transposes the image, bit 1 flips it upside down and bit 0
+    // mirrors it, in this order
+    const int flip = S.flip;
+    const ptrdiff_t iwidth = S.iwidth;
+    const ptrdiff_t iheight = S.iheight;
+    const auto flipIndex = [=](ptrdiff_t row, ptrdiff_t col) {
+        if (flip & 4) std::swap(row, col);
+        if (flip & 2) row = iheight - 1 - row;
+        if (flip & 1) col = iwidth - 1 - col;
+        return row * iwidth + col;
+    };
+
+    const size_t W = (flip & 4) ? S.height : S.width;
+    const int H = (flip & 4) ? S.width : S.height;
+    pfs::Frame tempFrame(W, H);
+    pfs::Channel *Xc, *Yc, *Zc;
+    tempFrame.createXYZChannels(Xc, Yc, Zc);
+
+    // de-interleave, flip, scale and normalize in a single pass
+    const ushort(*image)[4] = m_processor.imgdata.image;
+    const ptrdiff_t colStep = flipIndex(0, 1) - flipIndex(0, 0);
+#pragma omp parallel for
+    for (int row = 0; row < H; ++row) {
+        ptrdiff_t offset = flipIndex(row, 0);
+        float *x = Xc->row_begin(row);
+        float *y = Yc->row_begin(row);
+        float *z = Zc->row_begin(row);
+        for (size_t col = 0; col < W; ++col, offset += colStep) {
+            const ushort *pixel = image[offset];
+            x[col] = lut[pixel[0]];
+            y[col] = lut[pixel[1]];
+            z[col] = lut[pixel[2]];
+        }
+    }
+    PRINT_DEBUG("W: " << W << " H: " << H << " flip: " << flip
+                      << " (from imgdata.image)");
+
+    frame.swap(tempFrame);
+    return true;
+}
+
+bool RAWReader::readThumbnail(Frame &frame) {
+    if (m_processor.unpack_thumb() != LIBRAW_SUCCESS) {
+        PRINT_DEBUG("No thumbnail in " << filename());
+        return false;
+    }
+
+    int ret = LIBRAW_SUCCESS;
+    libraw_processed_image_t *thumb = m_processor.dcraw_make_mem_thumb(&ret);
+    if (!thumb) {
+        PRINT_DEBUG("Cannot extract the thumbnail: " << libraw_strerror(ret));
+        return false;
+    }
+
+    std::vector<uint8_t> rgb;
+    size_t W = 0;
+    size_t H = 0;
+    try {
+        if (thumb->type == LIBRAW_IMAGE_JPEG) {
+            decodeJpeg(thumb->data, thumb->data_size, rgb, W, H);
+        } else if (thumb->type == LIBRAW_IMAGE_BITMAP && thumb->bits == 8 &&
+                   (thumb->colors == 3 || thumb->colors == 1)) {
+            W = thumb->width;
+            H = thumb->height;
+            rgb.resize(W * H * 3);
+            for (size_t idx = 0; idx < W * H; ++idx) {
+                for (int c = 0; c < 3; ++c) {
+                    rgb[idx * 3 + c] =
+                        thumb->data[idx * thumb->colors +
+                                    (thumb->colors == 3 ? c : 0)];
+                }
+            }
+        }
+    } catch (const std::runtime_error &err) {
+        PRINT_DEBUG("Cannot decode the thumbnail: " << err.what());
+        rgb.clear();
+    }
+    LibRaw::dcraw_clear_mem(thumb);
+    if (rgb.empty()) {
+        return false;
+    }
+
+    // the camera stores its thumbnail as 8 bit sRGB: back to linear, then
+    // through the output curve of the full decode (its gamma and
+    // raw.brightness), so both end up on the same transfer curve. White
+    // balance, exposure and tone curve are still the camera's own: the
+    // thumbnail only approximates the decoded frame, it is not on its scale
+    std::vector<float> curve;
+    buildOutputLut(OUT.gamm[0], OUT.gamm[1],
+                   static_cast<int>((0x2000 << 3) / OUT.bright), curve);
+    const colorspace::ConvertSRGB2RGB toLinear;
+    float lut[256];
+    for (int v = 0; v < 256; ++v) {
+        const float linear = toLinear(static_cast<float>(v) / 255.f);
+        lut[v] = curve[static_cast<size_t>(linear * 65535.f + 0.5f)];
+    }
+
+    pfs::Frame tempFrame(W, H);
+    pfs::Channel *Xc, *Yc, *Zc;
+    tempFrame.createXYZChannels(Xc, Yc, Zc);
+    for (size_t idx = 0; idx < W * H; ++idx) {
+        (*Xc)(idx) = lut[rgb[idx * 3]];
+        (*Yc)(idx) = lut[rgb[idx * 3 + 1]];
+        (*Zc)(idx) = lut[rgb[idx * 3 + 2]];
+    }
+    PRINT_DEBUG("Thumbnail W: " << W << " H: " << H);
+
+    frame.swap(tempFrame);
+    return true;
+}
+
 #undef P1
 #undef S
 #undef C
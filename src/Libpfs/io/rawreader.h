@@ -42,6 +42,12 @@
 namespace pfs {
 namespace io {
 
+//! \brief camera raw files, through LibRaw. Besides the raw.* settings of
+//! the demosaic, \c read() takes raw.preview: "half" builds a half size
+//! image without any interpolation, "thumbnail" decodes the thumbnail
+//! embedded by the camera (falling back to "half" without one) and "none"
+//! (the default) runs the full demosaic. Only "half" gives the scale of the
+//! full decode: the thumbnail is rendered by the camera
 class RAWReader : public FrameReader {
    public:
     RAWReader(const std::string &filename);
@@ -52,8 +58,20 @@ class RAWReader : public FrameReader {
     void close();
 
     void read(Frame &frame, const Params &params);
+    void probe(FrameInfo &info) const;
 
    private:
+    //! \brief demosaic the raw data (only binned with raw.preview)
+    void readImage(Frame &frame);
+    //! \brief convert the output of dcraw_process() straight from
+    //! \c imgdata.image, without the interleaved copy of the mem image
+    //! \return false if only the mem image can handle the output
+    bool copyImage(Frame &frame);
+    //! \brief decode the thumbnail embedded by the camera, on the transfer
+    //! curve of the full decode (but with the colors of the camera)
+    //! \return false if there is none LibRaw (or libjpeg) can decode
+    bool readThumbnail(Frame &frame);
+
     LibRaw m_processor;
 };
 
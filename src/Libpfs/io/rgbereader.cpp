@@ -21,36 +21,26 @@
  * ----------------------------------------------------------------------
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <Libpfs/array2d.h>
 #include <Libpfs/colorspace/colorspace.h>
 #include <Libpfs/frame.h>
 #include <Libpfs/io/rgbecommon.h>
 #include <Libpfs/io/rgbereader.h>
+#include <Libpfs/utils/alignedbuffer.h>
 
 using namespace std;
 
 namespace pfs {
 namespace io {
 
-void rgbe2rgb(const Trgbe_pixel &rgbe, float exposure, float &r, float &g,
-              float &b) {
-    if (rgbe.e != 0)  // a non-zero pixel
-    {
-        int e = rgbe.e - int(128 + 8);
-        double f = ldexp(1.0, e) /*WHITE_EFFICACY */ / exposure;
-
-        r = (float)(rgbe.r * f);
-        g = (float)(rgbe.g * f);
-        b = (float)(rgbe.b * f);
-    } else
-        r = g = b = 0.f;
-}
-
 // Reading RGBE files
 void readRadianceHeader(FILE *file, int &width, int &height, float &exposure,
                         Colorspace &colorspace) {
@@ -128,102 +118,163 @@ void readRadianceHeader(FILE *file, int &width, int &height, float &exposure,
     // DEBUG_STR << "RGBE: image size " << width << "x" << height << endl;
 }
 
-void RLERead(FILE *file, Trgbe *scanline, int size) {
+namespace {
+
+//! \brief RGBE -> float for \a width pixels, whose components are \a step
+//! bytes apart. \a scale holds 2^(e - 136) / exposure for each exponent, so
+//! the loop is a lookup and three products that vectorize.
+void rgbe2rgb(const Trgbe *r, const Trgbe *g, const Trgbe *b, const Trgbe *e,
+              int step, const double *scale, float *X, float *Y, float *Z,
+              int width) {
+#pragma omp simd
+    for (int x = 0; x < width; ++x) {
+        const double f = scale[e[x * step]];
+        X[x] = static_cast<float>(r[x * step] * f);
+        Y[x] = static_cast<float>(g[x * step] * f);
+        Z[x] = static_cast<float>(b[x * step] * f);
+    }
+}
+
+//! \brief expands the RLE channel at \a data into \a size bytes of
+//! \a scanline, or only skips it when \a scanline is NULL
+//! \return the first byte after the channel
+const Trgbe *RLERead(const Trgbe *data, const Trgbe *end, Trgbe *scanline,
+                     int size) {
     int peek = 0;
     while (peek < size) {
-        Trgbe p[2];
-        if (fread(p, sizeof(p), 1, file) == 0) {
+        if (end - data < 2) {
             throw pfs::io::ReadException("RGBE: Invalid data size");
         }
-        if (p[0] > 128) {
+        int count = data[0];
+        if (count > 128) {
             // a run
-            int run_len = p[0] - 128;
-
-            while (run_len > 0) {
-                scanline[peek++] = p[1];
-                run_len--;
-            }
+            count -= 128;
+            if (peek + count > size) break;
+            if (scanline) std::memset(scanline + peek, data[1], count);
+            data += 2;
         } else {
-            // a non-run
-            scanline[peek++] = p[1];
-
-            int nonrun_len = p[0] - 1;
-            if (nonrun_len > 0) {
-                if (fread(scanline + peek, sizeof(*scanline), nonrun_len,
-                          file) == 0) {
-                    throw pfs::io::ReadException("RGBE: Invalid data size");
-                } else {
-                    peek += nonrun_len;
-                }
+            // a non-run (of one byte at least)
+            count = std::max(count, 1);
+            if (peek + count > size) break;
+            if (end - data < count + 1) {
+                throw pfs::io::ReadException("RGBE: Invalid data size");
             }
+            if (scanline) std::memcpy(scanline + peek, data + 1, count);
+            data += count + 1;
         }
+        peek += count;
     }
     if (peek != size) {
         throw pfs::io::ReadException(
             "RGBE: difference in size while reading RLE scanline");
     }
+    return data;
 }
 
-void readRadiance(FILE *file, int width, int height, float exposure,
-                  pfs::Array2Df &X, pfs::Array2Df &Y, pfs::Array2Df &Z) {
-    // read image
+//! \return true if the scanline at \a data is new-style RLE
+bool isRLE(const Trgbe *data, const Trgbe *end, int width) {
+    return end - data >= 4 && data[0] == 2 && data[1] == 2 &&
+           (data[2] << 8) + data[3] == width;
+}
+
+//! \brief maps what is left of \a file, named \a filename, or reads it in
+//! memory if it cannot be mapped
+//! \return the first byte left in \a file
+const Trgbe *readAll(FILE *file, const std::string &filename,
+                     pfs::utils::AlignedBuffer<Trgbe> &data) {
+    const long offset = ftell(file);
+    if (offset < 0 || fseek(file, 0, SEEK_END) != 0) {
+        throw pfs::io::ReadException("RGBE: cannot seek in " + filename);
+    }
+    const long fileSize = ftell(file);
+    if (fileSize < offset) {
+        throw pfs::io::ReadException("RGBE: cannot seek in " + filename);
+    }
+
+    // mappings start on an aligned offset: map the tail of the header too
+    const size_t start = offset - offset % pfs::utils::BUFFER_ALIGNMENT;
+    if (data.mapFile(filename, start, fileSize - start)) {
+        return data.data() + (offset - start);
+    }
+
+    const size_t size = fileSize - offset;
+    pfs::utils::AlignedBuffer<Trgbe> buffer(size, false);
+    fseek(file, offset, SEEK_SET);
+    if (fread(buffer.data(), 1, size, file) != size) {
+        throw pfs::io::ReadException("RGBE: cannot read " + filename);
+    }
+    data.swap(buffer);
+    return data.data();
+}
+
+//! \brief maps (or reads) the pixels of \a file, finds where each scanline
+//! starts (one cheap serial walk of the RLE counts) and then expands and
+//! converts the scanlines in parallel
+void readRadiance(FILE *file, const std::string &filename, int width,
+                  int height, float exposure, pfs::Array2Df &X,
+                  pfs::Array2Df &Y, pfs::Array2Df &Z) {
     // depending on format read either rle or normal (note: only rle supported)
-    std::vector<Trgbe> scanline(width * 4);
+    pfs::utils::AlignedBuffer<Trgbe> data;
+    const Trgbe *begin = readAll(file, filename, data);
+    const Trgbe *end = data.data() + data.size();
 
+    std::vector<const Trgbe *> scanlines(height);
+    const Trgbe *peek = begin;
     for (int y = 0; y < height; ++y) {
-        // read rle header
-        Trgbe header[4];
-        if (fread(header, sizeof(header), 1, file) == sizeof(header)) {
+        if (end - peek < 4) {
             throw pfs::io::ReadException("RGBE: invalid data size");
         }
-        if (header[0] != 2 || header[1] != 2 ||
-            (header[2] << 8) + header[3] != width) {
+        scanlines[y] = peek;
+        if (isRLE(peek, end, width)) {
+            //--- rle scanline: each channel is encoded separately
+            peek += 4;
+            for (int ch = 0; ch < 4; ++ch) {
+                peek = RLERead(peek, end, NULL, width);
+            }
+        } else {
             //--- simple scanline (not rle)
-            size_t rez =
-                fread(scanline.data() + 4, sizeof(Trgbe), 4 * width - 4, file);
-            if (rez != (size_t)4 * width - 4) {
-                //     DEBUG_STR << "RGBE: scanline " << y
-                //           << "(" << (int)rez << "/" << width << ")" <<endl;
+            if (end - peek < 4 * width) {
                 throw pfs::Exception(
                     "RGBE: not enough data to read "
                     "in the simple format.");
             }
-            //--- yes, we've read one pixel as a header
-            scanline[0] = header[0];
-            scanline[1] = header[1];
-            scanline[2] = header[2];
-            scanline[3] = header[3];
-
-            //--- write scanline to the image
-            for (int x = 0; x < width; ++x) {
-                Trgbe_pixel rgbe;
-                rgbe.r = scanline[4 * x + 0];
-                rgbe.g = scanline[4 * x + 1];
-                rgbe.b = scanline[4 * x + 2];
-                rgbe.e = scanline[4 * x + 3];
-
-                rgbe2rgb(rgbe, exposure, X(x, y), Y(x, y), Z(x, y));
-            }
-        } else {
-            //--- rle scanline
-            //--- each channel is encoded separately
-            for (int ch = 0; ch < 4; ++ch) {
-                RLERead(file, scanline.data() + width * ch, width);
-            }
+            peek += 4 * width;
+        }
+    }
 
-            //--- write scanline to the image
-            for (int x = 0; x < width; ++x) {
-                Trgbe_pixel rgbe;
-                rgbe.r = scanline[x + width * 0];
-                rgbe.g = scanline[x + width * 1];
-                rgbe.b = scanline[x + width * 2];
-                rgbe.e = scanline[x + width * 3];
+    double scale[256];
+    scale[0] = 0.0;
+    for (int e = 1; e < 256; ++e) {
+        scale[e] = ldexp(1.0, e - int(128 + 8)) /*WHITE_EFFICACY */ / exposure;
+    }
 
-                rgbe2rgb(rgbe, exposure, X(x, y), Y(x, y), Z(x, y));
+    // the walk above validated every scanline: nothing throws from here on
+#pragma omp parallel
+    {
+        std::vector<Trgbe> scanline(width * 4);
+#pragma omp for schedule(dynamic, 16)
+        for (int y = 0; y < height; ++y) {
+            const Trgbe *p = scanlines[y];
+            float *x = X.data() + static_cast<size_t>(y) * width;
+            float *yy = Y.data() + static_cast<size_t>(y) * width;
+            float *z = Z.data() + static_cast<size_t>(y) * width;
+
+            if (isRLE(p, end, width)) {
+                p += 4;
+                for (int ch = 0; ch < 4; ++ch) {
+                    p = RLERead(p, end, scanline.data() + width * ch, width);
+                }
+                rgbe2rgb(scanline.data(), scanline.data() + width,
+                         scanline.data() + width * 2,
+                         scanline.data() + width * 3, 1, scale, x, yy, z,
+                         width);
+            } else {
+                rgbe2rgb(p, p + 1, p + 2, p + 3, 4, scale, x, yy, z, width);
             }
         }
     }
 }
+}
 
 RGBEReader::RGBEReader(const string &filename)
     : FrameReader(filename), m_exposure(0.0) {
@@ -259,6 +310,13 @@ void RGBEReader::close() {
     setHeight(0);
 }
 
+void RGBEReader::probe(FrameInfo &info) const {
+    FrameReader::probe(info);
+
+    info.channels = 3;
+    info.sampleType = SAMPLE_FLOAT;
+}
+
 void RGBEReader::read(Frame &frame, const Params & /*params*/) {
     if (!isOpen()) open();
 
@@ -267,7 +325,8 @@ void RGBEReader::read(Frame &frame, const Params & /*params*/) {
     pfs::Channel *X, *Y, *Z;
     tempFrame.createXYZChannels(X, Y, Z);
 
-    readRadiance(m_file.data(), width(), height(), m_exposure, *X, *Y, *Z);
+    readRadiance(m_file.data(), filename(), width(), height(), m_exposure, *X,
+                 *Y, *Z);
 
     if (m_colorspace == XYZ) pfs::transformXYZ2RGB(X, Y, Z, X, Y, Z);
 
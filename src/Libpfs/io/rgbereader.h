@@ -50,6 +50,7 @@ class RGBEReader : public FrameReader {
     void open();
     void close();
     void read(pfs::Frame &frame, const pfs::Params &params);
+    void probe(FrameInfo &info) const;
 
    private:
     utils::ScopedStdIoFile m_file;
@@ -21,6 +21,8 @@
  * ----------------------------------------------------------------------
  */
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <cstdio>
 #include <vector>
@@ -37,8 +39,12 @@ using namespace std;
 namespace pfs {
 namespace io {
 
-int RLEWrite(FILE *file, Trgbe *scanline, int size) {
-    Trgbe *scanend = scanline + size;
+namespace {
+
+//! \brief appends the RLE encoding of \a size bytes of \a scanline to
+//! \a out
+void RLEWrite(const Trgbe *scanline, int size, std::vector<Trgbe> &out) {
+    const Trgbe *scanend = scanline + size;
     while (scanline < scanend) {
         int run_start = 0;
         int peek = 0;
@@ -57,39 +63,22 @@ int RLEWrite(FILE *file, Trgbe *scanline, int size) {
         if (run_len > 4) {
             // write a non run: scanline[0] to scanline[run_start]
             if (run_start > 0) {
-                std::vector<Trgbe> buf(run_start + 1);
-
-                buf[0] = run_start;
-                for (int i = 0; i < run_start; i++) {
-                    buf[i + 1] = scanline[i];
-                }
-                fwrite(buf.data(), sizeof(Trgbe), run_start + 1, file);
+                out.push_back(run_start);
+                out.insert(out.end(), scanline, scanline + run_start);
             }
 
             // write a run: scanline[run_start], run_len
-            Trgbe buf[2];
-            buf[0] = 128 + run_len;
-            buf[1] = scanline[run_start];
-            fwrite(buf, sizeof(*buf), 2, file);
+            out.push_back(128 + run_len);
+            out.push_back(scanline[run_start]);
         } else {
             // write a non run: scanline[0] to scanline[peek]
-            std::vector<Trgbe> buf(peek + 1);
-
-            buf[0] = peek;
-            for (int i = 0; i < peek; i++) {
-                buf[i + 1] = scanline[i];
-            }
-            fwrite(buf.data(), sizeof(Trgbe), peek + 1, file);
+            out.push_back(peek);
+            out.insert(out.end(), scanline, scanline + peek);
         }
         scanline += peek;
     }
 
-    if (scanline != scanend) {
-        throw pfs::io::WriteException(
-            "RGBE: difference in size while writing RLE scanline");
-    }
-
-    return 0;
+    assert(scanline == scanend);
 }
 
 void rgb2rgbe(float r, float g, float b, Trgbe_pixel &rgbe) {
@@ -114,6 +103,38 @@ void rgb2rgbe(float r, float g, float b, Trgbe_pixel &rgbe) {
     }
 }
 
+//! \brief converts and RLE encodes scanline \a y (with its header) into
+//! \a out. \a scanline is scratch space for 4 * width bytes.
+void encodeScanline(const pfs::Array2Df &X, const pfs::Array2Df &Y,
+                    const pfs::Array2Df &Z, size_t y, Trgbe *scanline,
+                    std::vector<Trgbe> &out) {
+    const size_t width = X.getCols();
+
+    // rle header
+    out.clear();
+    out.push_back(2);
+    out.push_back(2);
+    out.push_back(width >> 8);
+    out.push_back(width & 0xFF);
+
+    // each channel is encoded separately
+    for (size_t x = 0; x < width; x++) {
+        Trgbe_pixel p;
+        rgb2rgbe(X(x, y), Y(x, y), Z(x, y), p);
+        scanline[x] = p.r;
+        scanline[x + width] = p.g;
+        scanline[x + width * 2] = p.b;
+        scanline[x + width * 3] = p.e;
+    }
+    for (size_t ch = 0; ch < 4; ++ch) {
+        RLEWrite(scanline + width * ch, width, out);
+    }
+}
+
+//! \brief scanlines encoded in parallel before they are written in order:
+//! only one band is held in memory at a time
+const size_t BAND_ROWS = 256;
+
 void writeRadiance(FILE *file, const pfs::Array2Df &X, const pfs::Array2Df &Y,
                    const pfs::Array2Df &Z) {
     size_t width = X.getCols();
@@ -142,36 +163,29 @@ void writeRadiance(FILE *file, const pfs::Array2Df &X, const pfs::Array2Df &Y,
     fprintf(file, "-Y %d +X %d\n", (int)height, (int)width);
 
     // image run length encoded
-    std::vector<Trgbe> scanlineR(width);
-    std::vector<Trgbe> scanlineG(width);
-    std::vector<Trgbe> scanlineB(width);
-    std::vector<Trgbe> scanlineE(width);
-
-    for (size_t y = 0; y < height; ++y) {
-        // write rle header
-        unsigned char header[4];
-        header[0] = 2;
-        header[1] = 2;
-        header[2] = width >> 8;
-        ;
-        header[3] = width & 0xFF;
-        fwrite(header, sizeof(header), 1, file);
-
-        // each channel is encoded separately
-        for (size_t x = 0; x < width; x++) {
-            Trgbe_pixel p;
-            rgb2rgbe(X(x, y), Y(x, y), Z(x, y), p);
-            scanlineR[x] = p.r;
-            scanlineG[x] = p.g;
-            scanlineB[x] = p.b;
-            scanlineE[x] = p.e;
+    std::vector<std::vector<Trgbe> > band(std::min(BAND_ROWS, height));
+    for (size_t first = 0; first < height; first += BAND_ROWS) {
+        const int rows = static_cast<int>(std::min(BAND_ROWS, height - first));
+
+#pragma omp parallel
+        {
+            std::vector<Trgbe> scanline(width * 4);
+#pragma omp for schedule(dynamic, 8)
+            for (int row = 0; row < rows; ++row) {
+                encodeScanline(X, Y, Z, first + row, scanline.data(),
+                               band[row]);
+            }
+        }
+
+        for (int row = 0; row < rows; ++row) {
+            if (fwrite(band[row].data(), sizeof(Trgbe), band[row].size(),
+                       file) != band[row].size()) {
+                throw pfs::io::WriteException("RGBE: cannot write scanline");
+            }
         }
-        RLEWrite(file, scanlineR.data(), width);
-        RLEWrite(file, scanlineG.data(), width);
-        RLEWrite(file, scanlineB.data(), width);
-        RLEWrite(file, scanlineE.data(), width);
     }
 }
+}
 
 RGBEWriter::RGBEWriter(const std::string &filename) : FrameWriter(filename) {}
 
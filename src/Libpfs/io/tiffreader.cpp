@@ -34,10 +34,14 @@
 #include <Libpfs/utils/resourcehandlerlcms.h>
 #include <Libpfs/utils/transform.h>
 
+#include <omp.h>
 #include <tiffio.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <exception>
 #include <iostream>
 #include <stdexcept>
 #include <utility>
@@ -147,7 +151,18 @@ static cmsHPROFILE GetTIFFProfile(TIFF *in, uint16 bps) {
 namespace pfs {
 namespace io {
 
-struct TiffReaderParams {};
+//! \brief what \c TiffReaderData decodes
+struct TiffReaderParams {
+    TiffReaderParams() : x(0), y(0), width(0), height(0), threads(1) {}
+
+    //! \brief region of interest
+    size_t x;
+    size_t y;
+    size_t width;
+    size_t height;
+    //! \brief number of strips or tiles decoded at the same time
+    int threads;
+};
 
 struct TiffReaderData {
     // < photometric type, bits per sample >
@@ -156,17 +171,26 @@ struct TiffReaderData {
         Callback;
 
     TiffReaderData()
-        : hasAlpha_(false),
+        : tiled_(false),
+          blockWidth_(0),
+          blockHeight_(0),
+          hasAlpha_(false),
           stonits_(1.0),
           currentCallback_(boost::bind(&TiffReaderData::doNothing, _1, _2, _3)),
           hsRGB_(cmsCreate_sRGBProfile()) {}
 
     // public members...
+    std::string filename_;
     ScopedTiffFile file_;
 
     uint32 height_;
     uint32 width_;
 
+    // the image is decoded one block (strip or tile) at a time
+    bool tiled_;
+    uint32 blockWidth_;
+    uint32 blockHeight_;
+
     uint16 compressionType_;  // compression type
     uint16 photometricType_;  // type of photometric data
 
@@ -185,8 +209,17 @@ struct TiffReaderData {
     // public functions
     inline TIFF *handle() { return file_.data(); }
 
-    void read(Frame &frame, const Params & /*params*/) {
-        currentCallback_(this, frame, TiffReaderParams());
+    void read(Frame &frame, const TiffReaderParams &params) {
+        currentCallback_(this, frame, params);
+    }
+
+    //! \brief open another handle on the file, for another thread
+    TIFF *openHandle() const {
+        TIFF *tif = TIFFOpen(filename_.c_str(), "r");
+        if (tif && photometricType_ == PHOTOMETRIC_LOGLUV) {
+            TIFFSetField(tif, TIFFTAG_SGILOGDATAFMT, SGILOGDATAFMT_FLOAT);
+        }
+        return tif;
     }
 
     void initReader() {
@@ -282,72 +315,159 @@ struct TiffReaderData {
             } break;
         }
 
+        // without its cache, a transform can be shared between threads
         return cmsCreateTransform(hIn_.data(), cmsInputFormat, hsRGB_.data(),
-                                  cmsOutputFormat, cmsIntent, 0);
+                                  cmsOutputFormat, cmsIntent,
+                                  cmsFLAGS_NOCACHE);
     }
 
     void doNothing(Frame & /*frame*/, const TiffReaderParams & /*params*/) {}
 
+    //! \brief decode the region of interest, one strip or tile at a time,
+    //! and hand each of its rows to \a rowFunc(samples, count, row, col):
+    //! \a count interleaved pixels, to be stored from (\a col, \a row) of
+    //! the region. Blocks are decoded on \c params.threads threads, each one
+    //! with its own handle on the file, as libtiff handles cannot be shared.
+    template <typename InputDataType, typename RowFunc>
+    void readBlocks(const TiffReaderParams &params, const RowFunc &rowFunc) {
+        if (params.width == 0 || params.height == 0) return;
+
+        const size_t x1 = params.x + params.width;
+        const size_t y1 = params.y + params.height;
+        const size_t firstCol = params.x / blockWidth_;
+        const size_t firstRow = params.y / blockHeight_;
+        const size_t blocksAcross = (x1 - 1) / blockWidth_ - firstCol + 1;
+        const size_t blocksDown = (y1 - 1) / blockHeight_ - firstRow + 1;
+        const int blocks = static_cast<int>(blocksAcross * blocksDown);
+
+        const tmsize_t blockBytes =
+            tiled_ ? TIFFTileSize(handle()) : TIFFStripSize(handle());
+        const size_t rowSamples = blockWidth_ * samplesPerPixel_;
+
+        std::atomic<bool> failed(false);
+        // exceptions cannot leave the parallel region: the first one thrown
+        // (e.g. bad_alloc) is kept and rethrown once it is over
+        std::exception_ptr error;
+        const auto keepError = [&]() {
+#pragma omp critical(TiffReaderError)
+            if (!error) error = std::current_exception();
+            failed = true;
+        };
+#pragma omp parallel num_threads(std::max(1, std::min(params.threads, blocks)))
+        {
+            ScopedTiffFile ownFile;
+            TIFF *tif = handle();
+            std::vector<InputDataType> buffer;
+            try {
+                if (omp_get_thread_num() != 0) {
+                    ownFile.reset(openHandle());
+                    tif = ownFile.data();
+                    if (!tif) failed = true;
+                }
+                buffer.resize(blockBytes / sizeof(InputDataType) + 1);
+            } catch (...) {
+                keepError();
+            }
+
+#pragma omp for schedule(dynamic)
+            for (int b = 0; b < blocks; ++b) {
+                if (failed) continue;
+
+                try {
+                    const size_t bx =
+                        (firstCol + b % blocksAcross) * blockWidth_;
+                    const size_t by =
+                        (firstRow + b / blocksAcross) * blockHeight_;
+                    const tmsize_t read =
+                        tiled_ ? TIFFReadEncodedTile(
+                                     tif, TIFFComputeTile(tif, bx, by, 0, 0),
+                                     buffer.data(), blockBytes)
+                               : TIFFReadEncodedStrip(
+                                     tif, TIFFComputeStrip(tif, by, 0),
+                                     buffer.data(), blockBytes);
+                    if (read < 0) {
+                        failed = true;
+                        continue;
+                    }
+
+                    // the part of the block inside the region of interest
+                    const size_t cx0 = std::max(bx, params.x);
+                    const size_t cx1 = std::min<size_t>(bx + blockWidth_, x1);
+                    const size_t cy0 = std::max(by, params.y);
+                    const size_t cy1 =
+                        std::min<size_t>(by + blockHeight_, y1);
+                    for (size_t y = cy0; y < cy1; ++y) {
+                        InputDataType *samples =
+                            buffer.data() + (y - by) * rowSamples +
+                            (cx0 - bx) * samplesPerPixel_;
+                        rowFunc(samples, cx1 - cx0, y - params.y,
+                                cx0 - params.x);
+                    }
+                } catch (...) {
+                    keepError();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        if (failed) {
+            throw pfs::io::ReadException("TiffReader: cannot decode " +
+                                         filename_);
+        }
+    }
+
     template <typename InputDataType, typename Converter>
-    void read3Components(Frame &frame, const TiffReaderParams & /*params*/,
+    void read3Components(Frame &frame, const TiffReaderParams &params,
                          const Converter &conv) {
         assert(samplesPerPixel_ >= 3);
-        Frame tempFrame(width_, height_);
+        Frame tempFrame(params.width, params.height);
 
         pfs::Channel *Xc;
         pfs::Channel *Yc;
         pfs::Channel *Zc;
         tempFrame.createXYZChannels(Xc, Yc, Zc);
 
-        std::vector<InputDataType> tempBuffer(width_ * samplesPerPixel_);
-        for (uint32 row = 0; row < height_; row++) {
-            TIFFReadScanline(handle(), tempBuffer.data(), row);
-
-            utils::transform(StrideIterator<InputDataType *>(tempBuffer.data(),
-                                                             samplesPerPixel_),
-                             StrideIterator<InputDataType *>(
-                                 tempBuffer.data() + width_ * samplesPerPixel_,
-                                 samplesPerPixel_),
-                             StrideIterator<InputDataType *>(
-                                 tempBuffer.data() + 1, samplesPerPixel_),
-                             StrideIterator<InputDataType *>(
-                                 tempBuffer.data() + 2, samplesPerPixel_),
-                             Xc->row_begin(row), Yc->row_begin(row),
-                             Zc->row_begin(row), conv);
-        }
+        const size_t spp = samplesPerPixel_;
+        readBlocks<InputDataType>(params, [&](InputDataType *samples,
+                                              size_t count, size_t row,
+                                              size_t col) {
+            utils::transform(
+                StrideIterator<InputDataType *>(samples, spp),
+                StrideIterator<InputDataType *>(samples + count * spp, spp),
+                StrideIterator<InputDataType *>(samples + 1, spp),
+                StrideIterator<InputDataType *>(samples + 2, spp),
+                Xc->row_begin(row) + col, Yc->row_begin(row) + col,
+                Zc->row_begin(row) + col, conv);
+        });
 
         tempFrame.swap(frame);
     }
 
     template <typename InputDataType, typename Converter>
-    void read4Components(Frame &frame, const TiffReaderParams & /*params*/,
+    void read4Components(Frame &frame, const TiffReaderParams &params,
                          const Converter &conv) {
         assert(samplesPerPixel_ >= 4);
-        Frame tempFrame(width_, height_);
+        Frame tempFrame(params.width, params.height);
 
         pfs::Channel *Xc;
         pfs::Channel *Yc;
         pfs::Channel *Zc;
         tempFrame.createXYZChannels(Xc, Yc, Zc);
 
-        std::vector<InputDataType> tempBuffer(width_ * samplesPerPixel_);
-        for (uint32 row = 0; row < height_; row++) {
-            TIFFReadScanline(handle(), tempBuffer.data(), row);
-
-            utils::transform(StrideIterator<InputDataType *>(tempBuffer.data(),
-                                                             samplesPerPixel_),
-                             StrideIterator<InputDataType *>(
-                                 tempBuffer.data() + width_ * samplesPerPixel_,
-                                 samplesPerPixel_),
-                             StrideIterator<InputDataType *>(
-                                 tempBuffer.data() + 1, samplesPerPixel_),
-                             StrideIterator<InputDataType *>(
-                                 tempBuffer.data() + 2, samplesPerPixel_),
-                             StrideIterator<InputDataType *>(
-                                 tempBuffer.data() + 3, samplesPerPixel_),
-                             Xc->row_begin(row), Yc->row_begin(row),
-                             Zc->row_begin(row), conv);
-        }
+        const size_t spp = samplesPerPixel_;
+        readBlocks<InputDataType>(params, [&](InputDataType *samples,
+                                              size_t count, size_t row,
+                                              size_t col) {
+            utils::transform(
+                StrideIterator<InputDataType *>(samples, spp),
+                StrideIterator<InputDataType *>(samples + count * spp, spp),
+                StrideIterator<InputDataType *>(samples + 1, spp),
+                StrideIterator<InputDataType *>(samples + 2, spp),
+                StrideIterator<InputDataType *>(samples + 3, spp),
+                Xc->row_begin(row) + col, Yc->row_begin(row) + col,
+                Zc->row_begin(row) + col, conv);
+        });
 
         tempFrame.swap(frame);
     }
@@ -418,6 +538,7 @@ bool TiffReader::isOpen() const { return m_data->file_; }
 void TiffReader::close() { m_data.reset(new TiffReaderData); }
 
 void TiffReader::open() {
+    m_data->filename_ = filename();
     m_data->file_.reset(TIFFOpen(filename().c_str(), "r"));
     if (!m_data->file_) {
         throw pfs::io::InvalidFile("TiffReader: cannot open file " +
@@ -433,8 +554,25 @@ void TiffReader::open() {
     setWidth(m_data->width_);
     setHeight(m_data->height_);
 
-    // check if planar... maybe in the future we can add support for tiled
-    // images?
+    // strips or tiles
+    m_data->tiled_ = TIFFIsTiled(m_data->handle()) != 0;
+    if (m_data->tiled_) {
+        if (!TIFFGetField(m_data->handle(), TIFFTAG_TILEWIDTH,
+                          &m_data->blockWidth_) ||
+            !TIFFGetField(m_data->handle(), TIFFTAG_TILELENGTH,
+                          &m_data->blockHeight_) ||
+            m_data->blockWidth_ == 0 || m_data->blockHeight_ == 0) {
+            throw pfs::io::InvalidHeader("TiffReader: invalid tile size");
+        }
+    } else {
+        m_data->blockWidth_ = m_data->width_;
+        TIFFGetFieldDefaulted(m_data->handle(), TIFFTAG_ROWSPERSTRIP,
+                              &m_data->blockHeight_);
+        m_data->blockHeight_ = std::max<uint32>(
+            1, std::min(m_data->blockHeight_, m_data->height_));
+    }
+
+    // check if planar...
     uint16 planarConfig;
     TIFFGetField(m_data->handle(), TIFFTAG_PLANARCONFIG, &planarConfig);
     if (planarConfig != PLANARCONFIG_CONTIG) {
@@ -528,12 +666,42 @@ void TiffReader::open() {
 
 #define CALL_MEMBER_FN(object, ptrToMember) ((object).*(ptrToMember))
 
+void TiffReader::probe(FrameInfo &info) const {
+    FrameReader::probe(info);
+
+    info.channels = m_data->samplesPerPixel_;
+    if (m_data->photometricType_ == PHOTOMETRIC_LOGLUV) {
+        info.sampleType = SAMPLE_FLOAT;
+        return;
+    }
+    switch (m_data->bitsPerSample_) {
+        case 8:
+            info.sampleType = SAMPLE_UINT8;
+            break;
+        case 16:
+            info.sampleType = SAMPLE_UINT16;
+            break;
+        case 32:
+            info.sampleType = SAMPLE_FLOAT;
+            break;
+    }
+}
+
 void TiffReader::read(Frame &frame, const Params &params) {
     if (!isOpen()) {
         open();
     }
 
-    m_data->read(frame, params);
+    TiffReaderParams readerParams;
+    getROI(params, readerParams.x, readerParams.y, readerParams.width,
+           readerParams.height);
+    // same meaning of the EXR reader: 0 disables the threads
+    if (!params.get("threads", readerParams.threads) ||
+        readerParams.threads < 0) {
+        readerParams.threads = omp_get_max_threads();
+    }
+
+    m_data->read(frame, readerParams);
     FrameReader::read(frame, params);
 }
 
@@ -44,6 +44,7 @@ class TiffReader : public FrameReader {
     void close();
 
     void read(Frame &frame, const Params &params);
+    void probe(FrameInfo &info) const;
 
    private:
     std::unique_ptr<TiffReaderData> m_data;
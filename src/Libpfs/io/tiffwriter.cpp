@@ -34,12 +34,16 @@
 #include <Libpfs/io/tiffcommon.h>
 #include <Libpfs/io/tiffwriter.h>
 
+#include <omp.h>
 #include <tiffio.h>
 
 #include <stdint.h>
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cctype>
 #include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <limits>
 #include <sstream>
@@ -73,6 +77,43 @@ using namespace pfs;
 namespace pfs {
 namespace io {
 
+namespace {
+
+struct CompressionName {
+    const char *name;
+    uint16_t compression;
+};
+
+const CompressionName COMPRESSIONS[] = {
+    {"none", COMPRESSION_NONE},
+    {"deflate", COMPRESSION_DEFLATE},
+    {"lzw", COMPRESSION_LZW},
+    {"packbits", COMPRESSION_PACKBITS},
+#ifdef COMPRESSION_ZSTD
+    {"zstd", COMPRESSION_ZSTD},
+#endif
+};
+
+struct PredictorName {
+    const char *name;
+    uint16_t predictor;
+};
+
+const PredictorName PREDICTORS[] = {{"none", PREDICTOR_NONE},
+                                    {"horizontal", PREDICTOR_HORIZONTAL},
+                                    {"float", PREDICTOR_FLOATINGPOINT}};
+
+//! \brief uncompressed size of a strip: big enough to keep the
+//! compressors busy, small enough to spread a small image on all threads
+const size_t STRIP_BYTES = 256 * 1024;
+
+std::string toLower(const std::string &name) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    return lower;
+}
+}
+
 struct TiffWriterParams {
     TiffWriterParams()
         : quality_(100),
@@ -81,7 +122,11 @@ struct TiffWriterParams {
           luminanceMapping_(MAP_LINEAR),
           tiffWriterMode_(0)  // 8bit uint by default
           ,
-          deflateCompression_(true) {}
+          deflateCompression_(true),
+          compression_(-1),
+          compressionLevel_(0),
+          predictor_(PREDICTOR_NONE),
+          threads_(1) {}
 
     void parse(const Params &params) {
         for (Params::const_iterator it = params.begin(), itEnd = params.end();
@@ -109,9 +154,57 @@ struct TiffWriterParams {
             }
             if (it->first == "deflateCompression") {
                 deflateCompression_ = it->second.as<bool>(deflateCompression_);
+                continue;
+            }
+            if (it->first == "tiff_compression") {
+                setCompression(it->second.as<std::string>(std::string()));
+                continue;
+            }
+            if (it->first == "tiff_compression_level") {
+                compressionLevel_ =
+                    it->second.as<int>(compressionLevel_);
+                continue;
+            }
+            if (it->first == "tiff_predictor") {
+                setPredictor(it->second.as<std::string>(std::string()));
                 // continue;
             }
         }
+        // "tiff_compression" wins over the older "deflateCompression"
+        if (compression_ < 0) {
+            compression_ =
+                deflateCompression_ ? COMPRESSION_DEFLATE : COMPRESSION_NONE;
+        }
+        // same meaning of the EXR writer: 0 disables the threads
+        if (!params.get("threads", threads_) || threads_ < 0) {
+            threads_ = omp_get_max_threads();
+        }
+    }
+
+    void setCompression(const std::string &name) {
+        const std::string lower = toLower(name);
+        for (size_t i = 0; i < sizeof(COMPRESSIONS) / sizeof(COMPRESSIONS[0]);
+             ++i) {
+            if (lower == COMPRESSIONS[i].name) {
+                compression_ = COMPRESSIONS[i].compression;
+                return;
+            }
+        }
+        throw pfs::io::WriteException("TiffWriter: unsupported compression " +
+                                      name);
+    }
+
+    void setPredictor(const std::string &name) {
+        const std::string lower = toLower(name);
+        for (size_t i = 0; i < sizeof(PREDICTORS) / sizeof(PREDICTORS[0]);
+             ++i) {
+            if (lower == PREDICTORS[i].name) {
+                predictor_ = PREDICTORS[i].predictor;
+                return;
+            }
+        }
+        throw pfs::io::WriteException("TiffWriter: unsupported predictor " +
+                                      name);
     }
 
     size_t quality_;
@@ -120,6 +213,10 @@ struct TiffWriterParams {
     RGBMappingType luminanceMapping_;
     int tiffWriterMode_;
     bool deflateCompression_;
+    int compression_;
+    int compressionLevel_;
+    uint16_t predictor_;
+    int threads_;
 };
 
 ostream &operator<<(ostream &out, const TiffWriterParams &params) {
@@ -129,17 +226,83 @@ ostream &operator<<(ostream &out, const TiffWriterParams &params) {
     ss << "quality: " << params.quality_ << ", ";
     ss << "min_luminance: " << params.minLuminance_ << ", ";
     ss << "max_luminance: " << params.maxLuminance_ << ", ";
-    ss << "mapping_method: " << params.luminanceMapping_ << "]";
-    ss << "deflateCompression: " << params.deflateCompression_ << "]";
+    ss << "mapping_method: " << params.luminanceMapping_ << ", ";
+    ss << "compression: " << params.compression_ << ", ";
+    ss << "compression_level: " << params.compressionLevel_ << ", ";
+    ss << "predictor: " << params.predictor_ << ", ";
+    ss << "threads: " << params.threads_ << "]";
 
     return (out << ss.str());
 }
 
-void writeCommonHeader(TIFF *tif, uint32_t width, uint32_t height) {
+//! \brief how the samples of each mode are stored
+struct TiffLayout {
+    uint16_t bitsPerSample;
+    uint16_t sampleFormat;
+    uint16_t photometric;
+};
+
+//! \brief tags shared by the file and the strip encoders of \c writeStrips
+void writeCommonHeader(TIFF *tif, uint32_t width, uint32_t height,
+                       const TiffLayout &layout,
+                       const TiffWriterParams &params) {
+    const size_t rowBytes = width * 3 * (layout.bitsPerSample / 8);
+    const uint32_t rowsPerStrip = static_cast<uint32_t>(
+        std::min<size_t>(height, std::max<size_t>(1, STRIP_BYTES / rowBytes)));
+
     TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, (uint32_t)width);
     TIFFSetField(tif, TIFFTAG_IMAGELENGTH, (uint32_t)height);
-    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, (uint32_t)1);
+    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
     TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, layout.photometric);
+    TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, layout.sampleFormat);
+    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, layout.bitsPerSample);
+    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, (uint16_t)3);
+
+    if (layout.photometric == PHOTOMETRIC_LOGLUV) {
+        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_SGILOG);
+        TIFFSetField(tif, TIFFTAG_SGILOGDATAFMT, SGILOGDATAFMT_FLOAT);
+        TIFFSetField(tif, TIFFTAG_STONITS, 1.); /* not known */
+        return;
+    }
+
+    const uint16_t compression = static_cast<uint16_t>(params.compression_);
+    if (compression == COMPRESSION_NONE) return;
+    if (!TIFFIsCODECConfigured(compression)) {
+        throw pfs::io::WriteException(
+            "TiffWriter: compression not available in libtiff");
+    }
+    TIFFSetField(tif, TIFFTAG_COMPRESSION, compression);
+
+    switch (compression) {
+        case COMPRESSION_DEFLATE:
+            if (params.compressionLevel_ > 0) {
+                TIFFSetField(tif, TIFFTAG_ZIPQUALITY,
+                             std::min(params.compressionLevel_, 9));
+            }
+            break;
+#ifdef COMPRESSION_ZSTD
+        case COMPRESSION_ZSTD:
+            if (params.compressionLevel_ > 0) {
+                TIFFSetField(tif, TIFFTAG_ZSTD_LEVEL,
+                             std::min(params.compressionLevel_, 22));
+            }
+            break;
+#endif
+        case COMPRESSION_LZW:
+            break;
+        default:
+            // no predictor for the other schemes
+            return;
+    }
+    if (params.predictor_ == PREDICTOR_FLOATINGPOINT &&
+        layout.sampleFormat != SAMPLEFORMAT_IEEEFP) {
+        throw pfs::io::WriteException(
+            "TiffWriter: floating point predictor needs a float TIFF");
+    }
+    if (params.predictor_ != PREDICTOR_NONE) {
+        TIFFSetField(tif, TIFFTAG_PREDICTOR, params.predictor_);
+    }
 }
 
 void writeSRGBProfile(TIFF *tif) {
@@ -162,91 +325,223 @@ void writeSRGBProfile(TIFF *tif) {
 //    TIFFSetField (tif, TIFFTAG_SAMPLESPERPIXEL, (uint16_t)4);
 //    TIFFSetField (tif, TIFFTAG_EXTRASAMPLES, (uint16_t)1, &extras);
 
-bool writeUint8(TIFF *tif, const Frame &frame, const TiffWriterParams &params) {
-#ifndef NDEBUG
-    cout << BOOST_CURRENT_FUNCTION << endl;
-#endif
+namespace {
+
+//! \brief TIFF file living in memory, used to run the codecs of libtiff
+//! (predictors included) on a single strip. Every strip is appended right
+//! after the header, so \c encode leaves only that strip in the file.
+class StripEncoder {
+   public:
+    StripEncoder(uint32_t width, uint32_t height, const TiffLayout &layout,
+                 const TiffWriterParams &params)
+        : m_position(0), m_tif(NULL), m_headerSize(0) {
+        m_tif = TIFFClientOpen("memory", "w", reinterpret_cast<thandle_t>(this),
+                               &StripEncoder::read, &StripEncoder::write,
+                               &StripEncoder::seek, &StripEncoder::close,
+                               &StripEncoder::size, &StripEncoder::map,
+                               &StripEncoder::unmap);
+        if (m_tif) {
+            writeCommonHeader(m_tif, width, height, layout, params);
+            m_headerSize = m_data.size();
+        }
+    }
 
-    assert(tif != NULL);
+    // the directory is never written
+    ~StripEncoder() {
+        if (m_tif) TIFFCleanup(m_tif);
+    }
 
-    uint32_t width = frame.getWidth();
-    uint32_t height = frame.getHeight();
+    bool isOpen() const { return m_tif != NULL; }
 
-    writeCommonHeader(tif, width, height);
-    writeSRGBProfile(tif);
+    //! \brief compress \a bytes of \a data as strip \a strip. The encoded
+    //! strip is valid up to the next call.
+    bool encode(tstrip_t strip, void *data, tsize_t bytes,
+                const char *&encoded, tsize_t &encodedBytes) {
+        m_data.resize(m_headerSize);
+        if (TIFFWriteEncodedStrip(m_tif, strip, data, bytes) != bytes) {
+            return false;
+        }
+        encoded = m_data.data() + m_headerSize;
+        encodedBytes = m_data.size() - m_headerSize;
+        return true;
+    }
 
-    if (params.deflateCompression_)
-        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_DEFLATE);
-    TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
-    TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
-    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE,
-                 (uint16_t)8 * (uint16_t)sizeof(uint8_t));
-    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, (uint16_t)3);
+   private:
+    static StripEncoder *self(thandle_t handle) {
+        return reinterpret_cast<StripEncoder *>(handle);
+    }
+
+    static tsize_t read(thandle_t handle, tdata_t buffer, tsize_t bytes) {
+        StripEncoder *e = self(handle);
+        const size_t available =
+            e->m_position < e->m_data.size()
+                ? std::min<size_t>(bytes, e->m_data.size() - e->m_position)
+                : 0;
+        std::copy(e->m_data.begin() + e->m_position,
+                  e->m_data.begin() + e->m_position + available,
+                  static_cast<char *>(buffer));
+        e->m_position += available;
+        return available;
+    }
+
+    static tsize_t write(thandle_t handle, tdata_t buffer, tsize_t bytes) {
+        StripEncoder *e = self(handle);
+        if (e->m_data.size() < e->m_position + bytes) {
+            e->m_data.resize(e->m_position + bytes);
+        }
+        const char *src = static_cast<const char *>(buffer);
+        std::copy(src, src + bytes, e->m_data.begin() + e->m_position);
+        e->m_position += bytes;
+        return bytes;
+    }
+
+    static toff_t seek(thandle_t handle, toff_t offset, int whence) {
+        StripEncoder *e = self(handle);
+        switch (whence) {
+            case SEEK_CUR:
+                e->m_position += offset;
+                break;
+            case SEEK_END:
+                e->m_position = e->m_data.size() + offset;
+                break;
+            case SEEK_SET:
+            default:
+                e->m_position = offset;
+                break;
+        }
+        return e->m_position;
+    }
+
+    static toff_t size(thandle_t handle) { return self(handle)->m_data.size(); }
+
+    static int close(thandle_t) { return 0; }
 
-    tsize_t stripSize = TIFFStripSize(tif);
-    assert(width * 3 == stripSize);
-    tstrip_t stripsNum = TIFFNumberOfStrips(tif);
+    static int map(thandle_t, tdata_t *, toff_t *) { return 0; }
+
+    static void unmap(thandle_t, tdata_t, toff_t) {}
+
+    std::vector<char> m_data;
+    size_t m_position;
+    TIFF *m_tif;
+    size_t m_headerSize;
+};
+}
+
+//! \brief convert the frame into strips of \c T samples through \a remapper
+//! and write them. With more than one thread, the strips are converted and
+//! compressed in parallel, each thread running its own \c StripEncoder, and
+//! appended to the file in order.
+template <typename T, typename Remapper>
+bool writeStrips(TIFF *tif, const Frame &frame, const TiffLayout &layout,
+                 const TiffWriterParams &params, const Remapper &remapper) {
+    const uint32_t width = frame.getWidth();
+    const uint32_t height = frame.getHeight();
+
+    const tsize_t stripSize = TIFFStripSize(tif);
+    const tstrip_t stripsNum = TIFFNumberOfStrips(tif);
+    const uint32_t rowsPerStrip =
+        static_cast<uint32_t>(stripSize / (sizeof(T) * width * 3));
+    assert((tsize_t)sizeof(T) * width * 3 * rowsPerStrip == stripSize);
 
     const Channel *rChannel;
     const Channel *gChannel;
     const Channel *bChannel;
     frame.getXYZChannels(rChannel, gChannel, bChannel);
 
-    std::vector<uint8_t> stripBuffer(stripSize);
-    for (tstrip_t s = 0; s < stripsNum; s++) {
-        utils::transform(
-            rChannel->row_begin(s), rChannel->row_end(s),
-            gChannel->row_begin(s), bChannel->row_begin(s),
-            FixedStrideIterator<uint8_t *, 3>(stripBuffer.data()),
-            FixedStrideIterator<uint8_t *, 3>(stripBuffer.data() + 1),
-            FixedStrideIterator<uint8_t *, 3>(stripBuffer.data() + 2),
-            utils::chain(colorspace::Normalizer(params.minLuminance_,
-                                                params.maxLuminance_),
-                         utils::CLAMP_F32,
-                         Remapper<uint8_t>(params.luminanceMapping_)));
-
-        if (TIFFWriteEncodedStrip(tif, s, stripBuffer.data(), stripSize) !=
-            stripSize) {
-            throw pfs::io::WriteException("TiffWriter: Error writing strip " +
-                                          boost::lexical_cast<std::string>(s));
-            return false;
+    // convert strip s into buffer, return its size in bytes
+    auto convert = [&](tstrip_t s, T *buffer) -> tsize_t {
+        const uint32_t y0 = s * rowsPerStrip;
+        const uint32_t y1 = std::min(y0 + rowsPerStrip, height);
+        for (uint32_t y = y0; y < y1; ++y) {
+            T *row = buffer + (y - y0) * width * 3;
+            utils::transform(rChannel->row_begin(y), rChannel->row_end(y),
+                             gChannel->row_begin(y), bChannel->row_begin(y),
+                             FixedStrideIterator<T *, 3>(row),
+                             FixedStrideIterator<T *, 3>(row + 1),
+                             FixedStrideIterator<T *, 3>(row + 2), remapper);
         }
+        return (y1 - y0) * width * 3 * sizeof(T);
+    };
+
+    const int threads = std::min<int>(params.threads_, stripsNum);
+    if (threads <= 1) {
+        std::vector<T> stripBuffer(stripSize / sizeof(T));
+        for (tstrip_t s = 0; s < stripsNum; s++) {
+            const tsize_t bytes = convert(s, stripBuffer.data());
+            if (TIFFWriteEncodedStrip(tif, s, stripBuffer.data(), bytes) !=
+                bytes) {
+                throw pfs::io::WriteException(
+                    "TiffWriter: Error writing strip " +
+                    boost::lexical_cast<std::string>(s));
+            }
+        }
+        return true;
+    }
+
+    std::atomic<int> failedStrip(-1);
+#pragma omp parallel num_threads(threads)
+    {
+        StripEncoder encoder(width, height, layout, params);
+        std::vector<T> stripBuffer(stripSize / sizeof(T));
+
+#pragma omp for ordered schedule(dynamic)
+        for (int s = 0; s < static_cast<int>(stripsNum); s++) {
+            const char *encoded = NULL;
+            tsize_t encodedBytes = 0;
+            bool ok = failedStrip < 0 && encoder.isOpen() &&
+                      encoder.encode(s, stripBuffer.data(),
+                                     convert(s, stripBuffer.data()), encoded,
+                                     encodedBytes);
+#pragma omp ordered
+            {
+                ok = ok && failedStrip < 0 &&
+                     TIFFWriteRawStrip(tif, s, const_cast<char *>(encoded),
+                                       encodedBytes) == encodedBytes;
+                if (!ok && failedStrip < 0) failedStrip = s;
+            }
+        }
+    }
+    if (failedStrip >= 0) {
+        throw pfs::io::WriteException(
+            "TiffWriter: Error writing strip " +
+            boost::lexical_cast<std::string>(failedStrip));
     }
     return true;
 }
 
-bool writeUint16(TIFF *tif, const Frame &frame,
-                 const TiffWriterParams &params) {
+bool writeUint8(TIFF *tif, const Frame &frame, const TiffWriterParams &params) {
 #ifndef NDEBUG
     cout << BOOST_CURRENT_FUNCTION << endl;
 #endif
-    assert(tif != NULL);
 
-    uint32_t width = frame.getWidth();
-    uint32_t height = frame.getHeight();
+    assert(tif != NULL);
 
-    writeCommonHeader(tif, width, height);
+    const TiffLayout layout = {8 * sizeof(uint8_t), SAMPLEFORMAT_UINT,
+                               PHOTOMETRIC_RGB};
+    writeCommonHeader(tif, frame.getWidth(), frame.getHeight(), layout,
+                      params);
     writeSRGBProfile(tif);
 
-    if (params.deflateCompression_) {
-        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_DEFLATE);
-    }
-    TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
-    TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
-    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE,
-                 (uint16_t)8 * (uint16_t)sizeof(uint16_t));
-    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, (uint16_t)3);
-
-    tsize_t stripSize = TIFFStripSize(tif);
-    assert(width * 3 * 2 == stripSize);
-    tstrip_t stripsNum = TIFFNumberOfStrips(tif);
+    return writeStrips<uint8_t>(
+        tif, frame, layout, params,
+        utils::chain(colorspace::Normalizer(params.minLuminance_,
+                                            params.maxLuminance_),
+                     utils::CLAMP_F32,
+                     Remapper<uint8_t>(params.luminanceMapping_)));
+}
 
-    const Channel *rChannel;
-    const Channel *gChannel;
-    const Channel *bChannel;
-    frame.getXYZChannels(rChannel, gChannel, bChannel);
+bool writeUint16(TIFF *tif, const Frame &frame,
+                 const TiffWriterParams &params) {
+#ifndef NDEBUG
+    cout << BOOST_CURRENT_FUNCTION << endl;
+#endif
+    assert(tif != NULL);
 
-    std::vector<uint16_t> stripBuffer(width * 3);
+    const TiffLayout layout = {8 * sizeof(uint16_t), SAMPLEFORMAT_UINT,
+                               PHOTOMETRIC_RGB};
+    writeCommonHeader(tif, frame.getWidth(), frame.getHeight(), layout,
+                      params);
+    writeSRGBProfile(tif);
 
     typedef utils::Chain<colorspace::Normalizer,
                          utils::Chain<utils::Clamp<float>, Remapper<uint16_t>>>
@@ -257,23 +552,8 @@ bool writeUint16(TIFF *tif, const Frame &frame,
         utils::Chain<utils::Clamp<float>, Remapper<uint16_t>>(
             utils::Clamp<float>(0.f, 1.f),
             Remapper<uint16_t>(params.luminanceMapping_)));
-    for (tstrip_t s = 0; s < stripsNum; s++) {
-        utils::transform(
-            rChannel->row_begin(s), rChannel->row_end(s),
-            gChannel->row_begin(s), bChannel->row_begin(s),
-            FixedStrideIterator<uint16_t *, 3>(stripBuffer.data()),
-            FixedStrideIterator<uint16_t *, 3>(stripBuffer.data() + 1),
-            FixedStrideIterator<uint16_t *, 3>(stripBuffer.data() + 2),
-            remapper);
-        if (TIFFWriteEncodedStrip(tif, s, stripBuffer.data(), stripSize) !=
-            stripSize) {
-            throw pfs::io::WriteException("TiffWriter: Error writing strip " +
-                                          boost::lexical_cast<std::string>(s));
-            return false;
-        }
-    }
 
-    return true;
+    return writeStrips<uint16_t>(tif, frame, layout, params, remapper);
 }
 
 // write 32 bit float Tiff from pfs::Frame ... to finish!
@@ -284,56 +564,23 @@ bool writeFloat32(TIFF *tif, const Frame &frame,
 #endif
     assert(tif != NULL);
 
-    uint32_t width = frame.getWidth();
-    uint32_t height = frame.getHeight();
-
-    writeCommonHeader(tif, width, height);
+    const TiffLayout layout = {8 * sizeof(float), SAMPLEFORMAT_IEEEFP,
+                               PHOTOMETRIC_RGB};
+    writeCommonHeader(tif, frame.getWidth(), frame.getHeight(), layout,
+                      params);
     // writeSRGBProfile(tif);
 
-    if (params.deflateCompression_) {
-        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_DEFLATE);
-    }
-    TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
-    TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
-    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE,
-                 (uint16_t)8 * (uint16_t)sizeof(float));
-    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, (uint16_t)3);
-
-    tsize_t stripSize = TIFFStripSize(tif);
-    assert((tsize_t)sizeof(float) * width * 3 == stripSize);
-    tstrip_t stripsNum = TIFFNumberOfStrips(tif);
-
-    const Channel *rChannel;
-    const Channel *gChannel;
-    const Channel *bChannel;
-    frame.getXYZChannels(rChannel, gChannel, bChannel);
-
     PRINT_DEBUG(params.minLuminance_);
     PRINT_DEBUG(params.maxLuminance_);
 
-    std::vector<float> stripBuffer(width * 3);
     typedef utils::Chain<colorspace::Normalizer, utils::Clamp<float>>
         TiffRemapper;
     // Mapping is linear, so I avoid to call the Remapper class
     TiffRemapper remapper(
         colorspace::Normalizer(params.minLuminance_, params.maxLuminance_),
         utils::Clamp<float>(0.f, 1.f));
-    for (tstrip_t s = 0; s < stripsNum; s++) {
-        utils::transform(
-            rChannel->row_begin(s), rChannel->row_end(s),
-            gChannel->row_begin(s), bChannel->row_begin(s),
-            FixedStrideIterator<float *, 3>(stripBuffer.data()),
-            FixedStrideIterator<float *, 3>(stripBuffer.data() + 1),
-            FixedStrideIterator<float *, 3>(stripBuffer.data() + 2), remapper);
-        if (TIFFWriteEncodedStrip(tif, s, stripBuffer.data(), stripSize) == 0) {
-            throw pfs::io::WriteException("TiffWriter: Error writing strip " +
-                                          boost::lexical_cast<std::string>(s));
-
-            return -1;
-        }
-    }
 
-    return true;
+    return writeStrips<float>(tif, frame, layout, params, remapper);
 }
 
 // write LogLUv Tiff from pfs::Frame
@@ -344,30 +591,10 @@ bool writeLogLuv(TIFF *tif, const Frame &frame,
 #endif
     assert(tif != NULL);
 
-    uint32_t width = frame.getWidth();
-    uint32_t height = frame.getHeight();
-
-    writeCommonHeader(tif, width, height);
-
-    TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_SGILOG);
-    TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_LOGLUV);
-    TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
-    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE,
-                 (uint16_t)8 * (uint16_t)sizeof(float));
-    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, (uint16_t)3);
-    TIFFSetField(tif, TIFFTAG_SGILOGDATAFMT, SGILOGDATAFMT_FLOAT);
-    TIFFSetField(tif, TIFFTAG_STONITS, 1.); /* not known */
-
-    tsize_t stripSize = TIFFStripSize(tif);
-    assert((tsize_t)sizeof(float) * width * 3 == stripSize);
-    tstrip_t stripsNum = TIFFNumberOfStrips(tif);
-
-    const Channel *rChannel;
-    const Channel *gChannel;
-    const Channel *bChannel;
-    frame.getXYZChannels(rChannel, gChannel, bChannel);
-
-    std::vector<float> stripBuffer(width * 3);
+    const TiffLayout layout = {8 * sizeof(float), SAMPLEFORMAT_IEEEFP,
+                               PHOTOMETRIC_LOGLUV};
+    writeCommonHeader(tif, frame.getWidth(), frame.getHeight(), layout,
+                      params);
 
     // remap to [0, 1] + transform to colorspace XYZ
     // no gamma curve applied
@@ -381,23 +608,7 @@ bool writeLogLuv(TIFF *tif, const Frame &frame,
         utils::Chain<utils::Clamp<float>, colorspace::ConvertRGB2XYZ>(
             utils::Clamp<float>(0.f, 1.f), colorspace::ConvertRGB2XYZ()));
 
-    for (tstrip_t s = 0; s < stripsNum; s++) {
-        utils::transform(
-            rChannel->row_begin(s), rChannel->row_end(s),
-            gChannel->row_begin(s), bChannel->row_begin(s),
-            FixedStrideIterator<float *, 3>(stripBuffer.data()),
-            FixedStrideIterator<float *, 3>(stripBuffer.data() + 1),
-            FixedStrideIterator<float *, 3>(stripBuffer.data() + 2), remapper);
-        if (TIFFWriteEncodedStrip(tif, s, stripBuffer.data(), stripSize) !=
-            stripSize) {
-            throw pfs::io::WriteException("TiffWriter: Error writing strip " +
-                                          boost::lexical_cast<std::string>(s));
-
-            return false;
-        }
-    }
-
-    return true;
+    return writeStrips<float>(tif, frame, layout, params, remapper);
 }
 
 TiffWriter::TiffWriter(const std::string &filename) : FrameWriter(filename) {}
@@ -55,6 +55,15 @@ class TiffWriter : public FrameWriter {
     //!   max_luminance (float): maximum luminance to consider trusthworthy
     //!   mapping_method (int): RGB mapping methodo choosen between
     //!   RGBMappingType in rgbremapper.h
+    //!   tiff_compression (string): none, deflate, lzw, packbits or zstd
+    //!   (when libtiff has it). Default is deflate, or none when
+    //!   deflateCompression (bool) is false
+    //!   tiff_compression_level (int): deflate (1-9) or zstd (1-22) level,
+    //!   0 for the default of the codec
+    //!   tiff_predictor (string): none (default), horizontal or float (32bit
+    //!   float only), for deflate, lzw and zstd
+    //!   threads (int): number of strips converted and compressed at the
+    //!   same time (0 disables the threads, default is all the cores)
     bool write(const pfs::Frame &frame, const pfs::Params &params);
 };
 
@@ -25,6 +25,7 @@
 #include "copy.h"
 
 #include "Libpfs/frame.h"
+#include "Libpfs/frameview.h"
 #include "Libpfs/utils/msec_timer.h"
 
 #include <algorithm>
@@ -63,4 +64,38 @@ pfs::Frame *copy(const pfs::Frame *inFrame) {
 
     return outFrame;
 }
+
+pfs::Frame *copy(const pfs::FrameView &view) {
+    if (view.isWhole()) {
+        return copy(&view.getFrame());
+    }
+
+#ifdef TIMER_PROFILING
+    msec_timer f_timer;
+    f_timer.start();
+#endif
+
+    pfs::Frame *outFrame = new pfs::Frame(view.getWidth(), view.getHeight());
+
+    const ChannelContainer &channels = view.getFrame().getChannels();
+
+    for (ChannelContainer::const_iterator it = channels.begin();
+         it != channels.end(); ++it) {
+        const pfs::Channel *inCh = *it;
+
+        pfs::Channel *outCh = outFrame->createChannel(inCh->getName());
+
+        copy(view.getChannel(*inCh), outCh);
+    }
+
+    pfs::copyTags(&view.getFrame(), outFrame);
+
+#ifdef TIMER_PROFILING
+    f_timer.stop_and_update();
+    std::cout << "pfscopy(view) = " << f_timer.get_time() << " msec"
+              << std::endl;
+#endif
+
+    return outFrame;
+}
 }
@@ -29,9 +29,19 @@
 
 namespace pfs {
 class Frame;
+class FrameView;
 
+template <typename Type>
+class Array2DView;
+
+//! \brief Build a new \c Frame holding a deep copy of the pixels (and the
+//! tags) of \a inFrame
 pfs::Frame *copy(const pfs::Frame *inFrame);
 
+//! \brief Build a new \c Frame holding a deep copy of the pixels (and the
+//! tags) seen through \a view
+pfs::Frame *copy(const pfs::FrameView &view);
+
 //! \brief Copy data from one Array2D to another.
 //! Dimensions of the arrays must be the same.
 //!
@@ -40,6 +50,11 @@ pfs::Frame *copy(const pfs::Frame *inFrame);
 template <typename Type>
 void copy(const Array2D<Type> *from, Array2D<Type> *to);
 
+//! \brief Copy the region seen through \a from into \a to.
+//! Dimensions of \a to must be the same of the view.
+template <typename Type>
+void copy(const Array2DView<const Type> &from, Array2D<Type> *to);
+
 }  // pfs
 
 #include "copy.hxx"
@@ -30,6 +30,8 @@
 #include <algorithm>
 #include <cassert>
 
+#include "Libpfs/array2dview.h"
+
 namespace pfs {
 
 template <typename Type>
@@ -39,6 +41,23 @@ void copy(const Array2D<Type> *from, Array2D<Type> *to) {
 
     std::copy(from->begin(), from->end(), to->begin());
 }
+
+template <typename Type>
+void copy(const Array2DView<const Type> &from, Array2D<Type> *to) {
+    assert(from.getRows() == to->getRows());
+    assert(from.getCols() == to->getCols());
+
+    if (from.isContiguous()) {
+        std::copy(from.data(), from.data() + from.size(), to->begin());
+        return;
+    }
+
+    const int rows = static_cast<int>(from.getRows());
+#pragma omp parallel for
+    for (int r = 0; r < rows; r++) {
+        std::copy(from.row_begin(r), from.row_end(r), to->row_begin(r));
+    }
+}
 }
 
 #endif  // #ifndef PFS_COPY_HXX
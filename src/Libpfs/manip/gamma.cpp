@@ -31,6 +31,7 @@
 #include <iostream>
 
 #include "Libpfs/array2d.h"
+#include "Libpfs/array2dview.h"
 #include "Libpfs/colorspace/colorspace.h"
 #include "Libpfs/frame.h"
 #include "Libpfs/utils/msec_timer.h"
@@ -53,14 +54,21 @@ void applyGamma(pfs::Frame *frame, float gamma) {
 }
 
 void applyGamma(pfs::Array2Df *array, const float exponent) {
+    applyGamma(pfs::Array2DConstViewf(*array), array, exponent);
+}
+
+void applyGamma(const pfs::Array2DConstViewf &in, pfs::Array2Df *out,
+                const float exponent) {
+    assert(in.getCols() == out->getCols());
+    assert(in.getRows() == out->getRows());
 
 #ifdef TIMER_PROFILING
     msec_timer f_timer;
     f_timer.start();
 #endif
 
-    const int h = array->getRows();
-    const int w = array->getCols();
+    const int h = in.getRows();
+    const int w = in.getCols();
     #pragma omp parallel
     {
 #ifdef __SSE2__
@@ -68,18 +76,20 @@ void applyGamma(pfs::Array2Df *array, const float exponent) {
 #endif
         #pragma omp for
         for (int i = 0; i < h; ++i) {
+            const float *src = in.row_begin(i);
+            float *dst = out->row_begin(i);
             int j = 0;
 #ifdef __SSE2__
             for (; j < w - 3; j += 4) {
-                const vfloat Vinv = LVFU((*array)(j, i));
-                STVFU((*array)(j, i), vselfzero(vmaskf_gt(Vinv, ZEROV), pow_F(Vinv, exponentv)));
+                const vfloat Vinv = LVFU(src[j]);
+                STVFU(dst[j], vselfzero(vmaskf_gt(Vinv, ZEROV), pow_F(Vinv, exponentv)));
             }
 #endif
             for (; j < w; ++j) {
-                if ((*array)(j, i) > 0.0f) {
-                    (*array)(j, i) = pow_F((*array)(j, i), exponent);
+                if (src[j] > 0.0f) {
+                    dst[j] = pow_F(src[j], exponent);
                 } else {
-                    (*array)(j, i) = 0.0f;
+                    dst[j] = 0.0f;
                 }
             }
         }
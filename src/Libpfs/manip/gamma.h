@@ -37,6 +37,12 @@ void applyGamma(pfs::Frame *frame, float gamma);
 
 //! \brief Apply gamma on the input \c array
 void applyGamma(pfs::Array2Df *array, float exponent);
+
+//! \brief Write in \c out the pixels seen through \c in raised to
+//! \c exponent. \c out must have the size of the view; \c in and \c out can
+//! share the same storage only if they match element by element
+void applyGamma(const pfs::Array2DConstViewf &in, pfs::Array2Df *out,
+                float exponent);
 }
 
 #endif  // PFSGAMMA_H
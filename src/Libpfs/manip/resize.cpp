@@ -35,29 +35,34 @@
 #include "Libpfs/utils/msec_timer.h"
 
 #include "Libpfs/frame.h"
+#include "Libpfs/frameview.h"
 
 namespace pfs {
 
 Frame *resize(Frame *frame, int xSize, InterpolationMethod m) {
+    return resize(FrameView(*frame), xSize, m);
+}
+
+Frame *resize(const FrameView &view, int xSize, InterpolationMethod m) {
 #ifdef TIMER_PROFILING
     msec_timer f_timer;
     f_timer.start();
 #endif
 
     int new_x = xSize;
-    int new_y = (int)((float)frame->getHeight() * (float)xSize /
-                      (float)frame->getWidth());
+    int new_y = (int)((float)view.getHeight() * (float)xSize /
+                      (float)view.getWidth());
 
     pfs::Frame *resizedFrame = new pfs::Frame(new_x, new_y);
 
-    const ChannelContainer &channels = frame->getChannels();
+    const ChannelContainer &channels = view.getFrame().getChannels();
     for (ChannelContainer::const_iterator it = channels.begin();
          it != channels.end(); ++it) {
         pfs::Channel *newCh = resizedFrame->createChannel((*it)->getName());
 
-        resize(*it, newCh, m);
+        resize(view.getChannel(**it), newCh, m);
     }
-    pfs::copyTags(frame, resizedFrame);
+    pfs::copyTags(&view.getFrame(), resizedFrame);
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
@@ -68,4 +73,22 @@ Frame *resize(Frame *frame, int xSize, InterpolationMethod m) {
     return resizedFrame;
 }
 
+Frame *decimate(const Frame &frame, size_t factor) {
+    assert(factor > 0);
+    pfs::Frame *decimatedFrame =
+        new pfs::Frame(std::max<size_t>(1, frame.getWidth() / factor),
+                       std::max<size_t>(1, frame.getHeight() / factor));
+
+    const ChannelContainer &channels = frame.getChannels();
+    for (ChannelContainer::const_iterator it = channels.begin();
+         it != channels.end(); ++it) {
+        pfs::Channel *newCh = decimatedFrame->createChannel((*it)->getName());
+
+        decimate(Array2DView<const float>(**it), newCh, factor);
+    }
+    pfs::copyTags(&frame, decimatedFrame);
+
+    return decimatedFrame;
+}
+
 }  // pfs
@@ -34,13 +34,37 @@
 namespace pfs {
 // forward declaration
 class Frame;
+class FrameView;
+
+template <typename Type>
+class Array2DView;
 
 Frame *resize(Frame *frame, int xSize, InterpolationMethod m);
 
+//! \brief resample the region seen through \a view to a new frame
+//! \a xSize pixels wide (aspect ratio is preserved). The pixels are read
+//! straight from the parent frame: no intermediate crop is built
+Frame *resize(const FrameView &view, int xSize, InterpolationMethod m);
+
+//! \brief shrink \a frame by an integer \a factor, averaging each block of
+//! \a factor x \a factor pixels (trailing rows and columns that do not fill
+//! a block are dropped). Much cheaper than \c resize() for previews.
+Frame *decimate(const Frame &frame, size_t factor);
+
 template <typename Type>
 void resize(const Array2D<Type> *from, Array2D<Type> *to,
             InterpolationMethod m);
 
+//! \brief box average \a from into \a to, which is resized to
+//! max(1, cols / factor) x max(1, rows / factor)
+template <typename Type>
+void decimate(const Array2DView<const Type> &from, Array2D<Type> *to,
+              size_t factor);
+
+template <typename Type>
+void resize(const Array2DView<const Type> &from, Array2D<Type> *to,
+            InterpolationMethod m);
+
 template <typename Type>
 void resize(const Array2D<Type> &from, Array2D<Type> &to,
             InterpolationMethod m) {
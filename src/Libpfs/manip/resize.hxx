@@ -22,7 +22,11 @@
 #ifndef PFS_RESIZE_HXX
 #define PFS_RESIZE_HXX
 
+#include <algorithm>
+#include <vector>
+
 #include <boost/math/constants/constants.hpp>
+#include "Libpfs/array2dview.h"
 #include "copy.h"
 #include "resize.h"
 #include "../../sleef.c"
@@ -45,10 +49,10 @@ static inline float Lanc(float x, float a) {
     }
 }
 
+//! \param srcStride distance (in elements) between two rows of \a src
 template <typename Type>
-void Lanczos(const Type *src, Type *dst, int W, int H, int W2, int H2)
-
-{
+void Lanczos(const Type *src, size_t srcStride, Type *dst, int W, int H,
+             int W2, int H2) {
     const float scale = static_cast<float>(W2) / static_cast<float>(W);
     const float delta = 1.0f / scale;
     const float a = 3.0f;
@@ -124,16 +128,17 @@ void Lanczos(const Type *src, Type *dst, int W, int H, int W2, int H2)
             }
 
             // Do vertical interpolation. Store results.
-            for (int j = 0; j < W; j++) {
-                float o = 0.0f;
-
-                for (int ii = ii0; ii < ii1; ii++) {
-                    int k = ii - ii0;
+            // Accumulate one source row at a time, so the inner loop walks
+            // contiguous memory instead of striding down each column: the
+            // order of the sums (and so the result) does not change
+            std::fill(l, l + W, 0.0f);
+            for (int ii = ii0; ii < ii1; ii++) {
+                const float wk = w[ii - ii0];
+                const Type *srcRow = src + ii * srcStride;
 
-                    o += w[k] * static_cast<float>(src[ii * W + j]);
+                for (int j = 0; j < W; j++) {
+                    l[j] += wk * static_cast<float>(srcRow[j]);
                 }
-
-                l[j] = o;
             }
 
             // Do horizontal interpolation
@@ -168,9 +173,10 @@ const size_t BLOCK_FACTOR = 96;
 //! \note Code derived from
 //! http://tech-algorithm.com/articles/bilinear-image-scaling/
 //! with added OpenMP support and block based resampling
+//! \param stride distance (in elements) between two rows of \a pixels
 template <typename Type>
-void resizeBilinearGray(const Type *pixels, Type *output, size_t w, size_t h,
-                        size_t w2, size_t h2) {
+void resizeBilinearGray(const Type *pixels, size_t stride, Type *output,
+                        size_t w, size_t h, size_t w2, size_t h2) {
     const float x_ratio = static_cast<float>(w - 1) / w2;
     const float y_ratio = static_cast<float>(h - 1) / h2;
 
@@ -183,7 +189,7 @@ void resizeBilinearGray(const Type *pixels, Type *output, size_t w, size_t h,
     float x_diff = 0.0f;
     float y_diff = 0.0f;
 
-#pragma omp parallel shared(pixels, output, w, h, w2, h2) private( \
+#pragma omp parallel shared(pixels, output, stride, w, h, w2, h2) private( \
     x_diff, y_diff, x, y, index, outputPixel, A, B, C, D)
     {
 #pragma omp for schedule(static, 1)
@@ -199,12 +205,12 @@ void resizeBilinearGray(const Type *pixels, Type *output, size_t w, size_t h,
                         x = static_cast<size_t>(x_ratio * j);
                         x_diff = (x_ratio * j) - x;
 
-                        index = y * w + x;
+                        index = y * stride + x;
 
                         A = pixels[index];
                         B = pixels[index + 1];
-                        C = pixels[index + w];
-                        D = pixels[index + w + 1];
+                        C = pixels[index + stride];
+                        D = pixels[index + stride + 1];
 
                         // Y = A(1-w)(1-h) + B(w)(1-h) + C(h)(1-w) + D(w)(h)
                         outputPixel =
@@ -222,16 +228,17 @@ void resizeBilinearGray(const Type *pixels, Type *output, size_t w, size_t h,
 }
 
 template <typename Type>
-void resample(const ::pfs::Array2D<Type> *in, ::pfs::Array2D<Type> *out,
-              InterpolationMethod m) {
+void resample(const ::pfs::Array2DView<const Type> &in,
+              ::pfs::Array2D<Type> *out, InterpolationMethod m) {
     switch (m) {
         case LanczosInterp:
-            Lanczos(in->data(), out->data(), in->getCols(), in->getRows(),
-                    out->getCols(), out->getRows());
+            Lanczos(in.data(), in.getStride(), out->data(), in.getCols(),
+                    in.getRows(), out->getCols(), out->getRows());
             break;
         case BilinearInterp:
-            resizeBilinearGray(in->data(), out->data(), in->getCols(),
-                               in->getRows(), out->getCols(), out->getRows());
+            resizeBilinearGray(in.data(), in.getStride(), out->data(),
+                               in.getCols(), in.getRows(), out->getCols(),
+                               out->getRows());
             break;
     }
 }
@@ -239,15 +246,65 @@ void resample(const ::pfs::Array2D<Type> *in, ::pfs::Array2D<Type> *out,
 }  // anonymous
 
 template <typename Type>
-void resize(const Array2D<Type> *in, Array2D<Type> *out,
+void decimate(const Array2DView<const Type> &in, Array2D<Type> *out,
+              size_t factor) {
+    const size_t cols = in.getCols();
+    const size_t rows = in.getRows();
+    const size_t outCols = std::max<size_t>(1, cols / factor);
+    const size_t outRows = std::max<size_t>(1, rows / factor);
+    out->resize(outCols, outRows);
+
+    // blocks on the last row and column are clipped when the image is
+    // narrower (or shorter) than a single block
+    const size_t blockCols = std::min(factor, cols);
+
+#pragma omp parallel
+    {
+        std::vector<float> acc(outCols);
+#pragma omp for
+        for (int j = 0; j < static_cast<int>(outRows); ++j) {
+            const size_t r0 = j * factor;
+            const size_t r1 = std::min(r0 + factor, rows);
+            std::fill(acc.begin(), acc.end(), 0.0f);
+
+            // walk each source row once, left to right
+            for (size_t r = r0; r < r1; ++r) {
+                const Type *srcRow = in.data() + r * in.getStride();
+                for (size_t i = 0; i < outCols; ++i) {
+                    const Type *block = srcRow + i * factor;
+                    float sum = 0.0f;
+                    for (size_t k = 0; k < blockCols; ++k) {
+                        sum += static_cast<float>(block[k]);
+                    }
+                    acc[i] += sum;
+                }
+            }
+
+            const float norm = 1.0f / static_cast<float>((r1 - r0) * blockCols);
+            Type *dstRow = out->data() + j * outCols;
+            for (size_t i = 0; i < outCols; ++i) {
+                dstRow[i] = static_cast<Type>(acc[i] * norm);
+            }
+        }
+    }
+}
+
+template <typename Type>
+void resize(const Array2DView<const Type> &in, Array2D<Type> *out,
             InterpolationMethod m) {
-    if (in->getCols() == out->getCols() && in->getRows() == out->getRows()) {
+    if (in.getCols() == out->getCols() && in.getRows() == out->getRows()) {
         pfs::copy(in, out);
     } else {
         detail::resample(in, out, m);
     }
 }
 
+template <typename Type>
+void resize(const Array2D<Type> *in, Array2D<Type> *out,
+            InterpolationMethod m) {
+    resize(Array2DView<const Type>(*in), out, m);
+}
+
 }  // pfs
 
 #endif  // PFS_RESIZE_HXX
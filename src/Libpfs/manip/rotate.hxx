@@ -22,6 +22,8 @@
 #ifndef PFS_ROTATE_HXX
 #define PFS_ROTATE_HXX
 
+#include <algorithm>
+
 #include "rotate.h"
 
 namespace pfs {
@@ -38,18 +40,36 @@ void rotate(const pfs::Array2D<Type> *in, pfs::Array2D<Type> *out,
     // const int O_ROWS = out->getRows();
     const int O_COLS = out->getCols();
 
+    // walk the image in square blocks, so that both the rows read from \a in
+    // and the columns written to \a out stay in cache
+    const int BLOCK = 64;
+    const int BLOCKS_Y = (I_ROWS + BLOCK - 1) / BLOCK;
+
     if (clockwise) {
 #pragma omp parallel for
-        for (int j = 0; j < I_ROWS; j++) {
-            for (int i = 0; i < I_COLS; i++) {
-                Vout[(i + 1) * O_COLS - 1 - j] = Vin[j * I_COLS + i];
+        for (int bj = 0; bj < BLOCKS_Y; bj++) {
+            const int jEnd = std::min(I_ROWS, (bj + 1) * BLOCK);
+            for (int bi = 0; bi < I_COLS; bi += BLOCK) {
+                const int iEnd = std::min(I_COLS, bi + BLOCK);
+                for (int j = bj * BLOCK; j < jEnd; j++) {
+                    for (int i = bi; i < iEnd; i++) {
+                        Vout[(i + 1) * O_COLS - 1 - j] = Vin[j * I_COLS + i];
+                    }
+                }
             }
         }
     } else {
 #pragma omp parallel for
-        for (int j = 0; j < I_ROWS; j++) {
-            for (int i = 0; i < I_COLS; i++) {
-                Vout[(I_COLS - i - 1) * O_COLS + j] = Vin[j * I_COLS + i];
+        for (int bj = 0; bj < BLOCKS_Y; bj++) {
+            const int jEnd = std::min(I_ROWS, (bj + 1) * BLOCK);
+            for (int bi = 0; bi < I_COLS; bi += BLOCK) {
+                const int iEnd = std::min(I_COLS, bi + BLOCK);
+                for (int j = bj * BLOCK; j < jEnd; j++) {
+                    for (int i = bi; i < iEnd; i++) {
+                        Vout[(I_COLS - i - 1) * O_COLS + j] =
+                            Vin[j * I_COLS + i];
+                    }
+                }
             }
         }
     }
@@ -0,0 +1,159 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Contiguous buffer of trivially copyable elements, aligned to
+//! \c BUFFER_ALIGNMENT and drawn from \c BufferPool
+
+#ifndef PFS_UTILS_ALIGNEDBUFFER_H
+#define PFS_UTILS_ALIGNEDBUFFER_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <string>
+
+#include <Libpfs/utils/bufferpool.h>
+
+namespace pfs {
+namespace utils {
+
+//! \brief Minimal replacement of std::vector for pixel storage: the memory is
+//! 64-byte aligned, recycled through \c BufferPool and, on request, left
+//! uninitialized or mapped on a file (see \c mapFile()). \a T must be
+//! trivially copyable.
+template <typename T>
+class AlignedBuffer {
+   public:
+    typedef T value_type;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+
+    AlignedBuffer() : m_data(NULL), m_size(0), m_capacity(0), m_bytes(0) {}
+
+    //! \brief buffer of \a size elements, value-initialized when
+    //! \a initialize is true
+    explicit AlignedBuffer(size_t size, bool initialize = true)
+        : m_data(NULL), m_size(0), m_capacity(0), m_bytes(0) {
+        allocate(size);
+        // scratch files come zero filled: do not touch all their pages
+        if (initialize && !(m_bytes >= BufferPool::MIN_POOLED_SIZE &&
+                            BufferPool::instance().isMapped(m_data))) {
+            std::fill(m_data, m_data + m_size, T());
+        }
+    }
+
+    AlignedBuffer(const AlignedBuffer &rhs)
+        : m_data(NULL), m_size(0), m_capacity(0), m_bytes(0) {
+        allocate(rhs.m_size);
+        std::copy(rhs.m_data, rhs.m_data + rhs.m_size, m_data);
+    }
+
+    AlignedBuffer &operator=(const AlignedBuffer &rhs) {
+        AlignedBuffer tmp(rhs);
+        swap(tmp);
+        return *this;
+    }
+
+    ~AlignedBuffer() { BufferPool::instance().release(m_data, m_bytes); }
+
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+
+    T *data() { return m_data; }
+    const T *data() const { return m_data; }
+
+    iterator begin() { return m_data; }
+    iterator end() { return m_data + m_size; }
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+
+    T &operator[](size_t idx) {
+        assert(idx < m_size);
+        return m_data[idx];
+    }
+    const T &operator[](size_t idx) const {
+        assert(idx < m_size);
+        return m_data[idx];
+    }
+
+    //! \brief same semantic of std::vector::resize(): the first elements are
+    //! preserved, new elements are value-initialized. Shrinking never
+    //! reallocates.
+    void resize(size_t size) {
+        if (size > m_capacity) {
+            AlignedBuffer tmp;
+            tmp.allocate(size);
+            std::copy(m_data, m_data + m_size, tmp.m_data);
+            std::fill(tmp.m_data + m_size, tmp.m_data + size, T());
+            swap(tmp);
+        } else if (size > m_size) {
+            std::fill(m_data + m_size, m_data + size, T());
+        }
+        m_size = size;
+    }
+
+    //! \brief replace the content with \a size elements mapped copy-on-write
+    //! from \a filename at byte \a offset (see \c BufferPool::mapFile()).
+    //! \return false, leaving the buffer untouched, if the file cannot be
+    //! mapped
+    bool mapFile(const std::string &filename, size_t offset, size_t size) {
+        const size_t bytes = size * sizeof(T);
+        void *p = BufferPool::instance().mapFile(filename, offset, bytes);
+        if (p == NULL) return false;
+
+        AlignedBuffer tmp;
+        tmp.m_data = static_cast<T *>(p);
+        tmp.m_size = size;
+        tmp.m_capacity = size;
+        tmp.m_bytes = bytes;
+        swap(tmp);
+        return true;
+    }
+
+    void swap(AlignedBuffer &other) {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_bytes, other.m_bytes);
+    }
+
+   private:
+    // call only on an empty buffer
+    void allocate(size_t size) {
+        assert(m_data == NULL);
+        if (size == 0) return;
+
+        m_bytes = BufferPool::sizeClass(size * sizeof(T));
+        m_data = static_cast<T *>(BufferPool::instance().allocate(m_bytes));
+        m_size = size;
+        m_capacity = m_bytes / sizeof(T);
+    }
+
+    T *m_data;
+    size_t m_size;
+    size_t m_capacity;
+    size_t m_bytes;
+};
+
+}  // utils
+}  // pfs
+
+#endif  // PFS_UTILS_ALIGNEDBUFFER_H
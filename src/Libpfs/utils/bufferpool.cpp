@@ -0,0 +1,373 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Size-class pool of aligned memory blocks backing pfs::Array2D
+
+#include <Libpfs/utils/bufferpool.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pfs {
+namespace utils {
+
+void *alignedMalloc(size_t bytes) {
+    if (bytes == 0) bytes = BUFFER_ALIGNMENT;
+
+    void *p = NULL;
+#ifdef _WIN32
+    p = _aligned_malloc(bytes, BUFFER_ALIGNMENT);
+#else
+    if (posix_memalign(&p, BUFFER_ALIGNMENT, bytes) != 0) p = NULL;
+#endif
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void alignedFree(void *p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+const size_t BufferPool::MIN_POOLED_SIZE;
+const size_t BufferPool::DEFAULT_MAX_CACHED_BYTES;
+
+BufferPool &BufferPool::instance() {
+    // never destroyed: Array2D instances with static storage duration may
+    // release their memory after the end of main()
+    static BufferPool *pool = new BufferPool();
+    return *pool;
+}
+
+size_t BufferPool::sizeClass(size_t bytes) {
+    if (bytes < MIN_POOLED_SIZE) {
+        return bytes;
+    }
+    size_t p = MIN_POOLED_SIZE;
+    while ((p << 1) <= bytes && (p << 1) > p) {
+        p <<= 1;
+    }
+    const size_t step = p / 8;
+    return ((bytes + step - 1) / step) * step;
+}
+
+BufferPool::BufferPool()
+    : m_cachedBytes(0),
+      m_maxCachedBytes(DEFAULT_MAX_CACHED_BYTES),
+      m_mappedBytes(0),
+      m_mapThreshold(0) {}
+
+BufferPool::~BufferPool() { clear(); }
+
+void *BufferPool::allocate(size_t bytes) {
+    size_t threshold;
+    std::string scratchDir;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        threshold = m_mapThreshold;
+        scratchDir = m_scratchDir;
+    }
+    if (threshold != 0 && bytes >= threshold) {
+        // map outside of the lock: creating the file can take a while
+        void *p = mapScratch(bytes, scratchDir);
+        if (p != NULL) {
+            boost::mutex::scoped_lock lock(m_mutex);
+            const MappedBlock block = {p, bytes, true};
+            m_mapped[p] = block;
+            m_mappedBytes += bytes;
+            return p;
+        }
+        // no room on disk: try with RAM
+    }
+
+    const size_t size = sizeClass(bytes);
+    if (size >= MIN_POOLED_SIZE) {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        FreeLists::iterator it = m_freeLists.find(size);
+        if (it != m_freeLists.end() && !it->second.empty()) {
+            void *p = it->second.back();
+            it->second.pop_back();
+            m_cachedBytes -= size;
+            return p;
+        }
+    }
+    try {
+        return alignedMalloc(size);
+    } catch (std::bad_alloc &) {
+        // low on memory: hand the cached blocks back and try again
+        clear();
+        return alignedMalloc(size);
+    }
+}
+
+void BufferPool::release(void *p, size_t bytes) {
+    if (p == NULL) return;
+
+    const size_t size = sizeClass(bytes);
+    if (size >= MIN_POOLED_SIZE) {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        MappedBlocks::iterator it = m_mapped.find(p);
+        if (it != m_mapped.end()) {
+            const MappedBlock block = it->second;
+            if (block.scratch) {
+                m_mappedBytes -= block.length;
+            }
+            m_mapped.erase(it);
+            lock.unlock();
+
+            unmap(block.base, block.length);
+            return;
+        }
+
+        if (m_cachedBytes + size <= m_maxCachedBytes) {
+            m_freeLists[size].push_back(p);
+            m_cachedBytes += size;
+            return;
+        }
+    }
+    alignedFree(p);
+}
+
+void BufferPool::clear() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    trim(0);
+}
+
+size_t BufferPool::cachedBytes() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_cachedBytes;
+}
+
+size_t BufferPool::maxCachedBytes() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_maxCachedBytes;
+}
+
+void BufferPool::setMaxCachedBytes(size_t bytes) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_maxCachedBytes = bytes;
+    trim(bytes);
+}
+
+size_t BufferPool::mapThreshold() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_mapThreshold;
+}
+
+void BufferPool::setMapThreshold(size_t bytes, const std::string &scratchDir) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    // smaller blocks are released without looking at m_mapped
+    m_mapThreshold = (bytes == 0) ? 0 : std::max(bytes, MIN_POOLED_SIZE);
+    m_scratchDir = scratchDir;
+}
+
+bool BufferPool::isMapped(const void *p) const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_mapped.count(p) != 0;
+}
+
+bool BufferPool::isFileMapped(const void *p) const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    MappedBlocks::const_iterator it = m_mapped.find(p);
+    return it != m_mapped.end() && !it->second.scratch;
+}
+
+size_t BufferPool::mappedBytes() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_mappedBytes;
+}
+
+void *BufferPool::mapFile(const std::string &filename, size_t offset,
+                          size_t bytes) {
+    // smaller blocks are released without looking at m_mapped
+    if (bytes < MIN_POOLED_SIZE || offset % BUFFER_ALIGNMENT != 0) {
+        return NULL;
+    }
+
+    const size_t start = offset - offset % mapGranularity();
+    const size_t length = bytes + (offset - start);
+    char *base = static_cast<char *>(mapFileRange(filename, start, length));
+    if (base == NULL) {
+        return NULL;
+    }
+
+    void *p = base + (offset - start);
+    boost::mutex::scoped_lock lock(m_mutex);
+    const MappedBlock block = {base, length, false};
+    m_mapped[p] = block;
+    return p;
+}
+
+void *BufferPool::mapScratch(size_t bytes, const std::string &scratchDir) {
+#ifdef _WIN32
+    char path[MAX_PATH];
+    if (GetTempFileNameA(scratchDir.c_str(), "lhd", 0, path) == 0) {
+        return NULL;
+    }
+    // the file goes away with the last handle, the one held by the view
+    HANDLE file = CreateFileA(
+        path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    const unsigned long long size = bytes;
+    HANDLE mapping = CreateFileMappingA(
+        file, NULL, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+        static_cast<DWORD>(size & 0xffffffff), NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return NULL;
+    }
+    void *p = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    CloseHandle(mapping);
+    return p;
+#else
+    std::string name = scratchDir + "/luminance-XXXXXX";
+    std::vector<char> path(name.begin(), name.end());
+    path.push_back('\0');
+
+    const int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+        return NULL;
+    }
+    // the file lives as long as the mapping
+    unlink(&path[0]);
+
+    void *p = NULL;
+#ifdef __linux__
+    // reserve the blocks now: running out of disk later would be a SIGBUS
+    const bool sized = (posix_fallocate(fd, 0, bytes) == 0);
+#else
+    const bool sized = (ftruncate(fd, bytes) == 0);
+#endif
+    if (sized) {
+        p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            p = NULL;
+        }
+    }
+    close(fd);
+    return p;
+#endif
+}
+
+void *BufferPool::mapFileRange(const std::string &filename, size_t offset,
+                               size_t length) {
+    const unsigned long long end =
+        static_cast<unsigned long long>(offset) + length;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) ||
+        static_cast<unsigned long long>(fileSize.QuadPart) < end) {
+        CloseHandle(file);
+        return NULL;
+    }
+    // the view keeps the file open
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return NULL;
+    }
+    const unsigned long long start = offset;
+    void *p = MapViewOfFile(mapping, FILE_MAP_COPY,
+                            static_cast<DWORD>(start >> 32),
+                            static_cast<DWORD>(start & 0xffffffff), length);
+    CloseHandle(mapping);
+    return p;
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    void *p = NULL;
+    struct stat st;
+    // touching a page past the end of the file would be a SIGBUS
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        static_cast<unsigned long long>(st.st_size) >= end) {
+        p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                 static_cast<off_t>(offset));
+        if (p == MAP_FAILED) {
+            p = NULL;
+        }
+    }
+    close(fd);
+    return p;
+#endif
+}
+
+void BufferPool::unmap(void *base, size_t length) {
+#ifdef _WIN32
+    (void)length;
+    UnmapViewOfFile(base);
+#else
+    munmap(base, length);
+#endif
+}
+
+size_t BufferPool::mapGranularity() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+void BufferPool::trim(size_t maxBytes) {
+    // drop the largest blocks first
+    FreeLists::reverse_iterator it = m_freeLists.rbegin();
+    while (m_cachedBytes > maxBytes && it != m_freeLists.rend()) {
+        std::vector<void *> &blocks = it->second;
+        while (m_cachedBytes > maxBytes && !blocks.empty()) {
+            alignedFree(blocks.back());
+            blocks.pop_back();
+            m_cachedBytes -= it->first;
+        }
+        ++it;
+    }
+}
+
+}  // utils
+}  // pfs
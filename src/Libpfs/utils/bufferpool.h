@@ -0,0 +1,160 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Size-class pool of aligned memory blocks backing pfs::Array2D
+
+#ifndef PFS_UTILS_BUFFERPOOL_H
+#define PFS_UTILS_BUFFERPOOL_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+namespace pfs {
+namespace utils {
+
+//! \brief alignment (in bytes) of every block returned by \c BufferPool
+static const size_t BUFFER_ALIGNMENT = 64;
+
+//! \brief allocate \a bytes of memory aligned to \c BUFFER_ALIGNMENT
+//! \throw std::bad_alloc
+void *alignedMalloc(size_t bytes);
+
+//! \brief release memory obtained by \c alignedMalloc
+void alignedFree(void *p);
+
+//! \brief Process-wide cache of large aligned blocks.
+//! Requests are rounded up to a size class (eight classes per power of two)
+//! and released blocks are kept in a free list per class, so that a new
+//! buffer of an already seen size reuses memory that is already mapped
+//! instead of page-faulting in fresh zeroed pages. Small requests bypass the
+//! pool.
+//! Requests above the map threshold (disabled by default) are served by
+//! memory-mapped scratch files instead: the pixels of huge images are then
+//! backed by disk and paged in and out by the OS, so that they do not need
+//! to fit in RAM. Mapped blocks are never cached.
+//! Existing files can be mapped as well (see \c mapFile()), so that the
+//! pixels of an uncompressed image are read on demand instead of copied.
+//! All the methods are thread-safe.
+class BufferPool {
+   public:
+    //! \brief requests smaller than this go straight to \c alignedMalloc
+    static const size_t MIN_POOLED_SIZE = 64 * 1024;
+    //! \brief default upper bound of the memory kept in the free lists
+    static const size_t DEFAULT_MAX_CACHED_BYTES = 512 * 1024 * 1024;
+
+    static BufferPool &instance();
+
+    //! \brief size class used for a request of \a bytes
+    static size_t sizeClass(size_t bytes);
+
+    //! \brief return a block of at least \a bytes bytes (uninitialized).
+    //! If the system is out of memory, the cache is freed before giving up.
+    //! \throw std::bad_alloc
+    void *allocate(size_t bytes);
+    //! \brief give back a block obtained with \c allocate(bytes)
+    void release(void *p, size_t bytes);
+
+    //! \brief free every cached block
+    void clear();
+
+    size_t cachedBytes() const;
+
+    size_t maxCachedBytes() const;
+    //! \brief set the upper bound of the cached memory, trimming the free
+    //! lists if needed
+    void setMaxCachedBytes(size_t bytes);
+
+    size_t mapThreshold() const;
+    //! \brief back the requests of at least \a bytes bytes with scratch
+    //! files created in \a scratchDir. 0 disables the mapping.
+    void setMapThreshold(size_t bytes, const std::string &scratchDir);
+
+    //! \return true if \a p was mapped on a scratch file (a freshly mapped
+    //! block is zero filled) or on an existing file
+    bool isMapped(const void *p) const;
+    //! \return true if \a p was mapped on an existing file by \c mapFile()
+    bool isFileMapped(const void *p) const;
+
+    //! \brief map \a bytes of \a filename, starting at byte \a offset.
+    //! The mapping is private and copy-on-write: pages are read from the file
+    //! when first touched, and the first write to a page gives it a private
+    //! copy, so the file itself is never modified.
+    //! Release the block with \c release(p, bytes).
+    //! \note the file must not be truncated while the block is in use
+    //! \return NULL if the file cannot be mapped or is too short, if \a bytes
+    //! is smaller than \c MIN_POOLED_SIZE or if the block would not be
+    //! aligned to \c BUFFER_ALIGNMENT
+    void *mapFile(const std::string &filename, size_t offset, size_t bytes);
+
+    //! \return amount of memory currently mapped on scratch files
+    size_t mappedBytes() const;
+
+   private:
+    BufferPool();
+    ~BufferPool();
+
+    BufferPool(const BufferPool &);
+    BufferPool &operator=(const BufferPool &);
+
+    // call with m_mutex locked
+    void trim(size_t maxBytes);
+
+    //! \brief map \a bytes of a new scratch file
+    //! \return NULL on failure
+    static void *mapScratch(size_t bytes, const std::string &scratchDir);
+    //! \brief map \a length bytes of \a filename from \a offset, which
+    //! must be a multiple of \c mapGranularity()
+    //! \return NULL on failure
+    static void *mapFileRange(const std::string &filename, size_t offset,
+                              size_t length);
+    static void unmap(void *base, size_t length);
+    //! \brief alignment of the file offset of a mapping
+    static size_t mapGranularity();
+
+    //! \brief a mapped block starts \a p - \a base bytes into its mapping
+    struct MappedBlock {
+        void *base;
+        size_t length;
+        bool scratch;
+    };
+
+    typedef std::map<size_t, std::vector<void *> > FreeLists;
+    typedef std::map<const void *, MappedBlock> MappedBlocks;
+
+    mutable boost::mutex m_mutex;
+    FreeLists m_freeLists;
+    size_t m_cachedBytes;
+    size_t m_maxCachedBytes;
+
+    MappedBlocks m_mapped;
+    size_t m_mappedBytes;
+    size_t m_mapThreshold;
+    std::string m_scratchDir;
+};
+
+}  // utils
+}  // pfs
+
+#endif  // PFS_UTILS_BUFFERPOOL_H
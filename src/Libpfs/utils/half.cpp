@@ -0,0 +1,195 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Conversion between 32-bit floats and IEEE 754 half floats
+
+#include <Libpfs/utils/half.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define LUMINANCE_HALF_F16C
+#include <immintrin.h>
+#endif
+
+namespace pfs {
+namespace utils {
+
+half_t floatToHalf(float value) {
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+
+    const half_t sign = static_cast<half_t>((x >> 16) & 0x8000);
+    x &= 0x7fffffff;
+
+    // Inf and NaN (keep NaN quiet)
+    if (x >= 0x7f800000) {
+        return sign | 0x7c00 | (x > 0x7f800000 ? 0x0200 : 0);
+    }
+    // larger than 65504 after rounding: overflow
+    if (x >= 0x477ff000) {
+        return sign | 0x7c00;
+    }
+    // smaller than the smallest normal half: denormal or zero
+    if (x < 0x38800000) {
+        if (x < 0x33000000) {
+            return sign;
+        }
+        const uint32_t shift = 126 - (x >> 23);
+        const uint32_t m = (x & 0x007fffff) | 0x00800000;
+        const uint32_t rem = m & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        uint32_t h = m >> shift;
+        if (rem > halfway || (rem == halfway && (h & 1))) {
+            ++h;
+        }
+        return sign | static_cast<half_t>(h);
+    }
+
+    // normal: rebias the exponent, round the mantissa to 10 bits. A carry
+    // out of the mantissa correctly bumps the exponent.
+    uint32_t h = (x >> 13) - ((127 - 15) << 10);
+    const uint32_t rem = x & 0x1fff;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) {
+        ++h;
+    }
+    return sign | static_cast<half_t>(h);
+}
+
+float halfToFloat(half_t value) {
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t e = (value >> 10) & 0x1f;
+    uint32_t m = value & 0x03ff;
+
+    uint32_t x;
+    if (e == 0) {
+        if (m == 0) {
+            x = sign;
+        } else {
+            // denormal: normalize the mantissa
+            e = 127 - 14;
+            while (!(m & 0x0400)) {
+                m <<= 1;
+                --e;
+            }
+            x = sign | (e << 23) | ((m & 0x03ff) << 13);
+        }
+    } else if (e == 0x1f) {
+        x = sign | 0x7f800000 | (m << 13);
+    } else {
+        x = sign | ((e + 127 - 15) << 23) | (m << 13);
+    }
+
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+namespace {
+
+#ifdef LUMINANCE_HALF_F16C
+__attribute__((target("avx,f16c"))) void floatToHalfF16C(const float *in,
+                                                         half_t *out,
+                                                         size_t size) {
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+        const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + idx),
+                                          _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + idx), h);
+    }
+    for (; idx < size; ++idx) {
+        out[idx] = floatToHalf(in[idx]);
+    }
+}
+
+__attribute__((target("avx,f16c"))) void halfToFloatF16C(const half_t *in,
+                                                         float *out,
+                                                         size_t size) {
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+        const __m128i h =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + idx));
+        _mm256_storeu_ps(out + idx, _mm256_cvtph_ps(h));
+    }
+    for (; idx < size; ++idx) {
+        out[idx] = halfToFloat(in[idx]);
+    }
+}
+#endif
+
+void floatToHalfScalar(const float *in, half_t *out, size_t size) {
+    for (size_t idx = 0; idx < size; ++idx) {
+        out[idx] = floatToHalf(in[idx]);
+    }
+}
+
+void halfToFloatScalar(const half_t *in, float *out, size_t size) {
+    for (size_t idx = 0; idx < size; ++idx) {
+        out[idx] = halfToFloat(in[idx]);
+    }
+}
+
+// elements converted by each task of the parallel loops
+const size_t BLOCK_SIZE = 64 * 1024;
+}
+
+bool hasF16C() {
+#ifdef LUMINANCE_HALF_F16C
+    static const bool f16c = __builtin_cpu_supports("avx") &&
+                             __builtin_cpu_supports("f16c");
+    return f16c;
+#else
+    return false;
+#endif
+}
+
+void floatToHalf(const float *in, half_t *out, size_t size) {
+    void (*convert)(const float *, half_t *, size_t) = &floatToHalfScalar;
+#ifdef LUMINANCE_HALF_F16C
+    if (hasF16C()) convert = &floatToHalfF16C;
+#endif
+
+    const long blocks = static_cast<long>((size + BLOCK_SIZE - 1) / BLOCK_SIZE);
+#pragma omp parallel for if (blocks > 1)
+    for (long b = 0; b < blocks; ++b) {
+        const size_t first = b * BLOCK_SIZE;
+        convert(in + first, out + first, std::min(BLOCK_SIZE, size - first));
+    }
+}
+
+void halfToFloat(const half_t *in, float *out, size_t size) {
+    void (*convert)(const half_t *, float *, size_t) = &halfToFloatScalar;
+#ifdef LUMINANCE_HALF_F16C
+    if (hasF16C()) convert = &halfToFloatF16C;
+#endif
+
+    const long blocks = static_cast<long>((size + BLOCK_SIZE - 1) / BLOCK_SIZE);
+#pragma omp parallel for if (blocks > 1)
+    for (long b = 0; b < blocks; ++b) {
+        const size_t first = b * BLOCK_SIZE;
+        convert(in + first, out + first, std::min(BLOCK_SIZE, size - first));
+    }
+}
+
+}  // utils
+}  // pfs
@@ -0,0 +1,57 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Conversion between 32-bit floats and IEEE 754 half floats
+
+#ifndef PFS_UTILS_HALF_H
+#define PFS_UTILS_HALF_H
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace pfs {
+namespace utils {
+
+//! \brief bit pattern of an IEEE 754 binary16 value (same layout of the
+//! OpenEXR \c half)
+typedef uint16_t half_t;
+
+//! \brief convert \a value rounding to the nearest even half. Values beyond
+//! the half range become infinity.
+half_t floatToHalf(float value);
+
+float halfToFloat(half_t value);
+
+//! \brief convert \a size floats of \a in into \a out. Uses the F16C
+//! instructions when the CPU supports them.
+void floatToHalf(const float *in, half_t *out, size_t size);
+
+//! \brief convert \a size halfs of \a in into \a out. Uses the F16C
+//! instructions when the CPU supports them.
+void halfToFloat(const half_t *in, float *out, size_t size);
+
+//! \return true if the bulk conversions run on F16C instructions
+bool hasF16C();
+
+}  // utils
+}  // pfs
+
+#endif  // PFS_UTILS_HALF_H
@@ -45,6 +45,17 @@ struct CleanUpStdIoFile {
 
 typedef ResourceHandler<FILE, CleanUpStdIoFile> ScopedStdIoFile;
 
+//! \brief as \c CleanUpStdIoFile, but the standard streams are left open
+struct CleanUpStdIoStream {
+    static inline void cleanup(FILE *p) {
+        if (p && p != stdin && p != stdout && p != stderr) {
+            fclose(p);
+        }
+    }
+};
+
+typedef ResourceHandler<FILE, CleanUpStdIoStream> ScopedStdIoStream;
+
 }  // utils
 }  // pfs
 
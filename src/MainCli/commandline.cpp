@@ -26,7 +26,10 @@
  */
 
 #include <QDebug>
+#include <QFile>
+#include <QSharedPointer>
 #include <QTimer>
+#include <algorithm>
 #include <boost/program_options.hpp>
 #include <iostream>
 
@@ -39,13 +42,22 @@
 #include <Exif/ExifOperations.h>
 #include <Fileformat/pfsoutldrimage.h>
 #include <HdrHTML/pfsouthdrhtml.h>
+#include <Libpfs/colorspace/colorspace.h>
+#include <Libpfs/io/pfsreader.h>
+#include <Libpfs/io/pfswriter.h>
+#include <Libpfs/manip/copy.h>
 #include <Libpfs/manip/gamma_levels.h>
+#include <Libpfs/utils/bufferpool.h>
 #include <Libpfs/tm/TonemapOperator.h>
 #include "commandline.h"
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 #if defined(_MSC_VER)
 #include <fcntl.h>
-#include <io.h>
 #endif
 
 using namespace libhdr::fusion;
@@ -99,9 +111,18 @@ CommandLineInterfaceManager::CommandLineInterfaceManager(const int argc,
       htmlQuality(2),
       isProposedLdrName(false),
       isProposedHdrName(false),
+      isPfsIn(false),
+      isPfsOut(false),
+      isPfsMmap(LuminanceOptions().isPfsMmap()),
+      streamedFrames(0),
       pageName(),
       imagesDir(),
-      saveAlignedImagesPrefix(QLatin1String("")) {
+      saveAlignedImagesPrefix(QLatin1String("")),
+      ioService(new IOService(
+          static_cast<qint64>(LuminanceOptions().getBatchIOMemoryBudget())
+          << 20)),
+      hdrWrite(-1),
+      ldrWrite(-1) {
     hdrcreationconfig.weightFunction = WEIGHT_TRIANGULAR;
     hdrcreationconfig.responseCurve = RESPONSE_LINEAR;
     hdrcreationconfig.fusionOperator = DEBEVEC;
@@ -137,7 +158,7 @@ int CommandLineInterfaceManager::execCommandLineParams() {
         ("version,V", tr("Display program version.").toUtf8().constData())
         ("verbose,v", tr("Print more messages during execution.").toUtf8().constData())
         ("cameras,c", tr("Print a list of all supported cameras.").toUtf8().constData())
-        ("align,a", po::value<std::string>(), tr("[AIS|MTB]   Align Engine to use during HDR creation (default: no "
+        ("align,a", po::value<std::string>(), tr("[AIS|MTB|FEATURES]   Align Engine to use during HDR creation (default: no "
            "alignment).").toUtf8().constData())
         ("ev,e", po::value<std::string>(), tr("EV1,EV2,... Specify numerical EV values (as many as INPUTFILES).")
             .toUtf8().constData())
@@ -162,11 +183,21 @@ int CommandLineInterfaceManager::execCommandLineParams() {
             "given threshold. (0.0-1.0)").toUtf8().constData())
         ("autolevels,b", tr("Apply autolevels correction after tonemapping.").toUtf8().constData())
         ("createwebpage,w", tr("Enable generation of a webpage with embedded HDR viewer.").toUtf8().constData())
+        ("outofcore", po::value<int>(), tr("MB   Keep every image buffer larger than MB megabytes in a scratch file of "
+            "the temporary directory, 0 keeps everything in RAM. (default: from the settings)").toUtf8().constData())
         ("proposedldrname,p", po::value<std::string>(&ldrExtension),
             tr("FILE_EXTENSION   Save LDR file with a name of the form "
             "first-last_tmparameters.extension.").toUtf8().constData())
         ("proposedhdrname,z", po::value<std::string>(&hdrExtension), tr("FILE_EXTENSION   Save HDR file with a name of the form "
-            "first-last_HdrCreationModel.extension.").toUtf8().constData());
+            "first-last_HdrCreationModel.extension.").toUtf8().constData())
+        ("pfsin", tr("Read a stream of HDR frames in PFS format (as written by pfstools) from the standard input, instead of "
+            "loading or creating an HDR. Frames are tone mapped one after another as they arrive, with -o they are "
+            "saved as LDR_FILE_00001.ext, LDR_FILE_00002.ext, ...").toUtf8().constData())
+        ("pfsout", tr("Write the tone mapped frames to the standard output in PFS format, instead of saving them to "
+            "a file. Messages go to the standard error.").toUtf8().constData())
+        ("pfsmmap", po::value<bool>(), tr("true|false   Map PFS frames in memory instead of copying them: frames "
+            "read with --pfsin (when the standard input is a file), PFS files loaded with --load and PFS files "
+            "saved with --save. (default: from the settings)").toUtf8().constData());
 
     po::options_description hdr_desc(
         tr("HDR creation parameters  - you must either load an existing HDR "
@@ -204,6 +235,34 @@ int CommandLineInterfaceManager::execCommandLineParams() {
             .constData())(
         "ldrTiffDeflate", po::value<bool>(),
         tr("Tiff deflate compression. true|false (Default is true)")
+            .toUtf8()
+            .constData())(
+        "ldrTiffCompression", po::value<std::string>(),
+        tr("Tiff compression. Legal values are [none|deflate|lzw|packbits|"
+           "zstd] (Default is deflate)")
+            .toUtf8()
+            .constData())(
+        "ldrTiffLevel", po::value<int>(),
+        tr("VALUE      Tiff deflate (1-9) or zstd (1-22) compression level.")
+            .toUtf8()
+            .constData())(
+        "ldrTiffPredictor", po::value<std::string>(),
+        tr("Tiff predictor. Legal values are [none|horizontal|float] "
+           "(Default is none, float is for 32b only)")
+            .toUtf8()
+            .constData())(
+        "ldrPngLevel", po::value<int>(),
+        tr("VALUE      Png compression level (0-9), overrides the quality.")
+            .toUtf8()
+            .constData())(
+        "ldrPngStrategy", po::value<std::string>(),
+        tr("Png zlib strategy. Legal values are [default|filtered|huffman|"
+           "rle|fixed] (Default is default)")
+            .toUtf8()
+            .constData())(
+        "ldrPngFilter", po::value<std::string>(),
+        tr("Png row filter. Legal values are [none|sub|up|avg|paeth|all] "
+           "(Default is all)")
             .toUtf8()
             .constData());
 
@@ -483,6 +542,37 @@ directory must exist.  Useful to avoid clutter in the current directory. \
         if (vm.count("verbose")) {
             verbose = true;
         }
+        if (vm.count("pfsout")) {
+            isPfsOut = true;
+            // the standard output carries the frames: they are written on a
+            // duplicate of it, and the descriptor itself is pointed at the
+            // standard error, so that every message (including the printf()
+            // of the tone mapping operators) goes there
+            std::cout.flush();
+            fflush(stdout);
+#ifdef _WIN32
+            const int pfsOutFd = _dup(_fileno(stdout));
+            if (pfsOutFd >= 0 &&
+                _dup2(_fileno(stderr), _fileno(stdout)) == 0) {
+                pfsOutStream.reset(_fdopen(pfsOutFd, "wb"));
+            }
+#else
+            const int pfsOutFd = dup(STDOUT_FILENO);
+            if (pfsOutFd >= 0 && dup2(STDERR_FILENO, STDOUT_FILENO) >= 0) {
+                pfsOutStream.reset(fdopen(pfsOutFd, "wb"));
+            }
+#endif
+            if (!pfsOutStream) {
+                printErrorAndExit(
+                    tr("Error: Cannot redirect the standard output."));
+            }
+        }
+        if (vm.count("pfsin")) {
+            isPfsIn = true;
+        }
+        if (vm.count("pfsmmap")) {
+            isPfsMmap = vm["pfsmmap"].as<bool>();
+        }
         if (vm.count("cameras")) {
             cout << tr("With LibRaw version ").toStdString()
                  << LibRaw::version() << endl;
@@ -499,6 +589,15 @@ directory must exist.  Useful to avoid clutter in the current directory. \
         if (vm.count("createwebpage")) {
             isHtml = true;
         }
+        if (vm.count("outofcore")) {
+            // for this run only: the settings are left untouched
+            const size_t threshold =
+                static_cast<size_t>(std::max(vm["outofcore"].as<int>(), 0))
+                << 20;
+            pfs::utils::BufferPool::instance().setMapThreshold(
+                threshold,
+                QFile::encodeName(LuminanceOptions().getTempDir()).constData());
+        }
         if (vm.count("proposedldrname")) {
             isProposedLdrName = true;
             if (!validLdrExtensions.contains(
@@ -529,6 +628,8 @@ directory must exist.  Useful to avoid clutter in the current directory. \
                 alignMode = AIS_ALIGN;
             else if (strcmp(value, "MTB") == 0)
                 alignMode = MTB_ALIGN;
+            else if (strcmp(value, "FEATURES") == 0)
+                alignMode = FEATURE_ALIGN;
             else
                 printErrorAndExit(
                     tr("Error: Alignment engine not recognized."));
@@ -675,6 +776,34 @@ directory must exist.  Useful to avoid clutter in the current directory. \
         if (vm.count("ldrTiffDeflate"))
             tmofileparams->set("deflateCompression",
                                vm["ldrTiffDeflate"].as<bool>());
+        if (vm.count("ldrTiffCompression"))
+            tmofileparams->set("tiff_compression",
+                               vm["ldrTiffCompression"].as<std::string>());
+        if (vm.count("ldrTiffLevel")) {
+            int level = vm["ldrTiffLevel"].as<int>();
+            if (level < 1 || level > 22)
+                printErrorAndExit(
+                    tr("Error: Tiff level must be in the range [1..22]."));
+            else
+                tmofileparams->set("tiff_compression_level", level);
+        }
+        if (vm.count("ldrTiffPredictor"))
+            tmofileparams->set("tiff_predictor",
+                               vm["ldrTiffPredictor"].as<std::string>());
+        if (vm.count("ldrPngLevel")) {
+            int level = vm["ldrPngLevel"].as<int>();
+            if (level < 0 || level > 9)
+                printErrorAndExit(
+                    tr("Error: Png level must be in the range [0..9]."));
+            else
+                tmofileparams->set("png_compression_level", level);
+        }
+        if (vm.count("ldrPngStrategy"))
+            tmofileparams->set("png_strategy",
+                               vm["ldrPngStrategy"].as<std::string>());
+        if (vm.count("ldrPngFilter"))
+            tmofileparams->set("png_filter",
+                               vm["ldrPngFilter"].as<std::string>());
 
         if (vm.count("load"))
             loadHdrFilename =
@@ -725,7 +854,20 @@ directory must exist.  Useful to avoid clutter in the current directory. \
         }
     }
 
-    if (loadHdrFilename.isEmpty() && inputFiles.size() == 0) {
+    if (isPfsIn) {
+        if (!loadHdrFilename.isEmpty() || !inputFiles.isEmpty() ||
+            !saveHdrFilename.isEmpty() || isProposedHdrName ||
+            isProposedLdrName || isHtml) {
+            printErrorAndExit(
+                tr("Error: --pfsin cannot be used with input files, --load, "
+                   "--save, --proposedhdrname, --proposedldrname or "
+                   "--createwebpage."));
+        }
+        if (saveLdrFilename.isEmpty() && !isPfsOut) {
+            printErrorAndExit(
+                tr("Error: --pfsin needs either --output or --pfsout."));
+        }
+    } else if (loadHdrFilename.isEmpty() && inputFiles.size() == 0) {
         cout << cmdvisible_options << endl;
         exit(0); // Exit here instead of returning to main complicating main code
     }
@@ -742,7 +884,11 @@ void CommandLineInterfaceManager::execCommandLineParamsSlot() {
                "number of input files."));
     }
     // now validate operation mode.
-    if (inputFiles.size() != 0 && loadHdrFilename.isEmpty()) {
+    if (isPfsIn) {
+        operationMode = STREAM_MODE;
+
+        printIfVerbose(QObject::tr("Running in PFS stream mode."), verbose);
+    } else if (inputFiles.size() != 0 && loadHdrFilename.isEmpty()) {
         operationMode = CREATE_HDR_MODE;
 
         printIfVerbose(QObject::tr("Running in HDR-creation mode."), verbose);
@@ -754,7 +900,9 @@ void CommandLineInterfaceManager::execCommandLineParamsSlot() {
         exit(-1);
     }
 
-    if (operationMode == CREATE_HDR_MODE) {
+    if (operationMode == STREAM_MODE) {
+        streamFrames();
+    } else if (operationMode == CREATE_HDR_MODE) {
         if (verbose) {
             LuminanceOptions luminance_options;
 
@@ -793,7 +941,8 @@ void CommandLineInterfaceManager::execCommandLineParamsSlot() {
                        verbose);
 
         try {
-            HDR.reset(IOWorker().read_hdr_frame(loadHdrFilename));
+            HDR.reset(IOWorker().read_hdr_frame(
+                loadHdrFilename, pfs::Params("pfs_mmap", isPfsMmap)));
         } catch (...) {
             printErrorAndExit(QStringLiteral("Catched unhandled exception"));
         }
@@ -809,6 +958,52 @@ void CommandLineInterfaceManager::execCommandLineParamsSlot() {
     }
 }
 
+void CommandLineInterfaceManager::streamFrames() {
+    try {
+        pfs::io::PfsReader reader(PFS_STDIO_NAME);
+        pfs::Frame frame;
+        // only one frame at a time is kept in memory
+        const pfs::Params params("pfs_mmap", isPfsMmap);
+        while (reader.readNext(frame, params)) {
+            ++streamedFrames;
+            printIfVerbose(tr("Frame %1 read from the standard input.")
+                               .arg(streamedFrames),
+                           verbose);
+
+            // pfstools store XYZ, Luminance HDR works on RGB
+            pfs::Channel *X, *Y, *Z;
+            frame.getXYZChannels(X, Y, Z);
+            if (X == NULL) {
+                printErrorAndExit(
+                    tr("Error: frame %1 has no color channels.")
+                        .arg(streamedFrames));
+            }
+            pfs::transformColorSpace(pfs::CS_XYZ, X, Y, Z, pfs::CS_RGB, X, Y,
+                                     Z);
+
+            HDR.reset(new pfs::Frame());
+            HDR->swap(frame);
+
+            QString ldrFilename;
+            if (!isPfsOut) {
+                QFileInfo fi(saveLdrFilename);
+                ldrFilename = fi.path() + "/" + fi.completeBaseName() +
+                              QStringLiteral("_%1.").arg(streamedFrames, 5, 10,
+                                                        QLatin1Char('0')) +
+                              fi.suffix();
+            }
+            tonemap(ldrFilename, QStringLiteral("FromHdrFile"));
+            HDR.reset();
+        }
+    } catch (std::runtime_error &e) {
+        printErrorAndExit(tr("Error reading the PFS stream: %1").arg(e.what()));
+    }
+
+    finishWrites();
+    printIfVerbose(tr("%n frame(s) processed.", "", streamedFrames), verbose);
+    emit finishedParsing();
+}
+
 void CommandLineInterfaceManager::finishedLoadingInputFiles() {
     QStringList filesLackingExif = hdrCreationManager->getFilesWithoutExif();
     if (filesLackingExif.size() != 0 && ev.isEmpty()) {
@@ -829,6 +1024,9 @@ void CommandLineInterfaceManager::finishedLoadingInputFiles() {
     } else if (alignMode == MTB_ALIGN) {
         printIfVerbose(tr("Starting aligning..."), verbose);
         hdrCreationManager->align_with_mtb();
+    } else if (alignMode == FEATURE_ALIGN) {
+        printIfVerbose(tr("Starting aligning..."), verbose);
+        hdrCreationManager->align_with_features();
     } else if (alignMode == NO_ALIGN) {
         createHDR(0);
     }
@@ -912,15 +1110,17 @@ void CommandLineInterfaceManager::saveHDR() {
 
         // write_hdr_frame by default saves to EXR, if it doesn't find a
         // supported
-        // file type
-        if (IOWorker().write_hdr_frame(HDR.data(), saveHdrFilename)) {
-            printIfVerbose(
-                tr("Image %1 saved successfully").arg(saveHdrFilename),
-                verbose);
-        } else {
-            printIfVerbose(tr("Could not save %1").arg(saveHdrFilename),
-                           verbose);
-        }
+        // file type. It runs while HDR is tone mapped, so it writes its own
+        // copy: finishWrites() reports the result.
+        QSharedPointer<pfs::Frame> frame(pfs::copy(HDR.data()));
+        const QString filename = saveHdrFilename;
+        const pfs::Params params("pfs_mmap", isPfsMmap);
+        hdrWrite = ioService->write(
+            [frame, filename, params]() {
+                return IOWorker().write_hdr_frame(frame.data(), filename,
+                                                  params);
+            },
+            IOService::frameBytes(*frame));
     } else {
         printIfVerbose(
             tr("NOT Saving HDR image to file. %1").arg(saveHdrFilename),
@@ -953,7 +1153,7 @@ void CommandLineInterfaceManager::generateHTML() {
 }
 
 void CommandLineInterfaceManager::startTonemap() {
-    if (!saveLdrFilename.isEmpty() || isProposedLdrName) {
+    if (!saveLdrFilename.isEmpty() || isProposedLdrName || isPfsOut) {
         QString
             inputfname;  // to copy EXIF tags from 1st input image to saved LDR
         if (inputFiles.isEmpty()) {
@@ -979,83 +1179,153 @@ void CommandLineInterfaceManager::startTonemap() {
             }
         }
 
+        tonemap(saveLdrFilename, inputfname);
+        if (isHtml && !isHtmlDone) {
+            generateHTML();
+        }
+        finishWrites();
+        emit finishedParsing();
+    } else {
+        printIfVerbose(tr("Tonemapping NOT requested."), verbose);
+        if (isHtml && !isHtmlDone) {
+            generateHTML();
+        }
+        finishWrites();
+        emit finishedParsing();
+    }
+}
+
+void CommandLineInterfaceManager::tonemap(const QString &ldrFilename,
+                                          const QString &inputfname) {
+    if (isPfsOut) {
+        printIfVerbose(tr("Tonemapping requested, writing to the standard "
+                          "output."),
+                       verbose);
+    } else {
         printIfVerbose(tr("Tonemapping requested, saving to file %1.")
-                           .arg(saveLdrFilename),
+                           .arg(ldrFilename),
                        verbose);
+    }
+
+    // the frames of a stream may not share the same size
+    const int xsize = tmopts->xsize;
 
-        // now check if user wants to resize (create thread with either -2 or
-        // true
-        // original size as first argument in ctor,
-        // see options.cpp).
-        // TODO
-        tmopts->origxsize = HDR->getWidth();
+    // now check if user wants to resize (create thread with either -2 or
+    // true
+    // original size as first argument in ctor,
+    // see options.cpp).
+    // TODO
+    tmopts->origxsize = HDR->getWidth();
 #ifdef QT_DEBUG
-        qDebug() << "XSIZE:" << tmopts->xsize;
+    qDebug() << "XSIZE:" << tmopts->xsize;
 #endif
-        if (tmopts->xsize == -2)
-            tmopts->xsize = HDR->getWidth();
-        else
-            printIfVerbose(tr("Resizing to width %1.").arg(tmopts->xsize),
-                           verbose);
+    if (tmopts->xsize == -2)
+        tmopts->xsize = HDR->getWidth();
+    else
+        printIfVerbose(tr("Resizing to width %1.").arg(tmopts->xsize),
+                       verbose);
 
-        if (tmopts->pregamma != 1)
-            printIfVerbose(tr("Applying gamma %1.").arg(tmopts->pregamma),
-                           verbose);
+    if (tmopts->pregamma != 1)
+        printIfVerbose(tr("Applying gamma %1.").arg(tmopts->pregamma),
+                       verbose);
 
-        // Build TMWorker
-        TMWorker tm_worker;
-        connect(&tm_worker, &TMWorker::tonemapSetMaximum, this,
-                &CommandLineInterfaceManager::setProgressBar);
-        connect(&tm_worker, &TMWorker::tonemapSetValue, this,
-                &CommandLineInterfaceManager::updateProgressBar);
-        connect(&tm_worker, &TMWorker::tonemapFailed, this,
-                &CommandLineInterfaceManager::tonemapFailed);
-
-        // Build a new TM frame
-        // The scoped pointer will free the memory automatically later on
-        QScopedPointer<pfs::Frame> tm_frame(tm_worker.computeTonemap(
-            HDR.data(), tmopts.data(), BilinearInterp));
-
-        // Autolevels
-        if (isAutolevels) {
-            float minL, maxL, gammaL;
-            QScopedPointer<QImage> temp_qimage(
-                fromLDRPFStoQImage(tm_frame.data()));
-            computeAutolevels(temp_qimage.data(), 0.985f, minL, maxL, gammaL);
-            pfs::gammaAndLevels(tm_frame.data(), minL, maxL, 0.f, 1.f, gammaL);
+    // Build TMWorker
+    TMWorker tm_worker;
+    connect(&tm_worker, &TMWorker::tonemapSetMaximum, this,
+            &CommandLineInterfaceManager::setProgressBar);
+    connect(&tm_worker, &TMWorker::tonemapSetValue, this,
+            &CommandLineInterfaceManager::updateProgressBar);
+    connect(&tm_worker, &TMWorker::tonemapFailed, this,
+            &CommandLineInterfaceManager::tonemapFailed);
+
+    // Build a new TM frame
+    // The scoped pointer will free the memory automatically later on
+    QScopedPointer<pfs::Frame> tm_frame(tm_worker.computeTonemap(
+        HDR.data(), tmopts.data(), BilinearInterp));
+
+    // Autolevels
+    if (isAutolevels) {
+        float minL, maxL, gammaL;
+        QScopedPointer<QImage> temp_qimage(
+            fromLDRPFStoQImage(tm_frame.data()));
+        computeAutolevels(temp_qimage.data(), 0.985f, minL, maxL, gammaL);
+        pfs::gammaAndLevels(tm_frame.data(), minL, maxL, 0.f, 1.f, gammaL);
+    }
+    if (tmopts->postsaturation != 1)
+        printIfVerbose(tr("\nApplying saturation enhancement %1.").arg(tmopts->postsaturation),
+                       verbose);
+    if (tmopts->postgamma != 1)
+        printIfVerbose(tr("\nApplying post-gamma %1.").arg(tmopts->postgamma),
+                       verbose);
+
+    tmopts->xsize = xsize;
+
+    if (isPfsOut) {
+        // pfstools expect XYZ: the inverse of what pfsout does
+        pfs::Channel *X, *Y, *Z;
+        tm_frame->getXYZChannels(X, Y, Z);
+        if (X != NULL) {
+            pfs::transformColorSpace(pfs::CS_RGB, X, Y, Z, pfs::CS_XYZ, X, Y,
+                                     Z);
         }
-        if (tmopts->postsaturation != 1)
-            printIfVerbose(tr("\nApplying saturation enhancement %1.").arg(tmopts->postsaturation),
-                           verbose);
-        if (tmopts->postgamma != 1)
-            printIfVerbose(tr("\nApplying post-gamma %1.").arg(tmopts->postgamma),
-                           verbose);
+        try {
+            pfs::io::PfsWriter(pfsOutStream.data())
+                .write(*tm_frame, pfs::Params());
+        } catch (std::runtime_error &e) {
+            printErrorAndExit(
+                tr("\nERROR: Cannot write to the standard output: %1")
+                    .arg(e.what()));
+        }
+        return;
+    }
+
+    // one image at a time waits to be written
+    finishWrites();
+
+    // Create an ad-hoc IOWorker to save the file, on the IOService thread:
+    // it gets its own copy of everything, the next frame changes them
+    QSharedPointer<pfs::Frame> output(tm_frame.take());
+    QSharedPointer<TonemappingOptions> opts(new TonemappingOptions(*tmopts));
+    const QVector<float> expotimes = hdrCreationManager.data()
+                                         ? hdrCreationManager->getExpotimes()
+                                         : QVector<float>();
+    const pfs::Params params = *tmofileparams;
+    ldrWriteFilename = ldrFilename;
+    ldrWrite = ioService->write(
+        [output, ldrFilename, inputfname, expotimes, opts, params]() {
+            return IOWorker().write_ldr_frame(output.data(), ldrFilename,
+                                              inputfname, expotimes,
+                                              opts.data(), params);
+        },
+        IOService::frameBytes(*output));
+}
 
-        // Create an ad-hoc IOWorker to save the file
-        if (IOWorker().write_ldr_frame(
-                tm_frame.data(), saveLdrFilename, inputfname,
-                hdrCreationManager.data() ? hdrCreationManager->getExpotimes()
-                                          : QVector<float>(),
-                tmopts.data(), *tmofileparams)) {
+void CommandLineInterfaceManager::finishWrites() {
+    if (hdrWrite >= 0) {
+        const int ticket = hdrWrite;
+        hdrWrite = -1;
+        if (ioService->wait(ticket)) {
+            printIfVerbose(
+                tr("Image %1 saved successfully").arg(saveHdrFilename),
+                verbose);
+        } else {
+            printIfVerbose(tr("Could not save %1").arg(saveHdrFilename),
+                           verbose);
+        }
+    }
+    if (ldrWrite >= 0) {
+        const int ticket = ldrWrite;
+        ldrWrite = -1;
+        if (ioService->wait(ticket)) {
             // File save successful
             printIfVerbose(
-                tr("\nImage %1 successfully saved").arg(saveLdrFilename),
+                tr("\nImage %1 successfully saved").arg(ldrWriteFilename),
                 verbose);
         } else {
             // File save failed
-            printErrorAndExit(
-                tr("\nERROR: Cannot save to file: %1").arg(saveLdrFilename));
+            printErrorAndExit(tr("\nERROR: Cannot save to file: %1")
+                                  .arg(ldrWriteFilename));
         }
-        if (isHtml && !isHtmlDone) {
-            generateHTML();
-        }
-        emit finishedParsing();
-    } else {
-        printIfVerbose(tr("Tonemapping NOT requested."), verbose);
-        if (isHtml && !isHtmlDone) {
-            generateHTML();
-        }
-        emit finishedParsing();
     }
 }
 
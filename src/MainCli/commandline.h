@@ -34,10 +34,12 @@
 #include <QString>
 #include <QStringList>
 
+#include <Core/IOService.h>
 #include <Core/TonemappingOptions.h>
 #include <HdrWizard/HdrCreationManager.h>
 #include <Libpfs/frame.h>
 #include <Libpfs/params.h>
+#include <Libpfs/utils/resourcehandlerstdio.h>
 #include "ezETAProgressBar.hpp"
 
 class CommandLineInterfaceManager : public QObject {
@@ -53,10 +55,11 @@ class CommandLineInterfaceManager : public QObject {
     enum operation_mode {
         CREATE_HDR_MODE,
         LOAD_HDR_MODE,
+        STREAM_MODE,
         UNKNOWN_MODE
     } operationMode;
 
-    enum align_mode { AIS_ALIGN, MTB_ALIGN, NO_ALIGN } alignMode;
+    enum align_mode { AIS_ALIGN, MTB_ALIGN, FEATURE_ALIGN, NO_ALIGN } alignMode;
 
     QList<float> ev;
     QScopedPointer<HdrCreationManager> hdrCreationManager;
@@ -82,6 +85,12 @@ class CommandLineInterfaceManager : public QObject {
     int htmlQuality;
     bool isProposedLdrName;
     bool isProposedHdrName;
+    bool isPfsIn;
+    bool isPfsOut;
+    bool isPfsMmap;
+    // the standard output as it was before --pfsout redirected it
+    pfs::utils::ScopedStdIoFile pfsOutStream;
+    int streamedFrames;
     std::string pageName;
     std::string imagesDir;
     std::string ldrExtension;
@@ -89,9 +98,22 @@ class CommandLineInterfaceManager : public QObject {
     QString saveAlignedImagesPrefix;
     QStringList validLdrExtensions;
     QStringList validHdrExtensions;
+    // writes the HDR while it is tone mapped, and each LDR of a stream
+    // while the next frame is tone mapped
+    QScopedPointer<IOService> ioService;
+    int hdrWrite;
+    int ldrWrite;
+    QString ldrWriteFilename;
 
     void generateHTML();
+    //! \brief waits for the images still being written and reports them
+    void finishWrites();
     void startTonemap();
+    //! \brief tone map HDR and save it to \a ldrFilename (or to the standard
+    //! output with --pfsout)
+    void tonemap(const QString &ldrFilename, const QString &inputfname);
+    //! \brief tone map each frame of the PFS stream on the standard input
+    void streamFrames();
 
    private slots:
     void finishedLoadingInputFiles();
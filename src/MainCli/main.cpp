@@ -34,6 +34,7 @@ int main(int argc, char **argv) {
     QCoreApplication::setOrganizationName(LUMINANCEORGANIZATION);
     QCoreApplication application(argc, argv);
     LuminanceOptions lumOpts;
+    lumOpts.applyMemorySettings();
 
     TranslatorManager::setLanguage(lumOpts.getGuiLang(), false);
 
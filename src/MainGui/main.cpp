@@ -156,6 +156,7 @@ int main(int argc, char **argv) {
     TranslatorManager::setLanguage(LuminanceOptions().getGuiLang());
 
     LuminanceOptions().applyTheme(true);
+    LuminanceOptions().applyMemorySettings();
 
     QStringList arguments = application.arguments();
 
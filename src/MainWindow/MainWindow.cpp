@@ -367,6 +367,8 @@ void MainWindow::createCentralWidget() {
             &MainWindow::exportImage);
     connect(this, &MainWindow::updatedHDR, m_tonemapPanel,
             &TonemappingPanel::updatedHDR);
+    connect(this, &MainWindow::updatedHDR, this,
+            &MainWindow::updatePreviewFrames);
     connect(this, &QObject::destroyed, m_PreviewPanel, &QObject::deleteLater);
 
     m_centralwidget_splitter->restoreState(
@@ -1108,6 +1110,8 @@ void MainWindow::setupIO() {
             this, SLOT(load_success(pfs::Frame *, const QString &)));
     connect(m_IOWorker, &IOWorker::read_hdr_failed, this,
             &MainWindow::load_failed);
+    connect(m_IOWorker, &IOWorker::read_hdr_preview, this,
+            &MainWindow::load_preview);
 
     // Save HDR
     connect(m_IOWorker,
@@ -1155,6 +1159,7 @@ void MainWindow::ioEnd() {
 }
 
 void MainWindow::load_failed(const QString &errorMessage) {
+    m_loadedPreview.reset();
     m_ProgressBar->reset();
     m_ProgressBar->hide();
 
@@ -1165,6 +1170,12 @@ void MainWindow::load_failed(const QString &errorMessage) {
                           QMessageBox::Ok, QMessageBox::NoButton);
 }
 
+void MainWindow::load_preview(pfs::Frame *preview, const QString &fname) {
+    // kept until the full image gets to load_success()
+    m_loadedPreview.reset(preview);
+    m_loadedPreviewName = fname;
+}
+
 void MainWindow::load_success(pfs::Frame *new_hdr_frame,
                               const QString &new_fname,
                               const QStringList &inputFileNames,
@@ -1180,6 +1191,9 @@ void MainWindow::load_success(pfs::Frame *new_hdr_frame,
 #endif
 
         HdrViewer *newhdr = new HdrViewer(new_hdr_frame, this, needSaving);
+        if (m_loadedPreview && new_fname == m_loadedPreviewName) {
+            newhdr->setPreviewFrame(m_loadedPreview.take());
+        }
 
         newhdr->setAttribute(Qt::WA_DeleteOnClose);
 
@@ -1247,6 +1261,7 @@ void MainWindow::load_success(pfs::Frame *new_hdr_frame,
         // signal: I have a new HDR open
         emit updatedHDR(newhdr->getFrame());
     }
+    m_loadedPreview.reset();
 }
 
 void MainWindow::on_OptionsAction_triggered() {
@@ -1851,11 +1866,11 @@ void MainWindow::showPreviewPanel(bool b) {
             m_PreviewPanel->setAutolevels(
                 m_tonemapPanel->doAutoLevels(),
                 m_tonemapPanel->getAutoLevelsThreshold());
-            m_PreviewPanel->updatePreviews(tm_status.curr_tm_frame->getFrame());
+            refreshPreviewPanel();
 
             // connect signals
-            connect(this, SIGNAL(updatedHDR(pfs::Frame *)), m_PreviewPanel,
-                    SLOT(updatePreviews(pfs::Frame *)));
+            connect(this, SIGNAL(updatedHDR(pfs::Frame *)), this,
+                    SLOT(refreshPreviewPanel()));
             connect(m_PreviewPanel, &PreviewPanel::startTonemapping, this,
                     &MainWindow::tonemapImage);
             connect(m_PreviewPanel, &PreviewPanel::startTonemapping,
@@ -1867,8 +1882,8 @@ void MainWindow::showPreviewPanel(bool b) {
         m_PreviewscrollArea->hide();
 
         // disconnect signals
-        disconnect(this, SIGNAL(updatedHDR(pfs::Frame *)), m_PreviewPanel,
-                   SLOT(updatePreviews(pfs::Frame *)));
+        disconnect(this, SIGNAL(updatedHDR(pfs::Frame *)), this,
+                   SLOT(refreshPreviewPanel()));
         disconnect(m_PreviewPanel, &PreviewPanel::startTonemapping, this,
                    &MainWindow::tonemapImage);
         disconnect(m_PreviewPanel, &PreviewPanel::startTonemapping,
@@ -1883,11 +1898,26 @@ void MainWindow::updatePreviews(bool b, float th) {
         if (tm_status.is_hdr_ready) {
             m_PreviewPanel->setAutolevels(b, th);
             // ask panel to refresh itself
-            m_PreviewPanel->updatePreviews(tm_status.curr_tm_frame->getFrame());
+            refreshPreviewPanel();
         }
     }
 }
 
+void MainWindow::updatePreviewFrames() {
+    HdrViewer *viewer = qobject_cast<HdrViewer *>(tm_status.curr_tm_frame);
+    if (!tm_status.is_hdr_ready || viewer == NULL) return;
+
+    m_tonemapPanel->setPreviewFrame(viewer->getPreviewFrame());
+}
+
+void MainWindow::refreshPreviewPanel() {
+    HdrViewer *viewer = qobject_cast<HdrViewer *>(tm_status.curr_tm_frame);
+    if (!tm_status.is_hdr_ready || viewer == NULL) return;
+
+    m_PreviewPanel->updatePreviews(viewer->getPreviewFrame(), -1,
+                                   viewer->getFrame()->getWidth());
+}
+
 void MainWindow::updateMagnificationButtons(GenericViewer *c_v) {
     if (c_v == nullptr) return;
     bool isNormalSize = c_v->isNormalSize();
@@ -2109,7 +2139,9 @@ void MainWindow::whiteBalanceDone() {
     m_viewerToProcess->updatePixmap();
     if (m_viewerToProcess->isHDR()) {
         m_viewerToProcess->setNeedsSaving(true);
-        m_PreviewPanel->updatePreviews(tm_status.curr_tm_frame->getFrame());
+        // the frame was balanced in place: drop its preview
+        qobject_cast<HdrViewer *>(m_viewerToProcess)->setPreviewFrame(NULL);
+        emit updatedHDR(m_viewerToProcess->getFrame());
     }
 }
 
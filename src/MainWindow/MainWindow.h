@@ -96,6 +96,7 @@ class MainWindow : public QMainWindow {
     void save_ldr_failed(const QString &fname);
 
     void load_failed(const QString &);
+    void load_preview(pfs::Frame *preview, const QString &fname);
     void load_success(pfs::Frame *new_hdr_frame, const QString &new_fname,
                       const QStringList &inputFileNames = QStringList(),
                       bool needSaving = false);
@@ -220,6 +221,9 @@ class MainWindow : public QMainWindow {
     void on_actionSelect_Interpolation_Method_toggled(bool);
 
     void updatePreviews(bool, float);
+    //! \brief hand the preview frame of the HDR over to the tone mapping panel
+    void updatePreviewFrames();
+    void refreshPreviewPanel();
 
     void reparentViewer(GenericViewer *g_v);
     void showNextViewer(GenericViewer *g_v);
@@ -328,6 +332,9 @@ class MainWindow : public QMainWindow {
     QThread *m_IOThread;
     IOWorker *m_IOWorker;
     QProgressBar *m_ProgressBar;
+    //! \brief preview of the file being loaded, see IOWorker::read_hdr_preview
+    QScopedPointer<pfs::Frame> m_loadedPreview;
+    QString m_loadedPreviewName;
 
     // TM thread
     QThread *m_TMThread;
@@ -64,6 +64,11 @@ inline int value2pos(double value, int minpos, int maxpos, double minv,
     double y = (log(value) - log(minv)) / (log(maxv) - log(minv));
     return (int)((maxpos - minpos) * y) + minpos;
 }
+
+// values of KEY_WIZARD_RAW_PREVIEW, in the order of rawPreviewComboBox
+const char *const RAW_PREVIEW_MODES[] = {"half", "thumbnail", "none"};
+const int RAW_PREVIEW_MODES_SIZE =
+    sizeof(RAW_PREVIEW_MODES) / sizeof(RAW_PREVIEW_MODES[0]);
 }
 
 PreferencesDialog::PreferencesDialog(QWidget *p, int tab)
@@ -194,6 +199,13 @@ void PreferencesDialog::on_okButton_clicked() {
     }
 
     luminance_options.setTempDir(m_Ui->lineEditTempPath->text());
+    luminance_options.setBufferCacheSize(m_Ui->bufferCacheSpinBox->value());
+    luminance_options.setOutOfCoreThreshold(m_Ui->outOfCoreSpinBox->value());
+    luminance_options.setHalfFloatInputs(
+        m_Ui->halfFloatInputsCheckBox->isChecked());
+    luminance_options.setExrMipmap(m_Ui->exrMipmapCheckBox->isChecked());
+    luminance_options.setPfsMmap(m_Ui->pfsMmapCheckBox->isChecked());
+    luminance_options.applyMemorySettings();
 
     luminance_options.setPreviewWidth(m_Ui->previewsWidthSpinBox->value());
     luminance_options.setPreviewPanelActive(
@@ -218,6 +230,8 @@ void PreferencesDialog::on_okButton_clicked() {
     luminance_options.setRawFourColorRGB(m_Ui->four_color_rgb_CB->isChecked());
     luminance_options.setRawDoNotUseFujiRotate(
         m_Ui->do_not_use_fuji_rotate_CB->isChecked());
+    luminance_options.setRawPreview(QLatin1String(
+        RAW_PREVIEW_MODES[m_Ui->rawPreviewComboBox->currentIndex()]));
     QString user_qual = m_Ui->user_qual_comboBox->itemText(
         m_Ui->user_qual_comboBox->currentIndex());
     if (user_qual == QLatin1String("Bilinear") ||
@@ -578,6 +592,12 @@ void PreferencesDialog::from_options_to_gui() {
     m_Ui->lineEditTempPath->setText(luminance_options.getTempDir());
 
     m_Ui->numThreadspinBox->setValue(luminance_options.getBatchTmNumThreads());
+    m_Ui->bufferCacheSpinBox->setValue(luminance_options.getBufferCacheSize());
+    m_Ui->outOfCoreSpinBox->setValue(luminance_options.getOutOfCoreThreshold());
+    m_Ui->halfFloatInputsCheckBox->setChecked(
+        luminance_options.isHalfFloatInputs());
+    m_Ui->exrMipmapCheckBox->setChecked(luminance_options.isExrMipmap());
+    m_Ui->pfsMmapCheckBox->setChecked(luminance_options.isPfsMmap());
 
     m_Ui->aisParamsLineEdit->setText(
         luminance_options.getAlignImageStackOptions().join(
@@ -600,6 +620,12 @@ void PreferencesDialog::from_options_to_gui() {
     m_Ui->four_color_rgb_CB->setChecked(luminance_options.isRawFourColorRGB());
     m_Ui->do_not_use_fuji_rotate_CB->setChecked(
         luminance_options.isRawDoNotUseFujiRotate());
+    const QString rawPreview = luminance_options.getRawPreview();
+    for (int i = 0; i < RAW_PREVIEW_MODES_SIZE; ++i) {
+        if (rawPreview == QLatin1String(RAW_PREVIEW_MODES[i])) {
+            m_Ui->rawPreviewComboBox->setCurrentIndex(i);
+        }
+    }
 
 #ifdef DEMOSAICING_GPL2
     bool GPL2 = true;
@@ -90,14 +90,10 @@ class PreviewLabelUpdater {
 #endif
         }
 
-        // Copy Reference Frame
-        QSharedPointer<pfs::Frame> temp_frame(
-            pfs::copy(m_ReferenceFrame.data()));
-
         // Tone Mapping
         // QScopedPointer<TonemapOperator> tm_operator(
         // TonemapOperator::getTonemapOperator(tm_options->tmoperator));
-        // tm_operator->tonemapFrame(temp_frame.data(), tm_options,
+        // tm_operator->tonemapFrame(m_ReferenceFrame.data(), tm_options,
         // fake_progress_helper);
 
         // try { //Since nothing here actually throws this isn't useful, i need
@@ -105,7 +101,7 @@ class PreviewLabelUpdater {
         // check if returned frame != NULL
         QScopedPointer<TMWorker> tmWorker(new TMWorker);
         QSharedPointer<pfs::Frame> frame(tmWorker->computeTonemap(
-            temp_frame.data(), tm_options, BilinearInterp));
+            m_ReferenceFrame.data(), tm_options, BilinearInterp));
 
         if (!frame.isNull()) {
             // Create QImage from pfs::Frame into QSharedPointer, and I give it
@@ -349,10 +345,13 @@ PreviewPanel::~PreviewPanel() {
 #endif
 }
 
-void PreviewPanel::updatePreviews(pfs::Frame *frame, int index) {
+void PreviewPanel::updatePreviews(pfs::Frame *frame, int index,
+                                  int originalWidth) {
     if (frame == NULL) return;
 
-    m_original_width_frame = frame->getWidth();
+    // the operators scale their parameters to the size of the image
+    m_original_width_frame =
+        originalWidth > 0 ? originalWidth : frame->getWidth();
 
     int frame_width = frame->getWidth();
     int frame_height = frame->getHeight();
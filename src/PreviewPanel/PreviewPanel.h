@@ -48,7 +48,10 @@ class PreviewPanel : public QWidget {
     PreviewLabel *getLabel(int);
 
    public Q_SLOTS:
-    void updatePreviews(pfs::Frame *frame, int index = -1);
+    //! \brief \a frame can be a reduced copy of an image \a originalWidth
+    //! pixels wide (0 if it is the image itself)
+    void updatePreviews(pfs::Frame *frame, int index = -1,
+                        int originalWidth = 0);
     void setAutolevels(bool, float);
 
    protected Q_SLOTS:
@@ -89,7 +89,7 @@ void pfstmo_fattal02(pfs::Frame &frame, float opt_alpha, float opt_beta,
     const int w = frame.getWidth();
     const int h = frame.getHeight();
 
-    pfs::Array2Df Yr(w, h);
+    pfs::Array2Df Yr(w, h, pfs::uninitialized);
     pfs::Array2Df L(w, h);
 
     pfs::transformRGB2Y(R, G, B, &Yr);
@@ -64,7 +64,7 @@ void pfstmo_ferwerda96(pfs::Frame &frame, float Ld_Max,
     int w = inX->getCols();
     int h = inX->getRows();
 
-    pfs::Array2Df L(w, h);
+    pfs::Array2Df L(w, h, pfs::uninitialized);
     transformRGB2Y(inX, inY, inZ, &L);
 
     try {
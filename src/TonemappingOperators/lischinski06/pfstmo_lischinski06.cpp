@@ -74,7 +74,7 @@ void pfstmo_lischinski06(Frame &frame, float alpha_mul,
     const int w = inX->getCols();
     const int h = inY->getRows();
 
-    Array2Df L(w, h);
+    Array2Df L(w, h, uninitialized);
 
     transformRGB2Y(inX, inY, inZ, &L);
 
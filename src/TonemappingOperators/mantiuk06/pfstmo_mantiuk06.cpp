@@ -93,7 +93,7 @@ void pfstmo_mantiuk06(pfs::Frame &frame, float scaleFactor,
     const int cols = frame.getWidth();
     const int rows = frame.getHeight();
 
-    pfs::Array2Df inY(cols, rows);
+    pfs::Array2Df inY(cols, rows, pfs::uninitialized);
     pfs::transformRGB2Y(inRed, inGreen, inBlue, &inY);
 
     try {
@@ -108,7 +108,7 @@ void pfstmo_mantiuk08(pfs::Frame &frame, float saturation_factor,
     const int cols = frame.getWidth();
     const int rows = frame.getHeight();
 
-    pfs::Array2Df R(cols, rows);
+    pfs::Array2Df R(cols, rows, pfs::uninitialized);
     pfs::transformColorSpace(pfs::CS_XYZ, inX, inY, inZ, pfs::CS_RGB, inX, &R,
                              inZ);
 
@@ -107,9 +107,9 @@ void pfstmo_pattanaik00(pfs::Frame &frame, bool local, float multiplier,
     int w = Y->getWidth();
     int h = Y->getHeight();
 
-    pfs::Array2Df R(w, h);
-    pfs::Array2Df G(w, h);
-    pfs::Array2Df B(w, h);
+    pfs::Array2Df R(w, h, pfs::uninitialized);
+    pfs::Array2Df G(w, h, pfs::uninitialized);
+    pfs::Array2Df B(w, h, pfs::uninitialized);
 
     pfs::transformColorSpace(pfs::CS_XYZ, X, Y, Z, pfs::CS_RGB, &R, &G, &B);
 
@@ -79,7 +79,7 @@ void pfstmo_reinhard05(pfs::Frame &frame, float brightness,
 
     // is there a way to remove this copy as well?
     // I am pretty sure there is!
-    pfs::Array2Df Y(width, height);
+    pfs::Array2Df Y(width, height, pfs::uninitialized);
     pfs::transformRGB2Y(R, G, B, &Y);
     try {
         tmo_reinhard05(
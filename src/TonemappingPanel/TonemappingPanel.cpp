@@ -62,6 +62,8 @@ TonemappingPanel::TonemappingPanel(int mainWinNumber, PreviewPanel *panel,
       adding_custom_size(false),
       m_previewPanel(panel),
       m_mainWinNumber(mainWinNumber),
+      m_currentFrame(NULL),
+      m_previewFrame(NULL),
       m_autolevelThreshold(0.985f),
       m_thd(new ThresholdWidget(this)),
       m_Ui(new Ui::TonemappingPanel) {
@@ -1544,6 +1546,11 @@ void TonemappingPanel::setEnabled(bool b) {
 void TonemappingPanel::updatedHDR(pfs::Frame *f) {
     setSizes(f->getWidth(), f->getHeight());
     m_currentFrame = f;
+    m_previewFrame = f;
+}
+
+void TonemappingPanel::setPreviewFrame(pfs::Frame *preview) {
+    m_previewFrame = preview;
 }
 
 /*
@@ -2523,7 +2530,8 @@ void TonemappingPanel::updatePreviews(double v) {
                     new TonemappingOptions(*m_toneMappingOptions);  // make a copy
                 tmopts->pregamma = v;
                 m_previewPanel->getLabel(i)->setTonemappingOptions(tmopts);
-                m_previewPanel->updatePreviews(m_currentFrame, i);
+                m_previewPanel->updatePreviews(m_previewFrame, i,
+                                               m_currentFrame->getWidth());
             }
             updateCurrentTmoOperator(index);
         } else if (eventSender == m_Ui->postgammadsb) {
@@ -2535,7 +2543,8 @@ void TonemappingPanel::updatePreviews(double v) {
                     new TonemappingOptions(*m_toneMappingOptions);  // make a copy
                 tmopts->postgamma = v;
                 m_previewPanel->getLabel(i)->setTonemappingOptions(tmopts);
-                m_previewPanel->updatePreviews(m_currentFrame, i);
+                m_previewPanel->updatePreviews(m_previewFrame, i,
+                                               m_currentFrame->getWidth());
             }
             updateCurrentTmoOperator(index);
         } else if (eventSender == m_Ui->postsaturationdsb) {
@@ -2547,13 +2556,15 @@ void TonemappingPanel::updatePreviews(double v) {
                     new TonemappingOptions(*m_toneMappingOptions);  // make a copy
                 tmopts->postsaturation = v;
                 m_previewPanel->getLabel(i)->setTonemappingOptions(tmopts);
-                m_previewPanel->updatePreviews(m_currentFrame, i);
+                m_previewPanel->updatePreviews(m_previewFrame, i,
+                                               m_currentFrame->getWidth());
             }
             updateCurrentTmoOperator(index);
         } else {
 
             m_previewPanel->getLabel(index)->setTonemappingOptions(tmopts);
-            m_previewPanel->updatePreviews(m_currentFrame, index);
+            m_previewPanel->updatePreviews(m_previewFrame, index,
+                                           m_currentFrame->getWidth());
         }
     }
     delete tmopts;
@@ -2588,7 +2599,8 @@ void TonemappingPanel::updatePreviewsCB(bool state) {
 
     if (index >= 0) {
         m_previewPanel->getLabel(index)->setTonemappingOptions(tmopts);
-        m_previewPanel->updatePreviews(m_currentFrame, index);
+        m_previewPanel->updatePreviews(m_previewFrame, index,
+                                       m_currentFrame->getWidth());
     }
     delete tmopts;
 }
@@ -2604,7 +2616,8 @@ void TonemappingPanel::updatePreviewsRB(bool toggled) {
 
     if (index >= 0) {
         m_previewPanel->getLabel(index)->setTonemappingOptions(tmopts);
-        m_previewPanel->updatePreviews(m_currentFrame, index);
+        m_previewPanel->updatePreviews(m_previewFrame, index,
+                                       m_currentFrame->getWidth());
     }
     delete tmopts;
 }
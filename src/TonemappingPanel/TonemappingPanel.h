@@ -106,6 +106,8 @@ class TonemappingPanel : public QWidget {
     int m_mainWinNumber;
 
     pfs::Frame *m_currentFrame;
+    //! \brief reduced copy of m_currentFrame the previews are computed from
+    pfs::Frame *m_previewFrame;
     float m_autolevelThreshold;
     QScopedPointer<ThresholdWidget> m_thd;
     QScopedPointer<Ui::TonemappingPanel> m_Ui;
@@ -170,6 +172,9 @@ class TonemappingPanel : public QWidget {
    public Q_SLOTS:
     void setEnabled(bool);
     void updatedHDR(pfs::Frame *);
+    //! \brief compute the previews from \a preview, a reduced copy of the
+    //! frame of updatedHDR()
+    void setPreviewFrame(pfs::Frame *preview);
     void updateTonemappingParams(TonemappingOptions *opts);
     void setRealtimePreviews(bool);
     void autoLevels(bool b);
@@ -43,6 +43,7 @@
 #include "Libpfs/array2d.h"
 #include "Libpfs/channel.h"
 #include "Libpfs/frame.h"
+#include "Libpfs/manip/resize.h"
 #include "Libpfs/utils/msec_timer.h"
 #include "Libpfs/utils/sse.h"
 
@@ -204,6 +205,26 @@ RGBMappingType HdrViewer::getLuminanceMappingMethod() {
     return m_mappingMethod;
 }
 
+pfs::Frame *HdrViewer::getPreviewFrame() {
+    if (!mFrame) return NULL;
+    if (m_previewFrame && m_previewSource.lock() == mFrame) {
+        return m_previewFrame.get();
+    }
+
+    m_previewFrame.reset();
+    const size_t factor = mFrame->getWidth() / HDR_PREVIEW_WIDTH;
+    if (factor < 2) return mFrame.get();
+
+    m_previewFrame.reset(pfs::decimate(*mFrame, factor));
+    m_previewSource = mFrame;
+    return m_previewFrame.get();
+}
+
+void HdrViewer::setPreviewFrame(pfs::Frame *preview) {
+    m_previewFrame.reset(preview);
+    m_previewSource = mFrame;
+}
+
 QImage *HdrViewer::mapFrameToImage(pfs::Frame *in_frame) {
     return fromLDRPFStoQImage(in_frame, m_minValue, m_maxValue,
                               m_mappingMethod);
@@ -37,6 +37,7 @@
 #include <QLabel>
 #include <QScopedPointer>
 #include <iostream>
+#include <memory>
 
 #include "GenericViewer.h"
 
@@ -71,6 +72,14 @@ class HdrViewer : public GenericViewer {
 
     RGBMappingType getLuminanceMappingMethod();
 
+    //! \brief reduced copy of the frame, about HDR_PREVIEW_WIDTH pixels wide,
+    //! the previews of the tone mapping operators are computed from. It is
+    //! the frame itself when that is not much wider.
+    pfs::Frame *getPreviewFrame();
+    //! \brief use \a preview (e.g. read by IOWorker::read_hdr_frame()) as
+    //! reduced copy of the current frame. The viewer takes ownership.
+    void setPreviewFrame(pfs::Frame *preview);
+
    public Q_SLOTS:
     void updateRangeWindow();
     int getLumMappingMethod();
@@ -99,6 +108,10 @@ class HdrViewer : public GenericViewer {
     float m_minValue;
     float m_maxValue;
 
+    std::unique_ptr<pfs::Frame> m_previewFrame;
+    //! \brief frame m_previewFrame is a copy of: setFrame() replaces it
+    std::weak_ptr<pfs::Frame> m_previewSource;
+
     QImage *mapFrameToImage(pfs::Frame *in_frame);
 };
 
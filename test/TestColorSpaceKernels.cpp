@@ -0,0 +1,199 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/array2dview.h>
+#include <Libpfs/colorspace/colorspace.h>
+#include <Libpfs/colorspace/kernels.h>
+#include <Libpfs/colorspace/rgb.h>
+#include <Libpfs/colorspace/xyz.h>
+#include <Libpfs/utils/msec_timer.h>
+
+using namespace pfs;
+using namespace pfs::colorspace;
+
+namespace {
+
+const size_t SIZE = 100003;
+
+float sample(size_t idx, size_t channel) {
+    // covers negative values, the linear toe and the power segment
+    return std::sin(idx * 0.37f + channel) * std::exp((idx % 97) * 0.05f - 2.f);
+}
+
+void fill(Array2Df &c1, Array2Df &c2, Array2Df &c3) {
+    for (size_t idx = 0; idx < c1.size(); ++idx) {
+        c1(idx) = sample(idx, 0);
+        c2(idx) = sample(idx, 1);
+        c3(idx) = sample(idx, 2);
+    }
+}
+
+// the error of a matrix product scales with the magnitude of its inputs
+bool near(float expected, float value, float scale) {
+    return std::fabs(expected - value) <= 1e-5f * std::max(1.f, scale);
+}
+
+// restores the best instruction set at the end of each test
+class TestColorSpaceKernels : public ::testing::Test {
+   protected:
+    void TearDown() { setSimdLevel(maxSimdLevel()); }
+};
+}
+
+TEST_F(TestColorSpaceKernels, Transfer)
+{
+    const float identity[3][3] = {{1.f, 0.f, 0.f}, {0.f, 1.f, 0.f},
+                                  {0.f, 0.f, 1.f}};
+    Array2Df c1(SIZE, 1), c2(SIZE, 1), c3(SIZE, 1);
+    fill(c1, c2, c3);
+    Array2Df o1(SIZE, 1), o2(SIZE, 1), o3(SIZE, 1);
+
+    for (int level = SIMD_NONE; level <= maxSimdLevel(); ++level) {
+        setSimdLevel(static_cast<SimdLevel>(level));
+
+        transformMatrix(c1.data(), c2.data(), c3.data(), o1.data(), o2.data(),
+                        o3.data(), SIZE, identity, TRANSFER_SRGB,
+                        TRANSFER_LINEAR);
+        for (size_t idx = 0; idx < SIZE; ++idx) {
+            const float expected = ConvertSRGB2RGB()(c1(idx));
+            ASSERT_NEAR(expected, o1(idx), 1e-6f * std::fabs(expected))
+                << "level " << level << ", sample " << c1(idx);
+        }
+
+        transformMatrix(c1.data(), c2.data(), c3.data(), o1.data(), o2.data(),
+                        o3.data(), SIZE, identity, TRANSFER_LINEAR,
+                        TRANSFER_SRGB);
+        for (size_t idx = 0; idx < SIZE; ++idx) {
+            const float expected = ConvertRGB2SRGB()(c1(idx));
+            ASSERT_NEAR(expected, o1(idx), 1e-6f * std::fabs(expected))
+                << "level " << level << ", sample " << c1(idx);
+        }
+    }
+}
+
+TEST_F(TestColorSpaceKernels, SRGB2XYZ)
+{
+    Array2Df r(SIZE, 1), g(SIZE, 1), b(SIZE, 1);
+    fill(r, g, b);
+    Array2Df x(SIZE, 1), y(SIZE, 1), z(SIZE, 1);
+
+    for (int level = SIMD_NONE; level <= maxSimdLevel(); ++level) {
+        setSimdLevel(static_cast<SimdLevel>(level));
+        transformSRGB2XYZ(&r, &g, &b, &x, &y, &z);
+
+        for (size_t idx = 0; idx < SIZE; ++idx) {
+            float ex, ey, ez;
+            ConvertSRGB2XYZ()(r(idx), g(idx), b(idx), ex, ey, ez);
+            float lr, lg, lb;
+            ConvertSRGB2RGB()(r(idx), g(idx), b(idx), lr, lg, lb);
+            const float scale = std::fabs(lr) + std::fabs(lg) + std::fabs(lb);
+            ASSERT_PRED3(near, ex, x(idx), scale) << "level " << level;
+            ASSERT_PRED3(near, ey, y(idx), scale) << "level " << level;
+            ASSERT_PRED3(near, ez, z(idx), scale) << "level " << level;
+        }
+    }
+}
+
+TEST_F(TestColorSpaceKernels, XYZ2SRGB)
+{
+    Array2Df x(SIZE, 1), y(SIZE, 1), z(SIZE, 1);
+    fill(x, y, z);
+    Array2Df r(SIZE, 1), g(SIZE, 1), b(SIZE, 1);
+
+    for (int level = SIMD_NONE; level <= maxSimdLevel(); ++level) {
+        setSimdLevel(static_cast<SimdLevel>(level));
+        transformXYZ2SRGB(&x, &y, &z, &r, &g, &b);
+
+        for (size_t idx = 0; idx < SIZE; ++idx) {
+            float er, eg, eb;
+            ConvertXYZ2SRGB()(x(idx), y(idx), z(idx), er, eg, eb);
+            const float scale =
+                std::fabs(x(idx)) + std::fabs(y(idx)) + std::fabs(z(idx));
+            ASSERT_PRED3(near, er, r(idx), scale) << "level " << level;
+            ASSERT_PRED3(near, eg, g(idx), scale) << "level " << level;
+            ASSERT_PRED3(near, eb, b(idx), scale) << "level " << level;
+        }
+    }
+}
+
+TEST_F(TestColorSpaceKernels, InPlaceView)
+{
+    // the negative side of the sRGB curve does not round trip: stay in
+    // [0, 1], where the inverse of the matrices is accurate enough
+    Array2Df r(301, 207), g(301, 207), b(301, 207);
+    fill(r, g, b);
+    for (size_t idx = 0; idx < r.size(); ++idx) {
+        r(idx) = std::min(std::fabs(r(idx)), 1.f);
+        g(idx) = std::min(std::fabs(g(idx)), 1.f);
+        b(idx) = std::min(std::fabs(b(idx)), 1.f);
+    }
+    Array2Df x(100, 50), y(100, 50), z(100, 50);
+
+    transformColorSpace(CS_SRGB, Array2DConstViewf(r, 7, 11, 100, 50),
+                        Array2DConstViewf(g, 7, 11, 100, 50),
+                        Array2DConstViewf(b, 7, 11, 100, 50), CS_XYZ, &x, &y,
+                        &z);
+    // and back again, in place
+    transformXYZ2SRGB(&x, &y, &z, &x, &y, &z);
+
+    for (size_t row = 0; row < 50; ++row) {
+        for (size_t col = 0; col < 100; ++col) {
+            ASSERT_NEAR(r(col + 7, row + 11), x(col, row), 1e-4f);
+            ASSERT_NEAR(g(col + 7, row + 11), y(col, row), 1e-4f);
+            ASSERT_NEAR(b(col + 7, row + 11), z(col, row), 1e-4f);
+        }
+    }
+}
+
+// run with --gtest_also_run_disabled_tests
+TEST_F(TestColorSpaceKernels, DISABLED_Benchmark)
+{
+    const size_t size = 8192 * 4096;
+    Array2Df c1(size, 1), c2(size, 1), c3(size, 1);
+    fill(c1, c2, c3);
+    Array2Df o1(size, 1), o2(size, 1), o3(size, 1);
+
+    msec_timer t;
+    t.start();
+    for (size_t idx = 0; idx < size; ++idx) {
+        ConvertXYZ2SRGB()(c1(idx), c2(idx), c3(idx), o1(idx), o2(idx), o3(idx));
+    }
+    t.stop_and_update();
+    std::cout << "XYZ -> sRGB, scalar functor: " << t.get_time() << " ms"
+              << std::endl;
+
+    for (int level = SIMD_NONE; level <= maxSimdLevel(); ++level) {
+        setSimdLevel(static_cast<SimdLevel>(level));
+        t.reset();
+        t.start();
+        transformXYZ2SRGB(&c1, &c2, &c3, &o1, &o2, &o3);
+        t.stop_and_update();
+        std::cout << "XYZ -> sRGB, level " << level << ": " << t.get_time()
+                  << " ms" << std::endl;
+    }
+}
@@ -0,0 +1,399 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <ImfChannelList.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfTiledInputFile.h>
+#include <OpenEXRConfig.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/io/exrreader.h>
+#include <Libpfs/io/exrwriter.h>
+#include <Libpfs/io/framereader.h>
+#include <Libpfs/io/ioexception.h>
+#include <Libpfs/manip/resize.h>
+#include <Libpfs/utils/half.h>
+
+#include "TestHelpers.h"
+
+using namespace pfs;
+using namespace pfs::io;
+
+namespace {
+
+// more than one strip of the writer and of the reader, and not a multiple
+// of the tile size: 10 mipmap levels
+const size_t WIDTH = 1000;
+const size_t HEIGHT = 611;
+
+const char *const NAMES[] = {"X", "Y", "Z"};
+
+struct Compression {
+    const char *name;
+    Imf::Compression compression;
+    // lossy for float channels
+    bool lossyFloat;
+    // lossy for half channels
+    bool lossyHalf;
+};
+
+const Compression COMPRESSIONS[] = {
+    {"none", Imf::NO_COMPRESSION, false, false},
+    {"rle", Imf::RLE_COMPRESSION, false, false},
+    {"zips", Imf::ZIPS_COMPRESSION, false, false},
+    {"zip", Imf::ZIP_COMPRESSION, false, false},
+    {"piz", Imf::PIZ_COMPRESSION, false, false},
+    // 24-bit floats
+    {"pxr24", Imf::PXR24_COMPRESSION, true, false},
+    // B44 and DWA only compress half channels
+    {"b44", Imf::B44_COMPRESSION, false, true},
+    {"b44a", Imf::B44A_COMPRESSION, false, true},
+#if OPENEXR_VERSION_MAJOR > 2 || \
+    (OPENEXR_VERSION_MAJOR == 2 && OPENEXR_VERSION_MINOR >= 2)
+    {"dwaa", Imf::DWAA_COMPRESSION, false, true},
+    {"dwab", Imf::DWAB_COMPRESSION, false, true},
+#endif
+};
+
+//! \brief \a frame with every sample rounded to a 16-bit float
+void roundToHalf(Frame &frame) {
+    for (int c = 0; c < 3; ++c) {
+        Channel *ch = frame.getChannel(NAMES[c]);
+        for (size_t idx = 0; idx < ch->size(); ++idx) {
+            (*ch)(idx) = utils::halfToFloat(utils::floatToHalf((*ch)(idx)));
+        }
+    }
+}
+
+// \a frame against \a expected, within \a tolerance of each sample
+void expectNear(const Frame &expected, const Frame &frame, float tolerance) {
+    ASSERT_EQ(expected.getWidth(), frame.getWidth());
+    ASSERT_EQ(expected.getHeight(), frame.getHeight());
+
+    for (int c = 0; c < 3; ++c) {
+        const Channel *a = expected.getChannel(NAMES[c]);
+        const Channel *b = frame.getChannel(NAMES[c]);
+        ASSERT_TRUE(a != NULL);
+        ASSERT_TRUE(b != NULL);
+        for (size_t idx = 0; idx < a->size(); ++idx) {
+            ASSERT_NEAR((*a)(idx), (*b)(idx),
+                        tolerance * std::fabs((*a)(idx)))
+                << NAMES[c] << " " << idx;
+        }
+    }
+}
+
+// mean absolute difference of the samples of \a frame and \a expected
+double meanError(const Frame &expected, const Frame &frame) {
+    EXPECT_EQ(expected.getWidth(), frame.getWidth());
+    EXPECT_EQ(expected.getHeight(), frame.getHeight());
+
+    double sum = 0.;
+    size_t count = 0;
+    for (int c = 0; c < 3; ++c) {
+        const Channel *a = expected.getChannel(NAMES[c]);
+        const Channel *b = frame.getChannel(NAMES[c]);
+        for (size_t idx = 0; idx < a->size() && idx < b->size(); ++idx) {
+            sum += std::fabs((*a)(idx) - (*b)(idx));
+            ++count;
+        }
+    }
+    return count ? sum / count : 0.;
+}
+
+// the rectangle (\a x, \a y, \a cols, \a rows) of \a frame
+void expectRegion(const Frame &frame, const Frame &roi, size_t x, size_t y,
+                  size_t cols, size_t rows) {
+    ASSERT_EQ(cols, roi.getWidth());
+    ASSERT_EQ(rows, roi.getHeight());
+
+    for (int c = 0; c < 3; ++c) {
+        const Channel *a = frame.getChannel(NAMES[c]);
+        const Channel *b = roi.getChannel(NAMES[c]);
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t i = 0; i < cols; ++i) {
+                ASSERT_EQ((*a)(x + i, y + r), (*b)(i, r))
+                    << NAMES[c] << " (" << i << ", " << r << ")";
+            }
+        }
+    }
+}
+
+Params roiParams(size_t x, size_t y, size_t cols, size_t rows) {
+    return Params("roi_x", x)("roi_y", y)("roi_width", cols)("roi_height",
+                                                              rows);
+}
+
+// the levels the writer builds: each one the previous one averaged over
+// blocks of 2x2 pixels
+std::unique_ptr<Frame> level(const Frame &frame, int count) {
+    std::unique_ptr<Frame> result(decimate(frame, 1));
+    for (int l = 0; l < count; ++l) {
+        result.reset(decimate(*result, 2));
+    }
+    return result;
+}
+}
+
+TEST(TestEXR, Compressions)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+    Frame halfFrame(WIDTH, HEIGHT);
+    fillFrame(halfFrame);
+    roundToHalf(halfFrame);
+
+    for (size_t i = 0; i < sizeof(COMPRESSIONS) / sizeof(COMPRESSIONS[0]);
+         ++i) {
+        const Compression &compression = COMPRESSIONS[i];
+        for (int half = 0; half <= 1; ++half) {
+            SCOPED_TRACE(std::string(compression.name) +
+                         (half ? ", half" : ", float"));
+
+            const Params params =
+                Params("exr_compression", std::string(compression.name))(
+                    "exr_half", half != 0)("threads", 4);
+            TempFile file("TestEXR_compression.exr");
+            ASSERT_TRUE(EXRWriter(file.name()).write(frame, params));
+
+            {
+                Imf::InputFile in(file.name().c_str());
+                EXPECT_EQ(compression.compression, in.header().compression());
+                EXPECT_EQ(half ? Imf::HALF : Imf::FLOAT,
+                          in.header().channels().findChannel("R")->type);
+            }
+
+            Frame read;
+            EXRReader(file.name()).read(read, Params());
+            const Frame &expected = half ? halfFrame : frame;
+            const bool lossy =
+                half ? compression.lossyHalf : compression.lossyFloat;
+            if (!lossy) {
+                expectNear(expected, read, 0.f);
+            } else if (!half) {
+                // 15 bits of mantissa are left
+                expectNear(expected, read, 1e-4f);
+            } else {
+                EXPECT_LT(meanError(expected, read), 0.02);
+            }
+        }
+    }
+}
+
+TEST(TestEXR, UnknownCompression)
+{
+    Frame frame(16, 16);
+    fillFrame(frame);
+
+    TempFile file("TestEXR_unknown.exr");
+    const Params params("exr_compression", std::string("lz4"));
+    EXPECT_THROW(EXRWriter(file.name()).write(frame, params), WriteException);
+}
+
+TEST(TestEXR, HalfStorage)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+    Frame expected(WIDTH, HEIGHT);
+    fillFrame(expected);
+    roundToHalf(expected);
+
+    TempFile file("TestEXR_half.exr");
+    ASSERT_TRUE(EXRWriter(file.name()).write(frame, Params("exr_half", true)));
+
+    FrameInfo info;
+    EXRReader(file.name()).probe(info);
+    EXPECT_EQ(SAMPLE_HALF, info.sampleType);
+
+    // held frames keep the 16-bit samples of the file as they are: the
+    // accessors unpack them
+    Frame packed;
+    EXRReader(file.name()).read(packed, Params("half_storage", true));
+    EXPECT_TRUE(packed.isPacked());
+    expectNear(expected, packed, 0.f);
+
+    Frame read;
+    EXRReader(file.name()).read(read, Params());
+    EXPECT_FALSE(read.isPacked());
+    expectNear(expected, read, 0.f);
+}
+
+TEST(TestEXR, Threads)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+
+    // the same file whatever the threads writing it
+    TempFile serial("TestEXR_serial.exr");
+    TempFile parallel("TestEXR_parallel.exr");
+    ASSERT_TRUE(EXRWriter(serial.name()).write(frame, Params("threads", 0)));
+    ASSERT_TRUE(
+        EXRWriter(parallel.name()).write(frame, Params("threads", 4)));
+
+    Frame read0, read4;
+    EXRReader(serial.name()).read(read0, Params("threads", 0));
+    EXRReader(parallel.name()).read(read4, Params("threads", 4));
+    expectNear(frame, read0, 0.f);
+    expectNear(frame, read4, 0.f);
+}
+
+TEST(TestEXR, MipmapLevels)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+
+    for (int half = 0; half <= 1; ++half) {
+        SCOPED_TRACE(half ? "half" : "float");
+
+        TempFile file("TestEXR_mipmap.exr");
+        ASSERT_TRUE(EXRWriter(file.name())
+                        .write(frame, Params("exr_mipmap", true)(
+                                          "exr_half", half != 0)));
+        EXPECT_TRUE(EXRReader(file.name()).hasScaledLevels());
+
+        // ROUND_DOWN: floor(log2(1000)) + 1 levels
+        int levels = 0;
+        {
+            Imf::TiledInputFile in(file.name().c_str());
+            EXPECT_EQ(Imf::MIPMAP_LEVELS, in.header().tileDescription().mode);
+            levels = in.numLevels();
+            EXPECT_EQ(10, levels);
+            for (int l = 0; l < levels; ++l) {
+                EXPECT_EQ(std::max<size_t>(1, WIDTH >> l),
+                          static_cast<size_t>(in.levelWidth(l)));
+                EXPECT_EQ(std::max<size_t>(1, HEIGHT >> l),
+                          static_cast<size_t>(in.levelHeight(l)));
+            }
+        }
+
+        // level 0 is the image, read through the scanline interface
+        Frame full;
+        EXRReader(file.name()).read(full, Params());
+        std::unique_ptr<Frame> expected(level(frame, 0));
+        if (half) roundToHalf(*expected);
+        expectNear(*expected, full, 0.f);
+
+        // a target width of WIDTH >> l loads level l as it is
+        for (int l = 1; l < levels; ++l) {
+            SCOPED_TRACE(l);
+            Frame read;
+            EXRReader(file.name())
+                .read(read, Params("target_width", WIDTH >> l));
+            expected = level(frame, l);
+            if (half) roundToHalf(*expected);
+            expectNear(*expected, read, 1e-6f);
+        }
+    }
+}
+
+TEST(TestEXR, RegionOfInterest)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+
+    for (int half = 0; half <= 1; ++half) {
+        SCOPED_TRACE(half ? "half" : "float");
+
+        // zip and piz store blocks of 16 and 32 scanlines
+        const char *compressions[] = {"zip", "piz"};
+        for (int i = 0; i < 2; ++i) {
+            const Params params =
+                Params("exr_compression", std::string(compressions[i]))(
+                    "exr_half", half != 0);
+            TempFile file("TestEXR_roi.exr");
+            ASSERT_TRUE(EXRWriter(file.name()).write(frame, params));
+            Frame full;
+            EXRReader(file.name()).read(full, Params());
+
+            // full width, narrow and crossing the strips of 256 rows
+            const size_t rects[][4] = {{0, 100, WIDTH, 300},
+                                       {37, 250, 211, 20},
+                                       {900, 5, 100, 606},
+                                       {999, 610, 1, 1}};
+            for (size_t r = 0; r < 4; ++r) {
+                SCOPED_TRACE(r);
+                const size_t *rect = rects[r];
+                Frame roi;
+                EXRReader(file.name())
+                    .read(roi, roiParams(rect[0], rect[1], rect[2], rect[3]));
+                expectRegion(full, roi, rect[0], rect[1], rect[2], rect[3]);
+
+                // half files held as they are
+                Frame packed;
+                EXRReader(file.name())
+                    .read(packed, roiParams(rect[0], rect[1], rect[2],
+                                            rect[3])("half_storage", true));
+                EXPECT_EQ(half != 0, packed.isPacked());
+                expectRegion(full, packed, rect[0], rect[1], rect[2],
+                             rect[3]);
+            }
+
+            // decimated while decoding
+            Frame decimated;
+            EXRReader(file.name())
+                .read(decimated,
+                      roiParams(37, 250, 400, 300)("target_width", 100));
+            Frame roi;
+            EXRReader(file.name()).read(roi, roiParams(37, 250, 400, 300));
+            std::unique_ptr<Frame> expected(decimate(roi, 4));
+            expectNear(*expected, decimated, 1e-5f);
+        }
+    }
+}
+
+TEST(TestEXR, MipmapRegionOfInterest)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+
+    TempFile file("TestEXR_mipmap_roi.exr");
+    ASSERT_TRUE(
+        EXRWriter(file.name()).write(frame, Params("exr_mipmap", true)));
+
+    // level 1, 500 x 305: tiles of 64 pixels
+    Frame level1;
+    EXRReader(file.name()).read(level1, Params("target_width", WIDTH / 2));
+    ASSERT_EQ(WIDTH / 2, level1.getWidth());
+
+    // aligned on the tiles, across tile edges and on the last tiles
+    const size_t rects[][4] = {{128, 64, 128, 128},
+                               {100, 50, 150, 90},
+                               {60, 250, 440, 55},
+                               {499, 304, 1, 1}};
+    for (size_t r = 0; r < 4; ++r) {
+        SCOPED_TRACE(r);
+        const size_t *rect = rects[r];
+        // the region is given at full resolution
+        Frame roi;
+        EXRReader(file.name())
+            .read(roi, roiParams(2 * rect[0], 2 * rect[1], 2 * rect[2],
+                                 2 * rect[3])("target_width", rect[2]));
+        expectRegion(level1, roi, rect[0], rect[1], rect[2], rect[3]);
+    }
+}
@@ -0,0 +1,148 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include <HdrCreation/feature_alignment.h>
+#include <Libpfs/channel.h>
+#include <Libpfs/frame.h>
+
+using namespace libhdr;
+
+namespace {
+
+const int WIDTH = 480;
+const int HEIGHT = 360;
+
+struct Rect {
+    int x0, y0, x1, y1;
+    float value;
+};
+
+// random overlapping rectangles: plenty of sharp corners to register
+std::vector<Rect> makeScene(unsigned int seed) {
+    srand(seed);
+    std::vector<Rect> scene;
+    for (int i = 0; i < 300; ++i) {
+        Rect r;
+        r.x0 = rand() % WIDTH - 20;
+        r.y0 = rand() % HEIGHT - 20;
+        r.x1 = r.x0 + 8 + rand() % 40;
+        r.y1 = r.y0 + 8 + rand() % 40;
+        r.value = 0.05f + 0.9f * (rand() % 1000) / 1000.f;
+        scene.push_back(r);
+    }
+    return scene;
+}
+
+float sceneAt(const std::vector<Rect> &scene, int x, int y) {
+    float v = 0.02f;
+    for (size_t i = 0; i < scene.size(); ++i) {
+        const Rect &r = scene[i];
+        if (x >= r.x0 && x < r.x1 && y >= r.y0 && y < r.y1) v = r.value;
+    }
+    return v;
+}
+
+// exposure of the scene translated by (dx, dy)
+pfs::FramePtr makeFrame(const std::vector<Rect> &scene, int dx, int dy,
+                        float exposure) {
+    pfs::FramePtr frame = std::make_shared<pfs::Frame>(WIDTH, HEIGHT);
+    pfs::Channel *X, *Y, *Z;
+    frame->createXYZChannels(X, Y, Z);
+    for (int y = 0; y < HEIGHT; ++y) {
+        for (int x = 0; x < WIDTH; ++x) {
+            const float v = exposure * sceneAt(scene, x - dx, y - dy);
+            (*X)(x, y) = v;
+            (*Y)(x, y) = v;
+            (*Z)(x, y) = v;
+        }
+    }
+    return frame;
+}
+
+// mean absolute difference between the middle of \a frame scaled back by
+// \a exposure and the middle of \a reference
+float meanDifference(const pfs::Frame &frame, float exposure,
+                     const pfs::Frame &reference) {
+    const pfs::Channel *X, *Y, *Z;
+    frame.getXYZChannels(X, Y, Z);
+    const pfs::Channel *RX, *RY, *RZ;
+    reference.getXYZChannels(RX, RY, RZ);
+
+    const int border = 40;
+    double sum = 0.;
+    long count = 0;
+    for (int y = border; y < HEIGHT - border; ++y) {
+        for (int x = border; x < WIDTH - border; ++x) {
+            sum += std::fabs((*Y)(x, y) / exposure - (*RY)(x, y));
+            ++count;
+        }
+    }
+    return static_cast<float>(sum / count);
+}
+}
+
+TEST(TestFeatureAlignment, RecoversShifts) {
+    const std::vector<Rect> scene = makeScene(7);
+
+    std::vector<pfs::FramePtr> frames;
+    frames.push_back(makeFrame(scene, 9, -6, 0.25f));
+    frames.push_back(makeFrame(scene, 0, 0, 1.f));
+    frames.push_back(makeFrame(scene, -12, 5, 4.f));
+
+    const float before0 = meanDifference(*frames[0], 0.25f, *frames[1]);
+    const float before2 = meanDifference(*frames[2], 4.f, *frames[1]);
+
+    EXPECT_EQ(feature_alignment(frames), 0u);
+
+    const float after0 = meanDifference(*frames[0], 0.25f, *frames[1]);
+    const float after2 = meanDifference(*frames[2], 4.f, *frames[1]);
+
+    EXPECT_LT(after0, 0.01f);
+    EXPECT_LT(after2, 0.01f);
+    EXPECT_LT(after0, 0.1f * before0);
+    EXPECT_LT(after2, 0.1f * before2);
+}
+
+TEST(TestFeatureAlignment, AlignedFramesAreUntouched) {
+    const std::vector<Rect> scene = makeScene(11);
+
+    std::vector<pfs::FramePtr> frames;
+    frames.push_back(makeFrame(scene, 0, 0, 0.5f));
+    frames.push_back(makeFrame(scene, 0, 0, 1.f));
+
+    EXPECT_EQ(feature_alignment(frames), 0u);
+    EXPECT_LT(meanDifference(*frames[0], 0.5f, *frames[1]), 0.01f);
+}
+
+TEST(TestFeatureAlignment, FlatFramesCannotBeRegistered) {
+    std::vector<pfs::FramePtr> frames;
+    const std::vector<Rect> empty;
+    frames.push_back(makeFrame(empty, 0, 0, 1.f));
+    frames.push_back(makeFrame(empty, 0, 0, 2.f));
+
+    EXPECT_EQ(feature_alignment(frames), 1u);
+}
@@ -21,14 +21,34 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
 #include <Libpfs/array2d.h>
 #include <Libpfs/frame.h>
+#include <Libpfs/manip/copy.h>
 
 #include "SeqInt.h"
 #include "CompareVector.h"
 
 using namespace pfs;
 
+namespace {
+// directory of the scratch files: $TMPDIR (%TEMP% on Windows), or the
+// system default
+std::string scratchDir() {
+#ifdef _WIN32
+    const char *dir = std::getenv("TEMP");
+    return (dir != NULL && *dir != '\0') ? dir : ".";
+#else
+    const char *dir = std::getenv("TMPDIR");
+    return (dir != NULL && *dir != '\0') ? dir : P_tmpdir;
+#endif
+}
+}
+
 TEST(TestArray2D, Resize1)
 {
     Array2Df array(100, 200);
@@ -126,3 +146,236 @@ TEST(TestArray2D, Ctor)
         compareVectors(array2d_v2.data(), array2d_2.data(), array2d.size());
     }
 }
+
+TEST(TestArray2D, Alignment)
+{
+    Array2Df array(127, 33);
+    EXPECT_EQ(reinterpret_cast<size_t>(array.data()) %
+              pfs::utils::BUFFER_ALIGNMENT, 0u);
+
+    Array2Df array2(1, 1, pfs::uninitialized);
+    EXPECT_EQ(reinterpret_cast<size_t>(array2.data()) %
+              pfs::utils::BUFFER_ALIGNMENT, 0u);
+}
+
+TEST(TestArray2D, ZeroInitialized)
+{
+    Array2Df array(300, 200);
+    std::fill(array.begin(), array.end(), 1.f);
+
+    // grow within the current allocation: the new elements are zero
+    array.resize(100, 100);
+    array.resize(300, 200);
+    for (size_t idx = 0; idx < 100 * 100; ++idx) {
+        EXPECT_EQ(array(idx), 1.f);
+    }
+    for (size_t idx = 100 * 100; idx < array.size(); ++idx) {
+        EXPECT_EQ(array(idx), 0.f);
+    }
+}
+
+TEST(TestArray2D, PoolRecycle)
+{
+    using pfs::utils::BufferPool;
+
+    BufferPool& pool = BufferPool::instance();
+    pool.clear();
+
+    float* d1 = NULL;
+    {
+        Array2Df array(1000, 1000, pfs::uninitialized);
+        d1 = array.data();
+    }
+    EXPECT_GE(pool.cachedBytes(), 1000 * 1000 * sizeof(float));
+
+    // same size class: the block is reused and zeroed
+    Array2Df array(1000, 999);
+    EXPECT_EQ(array.data(), d1);
+    EXPECT_EQ(*std::max_element(array.begin(), array.end()), 0.f);
+    EXPECT_EQ(pool.cachedBytes(), 0u);
+
+    pool.clear();
+}
+
+TEST(TestArray2D, PoolMaxCachedBytes)
+{
+    using pfs::utils::BufferPool;
+
+    BufferPool& pool = BufferPool::instance();
+    pool.clear();
+    {
+        Array2Df a1(1000, 1000, pfs::uninitialized);
+        Array2Df a2(500, 500, pfs::uninitialized);
+    }
+    const size_t cached = pool.cachedBytes();
+    EXPECT_GE(cached, 1250 * 1000 * sizeof(float));
+
+    // lowering the bound trims the free lists right away
+    pool.setMaxCachedBytes(cached / 2);
+    EXPECT_LE(pool.cachedBytes(), cached / 2);
+
+    // and keeps them from growing past it
+    pool.setMaxCachedBytes(0);
+    EXPECT_EQ(pool.cachedBytes(), 0u);
+    {
+        Array2Df a1(1000, 1000, pfs::uninitialized);
+    }
+    EXPECT_EQ(pool.cachedBytes(), 0u);
+
+    pool.setMaxCachedBytes(BufferPool::DEFAULT_MAX_CACHED_BYTES);
+    pool.clear();
+}
+
+TEST(TestArray2D, PoolSizeClass)
+{
+    using pfs::utils::BufferPool;
+
+    EXPECT_EQ(BufferPool::sizeClass(100), 100u);
+    EXPECT_EQ(BufferPool::sizeClass(BufferPool::MIN_POOLED_SIZE),
+              BufferPool::MIN_POOLED_SIZE);
+
+    const size_t sizes[] = {70000, 1000000, 4000000, 24000000};
+    for (size_t idx = 0; idx < 4; ++idx) {
+        const size_t s = BufferPool::sizeClass(sizes[idx]);
+        EXPECT_GE(s, sizes[idx]);
+        EXPECT_LE(s, sizes[idx] + sizes[idx] / 8);
+        EXPECT_EQ(BufferPool::sizeClass(s), s);
+    }
+}
+
+TEST(TestArray2D, MappedStorage)
+{
+    using pfs::utils::BufferPool;
+
+    BufferPool &pool = BufferPool::instance();
+    pool.clear();
+    pool.setMapThreshold(1024 * 1024, scratchDir());
+    {
+        Array2Df array(1000, 1000);
+        EXPECT_TRUE(pool.isMapped(array.data()));
+        EXPECT_GE(pool.mappedBytes(), 1000 * 1000 * sizeof(float));
+        EXPECT_EQ(*std::max_element(array.begin(), array.end()), 0.f);
+
+        std::fill(array.begin(), array.end(), 3.f);
+        Array2Df copy(array);
+        EXPECT_TRUE(pool.isMapped(copy.data()));
+        EXPECT_EQ(copy(999, 999), 3.f);
+
+        // below the threshold: RAM
+        Array2Df small(100, 100);
+        EXPECT_FALSE(pool.isMapped(small.data()));
+    }
+    // mapped blocks are not cached
+    EXPECT_EQ(pool.mappedBytes(), 0u);
+    EXPECT_EQ(pool.cachedBytes(), 0u);
+
+    pool.setMapThreshold(0, std::string());
+    Array2Df array(1000, 1000);
+    EXPECT_FALSE(pool.isMapped(array.data()));
+    pool.clear();
+}
+
+TEST(TestFrame, CopyOnWrite)
+{
+    pfs::Frame source(64, 32);
+    pfs::Channel *X;
+    pfs::Channel *Y;
+    pfs::Channel *Z;
+    source.createXYZChannels(X, Y, Z);
+    source.createChannel("A");
+    std::fill(Y->begin(), Y->end(), 1.f);
+
+    // nothing of this copy has been handed out for writing
+    pfs::Frame frame(source);
+    pfs::Frame copy(frame);
+    const pfs::Frame &cframe = frame;
+    const pfs::Frame &ccopy = copy;
+    Y = const_cast<pfs::Channel *>(cframe.getChannel("Y"));
+
+    // const access never duplicates the pixels
+    EXPECT_EQ(ccopy.getChannel("Y")->data(), Y->data());
+    EXPECT_TRUE(frame.isChannelShared("Y"));
+    EXPECT_TRUE(copy.isChannelShared("A"));
+
+    // write access duplicates only the requested channels
+    pfs::Channel *cX;
+    pfs::Channel *cY;
+    pfs::Channel *cZ;
+    copy.getXYZChannels(cX, cY, cZ);
+    EXPECT_NE(cY->data(), Y->data());
+    EXPECT_FALSE(frame.isChannelShared("Y"));
+    EXPECT_FALSE(copy.isChannelShared("Y"));
+    EXPECT_TRUE(copy.isChannelShared("A"));
+    EXPECT_EQ(ccopy.getChannel("A")->data(), cframe.getChannel("A")->data());
+
+    std::fill(cY->begin(), cY->end(), 2.f);
+    EXPECT_EQ((*Y)(10, 10), 1.f);
+    EXPECT_EQ((*cY)(10, 10), 2.f);
+
+    // the XYZ cache follows the detached channels
+    const pfs::Channel *kX;
+    const pfs::Channel *kY;
+    const pfs::Channel *kZ;
+    ccopy.getXYZChannels(kX, kY, kZ);
+    EXPECT_EQ(kY, cY);
+}
+
+TEST(TestFrame, CopyOnWriteRelease)
+{
+    pfs::Frame source(16, 16);
+    source.createChannel("Y");
+    pfs::Frame *frame = new pfs::Frame(source);
+    const float *data =
+        static_cast<const pfs::Frame *>(frame)->getChannel("Y")->data();
+
+    pfs::Frame copy(*frame);
+    EXPECT_TRUE(copy.isChannelShared("Y"));
+    delete frame;
+
+    // the last owner writes in place
+    EXPECT_FALSE(copy.isChannelShared("Y"));
+    EXPECT_EQ(copy.getChannel("Y")->data(), data);
+}
+
+TEST(TestFrame, CopyOfWrittenFrame)
+{
+    pfs::Frame frame(16, 16);
+    pfs::Channel *Y = frame.createChannel("Y");
+    std::fill(Y->begin(), Y->end(), 1.f);
+
+    // Y may still be written: the copy gets its own pixels
+    pfs::Frame copy(frame);
+    EXPECT_FALSE(copy.isChannelShared("Y"));
+    std::fill(Y->begin(), Y->end(), 2.f);
+    const pfs::Frame &ccopy = copy;
+    EXPECT_EQ((*ccopy.getChannel("Y"))(5, 5), 1.f);
+
+    // a copy of the copy shares: nothing was handed out for writing
+    pfs::Frame second(copy);
+    EXPECT_TRUE(second.isChannelShared("Y"));
+}
+
+TEST(TestFrame, DeepCopy)
+{
+    pfs::Frame frame(100, 100);
+    pfs::Channel *X;
+    pfs::Channel *Y;
+    pfs::Channel *Z;
+    frame.createXYZChannels(X, Y, Z);
+    std::fill(Y->begin(), Y->end(), 3.f);
+    frame.getTags().setTag("TAG", "value");
+
+    // the working copies of the tone mapping operators
+    std::unique_ptr<pfs::Frame> copy(pfs::copy(&frame));
+    const pfs::Frame &cframe = frame;
+    const pfs::Frame &ccopy = *copy;
+    const pfs::ChannelContainer &in = cframe.getChannels();
+    const pfs::ChannelContainer &out = ccopy.getChannels();
+    ASSERT_EQ(in.size(), out.size());
+    for (size_t idx = 0; idx < in.size(); ++idx) {
+        EXPECT_NE(in[idx]->data(), out[idx]->data());
+        EXPECT_FALSE(copy->isChannelShared(in[idx]->getName()));
+    }
+    EXPECT_EQ((*ccopy.getChannel("Y"))(50, 50), 3.f);
+    EXPECT_EQ(ccopy.getTags().getTag("TAG"), "value");
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <Libpfs/io/framereaderfactory.h>
+
+#include "TestHelpers.h"
+
+using namespace pfs::io;
+
+namespace {
+
+// header of a 4x3 PFS file with 3 channels (no pixels: probe must not need
+// them)
+const char PFS_HEADER[] = "PFS1\x0a" "4 3\x0a" "3\x0a";
+}
+
+TEST(TestFrameReaderProbe, Sniff)
+{
+    const char exr[] = "\x76\x2f\x31\x01\x02\0\0\0";
+    const char jpeg[] = "\xff\xd8\xff\xe0\0\x10JFIF";
+    const char tiff[] = "II*\0\x08\0\0\0";
+    const char hdr[] = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n";
+    const char crw[] = "II\x1a\0\0\0HEAPCCDR";
+    const char unknown[] = "hello world";
+
+    EXPECT_EQ("exr", FrameReaderFactory::sniffFormat(
+                         TempFile("sniff.exr", exr, 8).name()));
+    EXPECT_EQ("jpeg", FrameReaderFactory::sniffFormat(
+                          TempFile("sniff.jpg", jpeg, 10).name()));
+    EXPECT_EQ("tiff", FrameReaderFactory::sniffFormat(
+                          TempFile("sniff.tif", tiff, 8).name()));
+    EXPECT_EQ("hdr", FrameReaderFactory::sniffFormat(
+                         TempFile("sniff.hdr", hdr, sizeof(hdr) - 1).name()));
+    EXPECT_EQ("raw", FrameReaderFactory::sniffFormat(
+                         TempFile("sniff.crw", crw, 14).name()));
+    EXPECT_EQ("pfs", FrameReaderFactory::sniffFormat(
+                         TempFile("sniff.pfs", PFS_HEADER,
+                                  sizeof(PFS_HEADER) - 1).name()));
+    EXPECT_EQ("", FrameReaderFactory::sniffFormat(
+                      TempFile("sniff.txt", unknown, 11).name()));
+    // too short for any signature
+    EXPECT_EQ("", FrameReaderFactory::sniffFormat(
+                      TempFile("sniff.jpg", jpeg, 2).name()));
+    EXPECT_EQ("", FrameReaderFactory::sniffFormat("does_not_exist.exr"));
+}
+
+TEST(TestFrameReaderProbe, MisnamedFile)
+{
+    // a PFS file with a JPEG extension goes to the PFS reader
+    TempFile file("misnamed.jpg", PFS_HEADER, sizeof(PFS_HEADER) - 1);
+
+    FrameInfo info = FrameReaderFactory::probe(file.name());
+    EXPECT_EQ("pfs", info.format);
+    EXPECT_EQ(4u, info.width);
+    EXPECT_EQ(3u, info.height);
+    EXPECT_EQ(3u, info.channels);
+    EXPECT_EQ(SAMPLE_FLOAT, info.sampleType);
+    EXPECT_EQ(4u * 3u * 3u * sizeof(float), info.frameBytes());
+
+    FrameReaderPtr reader = FrameReaderFactory::open(file.name());
+    EXPECT_EQ(4u, reader->width());
+}
+
+TEST(TestFrameReaderProbe, Unsupported)
+{
+    TempFile file("unsupported.xyz", "hello world", 11);
+    EXPECT_THROW(FrameReaderFactory::probe(file.name()), UnsupportedFormat);
+}
@@ -0,0 +1,138 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/io/exrreader.h>
+#include <Libpfs/io/exrwriter.h>
+#include <Libpfs/io/pfsreader.h>
+#include <Libpfs/io/pfswriter.h>
+#include <Libpfs/manip/resize.h>
+
+#include "TestHelpers.h"
+
+using namespace pfs;
+using namespace pfs::io;
+
+namespace {
+
+const size_t WIDTH = 320;
+const size_t HEIGHT = 200;
+// a quarter of WIDTH: mipmap level 2
+const size_t TARGET_WIDTH = 80;
+
+void fillRamps(Frame &frame) {
+    Channel *X, *Y, *Z;
+    frame.createXYZChannels(X, Y, Z);
+    for (size_t y = 0; y < HEIGHT; ++y) {
+        for (size_t x = 0; x < WIDTH; ++x) {
+            (*X)(x, y) = 0.1f + 0.03f * static_cast<float>((x * 7 + y) % 301);
+            (*Y)(x, y) = 0.1f + 0.05f * static_cast<float>((x + y * 3) % 97);
+            (*Z)(x, y) = 0.1f + 0.02f * static_cast<float>((x ^ y) % 211);
+        }
+    }
+}
+
+// \a frame against \a expected, within \a tolerance of each sample
+void expectNear(const Frame &expected, const Frame &frame, float tolerance) {
+    ASSERT_EQ(expected.getWidth(), frame.getWidth());
+    ASSERT_EQ(expected.getHeight(), frame.getHeight());
+
+    const char *names[] = {"X", "Y", "Z"};
+    for (size_t c = 0; c < 3; ++c) {
+        const Channel *a = expected.getChannel(names[c]);
+        const Channel *b = frame.getChannel(names[c]);
+        ASSERT_TRUE(a != NULL);
+        ASSERT_TRUE(b != NULL);
+        for (size_t idx = 0; idx < a->size(); ++idx) {
+            ASSERT_NEAR((*a)(idx), (*b)(idx),
+                        tolerance * std::fabs((*a)(idx)))
+                << names[c] << " " << idx;
+        }
+    }
+}
+
+// readScaled() of \a filename against the decimated full read. Readers are
+// not required to read a file twice: each read gets its own
+template <typename Reader>
+void checkScaledRead(const std::string &filename, float tolerance) {
+    Frame full;
+    Reader(filename).read(full, Params());
+    ASSERT_EQ(WIDTH, full.getWidth());
+    std::unique_ptr<Frame> expected(decimate(full, WIDTH / TARGET_WIDTH));
+
+    Frame scaled;
+    Reader(filename).readScaled(scaled, TARGET_WIDTH, Params());
+    EXPECT_EQ(TARGET_WIDTH, scaled.getWidth());
+    EXPECT_EQ(HEIGHT * TARGET_WIDTH / WIDTH, scaled.getHeight());
+    expectNear(*expected, scaled, tolerance);
+}
+}
+
+TEST(TestFrameReaderScaled, Pfs) {
+    TempFile file("scaled.pfs");
+    Frame frame(WIDTH, HEIGHT);
+    fillRamps(frame);
+    PfsWriter(file.name()).write(frame, Params());
+
+    EXPECT_FALSE(PfsReader(file.name()).hasScaledLevels());
+    checkScaledRead<PfsReader>(file.name(), 1e-6f);
+}
+
+TEST(TestFrameReaderScaled, ExrScanlines) {
+    TempFile file("scaled.exr");
+    Frame frame(WIDTH, HEIGHT);
+    fillRamps(frame);
+    EXRWriter(file.name()).write(frame, Params("exr_mipmap", false));
+
+    EXPECT_FALSE(EXRReader(file.name()).hasScaledLevels());
+    checkScaledRead<EXRReader>(file.name(), 1e-3f);
+}
+
+TEST(TestFrameReaderScaled, ExrMipmap) {
+    TempFile file("scaled_mipmap.exr");
+    Frame frame(WIDTH, HEIGHT);
+    fillRamps(frame);
+    EXRWriter(file.name()).write(frame, Params("exr_mipmap", true));
+
+    EXPECT_TRUE(EXRReader(file.name()).hasScaledLevels());
+    checkScaledRead<EXRReader>(file.name(), 1e-3f);
+}
+
+TEST(TestFrameReaderScaled, SmallImage) {
+    // an image narrower than the target is read as it is
+    TempFile file("scaled_small.pfs");
+    Frame frame(WIDTH, HEIGHT);
+    fillRamps(frame);
+    PfsWriter(file.name()).write(frame, Params());
+
+    Frame full;
+    PfsReader(file.name()).read(full, Params());
+    Frame scaled;
+    PfsReader(file.name()).readScaled(scaled, 2 * WIDTH, Params());
+    expectNear(full, scaled, 0.f);
+}
@@ -0,0 +1,187 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/utils/half.h>
+
+using namespace pfs;
+using namespace pfs::utils;
+
+TEST(TestHalf, Values)
+{
+    EXPECT_EQ(floatToHalf(0.f), 0x0000);
+    EXPECT_EQ(floatToHalf(-0.f), 0x8000);
+    EXPECT_EQ(floatToHalf(1.f), 0x3c00);
+    EXPECT_EQ(floatToHalf(-2.f), 0xc000);
+    EXPECT_EQ(floatToHalf(65504.f), 0x7bff);
+    EXPECT_EQ(floatToHalf(1e6f), 0x7c00);
+    EXPECT_EQ(floatToHalf(std::numeric_limits<float>::infinity()), 0x7c00);
+    EXPECT_EQ(floatToHalf(std::pow(2.f, -24.f)), 0x0001);
+    EXPECT_EQ(floatToHalf(1e-10f), 0x0000);
+    // ties go to even
+    EXPECT_EQ(floatToHalf(1.f + std::pow(2.f, -11.f)), 0x3c00);
+    EXPECT_EQ(floatToHalf(1.f + 3.f * std::pow(2.f, -11.f)), 0x3c02);
+
+    EXPECT_EQ(halfToFloat(0x3c00), 1.f);
+    EXPECT_EQ(halfToFloat(0x0001), std::pow(2.f, -24.f));
+    EXPECT_TRUE(std::isnan(halfToFloat(floatToHalf(std::nanf("")))));
+}
+
+TEST(TestHalf, RoundTrip)
+{
+    // every non-NaN half survives the trip through float
+    for (unsigned int h = 0; h < 0x10000; ++h) {
+        const half_t value = static_cast<half_t>(h);
+        if ((value & 0x7c00) == 0x7c00 && (value & 0x03ff)) continue;
+
+        ASSERT_EQ(floatToHalf(halfToFloat(value)), value);
+    }
+}
+
+TEST(TestHalf, Bulk)
+{
+    // the bulk functions (F16C, if available) match the scalar ones
+    const size_t size = 200003;
+    std::vector<float> in(size);
+    for (size_t idx = 0; idx < size; ++idx) {
+        in[idx] = std::sin(idx * 0.001f) * std::exp((idx % 64) - 32.f);
+    }
+
+    std::vector<half_t> packed(size);
+    floatToHalf(in.data(), packed.data(), size);
+    std::vector<float> out(size);
+    halfToFloat(packed.data(), out.data(), size);
+
+    for (size_t idx = 0; idx < size; ++idx) {
+        ASSERT_EQ(packed[idx], floatToHalf(in[idx]));
+        ASSERT_EQ(out[idx], halfToFloat(packed[idx]));
+    }
+}
+
+TEST(TestHalf, FramePack)
+{
+    Frame frame(100, 50);
+    Channel *X;
+    Channel *Y;
+    Channel *Z;
+    frame.createXYZChannels(X, Y, Z);
+    for (size_t idx = 0; idx < Y->size(); ++idx) {
+        (*Y)(idx) = (idx % 1024) * 0.25f;
+    }
+    Y->getTags().setTag("TAG", "value");
+
+    Frame shared(frame);
+    Frame held(shared);
+    held.pack();
+    EXPECT_TRUE(held.isPacked());
+    EXPECT_FALSE(shared.isPacked());
+    EXPECT_FALSE(held.isChannelShared("Y"));
+
+    // the pointers handed out are dead: the copy keeps the packed channels,
+    // access unpacks them
+    frame.pack();
+    Frame copy(frame);
+    EXPECT_TRUE(copy.isChannelShared("Y"));
+
+    const Frame &ccopy = copy;
+    const Channel *cY = ccopy.getChannel("Y");
+    EXPECT_FALSE(cY->isPacked());
+    EXPECT_EQ(cY->getWidth(), 100u);
+    EXPECT_EQ(cY->getHeight(), 50u);
+    EXPECT_EQ(cY->getTags().getTag("TAG"), "value");
+    for (size_t idx = 0; idx < cY->size(); ++idx) {
+        ASSERT_EQ((*cY)(idx), (idx % 1024) * 0.25f);
+    }
+    EXPECT_TRUE(frame.isPacked());
+
+    const Channel *cX;
+    ccopy.getXYZChannels(cX, cY, cY);
+    EXPECT_FALSE(cX->isPacked());
+    EXPECT_FALSE(copy.isPacked());
+}
+
+TEST(TestHalf, PackedChannel)
+{
+    Frame frame(10, 10);
+    Channel *ch = frame.createPackedChannel("Y");
+    EXPECT_TRUE(ch->isPacked());
+    EXPECT_TRUE(ch->data() == NULL);
+    for (size_t idx = 0; idx < 100; ++idx) {
+        ch->packedData()[idx] = floatToHalf(static_cast<float>(idx));
+    }
+
+    ch = frame.getChannel("Y");
+    EXPECT_FALSE(ch->isPacked());
+    EXPECT_EQ((*ch)(7, 3), 37.f);
+}
+
+TEST(TestHalf, ConcurrentUnpack)
+{
+    Frame frame(300, 200);
+    Channel *X;
+    Channel *Y;
+    Channel *Z;
+    frame.createXYZChannels(X, Y, Z);
+    for (size_t idx = 0; idx < Y->size(); ++idx) {
+        (*X)(idx) = (*Y)(idx) = (*Z)(idx) = (idx % 2048) * 0.125f;
+    }
+    frame.pack();
+
+    // several readers race for the first access of the packed frame
+    const Frame &cframe = frame;
+    std::vector<char> ok(8, 0);
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < ok.size(); ++t) {
+        readers.push_back(std::thread([&cframe, &ok, t]() {
+            const Channel *cX;
+            const Channel *cY;
+            const Channel *cZ;
+            if (t % 2) {
+                cframe.getXYZChannels(cX, cY, cZ);
+            } else {
+                const ChannelContainer &channels = cframe.getChannels();
+                cX = channels[0];
+                cY = channels[1];
+                cZ = channels[2];
+            }
+            bool good = !cX->isPacked() && !cY->isPacked() && !cZ->isPacked();
+            for (size_t idx = 0; good && idx < cY->size(); ++idx) {
+                const float v = (idx % 2048) * 0.125f;
+                good = (*cX)(idx) == v && (*cY)(idx) == v && (*cZ)(idx) == v;
+            }
+            ok[t] = good;
+        }));
+    }
+    for (size_t t = 0; t < readers.size(); ++t) {
+        readers[t].join();
+    }
+    for (size_t t = 0; t < ok.size(); ++t) {
+        EXPECT_TRUE(ok[t]) << "reader " << t;
+    }
+    EXPECT_FALSE(frame.isPacked());
+}
@@ -0,0 +1,74 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Temporary files and test frames shared by the tests of the readers
+//! and the writers
+
+#ifndef TESTHELPERS_H
+#define TESTHELPERS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <Libpfs/channel.h>
+#include <Libpfs/frame.h>
+
+//! \brief removes a file (in the working directory) at the end of the scope
+class TempFile {
+   public:
+    explicit TempFile(const std::string &filename) : m_filename(filename) {}
+
+    //! \brief writes \a size bytes of \a content to \a filename first
+    TempFile(const std::string &filename, const char *content, size_t size)
+        : m_filename(filename) {
+        std::ofstream out(filename.c_str(), std::ios::binary);
+        out.write(content, size);
+    }
+
+    ~TempFile() { std::remove(m_filename.c_str()); }
+
+    const std::string &name() const { return m_filename; }
+
+   private:
+    TempFile(const TempFile &);
+    TempFile &operator=(const TempFile &);
+
+    std::string m_filename;
+};
+
+//! \brief fills \a frame with RGB values (in the XYZ channels) between 0 and
+//! 1: smooth gradients on R and B, a sawtooth on G
+inline void fillFrame(pfs::Frame &frame) {
+    pfs::Channel *R, *G, *B;
+    frame.createXYZChannels(R, G, B);
+    for (size_t y = 0; y < frame.getHeight(); ++y) {
+        for (size_t x = 0; x < frame.getWidth(); ++x) {
+            (*R)(x, y) = 0.5f + 0.5f * std::sin(x * 0.013f + y * 0.007f);
+            (*G)(x, y) = static_cast<float>((x * 7 + y * 13) % 256) / 255.f;
+            (*B)(x, y) = static_cast<float>(y) / frame.getHeight();
+        }
+    }
+}
+
+#endif
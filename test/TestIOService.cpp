@@ -0,0 +1,272 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <Core/IOService.h>
+#include <Libpfs/frame.h>
+
+namespace {
+
+const size_t WIDTH = 64;
+const size_t HEIGHT = 32;
+// memory held by a frame of the reader below
+const qint64 FRAME_BYTES = WIDTH * HEIGHT * 3 * sizeof(float);
+
+// how long the service gets to start reads it should not start
+const std::chrono::milliseconds SETTLE(100);
+
+QStringList fileList(int count) {
+    QStringList files;
+    for (int idx = 0; idx < count; ++idx) {
+        files << QString("input%1").arg(idx);
+    }
+    return files;
+}
+
+// a gate the reads and writes of a test can wait on
+class Gate {
+   public:
+    Gate() : m_open(false) {}
+
+    void open() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = true;
+        m_changed.notify_all();
+    }
+
+    void pass() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this]() { return m_open; });
+    }
+
+   private:
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_open;
+};
+
+// counts the reads and returns an XYZ frame named after its file, or NULL
+// for the files named "missing"
+class Reader {
+   public:
+    Reader() : started(0), running(0), maxRunning(0) {}
+
+    pfs::Frame *operator()(const QString &filename) {
+        ++started;
+        const int now = ++running;
+        int max = maxRunning;
+        while (now > max && !maxRunning.compare_exchange_weak(max, now)) {
+        }
+        gate.pass();
+        --running;
+
+        if (filename == "missing") return NULL;
+        pfs::Frame *frame = new pfs::Frame(WIDTH, HEIGHT);
+        pfs::Channel *X, *Y, *Z;
+        frame->createXYZChannels(X, Y, Z);
+        frame->getTags().setTag("FILE_NAME", filename.toStdString());
+        return frame;
+    }
+
+    IOService::Reader reader() {
+        return [this](const QString &filename) { return (*this)(filename); };
+    }
+
+    // waits up to a second for \a count reads
+    bool waitStarted(int count) {
+        for (int idx = 0; idx < 100 && started < count; ++idx) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return started >= count;
+    }
+
+    Gate gate;
+    std::atomic<int> started;
+    std::atomic<int> running;
+    std::atomic<int> maxRunning;
+};
+
+std::string fileName(const pfs::Frame &frame) {
+    return frame.getTags().getTag("FILE_NAME");
+}
+}
+
+TEST(TestIOService, OneReadBeforeTheFirstFrame) {
+    Reader reader;
+    IOService io(100 * FRAME_BYTES);
+    io.prefetch(fileList(4), 4, reader.reader());
+
+    // the size of the frames is not known yet
+    std::this_thread::sleep_for(SETTLE);
+    EXPECT_EQ(1, reader.started);
+
+    reader.gate.open();
+    ASSERT_TRUE(reader.waitStarted(4));
+    for (int idx = 0; idx < 4; ++idx) {
+        std::unique_ptr<pfs::Frame> frame(io.take(idx));
+        ASSERT_TRUE(frame != NULL);
+        frame.reset();
+        io.release(idx);
+    }
+}
+
+TEST(TestIOService, TakenFramesStayInTheBudget) {
+    Reader reader;
+    reader.gate.open();
+    IOService io(2 * FRAME_BYTES);
+    io.prefetch(fileList(6), 6, reader.reader());
+
+    // the first frame, then one more fits
+    ASSERT_TRUE(reader.waitStarted(2));
+    std::unique_ptr<pfs::Frame> frame0(io.take(0));
+    ASSERT_TRUE(frame0 != NULL);
+    std::this_thread::sleep_for(SETTLE);
+    EXPECT_EQ(2, reader.started);
+
+    // frame 0 is released: input 2 takes its place
+    frame0.reset();
+    io.release(0);
+    ASSERT_TRUE(reader.waitStarted(3));
+    std::this_thread::sleep_for(SETTLE);
+    EXPECT_EQ(3, reader.started);
+
+    // an input waited for is read whatever the budget
+    std::unique_ptr<pfs::Frame> frame1(io.take(1));
+    std::unique_ptr<pfs::Frame> frame4(io.take(4));
+    ASSERT_TRUE(frame4 != NULL);
+    EXPECT_EQ("input4", fileName(*frame4));
+
+    for (int idx = 1; idx < 6; ++idx) {
+        io.release(idx);
+    }
+}
+
+TEST(TestIOService, TakeInAnyOrder) {
+    Reader reader;
+    reader.gate.open();
+    IOService io(100 * FRAME_BYTES);
+    QStringList files = fileList(4);
+    files[1] = "missing";
+    io.prefetch(files, 2, reader.reader());
+
+    std::unique_ptr<pfs::Frame> frame3(io.take(3));
+    ASSERT_TRUE(frame3 != NULL);
+    EXPECT_EQ("input3", fileName(*frame3));
+
+    std::unique_ptr<pfs::Frame> frame0(io.take(0));
+    ASSERT_TRUE(frame0 != NULL);
+    EXPECT_EQ("input0", fileName(*frame0));
+
+    // a read that failed, an input taken twice and one that does not exist
+    EXPECT_TRUE(io.take(1) == NULL);
+    EXPECT_TRUE(io.take(3) == NULL);
+    EXPECT_TRUE(io.take(4) == NULL);
+
+    std::unique_ptr<pfs::Frame> frame2(io.take(2));
+    ASSERT_TRUE(frame2 != NULL);
+    EXPECT_EQ("input2", fileName(*frame2));
+
+    // released frames cannot be taken again
+    io.release(0);
+    EXPECT_TRUE(io.take(0) == NULL);
+    EXPECT_LE(reader.maxRunning, 2);
+}
+
+TEST(TestIOService, Tickets) {
+    IOService io(100 * FRAME_BYTES, 2);
+    std::vector<int> tickets;
+    for (int idx = 0; idx < 8; ++idx) {
+        tickets.push_back(io.write([idx]() { return idx % 3 != 0; }, 0));
+    }
+    const int failing =
+        io.write([]() -> bool { throw std::runtime_error("failed"); }, 0);
+
+    // the results wait for their ticket, in any order
+    EXPECT_FALSE(io.wait(failing));
+    for (int idx = 7; idx >= 0; --idx) {
+        EXPECT_EQ(idx % 3 != 0, io.wait(tickets[idx])) << idx;
+    }
+}
+
+TEST(TestIOService, WritesWaitForTheBudget) {
+    Gate gate;
+    std::atomic<int> written(0);
+    IOService io(FRAME_BYTES, 2);
+
+    // the whole budget: it starts since nothing else is written
+    const int first = io.write(
+        [&]() {
+            gate.pass();
+            ++written;
+            return true;
+        },
+        FRAME_BYTES);
+
+    std::atomic<bool> posted(false);
+    std::thread other([&]() {
+        io.post(
+            [&]() {
+                ++written;
+                return true;
+            },
+            FRAME_BYTES);
+        posted = true;
+    });
+
+    std::this_thread::sleep_for(SETTLE);
+    EXPECT_FALSE(posted);
+    EXPECT_EQ(0, written);
+
+    gate.open();
+    other.join();
+    EXPECT_TRUE(posted);
+    EXPECT_TRUE(io.wait(first));
+    io.waitForWrites();
+    EXPECT_EQ(2, written);
+}
+
+TEST(TestIOService, WriteWhileInputsAreHeld) {
+    Reader reader;
+    reader.gate.open();
+    IOService io(FRAME_BYTES);
+    io.prefetch(fileList(2), 2, reader.reader());
+
+    // the budget is taken by input 0: writes still make progress
+    std::unique_ptr<pfs::Frame> frame0(io.take(0));
+    ASSERT_TRUE(frame0 != NULL);
+    const int ticket = io.write([]() { return true; }, FRAME_BYTES);
+    EXPECT_TRUE(io.wait(ticket));
+
+    std::unique_ptr<pfs::Frame> frame1(io.take(1));
+    ASSERT_TRUE(frame1 != NULL);
+    io.release(0);
+    io.release(1);
+}
@@ -0,0 +1,172 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <jpeglib.h>
+
+#include <Libpfs/colorspace/normalizer.h>
+#include <Libpfs/colorspace/rgbremapper.h>
+#include <Libpfs/frame.h>
+#include <Libpfs/io/jpegwriter.h>
+#include <Libpfs/utils/chain.h>
+#include <Libpfs/utils/clamp.h>
+
+#include "TestHelpers.h"
+
+using namespace pfs;
+using namespace pfs::io;
+
+namespace {
+
+// more than a megapixel, to be split in bands
+const size_t WIDTH = 1301;
+const size_t HEIGHT = 853;
+
+// decodes \a filename into packed RGB
+std::vector<JSAMPLE> decode(const std::string &filename) {
+    FILE *file = std::fopen(filename.c_str(), "rb");
+    EXPECT_TRUE(file != NULL);
+    if (!file) return std::vector<JSAMPLE>();
+
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr errorHandler;
+    cinfo.err = jpeg_std_error(&errorHandler);
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, file);
+    jpeg_read_header(&cinfo, TRUE);
+    jpeg_start_decompress(&cinfo);
+
+    const size_t stride = cinfo.output_width * cinfo.output_components;
+    std::vector<JSAMPLE> pixels(stride * cinfo.output_height);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = pixels.data() + cinfo.output_scanline * stride;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    EXPECT_EQ(WIDTH, cinfo.output_width);
+    EXPECT_EQ(HEIGHT, cinfo.output_height);
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    std::fclose(file);
+    return pixels;
+}
+
+// the encoded size, through the in-memory writer
+size_t encodedSize(const Frame &frame, const Params &params) {
+    JpegWriter writer;
+    EXPECT_TRUE(writer.write(frame, params));
+    return writer.getFileSize();
+}
+
+// the serial and the banded encoders must decode to the same pixels
+void testBands(size_t quality) {
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+
+    TempFile serial("TestJpegWriterSerial.jpg");
+    TempFile banded("TestJpegWriterBanded.jpg");
+    ASSERT_TRUE(JpegWriter(serial.name())
+                    .write(frame, Params("quality", quality)("threads", 0)));
+    ASSERT_TRUE(JpegWriter(banded.name())
+                    .write(frame, Params("quality", quality)("threads", 4)));
+
+    const std::vector<JSAMPLE> expected = decode(serial.name());
+    const std::vector<JSAMPLE> pixels = decode(banded.name());
+    ASSERT_EQ(expected.size(), pixels.size());
+    EXPECT_TRUE(expected == pixels);
+
+    // the restart markers make the banded stream a bit bigger
+    EXPECT_LT(encodedSize(frame, Params("quality", quality)("threads", 0)),
+              encodedSize(frame, Params("quality", quality)("threads", 4)));
+}
+}
+
+TEST(TestJpegWriter, Interleave) {
+    const size_t size = 1003;
+    std::vector<float> r(size), g(size), b(size);
+    for (size_t idx = 0; idx < size; ++idx) {
+        r[idx] = std::sin(idx * 0.1f) * 1.5f;
+        g[idx] = static_cast<float>(idx) / size;
+        b[idx] = 1.f - g[idx] * 2.f;
+    }
+
+    std::vector<uint8_t> rgb(3 * size);
+    for (int mapping = MAP_LINEAR; mapping <= MAP_LOGARITHMIC; ++mapping) {
+        const Remapper<uint8_t> remapper(static_cast<RGBMappingType>(mapping));
+        remapper.interleave(r.data(), g.data(), b.data(), size, -0.2f, 1.1f,
+                            rgb.data());
+
+        for (size_t idx = 0; idx < size; ++idx) {
+            uint8_t o1, o2, o3;
+            utils::chain(colorspace::Normalizer(-0.2f, 1.1f),
+                         utils::CLAMP_F32, remapper)(r[idx], g[idx], b[idx],
+                                                     o1, o2, o3);
+            ASSERT_EQ(o1, rgb[3 * idx]) << "mapping " << mapping;
+            ASSERT_EQ(o2, rgb[3 * idx + 1]) << "mapping " << mapping;
+            ASSERT_EQ(o3, rgb[3 * idx + 2]) << "mapping " << mapping;
+        }
+    }
+
+    // NaN end up black
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const Remapper<uint8_t> remapper(MAP_LINEAR);
+    remapper.interleave(&nan, &nan, &nan, 1, 0.f, 1.f, rgb.data());
+    EXPECT_EQ(0, rgb[0]);
+}
+
+TEST(TestJpegWriter, Bands) { testBands(95); }
+
+TEST(TestJpegWriter, BandsSubsampled) { testBands(50); }
+
+TEST(TestJpegWriter, EstimateSize) {
+    // smooth on top, noisy at the bottom: the estimate has to follow the
+    // content down the image
+    Frame frame(2400, 1800);
+    Channel *R, *G, *B;
+    frame.createXYZChannels(R, G, B);
+    unsigned int seed = 12345;
+    for (size_t y = 0; y < frame.getHeight(); ++y) {
+        const float noise = static_cast<float>(y) / frame.getHeight();
+        for (size_t x = 0; x < frame.getWidth(); ++x) {
+            seed = seed * 1103515245u + 12345u;
+            const float n = noise * static_cast<float>(seed >> 24) / 255.f;
+            (*R)(x, y) = 0.5f + 0.4f * std::sin(x * 0.01f) + 0.1f * n;
+            (*G)(x, y) = 0.5f * (1.f - n) + 0.2f * std::cos(y * 0.02f);
+            (*B)(x, y) = n;
+        }
+    }
+
+    for (size_t quality = 50; quality <= 100; quality += 25) {
+        const size_t exact = encodedSize(
+            frame, Params("quality", quality)("threads", 0)("exact_size", true));
+        const size_t estimate =
+            encodedSize(frame, Params("quality", quality)("threads", 0));
+        EXPECT_NEAR(1.0, static_cast<double>(estimate) / exact, 0.03)
+            << "quality " << quality << ": " << estimate << " vs " << exact;
+    }
+}
@@ -1,8 +1,118 @@
 #include <gtest/gtest.h>
 
+#include <cstdlib>
+
 #include <HdrCreation/mtb_alignment.h>
+#include <HdrCreation/mtb_bitmap.h>
+#include <Libpfs/array2d.h>
+#include <Libpfs/manip/shift.h>
+
+using namespace libhdr;
+
+namespace {
+typedef pfs::Array2D<uint8_t> Array2D8u;
+
+void fillRandom(Array2D8u &img, unsigned int seed) {
+    srand(seed);
+    for (size_t idx = 0; idx < img.size(); ++idx) {
+        img(idx) = rand() % 256;
+    }
+}
+
+// reference implementation: one byte per pixel, explicit shifted copy
+long naiveXOR(const Array2D8u &img1, int median1, const Array2D8u &img2,
+              int median2, int noise, int dx, int dy) {
+    Array2D8u t1(img1.getCols(), img1.getRows());
+    Array2D8u m1(img1.getCols(), img1.getRows());
+    Array2D8u t2(img2.getCols(), img2.getRows());
+    Array2D8u m2(img2.getCols(), img2.getRows());
+    for (size_t idx = 0; idx < img1.size(); ++idx) {
+        t1(idx) = img1(idx) >= median1;
+        m1(idx) = !(img1(idx) > median1 - noise && img1(idx) < median1 + noise);
+        t2(idx) = img2(idx) >= median2;
+        m2(idx) = !(img2(idx) > median2 - noise && img2(idx) < median2 + noise);
+    }
+    Array2D8u t2s(img2.getCols(), img2.getRows());
+    Array2D8u m2s(img2.getCols(), img2.getRows());
+    pfs::shift(t2, dx, dy, t2s);
+    pfs::shift(m2, dx, dy, m2s);
+
+    long err = 0;
+    for (size_t idx = 0; idx < img1.size(); ++idx) {
+        err += (t1(idx) != t2s(idx)) && m1(idx) && m2s(idx);
+    }
+    return err;
+}
+}
 
 TEST(TestMTB, getLum)
 {
 
 }
+
+TEST(TestMTB, BitmapSetGet) {
+    Bitmap bitmap(131, 3);
+
+    EXPECT_EQ(bitmap.getWordsPerRow(), 3u);
+    EXPECT_EQ(bitmap.count(), 0u);
+
+    bitmap.set(0, 0, true);
+    bitmap.set(63, 1, true);
+    bitmap.set(64, 1, true);
+    bitmap.set(130, 2, true);
+
+    EXPECT_TRUE(bitmap.get(0, 0));
+    EXPECT_TRUE(bitmap.get(63, 1));
+    EXPECT_TRUE(bitmap.get(64, 1));
+    EXPECT_TRUE(bitmap.get(130, 2));
+    EXPECT_FALSE(bitmap.get(1, 0));
+    EXPECT_EQ(bitmap.count(), 4u);
+
+    bitmap.set(63, 1, false);
+    EXPECT_FALSE(bitmap.get(63, 1));
+    EXPECT_EQ(bitmap.count(), 3u);
+}
+
+TEST(TestMTB, SetThreshold) {
+    Array2D8u img(150, 7);
+    fillRandom(img, 42);
+
+    Bitmap threshold(img.getCols(), img.getRows());
+    Bitmap mask(img.getCols(), img.getRows());
+    setThreshold(img, 128, 4, threshold, mask);
+
+    for (size_t y = 0; y < img.getRows(); ++y) {
+        for (size_t x = 0; x < img.getCols(); ++x) {
+            ASSERT_EQ(threshold.get(x, y), img(x, y) >= 128);
+            ASSERT_EQ(mask.get(x, y), !(img(x, y) > 124 && img(x, y) < 132));
+        }
+    }
+}
+
+TEST(TestMTB, XORimagesShifted) {
+    const int median1 = 120;
+    const int median2 = 135;
+    const int noise = 4;
+
+    // odd width, to exercise the padding bits of the last word
+    Array2D8u img1(203, 37);
+    Array2D8u img2(203, 37);
+    fillRandom(img1, 1);
+    fillRandom(img2, 2);
+
+    Bitmap t1(img1.getCols(), img1.getRows());
+    Bitmap m1(img1.getCols(), img1.getRows());
+    Bitmap t2(img2.getCols(), img2.getRows());
+    Bitmap m2(img2.getCols(), img2.getRows());
+    setThreshold(img1, median1, noise, t1, m1);
+    setThreshold(img2, median2, noise, t2, m2);
+
+    const int shifts[] = {-70, -64, -5, -1, 0, 1, 3, 64, 65};
+    for (int dx : shifts) {
+        for (int dy = -3; dy <= 3; ++dy) {
+            EXPECT_EQ(XORimages(t1, m1, t2, m2, dx, dy),
+                      naiveXOR(img1, median1, img2, median2, noise, dx, dy))
+                << "dx = " << dx << ", dy = " << dy;
+        }
+    }
+}
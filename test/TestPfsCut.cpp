@@ -23,7 +23,12 @@
 #include <algorithm>
 
 #include "Libpfs/array2d.h"
+#include "Libpfs/array2dview.h"
+#include "Libpfs/frame.h"
+#include "Libpfs/frameview.h"
+#include "Libpfs/manip/copy.h"
 #include "Libpfs/manip/cut.h"
+#include "Libpfs/manip/resize.h"
 
 #include "SeqInt.h"
 #include "PrintArray2D.h"
@@ -164,3 +169,86 @@ TEST(TestPfsCut, Crop_OneTwo_TwoOne)
         ASSERT_NEAR(ref[idx], outData[idx], 10e-5f);
     }
 }
+
+TEST(TestPfsCut, ViewSharesStorage)
+{
+    size_t rows = 5;
+    size_t cols = 6;
+
+    Array2Df input(cols, rows);
+    std::generate(input.begin(), input.end(), SeqInt());
+
+    Array2DConstViewf view(input, 1, 2, 3, 2);
+    EXPECT_EQ(view.getStride(), cols);
+    EXPECT_FALSE(view.isContiguous());
+    EXPECT_EQ(view.data(), input.data() + 2*cols + 1);
+
+    input(2, 3) = 100.f;
+    EXPECT_EQ(view(1, 1), 100.f);
+
+    Array2DConstViewf sub = view.subView(1, 1, 2, 1);
+    EXPECT_EQ(sub(0, 0), 100.f);
+    EXPECT_EQ(sub(1, 0), 21.f);
+}
+
+TEST(TestPfsCut, FrameView)
+{
+    size_t rows = 5;
+    size_t cols = 6;
+
+    Frame frame(cols, rows);
+    Channel *X, *Y, *Z;
+    frame.createXYZChannels(X, Y, Z);
+    std::generate(X->begin(), X->end(), SeqInt());
+    std::generate(Y->begin(), Y->end(), SeqInt());
+    std::generate(Z->begin(), Z->end(), SeqInt());
+
+    // bottom-right corner is clamped
+    FrameView view(frame, 1, 2, cols + 10, rows - 1);
+    EXPECT_EQ(view.getWidth(), cols - 1);
+    EXPECT_EQ(view.getHeight(), 2u);
+
+    Array2DConstViewf vX, vY, vZ;
+    ASSERT_TRUE(view.getXYZChannels(vX, vY, vZ));
+    EXPECT_EQ(vX.data(), X->data() + 2*cols + 1);
+
+    const float ref[] = {13.f, 14.f, 15.f, 16.f, 17.f,
+                         19.f, 20.f, 21.f, 22.f, 23.f};
+
+    Frame* out = pfs::copy(view);
+    ASSERT_EQ(out->getWidth(), cols - 1);
+    ASSERT_EQ(out->getHeight(), 2u);
+
+    const Channel* outX = out->getChannel("X");
+    ASSERT_TRUE(outX != NULL);
+    for (size_t idx = 0; idx < outX->size(); ++idx)
+    {
+        ASSERT_NEAR(ref[idx], (*outX)(idx), 10e-5f);
+    }
+    delete out;
+}
+
+TEST(TestPfsCut, ResizeView)
+{
+    size_t rows = 40;
+    size_t cols = 60;
+
+    Array2Df input(cols, rows);
+    std::generate(input.begin(), input.end(), SeqInt());
+
+    // crop and then resize...
+    Array2Df crop(30, 20);
+    cut(&input, &crop, 10, 5, 40, 25);
+
+    Array2Df ref(15, 10);
+    resize(&crop, &ref, BilinearInterp);
+
+    // ... or resize straight from the view
+    Array2Df output(15, 10);
+    resize(Array2DConstViewf(input, 10, 5, 30, 20), &output, BilinearInterp);
+
+    for (size_t idx = 0; idx < output.size(); ++idx)
+    {
+        ASSERT_NEAR(ref(idx), output(idx), 10e-5f);
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/array2dview.h>
+#include <Libpfs/frame.h>
+#include <Libpfs/manip/resize.h>
+
+#include "SeqInt.h"
+
+using namespace pfs;
+
+TEST(TestPfsDecimate, BoxAverage)
+{
+    // trailing row and column are dropped
+    Array2Df input(7, 5);
+    std::generate(input.begin(), input.end(), SeqInt());
+
+    Array2Df output;
+    decimate(Array2DView<const float>(input), &output, 2);
+    ASSERT_EQ(output.getCols(), 3u);
+    ASSERT_EQ(output.getRows(), 2u);
+
+    for (size_t y = 0; y < output.getRows(); ++y) {
+        for (size_t x = 0; x < output.getCols(); ++x) {
+            const float expected =
+                (input(2 * x, 2 * y) + input(2 * x + 1, 2 * y) +
+                 input(2 * x, 2 * y + 1) + input(2 * x + 1, 2 * y + 1)) /
+                4.f;
+            EXPECT_FLOAT_EQ(expected, output(x, y));
+        }
+    }
+}
+
+TEST(TestPfsDecimate, View)
+{
+    Array2Df input(10, 10);
+    std::generate(input.begin(), input.end(), SeqInt());
+
+    Array2Df output;
+    decimate(Array2DView<const float>(input, 1, 2, 6, 3), &output, 3);
+    ASSERT_EQ(output.getCols(), 2u);
+    ASSERT_EQ(output.getRows(), 1u);
+
+    // average of the 3x3 blocks centered on (2, 3) and (5, 3)
+    EXPECT_FLOAT_EQ(input(2, 3), output(0, 0));
+    EXPECT_FLOAT_EQ(input(5, 3), output(1, 0));
+}
+
+TEST(TestPfsDecimate, SmallerThanFactor)
+{
+    // a 1 pixel tall strip still gives one row, averaged on what is there
+    Array2Df input(8, 1);
+    std::generate(input.begin(), input.end(), SeqInt());
+
+    Array2Df output;
+    decimate(Array2DView<const float>(input), &output, 4);
+    ASSERT_EQ(output.getCols(), 2u);
+    ASSERT_EQ(output.getRows(), 1u);
+    EXPECT_FLOAT_EQ(1.5f, output(0, 0));
+    EXPECT_FLOAT_EQ(5.5f, output(1, 0));
+
+    decimate(Array2DView<const float>(input), &output, 16);
+    ASSERT_EQ(output.getCols(), 1u);
+    EXPECT_FLOAT_EQ(3.5f, output(0, 0));
+}
+
+TEST(TestPfsDecimate, Frame)
+{
+    Frame frame(64, 48);
+    Channel *X, *Y, *Z;
+    frame.createXYZChannels(X, Y, Z);
+    std::fill(X->begin(), X->end(), 1.f);
+    std::fill(Y->begin(), Y->end(), 2.f);
+    std::fill(Z->begin(), Z->end(), 3.f);
+    frame.getTags().setTag("FILE_NAME", "test");
+
+    std::unique_ptr<Frame> decimated(decimate(frame, 4));
+    ASSERT_EQ(decimated->getWidth(), 16u);
+    ASSERT_EQ(decimated->getHeight(), 12u);
+    EXPECT_EQ(decimated->getTags().getTag("FILE_NAME"), "test");
+
+    const Channel *dX, *dY, *dZ;
+    static_cast<const Frame &>(*decimated).getXYZChannels(dX, dY, dZ);
+    ASSERT_TRUE(dX != NULL);
+    EXPECT_FLOAT_EQ(1.f, (*dX)(5, 7));
+    EXPECT_FLOAT_EQ(2.f, (*dY)(15, 11));
+    EXPECT_FLOAT_EQ(3.f, (*dZ)(0, 0));
+}
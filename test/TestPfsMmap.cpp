@@ -0,0 +1,384 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/io/pfsreader.h>
+#include <Libpfs/io/pfswriter.h>
+#include <Libpfs/utils/bufferpool.h>
+
+#include "TestHelpers.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace pfs;
+using namespace pfs::io;
+
+namespace {
+
+// large enough for the channels to be mapped, and a multiple of
+// BUFFER_ALIGNMENT bytes each, so that all of them can be
+const size_t WIDTH = 304;
+const size_t HEIGHT = 220;
+
+void fillTaggedFrame(Frame &frame) {
+    Channel *X, *Y, *Z;
+    frame.createXYZChannels(X, Y, Z);
+    for (size_t idx = 0; idx < frame.size(); ++idx) {
+        (*X)(idx) = static_cast<float>(idx);
+        (*Y)(idx) = static_cast<float>(idx) * 0.5f;
+        (*Z)(idx) = -static_cast<float>(idx);
+    }
+    frame.getTags().setTag("FILE_NAME", "frame.pfs");
+    Y->getTags().setTag("LUMINANCE", "RELATIVE");
+}
+
+void expectEqual(const Frame &expected, const Frame &frame) {
+    ASSERT_EQ(expected.getWidth(), frame.getWidth());
+    ASSERT_EQ(expected.getHeight(), frame.getHeight());
+    EXPECT_EQ(expected.getTags().getTag("FILE_NAME"),
+              frame.getTags().getTag("FILE_NAME"));
+    EXPECT_EQ(expected.getTags().size(), frame.getTags().size());
+
+    const char *names[] = {"X", "Y", "Z"};
+    for (size_t c = 0; c < 3; ++c) {
+        const Channel *a = expected.getChannel(names[c]);
+        const Channel *b = frame.getChannel(names[c]);
+        ASSERT_TRUE(b != NULL);
+        EXPECT_EQ(a->getTags().size(), b->getTags().size());
+        for (size_t idx = 0; idx < a->size(); ++idx) {
+            ASSERT_EQ((*a)(idx), (*b)(idx));
+        }
+    }
+}
+
+std::string readAll(const std::string &filename) {
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in),
+                       std::istreambuf_iterator<char>());
+}
+
+void readFrame(const std::string &filename, Frame &frame, bool mapped) {
+    Params params("pfs_mmap", mapped);
+    PfsReader reader(filename);
+    reader.read(frame, params);
+}
+}
+
+TEST(TestPfsMmap, RoundTrip)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillTaggedFrame(frame);
+
+    TempFile file("mmap.pfs");
+    PfsWriter(file.name()).write(frame, Params());
+
+    Frame mapped;
+    readFrame(file.name(), mapped, true);
+    expectEqual(frame, mapped);
+
+    const Channel *Y = mapped.getChannel("Y");
+    EXPECT_EQ(0u, reinterpret_cast<size_t>(Y->data()) %
+                      utils::BUFFER_ALIGNMENT);
+    EXPECT_TRUE(utils::BufferPool::instance().isMapped(Y->data()));
+    EXPECT_EQ("RELATIVE", Y->getTags().getTag("LUMINANCE"));
+
+    Frame copied;
+    readFrame(file.name(), copied, false);
+    expectEqual(frame, copied);
+    EXPECT_FALSE(
+        utils::BufferPool::instance().isMapped(copied.getChannel("Y")->data()));
+
+    // mapping is asked for
+    Frame plain;
+    PfsReader(file.name()).read(plain, Params());
+    EXPECT_FALSE(
+        utils::BufferPool::instance().isMapped(plain.getChannel("Y")->data()));
+}
+
+TEST(TestPfsMmap, Unaligned)
+{
+    // the channels after the first one are not aligned: they are read
+    Frame frame(WIDTH - 3, HEIGHT);
+    fillTaggedFrame(frame);
+
+    TempFile file("unaligned.pfs");
+    PfsWriter(file.name()).write(frame, Params());
+
+    Frame mapped;
+    readFrame(file.name(), mapped, true);
+    expectEqual(frame, mapped);
+
+    const utils::BufferPool &pool = utils::BufferPool::instance();
+    EXPECT_TRUE(pool.isMapped(mapped.getChannel("X")->data()));
+    EXPECT_FALSE(pool.isMapped(mapped.getChannel("Y")->data()));
+    EXPECT_EQ(0u, reinterpret_cast<size_t>(mapped.getChannel("Y")->data()) %
+                      utils::BUFFER_ALIGNMENT);
+}
+
+TEST(TestPfsMmap, UnpaddedHeader)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillTaggedFrame(frame);
+
+    // as written by pfstools: the data starts right after "ENDH"
+    TempFile padded("padded.pfs");
+    PfsWriter(padded.name()).write(frame, Params());
+    const std::string content = readAll(padded.name());
+    const size_t dataBytes = 3 * WIDTH * HEIGHT * sizeof(float);
+    const std::string header = "PFS1\n" + std::to_string(WIDTH) + " " +
+                               std::to_string(HEIGHT) +
+                               "\n3\n1\nFILE_NAME=frame.pfs\nX\n0\nY\n1\n"
+                               "LUMINANCE=RELATIVE\nZ\n0\nENDH";
+    ASSERT_NE(0u, header.size() % utils::BUFFER_ALIGNMENT);
+    const std::string unpadded =
+        header + content.substr(content.size() - dataBytes);
+    TempFile file("unpadded.pfs", unpadded.data(), unpadded.size());
+
+    // the channels are copied out of the mapping, and stay aligned
+    Frame mapped;
+    readFrame(file.name(), mapped, true);
+    expectEqual(frame, mapped);
+
+    const utils::BufferPool &pool = utils::BufferPool::instance();
+    const char *names[] = {"X", "Y", "Z"};
+    for (size_t c = 0; c < 3; ++c) {
+        const float *data = mapped.getChannel(names[c])->data();
+        EXPECT_FALSE(pool.isFileMapped(data));
+        EXPECT_EQ(0u,
+                  reinterpret_cast<size_t>(data) % utils::BUFFER_ALIGNMENT);
+    }
+}
+
+#ifndef _WIN32
+TEST(TestPfsMmap, StandardInput)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillTaggedFrame(frame);
+
+    TempFile file("stdin.pfs");
+    PfsWriter(file.name()).write(frame, Params());
+    ASSERT_TRUE(freopen(file.name().c_str(), "rb", stdin) != NULL);
+
+    Frame mapped;
+    readFrame(PFS_STDIO_NAME, mapped, true);
+    expectEqual(frame, mapped);
+    EXPECT_TRUE(utils::BufferPool::instance().isFileMapped(
+        mapped.getChannel("Y")->data()));
+}
+#endif
+
+TEST(TestPfsMmap, RewriteMappedFile)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillTaggedFrame(frame);
+
+    TempFile file("rewrite.pfs");
+    PfsWriter(file.name()).write(frame, Params());
+
+    // the frame still reads the file it is written to
+    for (int mappedWrite = 0; mappedWrite < 2; ++mappedWrite) {
+        Frame mapped;
+        readFrame(file.name(), mapped, true);
+        ASSERT_TRUE(utils::BufferPool::instance().isFileMapped(
+            mapped.getChannel("X")->data()));
+        PfsWriter(file.name())
+            .write(mapped, Params("pfs_mmap", mappedWrite != 0));
+
+        Frame again;
+        readFrame(file.name(), again, false);
+        expectEqual(frame, again);
+    }
+}
+
+TEST(TestPfsMmap, Padding)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillTaggedFrame(frame);
+
+    TempFile file("padding.pfs");
+    PfsWriter(file.name()).write(frame, Params());
+
+    // blank space after the channel count, not a tag
+    const std::string content = readAll(file.name());
+    const size_t dataBytes = 3 * WIDTH * HEIGHT * sizeof(float);
+    ASSERT_GT(content.size(), dataBytes);
+    EXPECT_EQ(0u, (content.size() - dataBytes) % PFS_DATA_ALIGNMENT);
+    EXPECT_EQ(std::string::npos, content.find("PADDING"));
+
+    Frame copied;
+    readFrame(file.name(), copied, false);
+    expectEqual(frame, copied);
+    EXPECT_EQ(1u, copied.getTags().size());
+}
+
+TEST(TestPfsMmap, MappedWrite)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillTaggedFrame(frame);
+
+    TempFile file("mapped_write.pfs");
+    PfsWriter(file.name()).write(frame, Params("pfs_mmap", true));
+    TempFile reference("stdio_write.pfs");
+    PfsWriter(reference.name()).write(frame, Params());
+
+    EXPECT_EQ(readAll(reference.name()), readAll(file.name()));
+}
+
+TEST(TestPfsMmap, CopyOnWrite)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillTaggedFrame(frame);
+
+    TempFile file("cow.pfs");
+    PfsWriter(file.name()).write(frame, Params());
+
+    {
+        Frame mapped;
+        readFrame(file.name(), mapped, true);
+        Channel *X = mapped.getChannel("X");
+        std::fill(X->begin(), X->end(), 42.f);
+        EXPECT_EQ(42.f, (*X)(1234));
+    }
+
+    // the file is untouched
+    Frame again;
+    readFrame(file.name(), again, true);
+    expectEqual(frame, again);
+}
+
+#ifndef _WIN32
+TEST(TestPfsMmap, Overwrite)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillTaggedFrame(frame);
+
+    TempFile file("overwrite.pfs");
+    PfsWriter(file.name()).write(frame, Params());
+    ASSERT_EQ(0, chmod(file.name().c_str(), 0600));
+    TempFile link("overwrite_link.pfs");
+    ASSERT_EQ(0, ::link(file.name().c_str(), link.name().c_str()));
+
+    // a smaller frame, rewritten in place
+    Frame modified(WIDTH / 2, HEIGHT);
+    Channel *X, *Y, *Z;
+    modified.createXYZChannels(X, Y, Z);
+    PfsWriter(file.name()).write(modified, Params("pfs_mmap", true));
+
+    Frame zero;
+    readFrame(link.name(), zero, true);
+    expectEqual(modified, zero);
+
+    struct stat st;
+    ASSERT_EQ(0, stat(file.name().c_str(), &st));
+    EXPECT_EQ(2u, st.st_nlink);
+    EXPECT_EQ(0600u, st.st_mode & 0777u);
+}
+#endif
+
+TEST(TestPfsMmap, Truncated)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillTaggedFrame(frame);
+
+    TempFile file("truncated.pfs");
+    PfsWriter(file.name()).write(frame, Params());
+
+    // drop the last pixel
+    const std::string content = readAll(file.name());
+    std::ofstream out(file.name().c_str(), std::ios::binary);
+    out.write(content.data(), content.size() - sizeof(float));
+    out.close();
+
+    Frame mapped;
+    EXPECT_THROW(readFrame(file.name(), mapped, true), ReadException);
+}
+
+TEST(TestPfsMmap, Sequence)
+{
+    Frame first(WIDTH, HEIGHT);
+    fillTaggedFrame(first);
+    Frame second(WIDTH / 2, HEIGHT);
+    fillTaggedFrame(second);
+
+    // a stream of frames, as written by pfstools
+    TempFile firstFile("first.pfs");
+    PfsWriter(firstFile.name()).write(first, Params());
+    TempFile secondFile("second.pfs");
+    PfsWriter(secondFile.name()).write(second, Params());
+
+    TempFile file("sequence.pfs");
+    {
+        std::ofstream out(file.name().c_str(), std::ios::binary);
+        out << readAll(firstFile.name()) << readAll(secondFile.name())
+            << readAll(firstFile.name());
+    }
+
+    for (int mapped = 0; mapped < 2; ++mapped) {
+        const Params params("pfs_mmap", mapped != 0);
+        PfsReader reader(file.name());
+        Frame frame;
+
+        ASSERT_TRUE(reader.readNext(frame, params));
+        expectEqual(first, frame);
+        ASSERT_TRUE(reader.readNext(frame, params));
+        expectEqual(second, frame);
+        ASSERT_TRUE(reader.readNext(frame, params));
+        expectEqual(first, frame);
+        EXPECT_FALSE(reader.readNext(frame, params));
+        EXPECT_THROW(reader.read(frame, params), ReadException);
+    }
+}
+
+TEST(TestPfsMmap, WriteToStream)
+{
+    Frame first(WIDTH, HEIGHT);
+    fillTaggedFrame(first);
+    Frame second(WIDTH / 2, HEIGHT);
+    fillTaggedFrame(second);
+
+    // the frames are appended to the stream, which is left open
+    TempFile file("stream.pfs");
+    FILE *stream = fopen(file.name().c_str(), "wb");
+    ASSERT_TRUE(stream != NULL);
+    PfsWriter(stream).write(first, Params("pfs_mmap", true));
+    PfsWriter(stream).write(second, Params());
+    EXPECT_EQ(0, fclose(stream));
+
+    PfsReader reader(file.name());
+    Frame frame;
+    ASSERT_TRUE(reader.readNext(frame, Params()));
+    expectEqual(first, frame);
+    ASSERT_TRUE(reader.readNext(frame, Params()));
+    expectEqual(second, frame);
+    EXPECT_FALSE(reader.readNext(frame, Params()));
+}
@@ -21,21 +21,17 @@
 
 #include <gtest/gtest.h>
 
-#if GTEST_HAS_COMBINE
-
 #include <algorithm>
+#include <iostream>
 #include <tuple>
 
 #include <Libpfs/array2d.h>
 #include <Libpfs/manip/rotate.h>
+#include <Libpfs/utils/msec_timer.h>
 
 #include "CompareVector.h"
 #include "SeqInt.h"
 
-using ::testing::TestWithParam;
-using ::testing::Values;
-using ::testing::Combine;
-
 template <typename InputType>
 void rotate_ccw(const InputType* input,
                 InputType* output,
@@ -66,6 +62,44 @@ void rotate_cw(const InputType* input,
     }
 }
 
+// pfs::rotate against the element by element walk it replaced
+// run with --gtest_also_run_disabled_tests
+TEST(TestPfsRotateSpeed, DISABLED_Benchmark)
+{
+    const size_t W = 8192;
+    const size_t H = 4096;
+
+    pfs::Array2Df input(W, H);
+    std::generate(input.begin(), input.end(), SeqInt());
+    pfs::Array2Df reference(H, W);
+    pfs::Array2Df computed(H, W);
+    msec_timer t;
+
+    t.start();
+#pragma omp parallel for
+    for (int j = 0; j < static_cast<int>(H); j++) {
+        for (size_t i = 0; i < W; i++) {
+            reference.data()[(i + 1) * H - 1 - j] = input.data()[j * W + i];
+        }
+    }
+    t.stop_and_update();
+    std::cout << "rotate, per pixel: " << t.get_time() << " ms" << std::endl;
+
+    t.reset();
+    t.start();
+    pfs::rotate(&input, &computed, true);
+    t.stop_and_update();
+    std::cout << "rotate, blocked:   " << t.get_time() << " ms" << std::endl;
+
+    compareVectors(reference.data(), computed.data(), W * H);
+}
+
+#if GTEST_HAS_COMBINE
+
+using ::testing::TestWithParam;
+using ::testing::Values;
+using ::testing::Combine;
+
 class TestPfsRotate : public TestWithParam< ::std::tuple<size_t, size_t> >
 {
 protected:
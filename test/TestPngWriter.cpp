@@ -0,0 +1,162 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <png.h>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/io/pngwriter.h>
+
+#include "TestHelpers.h"
+
+using namespace pfs;
+using namespace pfs::io;
+
+namespace {
+
+// a few chunks of filtered data
+const size_t WIDTH = 701;
+const size_t HEIGHT = 523;
+
+// decodes \a filename into packed RGB
+std::vector<png_byte> decode(const std::string &filename) {
+    std::vector<png_byte> pixels;
+    FILE *file = std::fopen(filename.c_str(), "rb");
+    EXPECT_TRUE(file != NULL);
+    if (!file) return pixels;
+
+    png_structp png_ptr =
+        png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop info_ptr = png_create_info_struct(png_ptr);
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        std::fclose(file);
+        ADD_FAILURE() << "cannot decode " << filename;
+        return std::vector<png_byte>();
+    }
+    png_init_io(png_ptr, file);
+    png_read_info(png_ptr, info_ptr);
+
+    const png_uint_32 width = png_get_image_width(png_ptr, info_ptr);
+    const png_uint_32 height = png_get_image_height(png_ptr, info_ptr);
+    EXPECT_EQ(WIDTH, width);
+    EXPECT_EQ(HEIGHT, height);
+    EXPECT_EQ(PNG_COLOR_TYPE_RGB, png_get_color_type(png_ptr, info_ptr));
+
+    pixels.resize(width * height * 3);
+    for (png_uint_32 row = 0; row < height; ++row) {
+        png_read_row(png_ptr, pixels.data() + row * width * 3, NULL);
+    }
+    png_read_end(png_ptr, NULL);
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+    std::fclose(file);
+    return pixels;
+}
+
+std::vector<png_byte> writeAndDecode(const Frame &frame, Params params,
+                                     const std::string &filename) {
+    TempFile file(filename);
+    PngWriter writer(file.name());
+    EXPECT_TRUE(writer.write(frame, params));
+    return decode(file.name());
+}
+}
+
+TEST(TestPngWriter, ChunksMatchSerial)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+
+    const char *filters[] = {"none", "sub", "up", "avg", "paeth", "all"};
+    for (size_t i = 0; i < sizeof(filters) / sizeof(filters[0]); ++i) {
+        std::vector<png_byte> serial = writeAndDecode(
+            frame, Params("threads", 0)("png_filter", std::string(filters[i])),
+            "TestPngWriter_serial.png");
+        std::vector<png_byte> chunked = writeAndDecode(
+            frame, Params("threads", 4)("png_filter", std::string(filters[i])),
+            "TestPngWriter_chunked.png");
+
+        ASSERT_EQ(WIDTH * HEIGHT * 3, serial.size()) << filters[i];
+        ASSERT_TRUE(serial == chunked) << filters[i];
+    }
+}
+
+TEST(TestPngWriter, Strategies)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+
+    const std::vector<png_byte> reference = writeAndDecode(
+        frame, Params("threads", 0), "TestPngWriter_reference.png");
+
+    const char *strategies[] = {"default", "filtered", "huffman", "rle",
+                                "fixed"};
+    for (size_t i = 0; i < sizeof(strategies) / sizeof(strategies[0]); ++i) {
+        for (int level = 0; level <= 9; level += 3) {
+            std::vector<png_byte> chunked = writeAndDecode(
+                frame, Params("threads", 3)("png_compression_level", level)(
+                           "png_strategy", std::string(strategies[i])),
+                "TestPngWriter_strategy.png");
+            ASSERT_TRUE(reference == chunked) << strategies[i] << ", level "
+                                              << level;
+        }
+    }
+}
+
+TEST(TestPngWriter, MemorySize)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+
+    TempFile file("TestPngWriter_size.png");
+    PngWriter fileWriter(file.name());
+    ASSERT_TRUE(fileWriter.write(frame, Params("threads", 4)));
+
+    FILE *handle = std::fopen(file.name().c_str(), "rb");
+    ASSERT_TRUE(handle != NULL);
+    std::fseek(handle, 0, SEEK_END);
+    const long size = std::ftell(handle);
+    std::fclose(handle);
+
+    PngWriter memoryWriter;
+    ASSERT_TRUE(memoryWriter.write(frame, Params("threads", 4)));
+    EXPECT_EQ(static_cast<size_t>(size), memoryWriter.getFileSize());
+}
+
+TEST(TestPngWriter, UnknownOption)
+{
+    Frame frame(16, 16);
+    fillFrame(frame);
+
+    PngWriter writer;
+    EXPECT_THROW(
+        writer.write(frame, Params("png_strategy", std::string("lz4"))),
+        WriteException);
+    EXPECT_THROW(
+        writer.write(frame, Params("png_filter", std::string("median"))),
+        WriteException);
+}
@@ -0,0 +1,146 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/io/rgbecommon.h>
+#include <Libpfs/io/rgbereader.h>
+#include <Libpfs/io/rgbewriter.h>
+
+#include "TestHelpers.h"
+
+using namespace pfs;
+using namespace pfs::io;
+
+namespace {
+
+// more than one band of scanlines, with flat areas (runs) and noise
+const size_t WIDTH = 509;
+const size_t HEIGHT = 301;
+
+void fillHdrFrame(Frame &frame) {
+    Channel *R, *G, *B;
+    frame.createXYZChannels(R, G, B);
+    for (size_t y = 0; y < frame.getHeight(); ++y) {
+        for (size_t x = 0; x < frame.getWidth(); ++x) {
+            const bool flat = x < 200;
+            (*R)(x, y) = flat ? 1.f : 100.f * std::exp(std::sin(x * 0.3f));
+            (*G)(x, y) = flat ? 0.f : static_cast<float>((x * 7 + y) % 97);
+            (*B)(x, y) = flat ? 1e-3f : static_cast<float>(y) / (x + 1);
+        }
+    }
+}
+
+// RGBE keeps 8 bits of mantissa for the largest component of each pixel.
+// The writer divides by WHITE_EFFICACY, the reader does not multiply back.
+void expectNear(const Frame &expected, const Frame &frame) {
+    ASSERT_EQ(expected.getWidth(), frame.getWidth());
+    ASSERT_EQ(expected.getHeight(), frame.getHeight());
+
+    const Channel *R, *G, *B;
+    expected.getXYZChannels(R, G, B);
+    const Channel *X, *Y, *Z;
+    frame.getXYZChannels(X, Y, Z);
+    for (size_t idx = 0; idx < R->size(); ++idx) {
+        const float r = (*R)(idx) / WHITE_EFFICACY;
+        const float g = (*G)(idx) / WHITE_EFFICACY;
+        const float b = (*B)(idx) / WHITE_EFFICACY;
+        const float tolerance = std::max(r, std::max(g, b)) / 128.f;
+        ASSERT_NEAR(r, (*X)(idx), tolerance) << idx;
+        ASSERT_NEAR(g, (*Y)(idx), tolerance) << idx;
+        ASSERT_NEAR(b, (*Z)(idx), tolerance) << idx;
+    }
+}
+
+const char HEADER[] = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y 2 +X 3\n";
+}
+
+TEST(TestRGBE, RoundTrip)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillHdrFrame(frame);
+
+    TempFile file("roundtrip.hdr");
+    RGBEWriter(file.name()).write(frame, Params());
+
+    Frame read;
+    RGBEReader(file.name()).read(read, Params());
+    expectNear(frame, read);
+}
+
+TEST(TestRGBE, FlatScanlines)
+{
+    // scanlines stored without RLE: one RGBE pixel every 4 bytes
+    const unsigned char pixels[] = {128, 0, 0, 129, 0, 64, 0, 130, 0, 0, 0, 0,
+                                    1, 2, 3, 136, 255, 255, 255, 128,
+                                    16, 32, 64, 127};
+    TempFile file("flat.hdr");
+    {
+        std::ofstream out(file.name().c_str(), std::ios::binary);
+        out.write(HEADER, sizeof(HEADER) - 1);
+        out.write(reinterpret_cast<const char *>(pixels), sizeof(pixels));
+    }
+
+    Frame frame;
+    RGBEReader(file.name()).read(frame, Params());
+    ASSERT_EQ(3u, frame.getWidth());
+    ASSERT_EQ(2u, frame.getHeight());
+
+    const Channel *R, *G, *B;
+    frame.getXYZChannels(R, G, B);
+    EXPECT_FLOAT_EQ(1.f, (*R)(0, 0));
+    EXPECT_FLOAT_EQ(1.f, (*G)(1, 0));
+    EXPECT_FLOAT_EQ(0.f, (*B)(2, 0));
+    EXPECT_FLOAT_EQ(3.f, (*B)(0, 1));
+    EXPECT_FLOAT_EQ(255.f / 256.f, (*R)(1, 1));
+    EXPECT_FLOAT_EQ(32.f / 512.f, (*G)(2, 1));
+}
+
+TEST(TestRGBE, Truncated)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillHdrFrame(frame);
+
+    TempFile file("truncated.hdr");
+    RGBEWriter(file.name()).write(frame, Params());
+    std::ifstream in(file.name().c_str(), std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(in)),
+                              std::istreambuf_iterator<char>());
+    in.close();
+
+    TempFile truncated("truncated_half.hdr");
+    {
+        std::ofstream out(truncated.name().c_str(), std::ios::binary);
+        out.write(content.data(), content.size() / 2);
+    }
+
+    Frame read;
+    EXPECT_THROW(RGBEReader(truncated.name()).read(read, Params()),
+                 pfs::Exception);
+}
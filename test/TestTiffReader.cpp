@@ -0,0 +1,299 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <tiffio.h>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/io/tiffreader.h>
+
+#include "TestHelpers.h"
+
+using namespace pfs;
+using namespace pfs::io;
+
+namespace {
+
+// partial strips and tiles on the right and bottom edges
+const size_t WIDTH = 301;
+const size_t HEIGHT = 203;
+
+struct Layout {
+    const char *name;
+    uint16_t bitsPerSample;
+    bool logLuv;
+    // 0 for strips of blockHeight rows
+    uint32_t blockWidth;
+    uint32_t blockHeight;
+};
+
+const Layout LAYOUTS[] = {{"8 bits, strips", 8, false, 0, 16},
+                          {"8 bits, tiles", 8, false, 64, 32},
+                          {"16 bits, strips", 16, false, 0, 7},
+                          {"16 bits, tiles", 16, false, 32, 48},
+                          {"float, strips", 32, false, 0, 16},
+                          {"float, tiles", 32, false, 64, 16},
+                          {"LogLuv, strips", 32, true, 0, 16},
+                          {"LogLuv, tiles", 32, true, 64, 32}};
+
+// a value between 0 and 1, different on every sample
+float sampleValue(size_t x, size_t y, size_t c) {
+    return static_cast<float>((x * 7 + y * 13 + c * 101) % 1021) / 1021.f;
+}
+
+template <typename T>
+T storedSample(float value);
+
+template <>
+uint8_t storedSample<uint8_t>(float value) {
+    return static_cast<uint8_t>(value * 255.f + 0.5f);
+}
+
+template <>
+uint16_t storedSample<uint16_t>(float value) {
+    return static_cast<uint16_t>(value * 65535.f + 0.5f);
+}
+
+template <>
+float storedSample<float>(float value) {
+    return value;
+}
+
+// the value the reader returns for \a value, stored in \a layout
+float expectedValue(const Layout &layout, float value) {
+    switch (layout.bitsPerSample) {
+        case 8:
+            return storedSample<uint8_t>(value) / 255.f;
+        case 16:
+            return storedSample<uint16_t>(value) / 65535.f;
+        default:
+            return value;
+    }
+}
+
+// writes the samples of the block at (bx, by), zero outside of the image
+template <typename T>
+bool writeBlocks(TIFF *tif, const Layout &layout) {
+    const bool tiled = layout.blockWidth != 0;
+    const size_t blockWidth = tiled ? layout.blockWidth : WIDTH;
+    std::vector<T> buffer(blockWidth * layout.blockHeight * 3);
+
+    for (size_t by = 0; by < HEIGHT; by += layout.blockHeight) {
+        for (size_t bx = 0; bx < WIDTH; bx += blockWidth) {
+            std::fill(buffer.begin(), buffer.end(), T());
+            const size_t rows = std::min<size_t>(layout.blockHeight,
+                                                 HEIGHT - by);
+            for (size_t y = 0; y < rows; ++y) {
+                for (size_t x = 0; x < blockWidth && bx + x < WIDTH; ++x) {
+                    for (size_t c = 0; c < 3; ++c) {
+                        buffer[(y * blockWidth + x) * 3 + c] = storedSample<T>(
+                            sampleValue(bx + x, by + y, c));
+                    }
+                }
+            }
+            const tmsize_t written =
+                tiled ? TIFFWriteEncodedTile(
+                            tif, TIFFComputeTile(tif, bx, by, 0, 0),
+                            buffer.data(), buffer.size() * sizeof(T))
+                      : TIFFWriteEncodedStrip(
+                            tif, TIFFComputeStrip(tif, by, 0), buffer.data(),
+                            rows * blockWidth * 3 * sizeof(T));
+            if (written < 0) return false;
+        }
+    }
+    return true;
+}
+
+void writeTiff(const std::string &filename, const Layout &layout) {
+    TIFF *tif = TIFFOpen(filename.c_str(), "w");
+    ASSERT_TRUE(tif != NULL);
+
+    TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, (uint32_t)WIDTH);
+    TIFFSetField(tif, TIFFTAG_IMAGELENGTH, (uint32_t)HEIGHT);
+    TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, (uint16_t)3);
+    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, layout.bitsPerSample);
+    TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, layout.bitsPerSample == 32
+                                                ? SAMPLEFORMAT_IEEEFP
+                                                : SAMPLEFORMAT_UINT);
+    if (layout.logLuv) {
+        // XYZ samples, as the TiffWriter stores them
+        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_LOGLUV);
+        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_SGILOG);
+        TIFFSetField(tif, TIFFTAG_SGILOGDATAFMT, SGILOGDATAFMT_FLOAT);
+    } else {
+        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_DEFLATE);
+    }
+    if (layout.blockWidth != 0) {
+        TIFFSetField(tif, TIFFTAG_TILEWIDTH, layout.blockWidth);
+        TIFFSetField(tif, TIFFTAG_TILELENGTH, layout.blockHeight);
+    } else {
+        TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, layout.blockHeight);
+    }
+
+    bool written = false;
+    switch (layout.bitsPerSample) {
+        case 8:
+            written = writeBlocks<uint8_t>(tif, layout);
+            break;
+        case 16:
+            written = writeBlocks<uint16_t>(tif, layout);
+            break;
+        default:
+            written = writeBlocks<float>(tif, layout);
+            break;
+    }
+    TIFFClose(tif);
+    EXPECT_TRUE(written) << layout.name;
+}
+
+void readTiff(const std::string &filename, const Params &params,
+              Frame &frame) {
+    TiffReader reader(filename);
+    reader.read(frame, params);
+}
+
+Params roiParams(size_t x, size_t y, size_t width, size_t height) {
+    return Params("roi_x", x)("roi_y", y)("roi_width", width)("roi_height",
+                                                               height);
+}
+
+// \a frame is the region of \a reference at (x, y)
+void expectRegion(const Frame &reference, size_t x, size_t y,
+                  const Frame &frame, const std::string &what) {
+    const Channel *R, *G, *B;
+    const Channel *r, *g, *b;
+    reference.getXYZChannels(R, G, B);
+    frame.getXYZChannels(r, g, b);
+    ASSERT_TRUE(R != NULL && r != NULL) << what;
+
+    const Channel *expected[] = {R, G, B};
+    const Channel *actual[] = {r, g, b};
+    for (size_t c = 0; c < 3; ++c) {
+        for (size_t row = 0; row < frame.getHeight(); ++row) {
+            for (size_t col = 0; col < frame.getWidth(); ++col) {
+                ASSERT_EQ((*expected[c])(x + col, y + row),
+                          (*actual[c])(col, row))
+                    << what << ": (" << x + col << ", " << y + row
+                    << "), channel " << c;
+            }
+        }
+    }
+}
+}
+
+TEST(TestTiffReader, SerialDecode)
+{
+    for (size_t i = 0; i < sizeof(LAYOUTS) / sizeof(LAYOUTS[0]); ++i) {
+        const Layout &layout = LAYOUTS[i];
+        // LogLuv is lossy: its threaded decodes are checked below
+        if (layout.logLuv) continue;
+
+        TempFile file("TestTiffReader_serial.tif");
+        writeTiff(file.name(), layout);
+
+        Frame frame;
+        readTiff(file.name(), Params("threads", 0), frame);
+        ASSERT_EQ(WIDTH, frame.getWidth()) << layout.name;
+        ASSERT_EQ(HEIGHT, frame.getHeight()) << layout.name;
+
+        const Channel *channels[3];
+        frame.getXYZChannels(channels[0], channels[1], channels[2]);
+        for (size_t c = 0; c < 3; ++c) {
+            for (size_t y = 0; y < HEIGHT; ++y) {
+                for (size_t x = 0; x < WIDTH; ++x) {
+                    ASSERT_EQ(expectedValue(layout, sampleValue(x, y, c)),
+                              (*channels[c])(x, y))
+                        << layout.name << ": (" << x << ", " << y
+                        << "), channel " << c;
+                }
+            }
+        }
+    }
+}
+
+TEST(TestTiffReader, Threads)
+{
+    for (size_t i = 0; i < sizeof(LAYOUTS) / sizeof(LAYOUTS[0]); ++i) {
+        const Layout &layout = LAYOUTS[i];
+        TempFile file("TestTiffReader_threads.tif");
+        writeTiff(file.name(), layout);
+
+        Frame reference;
+        readTiff(file.name(), Params("threads", 0), reference);
+
+        // LogLuv needs its data format set on the handle of every thread
+        const int threads[] = {1, 3, 8};
+        for (size_t t = 0; t < 3; ++t) {
+            Frame frame;
+            readTiff(file.name(), Params("threads", threads[t]), frame);
+            ASSERT_EQ(WIDTH, frame.getWidth());
+            ASSERT_EQ(HEIGHT, frame.getHeight());
+            expectRegion(reference, 0, 0, frame,
+                         std::string(layout.name) + ", threads " +
+                             std::to_string(threads[t]));
+        }
+    }
+}
+
+TEST(TestTiffReader, RegionOfInterest)
+{
+    // across strip and tile edges, inside a single block, on the bottom
+    // right partial blocks and past the end of the image
+    const size_t rects[][4] = {{63, 31, 2, 2},    {1, 15, 298, 3},
+                               {70, 40, 1, 1},    {250, 190, 51, 13},
+                               {31, 47, 66, 100}, {280, 180, 100, 100},
+                               {0, 0, WIDTH, 1},  {0, 0, 1, HEIGHT}};
+
+    for (size_t i = 0; i < sizeof(LAYOUTS) / sizeof(LAYOUTS[0]); ++i) {
+        const Layout &layout = LAYOUTS[i];
+        TempFile file("TestTiffReader_roi.tif");
+        writeTiff(file.name(), layout);
+
+        Frame reference;
+        readTiff(file.name(), Params("threads", 0), reference);
+
+        for (size_t r = 0; r < sizeof(rects) / sizeof(rects[0]); ++r) {
+            const size_t x = rects[r][0];
+            const size_t y = rects[r][1];
+            for (int threads = 0; threads <= 4; threads += 4) {
+                Frame frame;
+                readTiff(file.name(),
+                         roiParams(x, y, rects[r][2], rects[r][3])(
+                             "threads", threads),
+                         frame);
+                ASSERT_EQ(std::min(rects[r][2], WIDTH - x), frame.getWidth());
+                ASSERT_EQ(std::min(rects[r][3], HEIGHT - y),
+                          frame.getHeight());
+                expectRegion(reference, x, y, frame,
+                             std::string(layout.name) + ", rect " +
+                                 std::to_string(r) + ", threads " +
+                                 std::to_string(threads));
+            }
+        }
+    }
+}
@@ -0,0 +1,217 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2026 The Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <tiffio.h>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/io/ioexception.h>
+#include <Libpfs/io/tiffwriter.h>
+
+#include "TestHelpers.h"
+
+using namespace pfs;
+using namespace pfs::io;
+
+namespace {
+
+// a few strips in every mode
+const size_t WIDTH = 1023;
+const size_t HEIGHT = 611;
+
+// what the options --ldrTiffCompression, --ldrTiffLevel and
+// --ldrTiffPredictor of the command line become
+Params tiffParams(int mode, const std::string &compression, int level,
+                  const std::string &predictor) {
+    return Params("tiff_mode", mode)("tiff_compression", compression)(
+        "tiff_compression_level", level)("tiff_predictor", predictor);
+}
+
+struct Decoded {
+    uint16_t compression;
+    uint16_t predictor;
+    std::vector<unsigned char> samples;
+};
+
+// decodes the samples of \a filename, as stored
+Decoded decode(const std::string &filename) {
+    Decoded decoded;
+    decoded.compression = COMPRESSION_NONE;
+    decoded.predictor = PREDICTOR_NONE;
+
+    TIFF *tif = TIFFOpen(filename.c_str(), "r");
+    EXPECT_TRUE(tif != NULL);
+    if (!tif) return decoded;
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
+    EXPECT_EQ(WIDTH, width);
+    EXPECT_EQ(HEIGHT, height);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_COMPRESSION, &decoded.compression);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_PREDICTOR, &decoded.predictor);
+
+    const tsize_t rowBytes = TIFFScanlineSize(tif);
+    decoded.samples.resize(rowBytes * height);
+    for (uint32_t row = 0; row < height; ++row) {
+        if (TIFFReadScanline(tif, &decoded.samples[row * rowBytes], row) < 0) {
+            ADD_FAILURE() << "cannot decode row " << row << " of " << filename;
+            break;
+        }
+    }
+    TIFFClose(tif);
+    return decoded;
+}
+
+Decoded writeAndDecode(const Frame &frame, const Params &params,
+                       const std::string &filename) {
+    TempFile file(filename);
+    TiffWriter writer(file.name());
+    EXPECT_TRUE(writer.write(frame, params));
+    return decode(file.name());
+}
+
+long fileSize(const std::string &filename) {
+    FILE *handle = std::fopen(filename.c_str(), "rb");
+    if (!handle) return -1;
+    std::fseek(handle, 0, SEEK_END);
+    const long size = std::ftell(handle);
+    std::fclose(handle);
+    return size;
+}
+}
+
+TEST(TestTiffWriter, RoundTrip)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+
+    struct {
+        const char *compression;
+        uint16_t tag;
+        const char *predictor;
+        uint16_t predictorTag;
+    } cases[] = {{"deflate", COMPRESSION_DEFLATE, "horizontal",
+                  PREDICTOR_HORIZONTAL},
+                 {"deflate", COMPRESSION_DEFLATE, "none",
+                  PREDICTOR_NONE},
+                 {"lzw", COMPRESSION_LZW, "horizontal", PREDICTOR_HORIZONTAL},
+                 // no predictor for PackBits
+                 {"packbits", COMPRESSION_PACKBITS, "horizontal",
+                  PREDICTOR_NONE}};
+
+    // 8 bits, 16 bits and float
+    for (int mode = 0; mode <= 2; ++mode) {
+        const Decoded reference = writeAndDecode(
+            frame, tiffParams(mode, "none", 0, "none"),
+            "TestTiffWriter_reference.tif");
+        ASSERT_EQ(COMPRESSION_NONE, reference.compression);
+        ASSERT_FALSE(reference.samples.empty());
+
+        for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+            for (int threads = 0; threads <= 4; threads += 4) {
+                const Decoded decoded = writeAndDecode(
+                    frame, tiffParams(mode, cases[i].compression, 6,
+                                      cases[i].predictor)("threads", threads),
+                    "TestTiffWriter_compressed.tif");
+                EXPECT_EQ(cases[i].tag, decoded.compression)
+                    << cases[i].compression;
+                EXPECT_EQ(cases[i].predictorTag, decoded.predictor)
+                    << cases[i].compression;
+                ASSERT_TRUE(reference.samples == decoded.samples)
+                    << "mode " << mode << ", " << cases[i].compression << ", "
+                    << cases[i].predictor << ", threads " << threads;
+            }
+        }
+    }
+}
+
+TEST(TestTiffWriter, FloatPredictor)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+
+    const Decoded reference =
+        writeAndDecode(frame, tiffParams(2, "none", 0, "none"),
+                       "TestTiffWriter_reference.tif");
+    const Decoded decoded =
+        writeAndDecode(frame, tiffParams(2, "deflate", 6, "float"),
+                       "TestTiffWriter_float.tif");
+    EXPECT_EQ(PREDICTOR_FLOATINGPOINT, decoded.predictor);
+    ASSERT_TRUE(reference.samples == decoded.samples);
+
+    // only float samples have a floating point predictor
+    TempFile file("TestTiffWriter_float16.tif");
+    TiffWriter writer(file.name());
+    EXPECT_THROW(writer.write(frame, tiffParams(1, "deflate", 6, "float")),
+                 WriteException);
+}
+
+TEST(TestTiffWriter, Levels)
+{
+    Frame frame(WIDTH, HEIGHT);
+    fillFrame(frame);
+
+    const Decoded reference =
+        writeAndDecode(frame, tiffParams(1, "none", 0, "none"),
+                       "TestTiffWriter_reference.tif");
+
+    std::vector<std::string> compressions(1, "deflate");
+#ifdef COMPRESSION_ZSTD
+    if (TIFFIsCODECConfigured(COMPRESSION_ZSTD)) compressions.push_back("zstd");
+#endif
+    for (size_t i = 0; i < compressions.size(); ++i) {
+        // the level of Deflate is capped at 9
+        const int levels[] = {1, 9, 22};
+        long sizes[3];
+        for (size_t l = 0; l < 3; ++l) {
+            TempFile file("TestTiffWriter_level.tif");
+            TiffWriter writer(file.name());
+            ASSERT_TRUE(writer.write(
+                frame, tiffParams(1, compressions[i], levels[l], "horizontal")(
+                           "threads", 4)));
+            sizes[l] = fileSize(file.name());
+            ASSERT_TRUE(reference.samples == decode(file.name()).samples)
+                << compressions[i] << ", level " << levels[l];
+        }
+        EXPECT_LE(sizes[1], sizes[0]) << compressions[i];
+        EXPECT_LE(sizes[2], sizes[1]) << compressions[i];
+    }
+}
+
+TEST(TestTiffWriter, UnknownOption)
+{
+    Frame frame(16, 16);
+    fillFrame(frame);
+
+    TempFile file("TestTiffWriter_unknown.tif");
+    TiffWriter writer(file.name());
+    EXPECT_THROW(writer.write(frame, tiffParams(0, "lz4", 6, "none")),
+                 WriteException);
+    EXPECT_THROW(writer.write(frame, tiffParams(0, "lzw", 6, "median")),
+                 WriteException);
+}